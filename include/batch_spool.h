@@ -0,0 +1,182 @@
+#ifndef BATCH_SPOOL_H
+#define BATCH_SPOOL_H
+
+// Batch Spool
+// ===========
+// Store-and-forward queue of outgoing batches (InfluxDB line protocol) on a
+// flash filesystem: one numbered file per batch (<dir>/00000001.lp, ...),
+// replayed oldest first. Bounded by file count and total bytes; when either
+// is exceeded the oldest batches are deleted, as for the segment log.
+//
+// Each file starts with a header carrying the payload length and CRC-32, so a
+// batch torn by a power loss is discarded on replay instead of being sent.
+// FileSystem is the same fs::FS subset SegmentLog uses.
+// Not thread-safe: callers serialize access.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_codec.h"  // crc32Update()
+
+struct BatchSpoolHeader {
+    char magic[4];      // "LPB1"
+    uint32_t length;    // Payload bytes
+    uint32_t crc;       // CRC-32 of the payload
+};
+
+struct BatchSpoolStats {
+    uint32_t batchesWritten = 0;
+    uint32_t batchesReplayed = 0;
+    uint32_t batchesDropped = 0;   // Oldest batches deleted to stay within the limits
+    uint32_t batchesCorrupt = 0;   // Torn or unreadable files discarded on replay
+    uint32_t writeErrors = 0;
+};
+
+template <typename FileSystem>
+class BatchSpool {
+public:
+    bool begin(FileSystem& fileSystem, const char* directory, uint16_t fileLimit, uint32_t byteLimit) {
+        fs = &fileSystem;
+        dir = directory;
+        maxFiles = fileLimit;
+        maxBytes = byteLimit;
+
+        if (!fs->exists(dir) && !fs->mkdir(dir)) {
+            fs = NULL;
+            return false;
+        }
+
+        // Batches left from before a reboot are replayed too
+        first = 0;
+        last = 0;
+        totalBytes = 0;
+        auto root = fs->open(dir);
+        auto file = root.openNextFile();
+        while (file) {
+            uint32_t number = strtoul(baseName(file.name()), NULL, 10);
+            if (number > 0) {
+                if (first == 0 || number < first) first = number;
+                if (number > last) last = number;
+                totalBytes += file.size();
+            }
+            file = root.openNextFile();
+        }
+        if (last == 0) {
+            first = 1;
+        }
+        return true;
+    }
+
+    bool isReady() const { return fs != NULL; }
+    uint32_t size() const { return last >= first ? last - first + 1 : 0; }
+    uint32_t bytes() const { return totalBytes; }
+    const BatchSpoolStats& getStats() const { return stats; }
+
+    // Appends a batch as the newest file
+    bool push(const char* data, uint32_t length) {
+        if (fs == NULL || length == 0) {
+            return false;
+        }
+        BatchSpoolHeader header;
+        memcpy(header.magic, "LPB1", 4);
+        header.length = length;
+        header.crc = crc32Update(0, (const uint8_t*)data, length);
+
+        char path[48];
+        filePath(last + 1, path, sizeof(path));
+        auto file = fs->open(path, "w");
+        size_t written = 0;
+        if (file) {
+            written = file.write((const uint8_t*)&header, sizeof(header));
+            written += file.write((const uint8_t*)data, length);
+            file.close();
+        }
+        if (written != sizeof(header) + length) {
+            stats.writeErrors++;
+            fs->remove(path);
+            return false;
+        }
+
+        last++;
+        totalBytes += written;
+        stats.batchesWritten++;
+        while (size() > maxFiles || (totalBytes > maxBytes && size() > 1)) {
+            removeOldest();
+            stats.batchesDropped++;
+        }
+        return true;
+    }
+
+    // Reads the oldest batch into `out` (capacity bytes). Corrupt batches are
+    // discarded on the way. Returns the payload length, 0 if the spool is empty.
+    uint32_t peek(char* out, uint32_t capacity) {
+        while (fs != NULL && size() > 0) {
+            char path[48];
+            filePath(first, path, sizeof(path));
+            auto file = fs->open(path, "r");
+            BatchSpoolHeader header;
+            bool valid = false;
+            if (file) {
+                valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                        memcmp(header.magic, "LPB1", 4) == 0 && header.length > 0 && header.length <= capacity &&
+                        file.read((uint8_t*)out, header.length) == header.length &&
+                        crc32Update(0, (const uint8_t*)out, header.length) == header.crc;
+                file.close();
+            }
+            if (valid) {
+                return header.length;
+            }
+            removeOldest();
+            stats.batchesCorrupt++;
+        }
+        return 0;
+    }
+
+    // Deletes the oldest batch once it was delivered
+    void pop() {
+        if (fs != NULL && size() > 0) {
+            removeOldest();
+            stats.batchesReplayed++;
+        }
+    }
+
+private:
+    void removeOldest() {
+        char path[48];
+        filePath(first, path, sizeof(path));
+        auto file = fs->open(path, "r");
+        uint32_t fileBytes = file ? file.size() : 0;
+        if (file) {
+            file.close();
+        }
+        fs->remove(path);
+        totalBytes = totalBytes > fileBytes ? totalBytes - fileBytes : 0;
+        first++;
+        if (first > last) {
+            // Empty: keep numbering from where it was
+            first = last + 1;
+        }
+    }
+
+    void filePath(uint32_t number, char* path, size_t size) const {
+        snprintf(path, size, "%s/%08lu.lp", dir, (unsigned long)number);
+    }
+
+    // File::name() is the bare name on LittleFS but may include the directory elsewhere
+    static const char* baseName(const char* name) {
+        const char* slash = strrchr(name, '/');
+        return slash != NULL ? slash + 1 : name;
+    }
+
+    FileSystem* fs = NULL;
+    const char* dir = "";
+    uint16_t maxFiles = 64;
+    uint32_t maxBytes = 0;
+    uint32_t first = 1;   // Oldest batch (first > last when empty)
+    uint32_t last = 0;    // Newest batch
+    uint32_t totalBytes = 0;
+    BatchSpoolStats stats;
+};
+
+#endif // BATCH_SPOOL_H
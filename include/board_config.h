@@ -66,6 +66,38 @@
     // Power Management
     #define CPU_FREQ_MHZ 80  // Reduce to 80 MHz for power saving
 
+    // Sensor Task
+    // Single-core RISC-V: the sensor task shares core 0 with the WiFi stack
+    #define SENSOR_TASK_CORE 0
+
+    // I2C Sensors (drivers in sensor_drivers.h, last one wins on shared channels)
+    #define BOARD_SENSORS Bmp280Driver, Aht20Driver
+
+    // Sensor History (16 bytes per 5 s record)
+    // Smaller RAM: keep the ring modest so HTTP/WiFi buffers have room
+    #define HISTORY_HEAP_PERCENT 15
+    #define HISTORY_MAX_RECORDS 2160  // 3 hours
+    #define ROLLUP_MINUTE_BUCKETS 240  // 4 hours   (76 bytes per bucket, ~37 KB in total)
+    #define ROLLUP_HOUR_BUCKETS 168    // 7 days
+    #define ROLLUP_DAY_BUCKETS 90      // 90 days
+    #define SENSOR_BLOCK_COUNT 64      // Compressed ring, 256 B each (~80 records/block, ~7 hours)
+
+    // History Log (LittleFS, default partition table: ~1.4 MB filesystem)
+    #define LOG_SEGMENT_BLOCKS 64      // 16 KB segment files
+    #define LOG_MAX_SEGMENTS 48        // 768 KB, ~18 days
+
+    // Adaptive Sampling: steady readings stretch a sensor's interval up to this
+    #define ADAPTIVE_MAX_INTERVAL_MS 60000  // Battery/power-sensitive board
+
+    // Burst Capture (BMP280, 12 bytes per sample, allocated at boot)
+    #define CAPTURE_MAX_SAMPLES 1024   // 12 KB: ~10 s at 100 Hz
+
+    // Rules engine (172 bytes of RAM and one NVS blob per rule)
+    #define RULES_MAX 16
+
+    // MQTT offline queue (44 bytes per snapshot, allocated at boot)
+    #define MQTT_QUEUE_RECORDS 180     // ~8 KB: 15 minutes of 5 s snapshots
+
     // Board-specific notes
     #define BOARD_NOTES "WiFi TX power limited to 8.5dBm due to hardware power supply design"
 
@@ -94,6 +126,38 @@
     // Power Management
     #define CPU_FREQ_MHZ 80  // Reduced for power saving (can use 160 or 240 for more performance)
 
+    // Sensor Task
+    // WiFi/LWIP run on core 0 (PRO_CPU), so keep I2C reads on core 1 (APP_CPU)
+    #define SENSOR_TASK_CORE 1
+
+    // I2C Sensors (drivers in sensor_drivers.h, last one wins on shared channels)
+    // e.g. add Sht4xDriver or Scd4xDriver to this list
+    #define BOARD_SENSORS Bmp280Driver, Aht20Driver
+
+    // Sensor History (16 bytes per 5 s record)
+    #define HISTORY_HEAP_PERCENT 25
+    #define HISTORY_MAX_RECORDS 8640  // 12 hours
+    #define ROLLUP_MINUTE_BUCKETS 720  // 12 hours  (76 bytes per bucket, ~92 KB in total)
+    #define ROLLUP_HOUR_BUCKETS 336    // 14 days
+    #define ROLLUP_DAY_BUCKETS 180     // 180 days
+    #define SENSOR_BLOCK_COUNT 192     // Compressed ring, 256 B each (~80 records/block, ~21 hours)
+
+    // History Log (LittleFS, default partition table: ~1.4 MB filesystem)
+    #define LOG_SEGMENT_BLOCKS 64      // 16 KB segment files
+    #define LOG_MAX_SEGMENTS 64        // 1 MB, ~24 days
+
+    // Adaptive Sampling: steady readings stretch a sensor's interval up to this
+    #define ADAPTIVE_MAX_INTERVAL_MS 30000
+
+    // Burst Capture (BMP280, 12 bytes per sample, allocated at boot)
+    #define CAPTURE_MAX_SAMPLES 4096   // 48 KB: ~40 s at 100 Hz
+
+    // Rules engine (172 bytes of RAM and one NVS blob per rule)
+    #define RULES_MAX 32
+
+    // MQTT offline queue (44 bytes per snapshot, allocated at boot)
+    #define MQTT_QUEUE_RECORDS 720     // ~31 KB: 1 hour of 5 s snapshots
+
     // Board-specific notes
     #define BOARD_NOTES "Full WiFi TX power available (19.5dBm max)"
 
@@ -102,11 +166,63 @@
 #endif
 
 // Common Configuration (applies to all boards)
-// Note: BMP280_ADDRESS is defined in Adafruit_BMP280.h as 0x77
-// We use 0x76 as the primary address and 0x77 as fallback in setupBMP280()
 #define FIRMWARE_VERSION "2.2.0"  // Device naming feature - customize device name in webapp
 #define WDT_TIMEOUT 10  // Watchdog timer timeout in seconds
 
+// Sensor Task Configuration
+// Sensor acquisition runs in its own FreeRTOS task so slow I2C transactions
+// never delay web requests (and vice versa). Priority is above the Arduino
+// loop task (1) so readings stay on schedule; the task sleeps between cycles.
+// It does no flash I/O (sealed history blocks are written by the loop task),
+// so the stack only covers I2C, the history append, the detectors and
+// logWrite(); check "sensors" stackFreeMin in /debug/tasks after changing them.
+#define SENSOR_TASK_STACK 4096
+#define SENSOR_TASK_PRIORITY 2
+#define SEALED_BLOCK_QUEUE 4  // Sealed blocks waiting for the loop task to write them (~30 min)
+
+// Log drain task: writes the log ring (log_ring.h) to Serial. Idle priority,
+// so a UART that can't keep up delays only this task, never the loop.
+#define LOG_DRAIN_TASK_STACK 3072
+#define LOG_DRAIN_TASK_PRIORITY 0
+
+// Supervisor: checks the subsystem heartbeats (heartbeat_registry.h) every
+// SUPERVISOR_INTERVAL_MS and is the only task the hardware task watchdog
+// watches after setup(). Above the sensor task, so a busy task can't starve it.
+#define SUPERVISOR_TASK_STACK 3072
+#define SUPERVISOR_TASK_PRIORITY 3
+#define SUPERVISOR_INTERVAL_MS 1000
+
+// Heartbeat periods: the longest a subsystem may go without checking in
+// before it is restarted (and after another period, the device). Each is
+// well above the longest blocking call in that subsystem.
+#define HEARTBEAT_SENSORS_MS 20000  // 5 s cycle
+#define HEARTBEAT_WEB_MS 20000      // /connect waits up to 10 s for WiFi
+#define HEARTBEAT_WIFI_MS 30000     // Roaming scans, reconnect with mDNS/OTA setup
+#define HEARTBEAT_OTA_MS 30000      // Between upload progress callbacks (flash erase)
+#define HEARTBEAT_PUSH_MS 30000     // MQTT / InfluxDB: DNS and 4-5 s socket timeouts
+
+// Burst Capture: the BMP280 converts every ~7 ms with 1x oversampling, so
+// 100 Hz leaves headroom for I2C transfers and timer latency
+#define CAPTURE_MAX_RATE_HZ 100
+
+// MQTT: up to MQTT_MAX_BATCH snapshots per message (~200 bytes of JSON each).
+// The keepalive is well above the modem-sleep DTIM wake-up latency, and
+// blocking socket calls give up long before the watchdog fires.
+#define MQTT_MAX_BATCH 12
+#define MQTT_BUFFER_SIZE 3072
+#define MQTT_KEEPALIVE_SECONDS 60
+#define MQTT_SOCKET_TIMEOUT_SECONDS 5
+
+// InfluxDB push: a batch is sent once it reaches INFLUX_BATCH_BYTES (~13
+// lines) or its first line is INFLUX_BATCH_MAX_AGE_MS old. Batches that
+// can't be sent are spooled to LittleFS next to the history log.
+#define INFLUX_BATCH_BYTES 2048
+#define INFLUX_BATCH_MAX_AGE_MS 60000
+#define INFLUX_QUEUE_RECORDS 60          // Snapshots waiting for the clock / formatting (5 minutes)
+#define INFLUX_SPOOL_MAX_BATCHES 128
+#define INFLUX_SPOOL_MAX_BYTES 262144    // 256 KB, ~1 day of 5 s snapshots
+#define INFLUX_HTTP_TIMEOUT_MS 4000
+
 // Power Management Configuration Type (chip-specific)
 // ESP32-C3 uses esp_pm_config_esp32c3_t, ESP32 uses esp_pm_config_esp32_t
 #if defined(BOARD_ESP32C3)
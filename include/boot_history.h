@@ -0,0 +1,168 @@
+#ifndef BOOT_HISTORY_H
+#define BOOT_HISTORY_H
+
+// Boot History
+// ============
+// Why the device restarted, for the last BOOT_HISTORY_RECORDS boots: a
+// watchdog reset, a brown-out and a panic all look the same from outside
+// (uptime drops to zero), but not here.
+//
+// BootBreadcrumbs live in RTC memory that is not initialized at boot
+// (RTC_NOINIT_ATTR in main.cpp), so they survive panics, watchdog and
+// software resets but not a power cycle. While running, the firmware leaves
+// in them the last PerfPhase the loop and the sensor task entered (every
+// PERF_BEGIN / PERF_TIME, see perf_profiler.h), the route whose handler is
+// running, the uptime of the last loop pass and the subsystem the supervisor
+// found stalled (heartbeat_registry.h), if any. At the next boot they say
+// what the device was doing when it went down.
+//
+// setupBootHistory() turns them, esp_reset_reason() and - after a panic or
+// watchdog reset - the core dump summary (crashed task, PC, first frames of
+// the backtrace) into a BootRecord, and stores the BootHistory as one NVS
+// blob: one flash write per boot.
+//
+// Backtrace addresses resolve against the firmware's ELF:
+//   xtensa-esp32-elf-addr2line -pfiaC -e .pio/build/esp32wroom/firmware.elf 0x400d1234 ...
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BOOT_HISTORY_RECORDS 8
+#define BOOT_BACKTRACE_DEPTH 4
+#define BOOT_HISTORY_VERSION 3           // Changes with the layout and the PerfPhase numbering
+#define BOOT_BREADCRUMB_MAGIC 0xB007C0E0UL  // Likewise
+#define BOOT_PHASE_NONE 0xFF
+#define BOOT_SUBSYSTEM_NONE 0xFF
+#define BOOT_ROUTE_LENGTH 24  // Including the terminator
+
+// Same values as esp_reset_reason_t (ESP-IDF 4.4); newer IDF reasons are
+// stored as they are and named "other"
+enum BootResetReason : uint8_t {
+    BOOT_RESET_UNKNOWN,
+    BOOT_RESET_POWERON,
+    BOOT_RESET_EXTERNAL,
+    BOOT_RESET_SOFTWARE,   // ESP.restart(), OTA
+    BOOT_RESET_PANIC,      // Exception, abort(), assert
+    BOOT_RESET_INT_WDT,    // Interrupt watchdog: a core stuck with interrupts off
+    BOOT_RESET_TASK_WDT,   // Task watchdog (WDT_TIMEOUT): loop or sensor task stalled
+    BOOT_RESET_WDT,        // Other watchdogs (RTC, MWDT)
+    BOOT_RESET_DEEPSLEEP,
+    BOOT_RESET_BROWNOUT,
+    BOOT_RESET_SDIO,
+    BOOT_RESET_REASON_COUNT
+};
+
+static constexpr const char* BOOT_RESET_REASON_NAMES[BOOT_RESET_REASON_COUNT] = {
+    "unknown", "power-on", "external", "software", "panic",    "int-wdt",
+    "task-wdt", "wdt",     "deep-sleep", "brownout", "sdio",
+};
+
+inline const char* bootResetReasonName(uint8_t reason) {
+    return reason < BOOT_RESET_REASON_COUNT ? BOOT_RESET_REASON_NAMES[reason] : "other";
+}
+
+// Resets nobody asked for
+inline bool bootResetIsCrash(uint8_t reason) {
+    return reason == BOOT_RESET_PANIC || reason == BOOT_RESET_INT_WDT || reason == BOOT_RESET_TASK_WDT ||
+           reason == BOOT_RESET_WDT || reason == BOOT_RESET_BROWNOUT;
+}
+
+struct BootBreadcrumbs {
+    uint32_t magic;                 // BOOT_BREADCRUMB_MAGIC once initialized
+    volatile uint32_t uptimeMs;     // Last loop pass
+    volatile uint32_t unixTime;     // Last update cycle, 0 before SNTP sync
+    volatile uint8_t loopPhase;     // Last PerfPhase entered by loop(), BOOT_PHASE_NONE before the first
+    volatile uint8_t sensorPhase;   // Last PerfPhase entered by the sensor task
+    volatile uint8_t stalled;       // HeartbeatId of a stalled subsystem, BOOT_SUBSYSTEM_NONE if none
+    char route[BOOT_ROUTE_LENGTH];  // Route handler running, "" outside handlers
+
+    bool valid() const { return magic == BOOT_BREADCRUMB_MAGIC; }
+
+    void reset() {
+        magic = BOOT_BREADCRUMB_MAGIC;
+        uptimeMs = 0;
+        unixTime = 0;
+        loopPhase = BOOT_PHASE_NONE;
+        sensorPhase = BOOT_PHASE_NONE;
+        stalled = BOOT_SUBSYSTEM_NONE;
+        route[0] = '\0';
+    }
+};
+
+struct BootRecord {
+    uint32_t boot;            // Boot number, counted since the history was created
+    uint8_t reason;           // BootResetReason
+    uint8_t loopPhase;        // The previous boot's last phases, BOOT_PHASE_NONE if unknown
+    uint8_t sensorPhase;
+    uint8_t backtraceDepth;   // Frames in backtrace[]
+    uint8_t stalled;          // Subsystem stalled when the previous boot ended, BOOT_SUBSYSTEM_NONE if none
+    uint32_t uptimeS;         // Uptime of the previous boot at its last loop pass, 0 if unknown
+    uint32_t unixTime;        // Wall clock at about the same time, 0 if unknown
+    char route[BOOT_ROUTE_LENGTH];
+    char task[16];            // Task that crashed, "" without a core dump
+    uint32_t pc;              // Where it crashed
+    uint32_t backtrace[BOOT_BACKTRACE_DEPTH];
+};
+
+// The supervisor gave up on a stalled subsystem and restarted the device
+inline bool bootRecordIsSupervisorReset(const BootRecord& record) {
+    return record.reason == BOOT_RESET_SOFTWARE && record.stalled != BOOT_SUBSYSTEM_NONE;
+}
+
+// "0x400d1234 0x400d5678 ..." (PC first), ready for addr2line; "" without a core dump
+inline size_t bootFormatBacktrace(const BootRecord& record, char* out, size_t size) {
+    size_t length = 0;
+    out[0] = '\0';
+    if (record.task[0] == '\0') {
+        return 0;
+    }
+    uint8_t depth = record.backtraceDepth < BOOT_BACKTRACE_DEPTH ? record.backtraceDepth : BOOT_BACKTRACE_DEPTH;
+    for (int i = -1; i < (int)depth; i++) {
+        uint32_t address = i < 0 ? record.pc : record.backtrace[i];
+        int written = snprintf(out + length, size - length, "%s0x%08lx", length > 0 ? " " : "", (unsigned long)address);
+        if (written < 0 || (size_t)written >= size - length) {
+            out[length] = '\0';
+            break;
+        }
+        length += written;
+    }
+    return length;
+}
+
+// Newest record first; stored as one blob, rejected on a layout change
+struct BootHistory {
+    uint8_t version = BOOT_HISTORY_VERSION;
+    uint8_t count = 0;
+    uint32_t boots = 0;
+    uint32_t resets[BOOT_RESET_REASON_COUNT + 1] = {};  // Per reason; last slot: "other"
+    uint32_t supervisorResets = 0;  // Software resets by the heartbeat supervisor
+    BootRecord records[BOOT_HISTORY_RECORDS];
+
+    // Numbers and stores the record, dropping the oldest when full
+    void add(BootRecord record) {
+        record.boot = ++boots;
+        resets[record.reason < BOOT_RESET_REASON_COUNT ? record.reason : (uint8_t)BOOT_RESET_REASON_COUNT]++;
+        if (bootRecordIsSupervisorReset(record)) {
+            supervisorResets++;
+        }
+        memmove(&records[1], &records[0], sizeof(BootRecord) * (BOOT_HISTORY_RECORDS - 1));
+        records[0] = record;
+        if (count < BOOT_HISTORY_RECORDS) {
+            count++;
+        }
+    }
+
+    // Panics, watchdog resets, brown-outs and supervisor resets
+    uint32_t crashes() const {
+        uint32_t total = supervisorResets;
+        for (uint8_t reason = 0; reason < BOOT_RESET_REASON_COUNT; reason++) {
+            if (bootResetIsCrash(reason)) {
+                total += resets[reason];
+            }
+        }
+        return total;
+    }
+};
+
+#endif // BOOT_HISTORY_H
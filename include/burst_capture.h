@@ -0,0 +1,146 @@
+#ifndef BURST_CAPTURE_H
+#define BURST_CAPTURE_H
+
+// Burst Capture Buffer
+// ====================
+// Preallocated buffer for high-rate BMP280 captures (door-open / pressure
+// transient investigations). The capture task appends one sample per timer
+// tick; this class only stores samples and keeps timing statistics, so adding
+// a sample is O(1) and never allocates.
+//
+// Download format (little-endian, as served by /capture-data):
+//   CaptureHeader, then `count` CaptureSample records
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct CaptureSample {
+    uint32_t timeUs;       // Since the first sample
+    uint32_t pressureQ8;   // Pa * 256
+    int16_t temperature;   // 0.01 °C
+    uint16_t reserved;
+};
+
+struct CaptureHeader {
+    char magic[4];         // "BCAP"
+    uint16_t version;      // 1
+    uint16_t sampleSize;   // sizeof(CaptureSample)
+    uint32_t count;
+    uint32_t rateHz;       // Requested rate
+};
+
+static_assert(sizeof(CaptureSample) == 12, "CaptureSample is part of the download format");
+static_assert(sizeof(CaptureHeader) == 16, "CaptureHeader is part of the download format");
+
+enum CaptureState : uint8_t {
+    CAPTURE_IDLE,
+    CAPTURE_RUNNING,
+    CAPTURE_DONE,
+    CAPTURE_FAILED
+};
+
+class BurstCapture {
+public:
+    bool begin(size_t maxSamples) {
+        samples = (CaptureSample*)malloc(maxSamples * sizeof(CaptureSample));
+        capacitySamples = samples != NULL ? maxSamples : 0;
+        return samples != NULL;
+    }
+
+    size_t capacity() const { return capacitySamples; }
+
+    // Resets the buffer for `count` samples at `rate` Hz
+    bool start(uint32_t rate, size_t count) {
+        if (count == 0 || count > capacitySamples || rate == 0) {
+            return false;
+        }
+        rateHz = rate;
+        target = count;
+        used = 0;
+        missed = 0;
+        readErrors = 0;
+        firstUs = 0;
+        lastUs = 0;
+        minIntervalUs = UINT32_MAX;
+        maxIntervalUs = 0;
+        sumSquaredDeviation = 0;
+        state = CAPTURE_RUNNING;
+        return true;
+    }
+
+    // O(1): stores one sample taken at `nowUs` (esp_timer clock)
+    void add(int64_t nowUs, int16_t temperature, uint32_t pressureQ8) {
+        if (used >= target) {
+            return;
+        }
+        if (used == 0) {
+            firstUs = nowUs;
+        } else {
+            uint32_t interval = (uint32_t)(nowUs - lastUs);
+            int64_t deviation = (int64_t)interval - periodUs();
+            if (interval < minIntervalUs) minIntervalUs = interval;
+            if (interval > maxIntervalUs) maxIntervalUs = interval;
+            sumSquaredDeviation += (uint64_t)(deviation * deviation);
+        }
+        lastUs = nowUs;
+        samples[used++] = {(uint32_t)(nowUs - firstUs), pressureQ8, temperature, 0};
+    }
+
+    void addMissed(uint32_t ticks) { missed += ticks; }
+    void addReadError() { readErrors++; }
+
+    bool isFull() const { return used >= target; }
+    void finish(bool ok) { state = ok ? CAPTURE_DONE : CAPTURE_FAILED; }
+
+    CaptureState getState() const { return state; }
+    size_t size() const { return used; }
+    size_t getTarget() const { return target; }
+    uint32_t getRateHz() const { return rateHz; }
+    uint32_t getMissed() const { return missed; }
+    uint32_t getReadErrors() const { return readErrors; }
+    uint32_t getMinIntervalUs() const { return used > 1 ? minIntervalUs : 0; }
+    uint32_t getMaxIntervalUs() const { return used > 1 ? maxIntervalUs : 0; }
+
+    // Samples per second actually achieved
+    float achievedRate() const {
+        return used > 1 && lastUs > firstUs ? (used - 1) * 1000000.0f / (float)(lastUs - firstUs) : 0;
+    }
+
+    // RMS deviation of the sample intervals from the requested period
+    float jitterRmsUs() const {
+        return used > 1 ? sqrtf((float)sumSquaredDeviation / (used - 1)) : 0;
+    }
+
+    CaptureHeader header() const {
+        CaptureHeader h;
+        memcpy(h.magic, "BCAP", 4);
+        h.version = 1;
+        h.sampleSize = sizeof(CaptureSample);
+        h.count = used;
+        h.rateHz = rateHz;
+        return h;
+    }
+
+    const CaptureSample* data() const { return samples; }
+
+private:
+    int64_t periodUs() const { return 1000000 / rateHz; }
+
+    CaptureSample* samples = NULL;
+    size_t capacitySamples = 0;
+    size_t target = 0;
+    volatile size_t used = 0;  // Read by the web task for progress
+    volatile CaptureState state = CAPTURE_IDLE;
+    uint32_t rateHz = 1;
+    uint32_t missed = 0;       // Timer ticks that fired while a read was still running
+    uint32_t readErrors = 0;
+    int64_t firstUs = 0;
+    int64_t lastUs = 0;
+    uint32_t minIntervalUs = UINT32_MAX;
+    uint32_t maxIntervalUs = 0;
+    uint64_t sumSquaredDeviation = 0;  // µs²
+};
+
+#endif // BURST_CAPTURE_H
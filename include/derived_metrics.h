@@ -0,0 +1,129 @@
+#ifndef DERIVED_METRICS_H
+#define DERIVED_METRICS_H
+
+// Derived Metrics
+// ===============
+// Values computed from the raw readings once per sensor cycle and published
+// in the same snapshot, so clients read them from /status instead of each
+// deriving their own:
+//
+// - Dew point, heat index, absolute humidity (temperature + humidity, env_math.h)
+// - Pressure tendency: change over 3 hours from a least-squares line through
+//   one pressure sample per minute, as used for barometric weather trends
+//
+// The tendency regression slides over a fixed ring of samples; its sums are
+// updated in O(1) per sample rather than refitting the whole window.
+
+#include <stdint.h>
+#include "sensor_snapshot.h"
+#include "env_math.h"
+
+#define PRESSURE_TREND_WINDOW 180       // Samples in the regression (3 hours)
+#define PRESSURE_TREND_SLOT_SECONDS 60  // One sample per minute
+#define PRESSURE_TREND_MIN_SAMPLES 30   // Publish once 30 minutes are covered
+
+// Least-squares slope over the last PRESSURE_TREND_WINDOW evenly spaced
+// samples. x is the sample's position in the window (0 = oldest), so sumX and
+// sumXX follow from the count; only sumY and sumXY are tracked. When the
+// window is full, dropping the oldest sample shifts every other x down by
+// one, which lowers sumXY by the remaining sumY.
+class SlidingTrend {
+public:
+    void reset() {
+        count = 0;
+        head = 0;
+        sumY = 0;
+        sumXY = 0;
+    }
+
+    void add(int32_t value) {
+        if (count == PRESSURE_TREND_WINDOW) {
+            sumY -= samples[head];  // Oldest sample, x = 0
+            sumXY -= sumY;
+            count--;
+        }
+        samples[head] = value;
+        head = (head + 1) % PRESSURE_TREND_WINDOW;
+        sumXY += (int64_t)count * value;
+        sumY += value;
+        count++;
+    }
+
+    uint16_t size() const { return count; }
+
+    // Change across a full window at the current slope, in value units
+    // (false with fewer than 2 samples)
+    bool change(int32_t& result) const {
+        if (count < 2) {
+            return false;
+        }
+        int64_t n = count;
+        int64_t sumX = n * (n - 1) / 2;
+        int64_t sumXX = (n - 1) * n * (2 * n - 1) / 6;
+        int64_t numerator = (n * sumXY - sumX * sumY) * PRESSURE_TREND_WINDOW;
+        int64_t denominator = n * sumXX - sumX * sumX;
+        result = (int32_t)((numerator + (numerator >= 0 ? denominator / 2 : -denominator / 2)) / denominator);
+        return true;
+    }
+
+private:
+    int32_t samples[PRESSURE_TREND_WINDOW] = {};
+    uint16_t count = 0;
+    uint16_t head = 0;   // Next write position (= oldest sample when full)
+    int64_t sumY = 0;
+    int64_t sumXY = 0;
+};
+
+// Runs after the drivers have filled the snapshot (sensor task only)
+class DerivedMetrics {
+public:
+    // nowSeconds: monotonic seconds (uptime) for the tendency's sample slots
+    void update(SensorSnapshot& readings, uint32_t nowSeconds) {
+        if (readings.has(CHANNEL_TEMPERATURE) && readings.has(CHANNEL_HUMIDITY)) {
+            int32_t temperature = readings.get(CHANNEL_TEMPERATURE);
+            int32_t humidity = readings.get(CHANNEL_HUMIDITY);
+            readings.set(CHANNEL_DEW_POINT, dewPointCenti(temperature, humidity));
+            readings.set(CHANNEL_HEAT_INDEX, heatIndexCenti(temperature, humidity));
+            readings.set(CHANNEL_ABSOLUTE_HUMIDITY, absoluteHumidityCenti(temperature, humidity));
+        }
+
+        updateTrend(readings, nowSeconds);
+        if (trend.size() >= PRESSURE_TREND_MIN_SAMPLES && trend.change(tendency)) {
+            readings.set(CHANNEL_PRESSURE_TREND, tendency);
+        }
+    }
+
+private:
+    void updateTrend(const SensorSnapshot& readings, uint32_t nowSeconds) {
+        if (!readings.has(CHANNEL_PRESSURE)) {
+            trend.reset();  // Sensor detached: start a fresh window when it returns
+            hasSlot = false;
+            return;
+        }
+        uint32_t slot = nowSeconds / PRESSURE_TREND_SLOT_SECONDS;
+        if (hasSlot && slot == lastSlot) {
+            return;
+        }
+
+        // Adaptive sampling may skip cycles while pressure is steady; the
+        // held value is still within its deadband, so it fills skipped slots
+        if (hasSlot) {
+            uint32_t skipped = slot - lastSlot - 1;
+            for (uint32_t i = 0; i < skipped && i < PRESSURE_TREND_WINDOW; i++) {
+                trend.add(lastPressure);
+            }
+        }
+        lastPressure = readings.get(CHANNEL_PRESSURE);
+        trend.add(lastPressure);
+        lastSlot = slot;
+        hasSlot = true;
+    }
+
+    SlidingTrend trend;
+    int32_t tendency = 0;
+    int32_t lastPressure = 0;
+    uint32_t lastSlot = 0;
+    bool hasSlot = false;
+};
+
+#endif // DERIVED_METRICS_H
@@ -0,0 +1,291 @@
+#ifndef ENV_MATH_H
+#define ENV_MATH_H
+
+// Fixed-Point Environmental Math
+// ==============================
+// The ESP32-C3 RISC-V core has no FPU: every float operation is a libgcc
+// call and powf()/logf()/expf() cost thousands of cycles. Everything on the
+// per-sample path is therefore integer-only:
+//
+// - BMP280 compensation: Bosch datasheet integer formulas (section 8.2)
+//   -> temperature in 0.01 °C, pressure in Q24.8 Pa. Exact to the datasheet.
+// - Altitude: lookup table over 300-1100 hPa (512 Pa steps) with linear
+//   interpolation of the international barometric formula.
+//   Max error vs. 44330 * (1 - (p / 1013.25)^0.1903): 0.21 m.
+// - Dew point: Magnus saturation vapour pressure table (-45..90 °C, 1 °C
+//   steps), interpolated forward for e = RH * es(T), then inverted.
+//   Dew points below the table clamp to -45 °C (-40 °C air below ~59 %RH,
+//   25 °C air below ~0.4 %RH). Max error vs. the float Magnus formula
+//   (b = 17.62, c = 243.12 °C) over -40..85 °C and 1-100 %RH, wherever the
+//   dew point is -45 °C or above: 0.032 °C.
+// - Absolute humidity: rho = e / (Rv * T) from the same vapour pressure.
+//   Max error vs. the float Magnus formula over -40..45 °C: 0.02 g/m³.
+// - Heat index: NWS algorithm (Steadman simple formula, Rothfusz regression
+//   with the low/high humidity adjustments) in 0.01 °F with coefficients
+//   scaled by 1e8, so every term stays exact in int64.
+//   Max error vs. the float NWS algorithm over -40..45 °C and 0-100 %RH:
+//   0.03 °C (except right at its 80 °F switch-over, where the float and
+//   integer versions may pick different formulas).
+// - JSON formatting: integer decimal formatting with round-half-away-from-zero.
+//
+// Both tables were generated from the float reference formulas above.
+
+#include <stdint.h>
+#include <stdio.h>
+
+// ============================================
+// BMP280 integer compensation
+// ============================================
+struct Bmp280Calibration {
+    uint16_t T1;
+    int16_t T2, T3;
+    uint16_t P1;
+    int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+
+    // Parses the 24 calibration bytes starting at register 0x88 (little-endian words)
+    void parse(const uint8_t* raw) {
+        T1 = (uint16_t)(raw[0] | (raw[1] << 8));
+        T2 = (int16_t)(raw[2] | (raw[3] << 8));
+        T3 = (int16_t)(raw[4] | (raw[5] << 8));
+        P1 = (uint16_t)(raw[6] | (raw[7] << 8));
+        P2 = (int16_t)(raw[8] | (raw[9] << 8));
+        P3 = (int16_t)(raw[10] | (raw[11] << 8));
+        P4 = (int16_t)(raw[12] | (raw[13] << 8));
+        P5 = (int16_t)(raw[14] | (raw[15] << 8));
+        P6 = (int16_t)(raw[16] | (raw[17] << 8));
+        P7 = (int16_t)(raw[18] | (raw[19] << 8));
+        P8 = (int16_t)(raw[20] | (raw[21] << 8));
+        P9 = (int16_t)(raw[22] | (raw[23] << 8));
+    }
+};
+
+// Returns t_fine (needed by pressure compensation); temperature = (t_fine * 5 + 128) >> 8 in 0.01 °C
+inline int32_t bmp280TFine(const Bmp280Calibration& cal, int32_t adcT) {
+    int32_t var1 = ((((adcT >> 3) - ((int32_t)cal.T1 << 1))) * ((int32_t)cal.T2)) >> 11;
+    int32_t var2 = (((((adcT >> 4) - ((int32_t)cal.T1)) * ((adcT >> 4) - ((int32_t)cal.T1))) >> 12) *
+                    ((int32_t)cal.T3)) >> 14;
+    return var1 + var2;
+}
+
+inline int32_t bmp280TemperatureCenti(int32_t tFine) {
+    return (tFine * 5 + 128) >> 8;
+}
+
+// Pressure in Q24.8 Pa (divide by 256 for Pa), 0 if the calibration is invalid
+inline uint32_t bmp280PressureQ8(const Bmp280Calibration& cal, int32_t adcP, int32_t tFine) {
+    int64_t var1 = ((int64_t)tFine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)cal.P6;
+    var2 = var2 + ((var1 * (int64_t)cal.P5) * 131072);  // << 17
+    var2 = var2 + (((int64_t)cal.P4) * 34359738368LL);  // << 35
+    var1 = ((var1 * var1 * (int64_t)cal.P3) >> 8) + ((var1 * (int64_t)cal.P2) * 4096);  // << 12
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)cal.P1) >> 33;
+    if (var1 == 0) {
+        return 0;  // Avoid division by zero
+    }
+    int64_t p = 1048576 - adcP;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)cal.P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)cal.P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)cal.P7) << 4);
+    return (uint32_t)p;
+}
+
+// ============================================
+// Altitude (international barometric formula, p0 = 1013.25 hPa)
+// ============================================
+#define ALTITUDE_LUT_MIN_PA 30000
+#define ALTITUDE_LUT_STEP_PA 512
+
+// Altitude in cm at ALTITUDE_LUT_MIN_PA + i * ALTITUDE_LUT_STEP_PA
+static const int32_t ALTITUDE_LUT_CM[] = {
+    916537, 905195, 894005, 882964, 872067, 861310, 850690, 840202, 829842, 819607,
+    809495, 799501, 789623, 779857, 770201, 760653, 751208, 741866, 732623, 723478,
+    714427, 705470, 696602, 687824, 679132, 670525, 662001, 653558, 645195, 636909,
+    628700, 620566, 612504, 604515, 596595, 588745, 580962, 573246, 565594, 558007,
+    550482, 543019, 535616, 528273, 520987, 513760, 506588, 499472, 492410, 485401,
+    478445, 471541, 464688, 457884, 451130, 444424, 437766, 431154, 424589, 418069,
+    411594, 405163, 398776, 392431, 386128, 379867, 373647, 367466, 361326, 355225,
+    349162, 343138, 337151, 331201, 325287, 319410, 313568, 307761, 301988, 296250,
+    290545, 284874, 279236, 273629, 268055, 262512, 257001, 251520, 246070, 240650,
+    235259, 229898, 224565, 219261, 213986, 208738, 203518, 198325, 193160, 188020,
+    182908, 177821, 172760, 167724, 162714, 157728, 152767, 147831, 142918, 138029,
+    133164, 128322, 123504, 118708, 113934, 109183, 104454, 99747, 95062, 90398,
+    85755, 81134, 76533, 71952, 67392, 62853, 58333, 53833, 49352, 44891,
+    40449, 36027, 31623, 27237, 22871, 18522, 14192, 9879, 5585, 1308,
+    -2951, -7193, -11418, -15626, -19817, -23992, -28149, -32291, -36416, -40524,
+    -44617, -48694, -52756, -56801, -60832, -64847, -68846, -72831,
+};
+static const uint16_t ALTITUDE_LUT_SIZE = sizeof(ALTITUDE_LUT_CM) / sizeof(ALTITUDE_LUT_CM[0]);
+
+// Altitude in cm for a pressure in Pa (clamped to 300-1100 hPa)
+inline int32_t altitudeCm(int32_t pressurePa) {
+    int32_t offset = pressurePa - ALTITUDE_LUT_MIN_PA;
+    if (offset < 0) {
+        offset = 0;
+    }
+    int32_t i = offset / ALTITUDE_LUT_STEP_PA;
+    if (i > ALTITUDE_LUT_SIZE - 2) {
+        i = ALTITUDE_LUT_SIZE - 2;
+        offset = (ALTITUDE_LUT_SIZE - 1) * ALTITUDE_LUT_STEP_PA;
+    }
+    int32_t fraction = offset - i * ALTITUDE_LUT_STEP_PA;
+    return ALTITUDE_LUT_CM[i] + (ALTITUDE_LUT_CM[i + 1] - ALTITUDE_LUT_CM[i]) * fraction / ALTITUDE_LUT_STEP_PA;
+}
+
+// ============================================
+// Saturation vapour pressure / dew point (Magnus, over water)
+// ============================================
+#define VAPOR_LUT_MIN_C -45
+
+// Saturation vapour pressure in 0.01 Pa at VAPOR_LUT_MIN_C + i °C
+static const int32_t VAPOR_LUT_CENTIPA[] = {
+    1117, 1245, 1387, 1542, 1714, 1902, 2109, 2336, 2586, 2858,
+    3157, 3484, 3840, 4230, 4654, 5117, 5620, 6168, 6764, 7410,
+    8112, 8872, 9696, 10588, 11553, 12597, 13723, 14939, 16251, 17665,
+    19187, 20826, 22589, 24483, 26518, 28703, 31047, 33559, 36251, 39134,
+    42218, 45517, 49043, 52809, 56830, 61120, 65695, 70570, 75763, 81292,
+    87174, 93430, 100079, 107143, 114643, 122603, 131046, 139998, 149483, 159531,
+    170167, 181423, 193327, 205913, 219212, 233260, 248090, 263742, 280251, 297659,
+    316006, 335334, 355689, 377115, 399660, 423372, 448303, 474505, 502031, 530939,
+    561284, 593128, 626531, 661558, 698274, 736746, 777044, 819241, 863409, 909627,
+    957971, 1008523, 1061367, 1116588, 1174274, 1234516, 1297407, 1363042, 1431521, 1502945,
+    1577416, 1655043, 1735933, 1820201, 1907960, 1999329, 2094429, 2193384, 2296322, 2403374,
+    2514671, 2630353, 2750558, 2875431, 3005117, 3139768, 3279536, 3424580, 3575059, 3731139,
+    3892987, 4060774, 4234677, 4414874, 4601548, 4794885, 4995078, 5202319, 5416808, 5638748,
+    5868344, 6105808, 6351354, 6605202, 6867574, 7138699,
+};
+static const uint16_t VAPOR_LUT_SIZE = sizeof(VAPOR_LUT_CENTIPA) / sizeof(VAPOR_LUT_CENTIPA[0]);
+
+// Saturation vapour pressure in 0.01 Pa for a temperature in 0.01 °C (clamped to -45..90 °C)
+inline int32_t saturationVaporPressure(int32_t temperatureCenti) {
+    int32_t offset = temperatureCenti - VAPOR_LUT_MIN_C * 100;
+    if (offset < 0) {
+        offset = 0;
+    }
+    int32_t i = offset / 100;
+    if (i > VAPOR_LUT_SIZE - 2) {
+        i = VAPOR_LUT_SIZE - 2;
+        offset = (VAPOR_LUT_SIZE - 1) * 100;
+    }
+    int32_t fraction = offset - i * 100;
+    return VAPOR_LUT_CENTIPA[i] + (VAPOR_LUT_CENTIPA[i + 1] - VAPOR_LUT_CENTIPA[i]) * fraction / 100;
+}
+
+// Temperature in 0.01 °C at which the saturation vapour pressure equals e (0.01 Pa)
+inline int32_t vaporPressureToTemperature(int32_t e) {
+    if (e <= VAPOR_LUT_CENTIPA[0]) {
+        return VAPOR_LUT_MIN_C * 100;
+    }
+    uint16_t low = 0;
+    uint16_t high = VAPOR_LUT_SIZE - 1;
+    while (high - low > 1) {
+        uint16_t mid = (low + high) / 2;
+        if (VAPOR_LUT_CENTIPA[mid] <= e) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    int32_t span = VAPOR_LUT_CENTIPA[low + 1] - VAPOR_LUT_CENTIPA[low];
+    return (VAPOR_LUT_MIN_C + low) * 100 + (int32_t)((int64_t)(e - VAPOR_LUT_CENTIPA[low]) * 100 / span);
+}
+
+// Actual vapour pressure in 0.01 Pa from temperature (0.01 °C) and humidity (0.01 %RH)
+inline int32_t vaporPressure(int32_t temperatureCenti, int32_t humidityCenti) {
+    return (int32_t)((int64_t)saturationVaporPressure(temperatureCenti) * humidityCenti / 10000);
+}
+
+// Dew point in 0.01 °C from temperature (0.01 °C) and humidity (0.01 %RH)
+inline int32_t dewPointCenti(int32_t temperatureCenti, int32_t humidityCenti) {
+    return vaporPressureToTemperature(vaporPressure(temperatureCenti, humidityCenti));
+}
+
+// Absolute humidity in 0.01 g/m³ from temperature (0.01 °C) and humidity (0.01 %RH)
+inline int32_t absoluteHumidityCenti(int32_t temperatureCenti, int32_t humidityCenti) {
+    // 1000 g/kg / Rv (461.5 J/(kg K)) = 2.1668 g K / (m³ Pa)
+    int64_t kelvinCenti = (int64_t)temperatureCenti + 27315;
+    return (int32_t)((int64_t)vaporPressure(temperatureCenti, humidityCenti) * 21668 / (100 * kelvinCenti));
+}
+
+// Integer square root (floor), one result bit per iteration
+inline uint32_t isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    for (uint64_t bit = 1ULL << 62; bit != 0; bit >>= 2) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return (uint32_t)root;
+}
+
+// Heat index ("feels like") in 0.01 °C from temperature (0.01 °C) and humidity (0.01 %RH)
+inline int32_t heatIndexCenti(int32_t temperatureCenti, int32_t humidityCenti) {
+    int64_t t = ((int64_t)temperatureCenti * 18 + (temperatureCenti >= 0 ? 5 : -5)) / 10 + 3200;  // 0.01 °F
+    int64_t r = humidityCenti;                              // 0.01 %RH
+
+    // Steadman's simple formula decides whether the regression applies
+    int64_t heat = (t + 6100 + (t - 6800) * 12 / 10 + r * 94 / 1000) / 2;
+    if ((heat + t) / 2 >= 8000) {
+        // Rothfusz regression; sum is in 1e-8 of 0.01 °F
+        int64_t sum = -423790000000LL + 204901523LL * t + 1014333127LL * r - 22475541LL * (t * r / 100) -
+                      683783LL * (t * t / 100) - 5481717LL * (r * r / 100) + 122874LL * (t * t * r / 10000) +
+                      85282LL * (t * r * r / 10000) - 199LL * (t * t * r * r / 1000000);
+        heat = sum / 100000000;
+
+        if (r < 1300 && t >= 8000 && t <= 11200) {
+            // Dry: - (13 - RH) / 4 * sqrt((17 - |T - 95|) / 17)
+            int64_t distance = t > 9500 ? t - 9500 : 9500 - t;
+            uint32_t root = isqrt64((uint64_t)((1700 - distance) * 1000000 / 1700));  // x 1000
+            heat -= (1300 - r) * root / 4000;
+        } else if (r > 8500 && t >= 8000 && t <= 8700) {
+            // Humid: + (RH - 85) / 10 * (87 - T) / 5
+            heat += (r - 8500) * (8700 - t) / 5000;
+        }
+    }
+    int64_t celsius = (heat - 3200) * 5;
+    return (int32_t)((celsius + (celsius >= 0 ? 4 : -4)) / 9);
+}
+
+// ============================================
+// Formatting
+// ============================================
+// Longest formatFixed() output plus its terminator: "-214748.3648"
+#define FIXED_TEXT_SIZE 13
+
+// Writes a fixed-point value stored with `scale` decimals using `decimals`
+// decimals (decimals <= scale <= 4), rounding half away from zero.
+// Returns the number of characters written (like snprintf).
+inline int formatFixed(char* out, size_t size, int32_t value, uint8_t scale, uint8_t decimals) {
+    static const uint32_t POW10[] = {1, 10, 100, 1000, 10000};
+    uint32_t divisor = POW10[scale - decimals];
+    // Negated in uint32_t: -INT32_MIN does not fit an int32_t
+    uint32_t absolute = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    uint32_t magnitude = (absolute + divisor / 2) / divisor;
+    bool negative = value < 0 && magnitude != 0;
+
+    // Digits are written backwards from the end, so the length is known
+    // without snprintf's worst case for each conversion
+    char text[FIXED_TEXT_SIZE];
+    char* p = text + sizeof(text);
+    *--p = '\0';
+    for (uint8_t d = 0; d < decimals; d++) {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    if (decimals > 0) {
+        *--p = '.';
+    }
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (negative) {
+        *--p = '-';
+    }
+    return snprintf(out, size, "%s", p);
+}
+
+#endif // ENV_MATH_H
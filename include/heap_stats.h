@@ -0,0 +1,60 @@
+#ifndef HEAP_STATS_H
+#define HEAP_STATS_H
+
+// Heap Health
+// ===========
+// Fragmentation tracking for long uptimes: free heap alone hides the problem
+// of many small Strings left scattered between long-lived blocks, so the
+// largest free block is tracked too. Fragmentation is 1 - largest / free in
+// per mille: 0 means every free byte is in one block; 900 means the largest
+// allocation that can succeed is a tenth of what is free.
+//
+// HeapWatermarks is sampled once per update cycle and keeps the worst values
+// since boot (the allocator itself only keeps the minimum free heap).
+//
+// RouteAllocations counts heap calls made while one route handler runs. It is
+// filled by the malloc wrappers of the instrumented build (HEAP_ACCOUNTING,
+// see the esp32c3-heap environment in platformio.ini), which link with
+// -Wl,--wrap=malloc,--wrap=free,... so every allocation - Arduino String,
+// new, the WebServer's own buffers - goes through them.
+
+#include <stdint.h>
+
+// 1 - largest / free, per mille
+inline uint16_t heapFragmentation(uint32_t freeBytes, uint32_t largestBlock) {
+    if (freeBytes == 0 || largestBlock >= freeBytes) {
+        return 0;
+    }
+    return (uint16_t)(1000 - (uint64_t)largestBlock * 1000 / freeBytes);
+}
+
+struct HeapWatermarks {
+    uint32_t lowestLargestBlock = UINT32_MAX;
+    uint16_t worstFragmentation = 0;  // Per mille
+    uint32_t samples = 0;
+
+    void sample(uint32_t freeBytes, uint32_t largestBlock) {
+        if (largestBlock < lowestLargestBlock) {
+            lowestLargestBlock = largestBlock;
+        }
+        uint16_t fragmentation = heapFragmentation(freeBytes, largestBlock);
+        if (fragmentation > worstFragmentation) {
+            worstFragmentation = fragmentation;
+        }
+        samples++;
+    }
+};
+
+struct RouteAllocations {
+    uint32_t allocations = 0;     // malloc / calloc / new, and realloc that moved or grew
+    uint32_t frees = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t bytesFreed = 0;
+    uint32_t requests = 0;
+    uint32_t peakRequestBytes = 0;  // Most bytes allocated by a single request
+
+    // Allocated but not freed by the end of the handler (caches, leaks)
+    int64_t retainedBytes() const { return (int64_t)bytesAllocated - (int64_t)bytesFreed; }
+};
+
+#endif // HEAP_STATS_H
@@ -0,0 +1,129 @@
+#ifndef HEARTBEAT_REGISTRY_H
+#define HEARTBEAT_REGISTRY_H
+
+// Heartbeat Registry
+// ==================
+// Per-subsystem software watchdog. Each subsystem registers the longest it
+// may go without checking in and calls beat() whenever it completes a pass:
+//
+//   heartbeats.add(HEARTBEAT_MQTT, HEARTBEAT_PUSH_MS, millis());
+//   ...
+//   PERF_TIME(PERF_MQTT, serviceMqtt());
+//   heartbeats.beat(HEARTBEAT_MQTT, millis());
+//
+// The supervisor task calls check() for every heartbeat once a second. A
+// heartbeat older than its period is STALLED: its stall is counted and a
+// restart is requested, which the owner picks up with takeRestart() once
+// control comes back to it (a blocked call timed out, say) and restarts
+// just that subsystem. If the heartbeat is still missing one more period
+// later, check() answers FAILED and the supervisor resets the device.
+//
+// A suspended heartbeat (OTA upload blocking the loop on purpose) is never
+// stalled; resume() restarts its clock.
+//
+// beat() and takeRestart() run in the owning task, check() in the
+// supervisor: the shared fields are single aligned words.
+
+#include <stdint.h>
+
+enum HeartbeatId : uint8_t {
+    HEARTBEAT_SENSORS,  // sensorTask(), every cycle
+    HEARTBEAT_WEB,      // server.handleClient() and the event stream; long handlers beat while streaming
+    HEARTBEAT_WIFI,     // Connection tracking, roaming and the update cycle
+    HEARTBEAT_OTA,      // ArduinoOTA.handle(), and every progress callback during an upload
+    HEARTBEAT_MQTT,
+    HEARTBEAT_INFLUX,
+    HEARTBEAT_COUNT
+};
+
+static constexpr const char* HEARTBEAT_NAMES[HEARTBEAT_COUNT] = {
+    "sensors", "web", "wifi", "ota", "mqtt", "influx",
+};
+
+inline const char* heartbeatName(uint8_t id) {
+    return id < HEARTBEAT_COUNT ? HEARTBEAT_NAMES[id] : "none";
+}
+
+enum HeartbeatVerdict : uint8_t {
+    HEARTBEAT_OK,
+    HEARTBEAT_STALLED,     // Just went overdue: restart requested
+    HEARTBEAT_RESTARTING,  // Still overdue, within the grace period
+    HEARTBEAT_RECOVERED,   // Beating again after a stall
+    HEARTBEAT_FAILED       // Overdue for two periods: reset the device
+};
+
+struct Heartbeat {
+    uint32_t periodMs = 0;  // 0: not registered
+    volatile uint32_t lastBeat = 0;
+    volatile bool suspended = false;
+    volatile bool restartRequested = false;
+    bool stalled = false;
+    uint32_t stalledAt = 0;
+    uint32_t stalls = 0;
+    uint32_t restarts = 0;
+};
+
+class HeartbeatRegistry {
+public:
+    void add(uint8_t id, uint32_t periodMs, uint32_t now) {
+        beats[id].periodMs = periodMs;
+        beats[id].lastBeat = now;
+    }
+
+    void beat(uint8_t id, uint32_t now) { beats[id].lastBeat = now; }
+
+    void suspend(uint8_t id) { beats[id].suspended = true; }
+
+    void resume(uint8_t id, uint32_t now) {
+        beats[id].lastBeat = now;
+        beats[id].suspended = false;
+    }
+
+    // Owner side: true once per requested restart
+    bool takeRestart(uint8_t id) {
+        if (!beats[id].restartRequested) {
+            return false;
+        }
+        beats[id].restartRequested = false;
+        beats[id].restarts++;
+        return true;
+    }
+
+    // Supervisor side. `waiting`: overdue only because its task is blocked in
+    // another subsystem, which gets the blame instead
+    HeartbeatVerdict check(uint8_t id, uint32_t now, bool waiting = false) {
+        Heartbeat& heartbeat = beats[id];
+        if (heartbeat.periodMs == 0) {
+            return HEARTBEAT_OK;
+        }
+        bool overdue = !heartbeat.suspended && !waiting && age(id, now) > heartbeat.periodMs;
+        if (!overdue) {
+            if (heartbeat.stalled && age(id, now) <= heartbeat.periodMs) {
+                heartbeat.stalled = false;
+                return HEARTBEAT_RECOVERED;
+            }
+            return heartbeat.stalled ? HEARTBEAT_RESTARTING : HEARTBEAT_OK;
+        }
+        if (!heartbeat.stalled) {
+            heartbeat.stalled = true;
+            heartbeat.stalledAt = now;
+            heartbeat.stalls++;
+            heartbeat.restartRequested = true;
+            return HEARTBEAT_STALLED;
+        }
+        return now - heartbeat.stalledAt > heartbeat.periodMs ? HEARTBEAT_FAILED : HEARTBEAT_RESTARTING;
+    }
+
+    // The owner may have beaten after the supervisor read millis()
+    uint32_t age(uint8_t id, uint32_t now) const {
+        int32_t elapsed = (int32_t)(now - beats[id].lastBeat);
+        return elapsed > 0 ? (uint32_t)elapsed : 0;
+    }
+
+    const Heartbeat& get(uint8_t id) const { return beats[id]; }
+
+private:
+    Heartbeat beats[HEARTBEAT_COUNT];
+};
+
+#endif // HEARTBEAT_REGISTRY_H
@@ -0,0 +1,146 @@
+#ifndef HISTORY_EXPORT_H
+#define HISTORY_EXPORT_H
+
+// History Export Formatter
+// ========================
+// Decodes compressed sensor blocks (sensor_codec.h) and formats their records
+// as CSV or NDJSON into a fixed buffer, handing each full buffer to a sink
+// (the web server's chunked sendContent on the board). Memory use is the
+// buffer plus one block being decoded, however long the export.
+//
+// CSV:    time,boot,temperature,pressure,altitude,humidity,co2,dewpoint
+// NDJSON: {"time":1700000000,"temperature":21.5,"pressure":1013.2,...}
+//
+// `time` is Unix seconds, or seconds since boot for blocks recorded before
+// the clock synced; those rows carry the boot number in `boot`. A time range
+// only matches Unix-timed records.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "sensor_snapshot.h"
+#include "sensor_codec.h"
+#include "env_math.h"
+
+#define EXPORT_BUFFER_SIZE 1536
+
+enum ExportFormat : uint8_t {
+    EXPORT_CSV,
+    EXPORT_NDJSON
+};
+
+// Sink: callable as sink(const char* data, size_t length)
+template <typename Sink>
+class HistoryExporter {
+public:
+    // from/to: Unix seconds, [from, to); both 0 = everything
+    HistoryExporter(ExportFormat exportFormat, uint32_t fromTime, uint32_t toTime, Sink output)
+        : format(exportFormat), from(fromTime), to(toTime), sink(output) {}
+
+    void begin() {
+        if (format == EXPORT_CSV) {
+            append("time,boot");
+            for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+                append(",");
+                append(CHANNEL_INFO[c].name);
+            }
+            append("\n");
+        }
+    }
+
+    // Formats every record of the block that falls in the range
+    void addBlock(const SensorBlock& block) {
+        bool unixTime = block.header.flags & SENSOR_BLOCK_UNIX_TIME;
+        if (isFiltered()) {
+            if (!unixTime || block.header.lastTime < from || (to != 0 && block.header.firstTime >= to)) {
+                return;  // Whole block outside the range
+            }
+        }
+
+        SensorBlockDecoder decoder(block);
+        uint32_t timestamp;
+        SensorSnapshot record;
+        while (decoder.next(timestamp, record)) {
+            if (isFiltered() && (timestamp < from || (to != 0 && timestamp >= to))) {
+                continue;
+            }
+            writeRecord(timestamp, unixTime ? 0 : block.header.bootCount, record);
+        }
+    }
+
+    // Sends whatever is left in the buffer
+    void finish() {
+        flush();
+    }
+
+    uint32_t getRecords() const { return records; }
+    uint32_t getBytes() const { return bytes; }
+
+private:
+    bool isFiltered() const { return from != 0 || to != 0; }
+
+    void writeRecord(uint32_t timestamp, uint16_t boot, const SensorSnapshot& record) {
+        char line[200];
+        size_t length = 0;
+        char value[FIXED_TEXT_SIZE];
+
+        if (format == EXPORT_CSV) {
+            length += snprintf(line + length, sizeof(line) - length, "%lu,", (unsigned long)timestamp);
+            if (boot != 0) {
+                length += snprintf(line + length, sizeof(line) - length, "%u", boot);
+            }
+            for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+                value[0] = '\0';
+                if (record.has((SensorChannel)c)) {
+                    formatFixed(value, sizeof(value), record.values[c], CHANNEL_INFO[c].scale, CHANNEL_INFO[c].decimals);
+                }
+                length += snprintf(line + length, sizeof(line) - length, ",%s", value);
+            }
+            length += snprintf(line + length, sizeof(line) - length, "\n");
+        } else {
+            length += snprintf(line + length, sizeof(line) - length, "{\"time\":%lu", (unsigned long)timestamp);
+            if (boot != 0) {
+                length += snprintf(line + length, sizeof(line) - length, ",\"boot\":%u", boot);
+            }
+            for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+                if (record.has((SensorChannel)c)) {
+                    formatFixed(value, sizeof(value), record.values[c], CHANNEL_INFO[c].scale, CHANNEL_INFO[c].decimals);
+                    length += snprintf(line + length, sizeof(line) - length, ",\"%s\":%s", CHANNEL_INFO[c].name, value);
+                }
+            }
+            length += snprintf(line + length, sizeof(line) - length, "}\n");
+        }
+
+        append(line, length);
+        records++;
+    }
+
+    void append(const char* text) { append(text, strlen(text)); }
+
+    void append(const char* text, size_t length) {
+        if (used + length > sizeof(buffer)) {
+            flush();
+        }
+        memcpy(buffer + used, text, length);
+        used += length;
+    }
+
+    void flush() {
+        if (used > 0) {
+            sink(buffer, used);
+            bytes += used;
+            used = 0;
+        }
+    }
+
+    ExportFormat format;
+    uint32_t from;
+    uint32_t to;
+    Sink sink;
+    char buffer[EXPORT_BUFFER_SIZE];
+    size_t used = 0;
+    uint32_t records = 0;
+    uint32_t bytes = 0;
+};
+
+#endif // HISTORY_EXPORT_H
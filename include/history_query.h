@@ -0,0 +1,153 @@
+#ifndef HISTORY_QUERY_H
+#define HISTORY_QUERY_H
+
+// History Query Helpers
+// =====================
+// Aggregation functions for /query. min/max/avg/count come straight from
+// HistoryAggregate (raw ring or rollup tiers); slope and percentile need the
+// accumulators below, both fixed-size so a query's memory doesn't depend on
+// how many records it covers.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum QueryFunction : uint8_t {
+    QUERY_MIN,
+    QUERY_MAX,
+    QUERY_AVG,
+    QUERY_COUNT,
+    QUERY_SLOPE,       // Least-squares slope, channel units per hour
+    QUERY_PERCENTILE,  // Approximate, see QuantileSketch
+    QUERY_FUNCTION_COUNT
+};
+
+static constexpr const char* QUERY_FUNCTION_NAMES[QUERY_FUNCTION_COUNT] = {
+    "min", "max", "avg", "count", "slope", "percentile"
+};
+
+inline bool queryFunctionFromName(const char* name, QueryFunction& function) {
+    for (uint8_t f = 0; f < QUERY_FUNCTION_COUNT; f++) {
+        if (strcmp(name, QUERY_FUNCTION_NAMES[f]) == 0) {
+            function = (QueryFunction)f;
+            return true;
+        }
+    }
+    return false;
+}
+
+// A positive whole number of seconds up to `maximum` (seconds=, step=);
+// false for anything else, including negative, empty and trailing text
+inline bool queryParseSeconds(const char* text, uint32_t maximum, uint32_t& seconds) {
+    char* end = NULL;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0 || (unsigned long)value > maximum) {
+        return false;
+    }
+    seconds = (uint32_t)value;
+    return true;
+}
+
+// Groups of `step` seconds starting at from, from + step, ... up to `now`
+// inclusive: what /query emits. In 64 bits so no combination wraps.
+inline uint32_t queryGroupCount(uint32_t from, uint32_t now, uint32_t step) {
+    if (step == 0 || now < from) {
+        return 0;
+    }
+    uint64_t groups = ((uint64_t)now - from) / step + 1;
+    return groups > UINT32_MAX ? UINT32_MAX : (uint32_t)groups;
+}
+
+// Least-squares line through (seconds, value) points, in integer sums.
+// x is relative to the first point so the sums stay well inside int64 for a
+// raw window (thousands of 5 s records) or a few hundred rollup buckets.
+struct LinearFit {
+    uint32_t n = 0;
+    uint32_t origin = 0;
+    int64_t sumX = 0;
+    int64_t sumY = 0;
+    int64_t sumXX = 0;
+    int64_t sumXY = 0;
+
+    void add(uint32_t time, int32_t value) {
+        if (n == 0) {
+            origin = time;
+        }
+        int64_t x = (int64_t)(time - origin);
+        n++;
+        sumX += x;
+        sumY += value;
+        sumXX += x * x;
+        sumXY += x * value;
+    }
+
+    // Fixed-point value units per hour; false with fewer than 2 distinct times
+    bool slopePerHour(int32_t& slope) const {
+        double denominator = (double)n * sumXX - (double)sumX * sumX;
+        if (n < 2 || denominator <= 0) {
+            return false;
+        }
+        double perSecond = ((double)n * sumXY - (double)sumX * sumY) / denominator;
+        slope = (int32_t)(perSecond * 3600.0 + (perSecond >= 0 ? 0.5 : -0.5));
+        return true;
+    }
+};
+
+// Fixed-bin quantile sketch: QUANTILE_BINS equal bins over a known [low, high]
+// (the range's min/max, which a first pass or the rollups provide). A
+// percentile is resolved to its bin's midpoint, so the error is within about
+// one bin width: (high - low) / QUANTILE_BINS.
+#define QUANTILE_BINS 256
+
+struct QuantileSketch {
+    int32_t low = 0;
+    int32_t high = 0;
+    uint32_t count = 0;
+    uint16_t bins[QUANTILE_BINS] = {};  // Saturates at 65535 per bin
+
+    void reset(int32_t minimum, int32_t maximum) {
+        low = minimum;
+        high = maximum;
+        count = 0;
+        memset(bins, 0, sizeof(bins));
+    }
+
+    void add(int32_t value) {
+        uint16_t& bin = bins[binFor(value)];
+        if (bin < UINT16_MAX) {
+            bin++;
+        }
+        count++;
+    }
+
+    int32_t percentile(uint8_t p) const {
+        if (count == 0 || high <= low) {
+            return low;
+        }
+        uint32_t target = (uint32_t)(((uint64_t)count * p + 99) / 100);
+        uint32_t seen = 0;
+        for (uint16_t i = 0; i < QUANTILE_BINS; i++) {
+            seen += bins[i];
+            if (seen >= target) {
+                return low + (int32_t)(((int64_t)(high - low) * (2 * i + 1)) / (2 * QUANTILE_BINS));
+            }
+        }
+        return high;
+    }
+
+    // Worst-case error of percentile(), in value units
+    int32_t resolution() const { return (high - low) / QUANTILE_BINS + 1; }
+
+private:
+    uint16_t binFor(int32_t value) const {
+        if (high <= low || value <= low) {
+            return 0;
+        }
+        if (value >= high) {
+            return QUANTILE_BINS - 1;
+        }
+        return (uint16_t)(((int64_t)(value - low) * QUANTILE_BINS) / ((int64_t)high - low + 1));
+    }
+};
+
+#endif // HISTORY_QUERY_H
@@ -0,0 +1,292 @@
+#ifndef I2C_MANAGER_H
+#define I2C_MANAGER_H
+
+// I2C Bus Manager
+// All I2C traffic goes through this class so that every transaction is
+// serialized, timed and accounted per device address:
+//
+// - A recursive mutex serializes the sensor task, OTA shutdown and any other
+//   bus user (Wire itself is not safe to end() mid-transaction)
+// - Latency histograms and error counters are kept per device address
+// - A stuck bus (a slave holding SDA low after a reset mid-byte) is detected
+//   and released with the standard SCL clock-out sequence (up to 9 clocks
+//   followed by a STOP condition), without rebooting
+//
+// The register-level drivers (sensor_drivers.h) use readRegisters(),
+// writeBytes() and read(), each timed as one transaction.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "latency_histogram.h"
+
+#define I2C_MAX_DEVICES 8
+#define I2C_LOCK_TIMEOUT_MS 200  // Give up on the bus rather than stall a task
+#define I2C_MAX_CONSECUTIVE_ERRORS 3  // Errors before a device is considered detached
+
+struct I2CDeviceStats {
+    uint8_t address = 0;
+    const char* name = "";
+    bool attached = false;
+    uint32_t transactions = 0;
+    uint32_t errors = 0;
+    uint32_t consecutiveErrors = 0;
+    uint32_t attachCount = 0;  // Successful (re)attaches, including boot
+    LatencyHistogram latency;
+};
+
+class I2CManager {
+public:
+    void begin(int sda, int scl, uint16_t timeoutMs) {
+        if (mutex == NULL) {
+            mutex = xSemaphoreCreateRecursiveMutex();
+        }
+        sdaPin = sda;
+        sclPin = scl;
+        timeout = timeoutMs;
+        Wire.begin(sdaPin, sclPin);
+        Wire.setTimeOut(timeout);
+        running = true;
+    }
+
+    // Stops the bus after any in-flight transaction completes (used before OTA)
+    void end() {
+        if (!lock()) {
+            return;
+        }
+        Wire.end();
+        running = false;
+        unlock();
+    }
+
+    bool isRunning() const { return running; }
+
+    bool lock() {
+        return mutex != NULL && xSemaphoreTakeRecursive(mutex, pdMS_TO_TICKS(I2C_LOCK_TIMEOUT_MS)) == pdTRUE;
+    }
+
+    void unlock() {
+        xSemaphoreGiveRecursive(mutex);
+    }
+
+    // Registers a device so it shows up in the stats (name is a string literal)
+    I2CDeviceStats* registerDevice(uint8_t address, const char* name) {
+        I2CDeviceStats* stats = find(address);
+        if (stats == NULL && deviceCount < I2C_MAX_DEVICES) {
+            stats = &devices[deviceCount++];
+            stats->address = address;
+        }
+        if (stats != NULL) {
+            stats->name = name;
+        }
+        return stats;
+    }
+
+    // Marks a device attached/detached (after a successful begin() or too many errors)
+    void setAttached(uint8_t address, bool attached) {
+        I2CDeviceStats* stats = find(address);
+        if (stats == NULL) {
+            return;
+        }
+        if (attached && !stats->attached) {
+            stats->attachCount++;
+        }
+        stats->attached = attached;
+        stats->consecutiveErrors = 0;
+    }
+
+    // Address-only transaction: true if the device ACKs
+    bool probe(uint8_t address) {
+        if (!lock()) {
+            return false;
+        }
+        bool ok = false;
+        if (running) {
+            Wire.beginTransmission(address);
+            ok = (Wire.endTransmission() == 0);
+        }
+        unlock();
+        return ok;
+    }
+
+    bool readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer, size_t length) {
+        if (!lock()) {
+            return false;
+        }
+        bool ok = false;
+        unsigned long start = micros();
+        if (running) {
+            Wire.beginTransmission(address);
+            Wire.write(reg);
+            ok = (Wire.endTransmission(false) == 0) && readInto(address, buffer, length);
+        }
+        record(address, ok, micros() - start);
+        unlock();
+        return ok;
+    }
+
+    bool writeBytes(uint8_t address, const uint8_t* data, size_t length) {
+        if (!lock()) {
+            return false;
+        }
+        bool ok = false;
+        unsigned long start = micros();
+        if (running) {
+            Wire.beginTransmission(address);
+            Wire.write(data, length);
+            ok = (Wire.endTransmission() == 0);
+        }
+        record(address, ok, micros() - start);
+        unlock();
+        return ok;
+    }
+
+    bool read(uint8_t address, uint8_t* buffer, size_t length) {
+        if (!lock()) {
+            return false;
+        }
+        bool ok = false;
+        unsigned long start = micros();
+        if (running) {
+            ok = readInto(address, buffer, length);
+        }
+        record(address, ok, micros() - start);
+        unlock();
+        return ok;
+    }
+
+    // A released bus idles with both lines pulled high
+    bool isBusStuck() {
+        if (!lock()) {
+            return false;
+        }
+        bool stuck = running && (digitalRead(sdaPin) == LOW || digitalRead(sclPin) == LOW);
+        unlock();
+        return stuck;
+    }
+
+    // Checks the bus and runs the clock-out recovery if a slave holds it.
+    // Returns true if the bus is usable afterwards.
+    bool checkAndRecover() {
+        if (!isBusStuck()) {
+            return true;
+        }
+        stuckDetections++;
+        return recoverBus();
+    }
+
+    // SCL clock-out sequence: a slave interrupted mid-byte keeps driving SDA
+    // low until it has clocked out the rest of its byte. Pulse SCL up to 9
+    // times until SDA is released, then issue a STOP and restart the driver.
+    bool recoverBus() {
+        if (!lock()) {
+            return false;
+        }
+        Wire.end();
+
+        pinMode(sdaPin, INPUT_PULLUP);
+        pinMode(sclPin, OUTPUT_OPEN_DRAIN);
+        digitalWrite(sclPin, HIGH);
+        delayMicroseconds(5);
+
+        for (int i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++) {
+            digitalWrite(sclPin, LOW);
+            delayMicroseconds(5);  // ~100 kHz
+            digitalWrite(sclPin, HIGH);
+            delayMicroseconds(5);
+        }
+
+        // STOP condition: SDA rising while SCL is high
+        pinMode(sdaPin, OUTPUT_OPEN_DRAIN);
+        digitalWrite(sdaPin, LOW);
+        delayMicroseconds(5);
+        digitalWrite(sclPin, HIGH);
+        delayMicroseconds(5);
+        digitalWrite(sdaPin, HIGH);
+        delayMicroseconds(5);
+
+        pinMode(sdaPin, INPUT_PULLUP);
+        bool released = (digitalRead(sdaPin) == HIGH);
+
+        Wire.begin(sdaPin, sclPin);
+        Wire.setTimeOut(timeout);
+        running = true;
+
+        recoveries++;
+        if (!released) {
+            failedRecoveries++;
+        }
+        unlock();
+        return released;
+    }
+
+    I2CDeviceStats* find(uint8_t address) {
+        for (uint8_t i = 0; i < deviceCount; i++) {
+            if (devices[i].address == address) {
+                return &devices[i];
+            }
+        }
+        return NULL;
+    }
+
+    // Stats are written under the bus lock by the sensor task; readers take
+    // unlocked copies (counters are 32-bit, so at worst a value is one cycle old)
+    uint8_t getDeviceCount() const { return deviceCount; }
+    const I2CDeviceStats& getDevice(uint8_t index) const { return devices[index]; }
+    uint32_t getRecoveries() const { return recoveries; }
+    uint32_t getFailedRecoveries() const { return failedRecoveries; }
+    uint32_t getStuckDetections() const { return stuckDetections; }
+
+    uint32_t getTotalErrors() const {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < deviceCount; i++) {
+            total += devices[i].errors;
+        }
+        return total;
+    }
+
+private:
+    bool readInto(uint8_t address, uint8_t* buffer, size_t length) {
+        if (Wire.requestFrom(address, length) != length) {
+            return false;
+        }
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = Wire.read();
+        }
+        return true;
+    }
+
+    void record(uint8_t address, bool ok, uint32_t elapsedUs) {
+        I2CDeviceStats* stats = find(address);
+        if (stats == NULL) {
+            stats = registerDevice(address, "unknown");
+            if (stats == NULL) {
+                return;
+            }
+        }
+        stats->transactions++;
+        stats->latency.record(elapsedUs);
+        if (ok) {
+            stats->consecutiveErrors = 0;
+        } else {
+            stats->errors++;
+            stats->consecutiveErrors++;
+        }
+    }
+
+    SemaphoreHandle_t mutex = NULL;
+    int sdaPin = -1;
+    int sclPin = -1;
+    uint16_t timeout = 50;
+    volatile bool running = false;
+
+    I2CDeviceStats devices[I2C_MAX_DEVICES];
+    uint8_t deviceCount = 0;
+
+    uint32_t recoveries = 0;
+    uint32_t failedRecoveries = 0;
+    uint32_t stuckDetections = 0;
+};
+
+#endif // I2C_MANAGER_H
@@ -755,6 +755,18 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                             <span class="metric-label">Feels Like</span>
                             <span class="metric-value" id="heatIndex">-</span>
                         </div>
+                        <div class="metric-row" id="dewPointRow">
+                            <span class="metric-label">Dew Point</span>
+                            <span class="metric-value" id="dewPoint">-</span>
+                        </div>
+                        <div class="metric-row" id="absoluteHumidityRow">
+                            <span class="metric-label">Absolute Humidity</span>
+                            <span class="metric-value" id="absoluteHumidity">-</span>
+                        </div>
+                        <div class="metric-row" id="pressureTrendRow">
+                            <span class="metric-label">Pressure Trend</span>
+                            <span class="metric-value" id="pressureTrend">-</span>
+                        </div>
                         <div class="metric-row" id="altitudeRow">
                             <span class="metric-label">Altitude</span>
                             <span class="metric-value" id="sensorAltitude">-</span>
@@ -785,6 +797,10 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                         <span class="metric-label">Free Heap</span>
                         <span class="metric-value" id="freeHeap">Loading...</span>
                     </div>
+                    <div class="metric-row">
+                        <span class="metric-label">Largest Block</span>
+                        <span class="metric-value" id="largestFreeBlock">Loading...</span>
+                    </div>
                 </div>
 
                 <div class="card">
@@ -932,6 +948,39 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                     <div id="deviceNameStatus" style="margin-top: 12px; padding: 12px; border-radius: 8px; font-size: 13px; display: none;"></div>
                 </div>
             </div>
+
+            <div class="card">
+                <div class="card-header">
+                    <div class="card-icon">
+                        <i data-lucide="send" style="width:20px;height:20px"></i>
+                    </div>
+                    <h3 class="card-title">MQTT</h3>
+                </div>
+                <div class="metric-row">
+                    <span class="metric-label">Status</span>
+                    <span class="metric-value" id="mqttState">-</span>
+                </div>
+                <div class="metric-row">
+                    <span class="metric-label">Topic</span>
+                    <span class="metric-value" id="mqttTopic">-</span>
+                </div>
+                <div style="padding: 16px 0;">
+                    <p style="font-size: 14px; color: #6b7280; margin-bottom: 12px;">
+                        Publish readings to an MQTT broker. Leave the host empty to disable.
+                    </p>
+                    <input type="text" id="mqttHostInput" placeholder="Broker host (e.g., 192.168.1.10)" maxlength="64" style="margin-bottom: 12px;">
+                    <input type="number" id="mqttPortInput" placeholder="Port" min="1" max="65535" style="margin-bottom: 12px;">
+                    <input type="text" id="mqttUserInput" placeholder="Username (optional)" maxlength="64" style="margin-bottom: 12px;">
+                    <input type="password" id="mqttPasswordInput" placeholder="Password (unchanged if empty)" maxlength="64" style="margin-bottom: 12px;">
+                    <input type="text" id="mqttPrefixInput" placeholder="Topic prefix" maxlength="64" style="margin-bottom: 12px;">
+                    <input type="number" id="mqttBatchInput" placeholder="Readings per message (1-12)" min="1" max="12" style="margin-bottom: 12px;">
+                    <button class="btn" onclick="saveMqttSettings()">
+                        <i data-lucide="save" style="width:16px;height:16px"></i>
+                        Save MQTT Settings
+                    </button>
+                    <div id="mqttStatus" style="margin-top: 12px; padding: 12px; border-radius: 8px; font-size: 13px; display: none;"></div>
+                </div>
+            </div>
         </div>
 
         <div id="ota" class="tab-content">
@@ -1054,6 +1103,8 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                     const totalHeapKB = (data.totalHeap / 1024).toFixed(2);
                     const heapPercent = ((data.freeHeap / data.totalHeap) * 100).toFixed(1);
                     document.getElementById('freeHeap').textContent = freeHeapKB + ' KB (' + heapPercent + '%)';
+                    document.getElementById('largestFreeBlock').textContent =
+                        (data.largestFreeBlock / 1024).toFixed(2) + ' KB (' + data.heapFragmentation.toFixed(1) + '% fragmented)';
 
                     document.getElementById('cpuFreq').textContent = data.cpuFreq + ' MHz';
                     document.getElementById('temperature').textContent = data.temperature.toFixed(1) + ' °C';
@@ -1119,40 +1170,21 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
                             document.getElementById('humidityRow').style.display = 'none';
                         }
 
-                        // Heat Index / Feels Like (calculated from temperature and humidity)
-                        if (ahtConnected && data.sensorTemperature !== undefined && data.ahtHumidity !== undefined) {
-                            const t = data.sensorTemperature;
-                            const rh = data.ahtHumidity;
-
-                            // Calculate heat index using Steadman's formula (simplified)
-                            // This formula works best for temperatures above 27°C (80°F) and humidity above 40%
-                            let heatIndex;
-
-                            if (t >= 27 && rh >= 40) {
-                                // Full heat index formula (Rothfusz regression)
-                                const c1 = -8.78469475556;
-                                const c2 = 1.61139411;
-                                const c3 = 2.33854883889;
-                                const c4 = -0.14611605;
-                                const c5 = -0.012308094;
-                                const c6 = -0.0164248277778;
-                                const c7 = 0.002211732;
-                                const c8 = 0.00072546;
-                                const c9 = -0.000003582;
-
-                                heatIndex = c1 + (c2 * t) + (c3 * rh) + (c4 * t * rh) +
-                                           (c5 * t * t) + (c6 * rh * rh) + (c7 * t * t * rh) +
-                                           (c8 * t * rh * rh) + (c9 * t * t * rh * rh);
-                            } else {
-                                // For lower temperatures, use simple formula or just show temperature
-                                heatIndex = t + (0.5555 * ((6.11 * Math.pow(Math.E, (5417.7530 * ((1/273.16) - (1/(273.15+t)))))) * (rh/100) - 10));
+                        // Derived values are computed on the device (see derived_metrics.h)
+                        // and only present when their inputs are
+                        const derivedRow = (key, row, id, format) => {
+                            const present = data[key] !== undefined;
+                            document.getElementById(row).style.display = present ? 'flex' : 'none';
+                            if (present) {
+                                document.getElementById(id).textContent = format(data[key]);
                             }
-
-                            document.getElementById('heatIndexRow').style.display = 'flex';
-                            document.getElementById('heatIndex').textContent = heatIndex.toFixed(1) + ' °C';
-                        } else {
-                            document.getElementById('heatIndexRow').style.display = 'none';
-                        }
+                        };
+                        derivedRow('heatIndex', 'heatIndexRow', 'heatIndex', v => v.toFixed(1) + ' °C');
+                        derivedRow('dewPoint', 'dewPointRow', 'dewPoint', v => v.toFixed(1) + ' °C');
+                        derivedRow('absoluteHumidity', 'absoluteHumidityRow', 'absoluteHumidity', v => v.toFixed(2) + ' g/m³');
+                        // Tendency over 3 hours: more than ±1 hPa is a noticeable change
+                        derivedRow('pressureTrend', 'pressureTrendRow', 'pressureTrend', v =>
+                            (v > 1 ? '↑ ' : v < -1 ? '↓ ' : '→ ') + (v > 0 ? '+' : '') + v.toFixed(1) + ' hPa/3h');
 
                         // Altitude (calculated from BMP280)
                         if (bmpConnected && data.bmpAltitude !== undefined) {
@@ -1362,6 +1394,45 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
             }, 2000);
         }
 
+        function loadMqttSettings() {
+            fetch('/get-mqtt-settings')
+                .then(response => response.json())
+                .then(data => {
+                    document.getElementById('mqttHostInput').value = data.host;
+                    document.getElementById('mqttPortInput').value = data.port;
+                    document.getElementById('mqttUserInput').value = data.user;
+                    document.getElementById('mqttPrefixInput').value = data.prefix;
+                    document.getElementById('mqttBatchInput').value = data.batch;
+                    document.getElementById('mqttTopic').textContent = data.topic;
+                    document.getElementById('mqttState').textContent = !data.host ? 'Disabled'
+                        : (data.connected ? 'Connected' : 'Disconnected') + ' (' + data.queued + ' queued)';
+                })
+                .catch(error => console.error('Error loading MQTT settings:', error));
+        }
+
+        function saveMqttSettings() {
+            const params = new URLSearchParams({
+                host: document.getElementById('mqttHostInput').value.trim(),
+                port: document.getElementById('mqttPortInput').value || '1883',
+                user: document.getElementById('mqttUserInput').value,
+                prefix: document.getElementById('mqttPrefixInput').value.trim(),
+                batch: document.getElementById('mqttBatchInput').value || '1'
+            });
+            const password = document.getElementById('mqttPasswordInput').value;
+            if (password.length > 0) {
+                params.append('password', password);
+            }
+
+            fetch('/set-mqtt-settings?' + params.toString())
+                .then(response => response.ok ? response.json() : response.text().then(text => { throw new Error(text); }))
+                .then(data => {
+                    document.getElementById('mqttPasswordInput').value = '';
+                    showStatusMessage('mqttStatus', data.enabled ? 'MQTT settings saved' : 'MQTT disabled', 'success');
+                    setTimeout(loadMqttSettings, 2000);
+                })
+                .catch(error => showStatusMessage('mqttStatus', error.message || 'Error saving MQTT settings', 'error'));
+        }
+
         function saveDeviceName() {
             const newName = document.getElementById('deviceNameInput').value.trim();
             const statusDiv = document.getElementById('deviceNameStatus');
@@ -1394,7 +1465,11 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
         }
 
         function showDeviceNameStatus(message, type) {
-            const statusDiv = document.getElementById('deviceNameStatus');
+            showStatusMessage('deviceNameStatus', message, type);
+        }
+
+        function showStatusMessage(id, message, type) {
+            const statusDiv = document.getElementById(id);
             statusDiv.style.display = 'block';
 
             if (type === 'success') {
@@ -1426,11 +1501,13 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
         theme.init();
         updateStatus();
         loadAPSettings();
+        loadMqttSettings();
         // Update every 10 seconds for battery optimization
         // When not browsing, ESP32 sleeps ~4+ seconds between 5-second sensor cycles
         // While browsing, 10-second polling provides good UX with reduced wake-ups
         setInterval(updateStatus, 10000);
         setInterval(loadAPSettings, 10000);
+        setInterval(loadMqttSettings, 30000);
 
         // Initialize Lucide icons (only if library loaded - requires internet)
         if (typeof lucide !== 'undefined') {
@@ -0,0 +1,75 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+// Latency Histogram
+// Fixed log2 buckets in microseconds: bucket i counts samples in
+// (2^(i-1), 2^i] µs, bucket 0 counts samples <= 1 µs and the last bucket
+// collects everything above the second-to-last bound (+Inf).
+// 80 bytes of counters, O(1) record() with no allocation.
+
+#include <stdint.h>
+#include <string.h>
+
+#define LATENCY_BUCKETS 20  // Upper bounds 1 µs ... 262 ms, then +Inf
+
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max;   // µs
+    uint64_t sum;   // µs
+
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        memset(buckets, 0, sizeof(buckets));
+        count = 0;
+        max = 0;
+        sum = 0;
+    }
+
+    void record(uint32_t us) {
+        buckets[bucketFor(us)]++;
+        count++;
+        sum += us;
+        if (us > max) {
+            max = us;
+        }
+    }
+
+    uint32_t average() const {
+        return count > 0 ? (uint32_t)(sum / count) : 0;
+    }
+
+    // Upper bound of bucket i in µs (0 for the +Inf bucket)
+    static uint32_t upperBound(uint8_t i) {
+        return i < LATENCY_BUCKETS - 1 ? (1UL << i) : 0;
+    }
+
+    static uint8_t bucketFor(uint32_t us) {
+        if (us <= 1) {
+            return 0;
+        }
+        uint8_t i = 32 - __builtin_clz(us - 1);  // ceil(log2(us))
+        return i < LATENCY_BUCKETS - 1 ? i : LATENCY_BUCKETS - 1;
+    }
+
+    // Approximate percentile (0-100): upper bound of the bucket holding it,
+    // clamped to the observed maximum
+    uint32_t percentile(uint8_t p) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint32_t target = (uint32_t)(((uint64_t)count * p + 99) / 100);
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= target && seen > 0) {
+                uint32_t bound = upperBound(i);
+                return (bound == 0 || bound > max) ? max : bound;
+            }
+        }
+        return max;
+    }
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,109 @@
+#ifndef LINE_PROTOCOL_H
+#define LINE_PROTOCOL_H
+
+// InfluxDB Line Protocol Batch
+// ============================
+// Formats telemetry records (telemetry_queue.h) as line protocol into a fixed
+// buffer allocated once:
+//
+//   environment,device=esp32-monitor-a1b2,name=Living\ Room temperature=21.53,humidity=45.20 1760000000
+//
+// Timestamps are Unix seconds (write with precision=s). They only move
+// forward: a record whose timestamp isn't later than the last one appended
+// is skipped, so a clock step back never produces two points for the same
+// series and time. Re-sending a batch is then idempotent on the server,
+// which keeps one point per series and timestamp.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_snapshot.h"
+#include "telemetry_queue.h"
+#include "env_math.h"
+
+#define LINE_PROTOCOL_MAX_LINE 320  // Measurement, tags and every channel
+
+enum LineAppendResult : uint8_t {
+    LINE_APPENDED,
+    LINE_FULL,       // Flush the batch, then append again
+    LINE_DUPLICATE,  // Not after the previous timestamp, skipped
+    LINE_EMPTY       // No channel had a reading
+};
+
+// Escapes a tag value (commas, spaces and equals signs) into `out`
+inline void lineProtocolEscapeTag(const char* value, char* out, size_t size) {
+    size_t n = 0;
+    for (; *value != '\0' && n + 2 < size; value++) {
+        if (*value == ',' || *value == ' ' || *value == '=') {
+            out[n++] = '\\';
+        }
+        out[n++] = *value;
+    }
+    out[n] = '\0';
+}
+
+class LineProtocolBatch {
+public:
+    bool begin(size_t capacityBytes) {
+        buffer = (char*)malloc(capacityBytes);
+        capacity = buffer != NULL ? capacityBytes : 0;
+        clear();
+        return buffer != NULL;
+    }
+
+    // measurementAndTags: "environment,device=...,name=..." (already escaped)
+    LineAppendResult append(const char* measurementAndTags, const TelemetryRecord& record, uint32_t unixTime) {
+        if (unixTime <= lastTime) {
+            return LINE_DUPLICATE;
+        }
+        char line[LINE_PROTOCOL_MAX_LINE];
+        int length = snprintf(line, sizeof(line), "%s ", measurementAndTags);
+        bool first = true;
+        for (uint8_t c = 0; c < CHANNEL_COUNT && length < (int)sizeof(line); c++) {
+            if (!(record.validChannels & (1UL << c))) {
+                continue;
+            }
+            const ChannelInfo& info = CHANNEL_INFO[c];
+            char value[FIXED_TEXT_SIZE];
+            formatFixed(value, sizeof(value), record.values[c], info.scale, info.scale);
+            length += snprintf(line + length, sizeof(line) - length, "%s%s=%s", first ? "" : ",", info.name, value);
+            first = false;
+        }
+        if (first) {
+            return LINE_EMPTY;
+        }
+        if (length < (int)sizeof(line)) {
+            length += snprintf(line + length, sizeof(line) - length, " %lu\n", (unsigned long)unixTime);
+        }
+        if (length >= (int)sizeof(line) || used + length > capacity) {
+            return LINE_FULL;
+        }
+
+        memcpy(buffer + used, line, length);
+        used += length;
+        lineCount++;
+        lastTime = unixTime;
+        return LINE_APPENDED;
+    }
+
+    // Empties the batch; the timestamp floor stays
+    void clear() {
+        used = 0;
+        lineCount = 0;
+    }
+
+    const char* data() const { return buffer; }
+    size_t size() const { return used; }
+    uint16_t lines() const { return lineCount; }
+    uint32_t getLastTime() const { return lastTime; }
+
+private:
+    char* buffer = NULL;
+    size_t capacity = 0;
+    size_t used = 0;
+    uint16_t lineCount = 0;
+    uint32_t lastTime = 0;  // Unix seconds of the newest line ever appended
+};
+
+#endif // LINE_PROTOCOL_H
@@ -0,0 +1,146 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+// Structured Log Ring
+// ===================
+// Levelled log messages kept in a fixed ring of LOG_RING_ENTRIES slots, so
+// logging never blocks on the UART: LOG_x() formats into a slot and returns,
+// and a low-priority task drains new entries to Serial (see logDrainTask()
+// in main.cpp). The last entries stay available at /logs.
+//
+//   LOG_I("wifi", "Connected to %s (%d dBm)", ssid, rssi);
+//   LOG_E("mqtt", "Connect to %s:%d failed (state %d)", host, port, state);
+//
+// Each entry keeps a sequence number, millis(), level, tag (subsystem) and
+// up to LOG_TEXT_LENGTH - 1 characters of text; longer messages are cut.
+//
+// LOG_COMPILED_LEVEL is the most verbose level built into the firmware
+// (default LOG_LEVEL_INFO). The macros of more verbose levels expand to
+// nothing, so neither the call nor its format string reaches the binary -
+// and their arguments are not evaluated, so they must not have side effects.
+//
+// LogRing itself is not thread-safe; logWrite() serializes access.
+
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_RING_ENTRIES
+#define LOG_RING_ENTRIES 48
+#endif
+#define LOG_TAG_LENGTH 8     // Including the terminator
+#define LOG_TEXT_LENGTH 120  // Including the terminator
+
+static constexpr char LOG_LEVEL_LETTERS[] = "?EWID";  // Indexed by level
+
+struct LogEntry {
+    uint32_t seq;
+    uint32_t ms;
+    uint8_t level;
+    char tag[LOG_TAG_LENGTH];
+    char text[LOG_TEXT_LENGTH];
+};
+
+class LogRing {
+public:
+    // Returns the entry's sequence number; overwrites the oldest when full
+    uint32_t append(uint8_t level, uint32_t ms, const char* tag, const char* text) {
+        LogEntry& entry = entries[nextSeq % LOG_RING_ENTRIES];
+        entry.seq = nextSeq;
+        entry.ms = ms;
+        entry.level = level;
+        strncpy(entry.tag, tag, LOG_TAG_LENGTH - 1);
+        entry.tag[LOG_TAG_LENGTH - 1] = '\0';
+        strncpy(entry.text, text, LOG_TEXT_LENGTH - 1);
+        entry.text[LOG_TEXT_LENGTH - 1] = '\0';
+        if (level <= LOG_LEVEL_DEBUG) {
+            counts[level]++;
+        }
+        return nextSeq++;
+    }
+
+    // Copies entry `seq`; false if it was overwritten or not written yet
+    bool get(uint32_t seq, LogEntry& out) const {
+        if (seq >= nextSeq || seq < oldest()) {
+            return false;
+        }
+        out = entries[seq % LOG_RING_ENTRIES];
+        return true;
+    }
+
+    uint32_t oldest() const { return nextSeq > LOG_RING_ENTRIES ? nextSeq - LOG_RING_ENTRIES : 0; }
+    uint32_t next() const { return nextSeq; }  // Sequence number of the next entry
+    uint32_t count(uint8_t level) const { return level <= LOG_LEVEL_DEBUG ? counts[level] : 0; }
+
+private:
+    LogEntry entries[LOG_RING_ENTRIES];
+    uint32_t nextSeq = 0;
+    uint32_t counts[LOG_LEVEL_DEBUG + 1] = {};
+};
+
+// Escapes `text` for a JSON string (quotes, backslashes, control characters);
+// returns the length written, always terminated
+inline size_t logEscapeJson(char* out, size_t size, const char* text) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    size_t length = 0;
+    for (const char* p = text; *p != '\0'; p++) {
+        unsigned char c = (unsigned char)*p;
+        char escaped[7];
+        uint8_t n = 0;
+        if (c == '"' || c == '\\') {
+            escaped[n++] = '\\';
+            escaped[n++] = (char)c;
+        } else if (c < 0x20) {
+            memcpy(escaped, "\\u00", 4);
+            n = 4;
+            escaped[n++] = HEX_DIGITS[c >> 4];
+            escaped[n++] = HEX_DIGITS[c & 0x0F];
+        } else {
+            escaped[n++] = (char)c;
+        }
+        if (length + n >= size) {
+            break;
+        }
+        memcpy(out + length, escaped, n);
+        length += n;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// Defined in main.cpp: formats into the ring and wakes the drain task
+void logWrite(uint8_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(tag, ...) logWrite(LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#else
+#define LOG_E(tag, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(tag, ...) logWrite(LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#else
+#define LOG_W(tag, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(tag, ...) logWrite(LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#else
+#define LOG_I(tag, ...) do {} while (0)
+#endif
+
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(tag, ...) logWrite(LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#else
+#define LOG_D(tag, ...) do {} while (0)
+#endif
+
+#endif // LOG_RING_H
@@ -0,0 +1,149 @@
+#ifndef METRICS_WRITER_H
+#define METRICS_WRITER_H
+
+// Prometheus Text Exposition Writer
+// =================================
+// Streams metrics in the Prometheus text format (version 0.0.4) through a
+// fixed buffer: lines are formatted with snprintf into METRICS_BUFFER_SIZE
+// bytes on the stack and written to the sink whenever the buffer fills, so a
+// scrape costs no heap however many series it has.
+//
+//   # HELP esp32_heap_free_bytes Free heap
+//   # TYPE esp32_heap_free_bytes gauge
+//   esp32_heap_free_bytes 182344
+//
+// Sink is anything with write(const uint8_t*, size_t) returning the bytes
+// written (WiFiClient on the device). Labels are passed preformatted
+// (route="/status"); values are integers or fixed-point with `scale`
+// decimals, like the sensor channels. LatencyHistogram (µs) maps onto a
+// Prometheus histogram in seconds with cumulative le buckets.
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "latency_histogram.h"
+
+#define METRICS_BUFFER_SIZE 512
+
+template <typename Sink>
+class MetricsWriter {
+public:
+    explicit MetricsWriter(Sink& sink) : sink(sink) {}
+
+    // # HELP and # TYPE lines of a metric family (type: gauge, counter, histogram)
+    void header(const char* name, const char* type, const char* help) {
+        append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    void sample(const char* name, int64_t value, const char* labels = NULL, uint8_t scale = 0) {
+        char number[24];
+        formatDecimal(number, sizeof(number), value, scale);
+        if (labels != NULL && labels[0] != '\0') {
+            append("%s{%s} %s\n", name, labels, number);
+        } else {
+            append("%s %s\n", name, number);
+        }
+    }
+
+    // name_bucket{le=...} (cumulative), name_sum and name_count, in seconds
+    void histogram(const char* name, const LatencyHistogram& histogram, const char* labels = NULL) {
+        const char* separator = labels != NULL && labels[0] != '\0' ? "," : "";
+        if (labels == NULL) {
+            labels = "";
+        }
+        uint32_t cumulative = 0;
+        for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+            cumulative += histogram.buckets[i];
+            uint32_t bound = LatencyHistogram::upperBound(i);
+            if (bound == 0) {
+                append("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, separator, (unsigned long)cumulative);
+            } else {
+                char le[24];
+                formatDecimal(le, sizeof(le), bound, 6);
+                append("%s_bucket{%s%sle=\"%s\"} %lu\n", name, labels, separator, le, (unsigned long)cumulative);
+            }
+        }
+        char sum[24];
+        formatDecimal(sum, sizeof(sum), (int64_t)histogram.sum, 6);
+        if (labels[0] != '\0') {
+            append("%s_sum{%s} %s\n%s_count{%s} %lu\n", name, labels, sum, name, labels,
+                   (unsigned long)histogram.count);
+        } else {
+            append("%s_sum %s\n%s_count %lu\n", name, sum, name, (unsigned long)histogram.count);
+        }
+    }
+
+    // Writes what is buffered; false if the sink stopped accepting data
+    bool finish() {
+        flush();
+        return !failed;
+    }
+
+    uint32_t getBytes() const { return bytes; }
+
+    // Fixed-point value with `scale` decimals ("-12.34"); integer math only,
+    // so 64-bit values don't depend on printf's %lld support
+    static int formatDecimal(char* out, size_t size, int64_t value, uint8_t scale) {
+        char digits[24];
+        uint8_t n = 0;
+        uint64_t magnitude = value < 0 ? (uint64_t)(-(value + 1)) + 1 : (uint64_t)value;
+        do {
+            digits[n++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while ((magnitude > 0 || n <= scale) && n < sizeof(digits));
+
+        size_t length = 0;
+        if (value < 0 && length + 1 < size) {
+            out[length++] = '-';
+        }
+        while (n > 0 && length + 1 < size) {
+            if (n == scale && length + 2 < size) {
+                out[length++] = '.';
+            }
+            out[length++] = digits[--n];
+        }
+        out[length] = '\0';
+        return (int)length;
+    }
+
+private:
+    void append(const char* format, ...) {
+        if (failed) {
+            return;
+        }
+        char line[160];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        if (length <= 0) {
+            return;
+        }
+        if ((size_t)length >= sizeof(line)) {
+            length = sizeof(line) - 1;
+            line[length - 1] = '\n';  // Truncated, but still one line
+        }
+        if (used + length > sizeof(buffer)) {
+            flush();
+        }
+        memcpy(buffer + used, line, length);
+        used += length;
+    }
+
+    void flush() {
+        if (used > 0 && !failed) {
+            failed = sink.write((const uint8_t*)buffer, used) != used;
+            bytes += used;
+        }
+        used = 0;
+    }
+
+    Sink& sink;
+    char buffer[METRICS_BUFFER_SIZE];
+    size_t used = 0;
+    uint32_t bytes = 0;
+    bool failed = false;
+};
+
+#endif // METRICS_WRITER_H
@@ -0,0 +1,145 @@
+#ifndef PERF_PROFILER_H
+#define PERF_PROFILER_H
+
+// Phase Profiler
+// ==============
+// Microsecond timings of the loop() phases, the sensor task phases and each
+// HTTP route, recorded into LatencyHistograms (log2 buckets + max) for
+// /debug/perf. Enabled with the PERF_PROFILING build flag (see
+// platformio.ini); without it the macros keep only the boot breadcrumb below
+// (PERF_TIME also its statement), so the release firmware carries no timing
+// code or counters.
+//
+//   PERF_TIME(PERF_HANDLE_CLIENT, server.handleClient());
+//
+//   PERF_BEGIN(PERF_LED);
+//   ...
+//   PERF_END(PERF_LED);
+//
+// Each phase is recorded by a single task. reset() only bumps a generation
+// counter; a slot clears itself on its next record(), so a reset from the web
+// server never races the task writing the slot.
+//
+// In every build, PERF_BEGIN and PERF_TIME also leave the phase as a boot
+// breadcrumb (one byte store to RTC memory, see boot_history.h), so the boot
+// history can name the phase a watchdog reset or panic interrupted. PERF_END
+// puts back the phase it was nested in (BOOT_PHASE_NONE at the top level), so
+// code between phases is never blamed on the last one that ran.
+
+#include <stdint.h>
+#include "latency_histogram.h"
+#include "boot_history.h"
+
+enum PerfPhase : uint8_t {
+    // loop() (loop task)
+    PERF_LOOP,             // Whole pass, excluding the trailing delay
+    PERF_HANDLE_CLIENT,    // server.handleClient(), route handlers included
+    PERF_EVENT_STREAM,     // SSE fan-out and keepalives
+    PERF_MQTT,
+    PERF_INFLUX,
+    PERF_OTA_HANDLE,       // ArduinoOTA.handle() and the prep timeout
+    PERF_UPDATE_CYCLE,     // 5 s cycle: heap and task sampling, roaming check and beacon
+    PERF_PERSIST,          // persistSealedBlocks() alone (LittleFS writes)
+    PERF_ROAMING,          // checkWiFiRoaming() alone (includes its scan)
+    PERF_LED,
+    PERF_WIFI_STATUS,      // Connection tracking, mDNS/OTA re-setup on reconnect
+    // sensorTask()
+    PERF_SENSOR_POLL,      // I2C reads (pollAll)
+    PERF_SENSOR_PUBLISH,   // Derived metrics, snapshot, history, telemetry queues
+    PERF_SENSOR_ANALYSIS,  // Anomaly detection and rules
+    PERF_SENSOR_HEALTH,    // Detach / re-probe / bus recovery
+    PERF_PHASE_COUNT
+};
+
+static constexpr const char* PERF_PHASE_NAMES[PERF_PHASE_COUNT] = {
+    "loop",         "handleClient",    "eventStream",     "mqtt",           "influx",
+    "otaHandle",    "updateCycle",     "persist",         "roaming",        "led",
+    "wifiStatus",   "sensorPoll",      "sensorPublish",   "sensorAnalysis", "sensorHealth",
+};
+
+inline const char* perfPhaseName(uint8_t phase) {
+    return phase < PERF_PHASE_COUNT ? PERF_PHASE_NAMES[phase] : "none";
+}
+
+extern BootBreadcrumbs bootBreadcrumbs;
+
+// The breadcrumb of the task that runs `phase`. Sensor task phases start at
+// PERF_SENSOR_POLL; the comparison folds at compile time
+#define PERF_BREADCRUMB_SLOT(phase) \
+    (*((phase) < PERF_SENSOR_POLL ? &bootBreadcrumbs.loopPhase : &bootBreadcrumbs.sensorPhase))
+
+// Enter a phase, remembering the enclosing one; leave it, restoring that
+#define PERF_BREADCRUMB(phase)                                  \
+    uint8_t perfOuter_##phase = PERF_BREADCRUMB_SLOT(phase);   \
+    PERF_BREADCRUMB_SLOT(phase) = (phase)
+#define PERF_BREADCRUMB_END(phase) PERF_BREADCRUMB_SLOT(phase) = perfOuter_##phase
+
+#ifdef PERF_PROFILING
+
+#include "esp_timer.h"
+
+#define PERF_ROUTE_SLOTS 40  // Matches MAX_ROUTES
+
+class PerfProfiler {
+public:
+    void record(uint8_t slot, uint32_t us) {
+        if (slot >= PERF_PHASE_COUNT + PERF_ROUTE_SLOTS) {
+            return;
+        }
+        if (generations[slot] != generation) {
+            histograms[slot].reset();
+            generations[slot] = generation;
+        }
+        histograms[slot].record(us);
+    }
+
+    void reset() { generation++; }
+
+    // Empty if the slot hasn't recorded since the last reset
+    const LatencyHistogram& get(uint8_t slot) const {
+        static const LatencyHistogram empty;
+        return generations[slot] == generation ? histograms[slot] : empty;
+    }
+
+    uint32_t getResets() const { return generation; }
+
+private:
+    LatencyHistogram histograms[PERF_PHASE_COUNT + PERF_ROUTE_SLOTS];
+    uint32_t generations[PERF_PHASE_COUNT + PERF_ROUTE_SLOTS] = {};
+    volatile uint32_t generation = 0;
+};
+
+extern PerfProfiler perfProfiler;
+
+#define PERF_BEGIN(phase)   \
+    PERF_BREADCRUMB(phase); \
+    int64_t perfStarted_##phase = esp_timer_get_time()
+#define PERF_END(phase)                                                               \
+    perfProfiler.record(phase, (uint32_t)(esp_timer_get_time() - perfStarted_##phase)); \
+    PERF_BREADCRUMB_END(phase)
+#define PERF_TIME(phase, ...) \
+    do {                      \
+        PERF_BEGIN(phase);    \
+        __VA_ARGS__;          \
+        PERF_END(phase);      \
+    } while (0)
+// An already measured duration; route i of addRoute() is slot PERF_PHASE_COUNT + i
+#define PERF_RECORD(phase, us) perfProfiler.record(phase, (us))
+#define PERF_RECORD_ROUTE(index, us) perfProfiler.record(PERF_PHASE_COUNT + (index), (us))
+
+#else
+
+#define PERF_BEGIN(phase) PERF_BREADCRUMB(phase)
+#define PERF_END(phase) PERF_BREADCRUMB_END(phase)
+#define PERF_TIME(phase, ...)       \
+    do {                            \
+        PERF_BREADCRUMB(phase);     \
+        __VA_ARGS__;                \
+        PERF_BREADCRUMB_END(phase); \
+    } while (0)
+#define PERF_RECORD(phase, us)
+#define PERF_RECORD_ROUTE(index, us)
+
+#endif // PERF_PROFILING
+
+#endif // PERF_PROFILER_H
@@ -0,0 +1,696 @@
+#ifndef RULES_ENGINE_H
+#define RULES_ENGINE_H
+
+// Rules Engine
+// ============
+// Threshold automations submitted as text (/rules-add), compiled once into a
+// small stack bytecode and kept in NVS, e.g.
+//
+//   humidity > 70 for 10m then alert, led:blink
+//   temperature - dewpoint < 2 and not co2 < 800 then alert
+//
+// Grammar:
+//   rule       := condition [ "for" duration ] "then" action { "," action }
+//   condition  := and { "or" and }
+//   and        := not { "and" not }
+//   not        := "not" not | comparison
+//   comparison := sum [ ( "<" | "<=" | ">" | ">=" | "==" | "!=" ) sum ]
+//   sum        := product { ( "+" | "-" ) product }
+//   product    := unary { ( "*" | "/" ) unary }
+//   unary      := "-" unary | number | channel | "(" condition ")"
+//   duration   := integer ( "s" | "m" | "h" )
+//   action     := "alert" | "led:blink" | "led:strobe"
+//
+// Channels are the short names from CHANNEL_INFO; numbers have up to three
+// decimals. Every value on the stack is an int32 in thousandths of the
+// channel's unit (no floats: the ESP32-C3 has no FPU), so a rule can mix
+// channels with different fixed-point scales.
+//
+// Bounds: a rule is at most RULE_MAX_CODE bytes of straight-line code (no
+// jumps) and the compiler rejects anything deeper than RULE_STACK_DEPTH, so
+// one evaluation is at most RULE_MAX_CODE instructions over a fixed stack.
+// Rules are re-run only when a channel they read changed since the last
+// snapshot; in between only their "for" timer advances.
+
+#include <stdint.h>
+#include <string.h>
+#include "sensor_snapshot.h"
+
+#define RULE_MAX_CODE 64        // Bytecode bytes per rule
+#define RULE_MAX_SOURCE 96      // Rule text kept for /rules, including the terminator
+#define RULE_STACK_DEPTH 8
+#define RULE_MAX_HOLD 86400     // Longest "for" duration, seconds
+#define RULE_FORMAT_VERSION 1   // Bump when RuleProgram or the opcodes change
+#define RULE_VALUE_SCALE 1000   // Stack values are thousandths of a unit
+
+enum RuleOpcode : uint8_t {
+    RULE_OP_PUSH,   // + int32 little-endian
+    RULE_OP_LOAD,   // + channel
+    RULE_OP_ADD,
+    RULE_OP_SUB,
+    RULE_OP_MUL,
+    RULE_OP_DIV,
+    RULE_OP_NEG,
+    RULE_OP_LT,
+    RULE_OP_LE,
+    RULE_OP_GT,
+    RULE_OP_GE,
+    RULE_OP_EQ,
+    RULE_OP_NE,
+    RULE_OP_AND,
+    RULE_OP_OR,
+    RULE_OP_NOT,
+    RULE_OP_COUNT
+};
+
+enum RuleAction : uint8_t {
+    RULE_ACTION_ALERT = 1 << 0,  // Serial log + /events
+    RULE_ACTION_LED = 1 << 1,    // LED pattern while the rule is firing
+};
+
+enum RuleLedPattern : uint8_t {
+    RULE_LED_NONE,
+    RULE_LED_BLINK,   // 250 ms on / 250 ms off
+    RULE_LED_STROBE,  // 50 ms flash every 500 ms
+};
+
+static constexpr const char* RULE_LED_NAMES[] = {"none", "blink", "strobe"};
+
+// Compiled rule; stored as-is in NVS (a blob per rule)
+struct RuleProgram {
+    uint8_t version;        // RULE_FORMAT_VERSION
+    uint8_t codeLength;
+    uint8_t actions;        // RuleAction bits
+    uint8_t ledPattern;     // RuleLedPattern, with RULE_ACTION_LED
+    uint32_t holdSeconds;   // Condition must hold this long before firing
+    uint32_t channelMask;   // Bit per channel the condition reads
+    uint8_t code[RULE_MAX_CODE];
+    char source[RULE_MAX_SOURCE];
+};
+
+struct RuleError {
+    const char* message = NULL;
+    uint16_t position = 0;  // Offset into the rule text
+};
+
+// Operands popped, stack effect and operand bytes per opcode, shared by the
+// compiler and verifyRuleProgram()
+inline uint8_t ruleStackInputs(uint8_t op) {
+    if (op == RULE_OP_PUSH || op == RULE_OP_LOAD) return 0;
+    if (op == RULE_OP_NEG || op == RULE_OP_NOT) return 1;
+    return 2;
+}
+
+inline int8_t ruleStackEffect(uint8_t op) { return 1 - (int8_t)ruleStackInputs(op); }
+
+inline uint8_t ruleOperandBytes(uint8_t op) {
+    return op == RULE_OP_PUSH ? 4 : (op == RULE_OP_LOAD ? 1 : 0);
+}
+
+// Thousandths of a unit per fixed-point step of a channel (10^(3 - scale))
+inline int32_t ruleChannelFactor(SensorChannel channel) {
+    int32_t factor = RULE_VALUE_SCALE;
+    for (uint8_t i = 0; i < CHANNEL_INFO[channel].scale; i++) {
+        factor /= 10;
+    }
+    return factor;
+}
+
+// Checks a program read back from NVS before it's ever run: known opcodes,
+// operands in range, the stack within RULE_STACK_DEPTH and one value left
+inline bool verifyRuleProgram(const RuleProgram& program) {
+    if (program.version != RULE_FORMAT_VERSION || program.codeLength > RULE_MAX_CODE ||
+        memchr(program.source, 0, RULE_MAX_SOURCE) == NULL || program.holdSeconds > RULE_MAX_HOLD ||
+        program.ledPattern > RULE_LED_STROBE) {
+        return false;
+    }
+    int depth = 0;
+    uint8_t pc = 0;
+    while (pc < program.codeLength) {
+        uint8_t op = program.code[pc++];
+        if (op >= RULE_OP_COUNT || pc + ruleOperandBytes(op) > program.codeLength) {
+            return false;
+        }
+        if (op == RULE_OP_LOAD && program.code[pc] >= CHANNEL_COUNT) {
+            return false;
+        }
+        pc += ruleOperandBytes(op);
+        if (depth < ruleStackInputs(op)) {
+            return false;
+        }
+        depth += ruleStackEffect(op);
+        if (depth > RULE_STACK_DEPTH) {
+            return false;
+        }
+    }
+    return depth == 1;
+}
+
+// Recursive descent compiler from rule text to a RuleProgram.
+// Tracks the type of every subexpression (number or condition) so mistakes
+// like "humidity and 70" are reported at compile time, not evaluated.
+class RuleCompiler {
+public:
+    bool compile(const char* text, RuleProgram& out, RuleError& error) {
+        memset(&out, 0, sizeof(out));
+        if (strlen(text) >= RULE_MAX_SOURCE) {
+            error.message = "rule text too long";
+            error.position = RULE_MAX_SOURCE - 1;
+            return false;
+        }
+        source = text;
+        program = &out;
+        failure = NULL;
+        depth = 0;
+        pos = 0;
+        next();
+
+        Type type = condition();
+        if (!failure && type != TYPE_BOOL) {
+            fail("expected a comparison");
+        }
+        if (!failure && accept("for")) {
+            duration();
+        }
+        if (!failure && !accept("then")) {
+            fail("expected 'then'");
+        }
+        if (!failure) {
+            do {
+                action();
+            } while (!failure && accept(TOKEN_COMMA));
+        }
+        if (!failure && token != TOKEN_END) {
+            fail("unexpected text after the actions");
+        }
+        if (failure) {
+            error.message = failure;
+            error.position = failurePosition;
+            return false;
+        }
+
+        out.version = RULE_FORMAT_VERSION;
+        strncpy(out.source, text, RULE_MAX_SOURCE - 1);
+        return true;
+    }
+
+private:
+    enum Token : uint8_t {
+        TOKEN_END, TOKEN_NUMBER, TOKEN_WORD, TOKEN_LPAREN, TOKEN_RPAREN, TOKEN_COMMA, TOKEN_COLON,
+        TOKEN_PLUS, TOKEN_MINUS, TOKEN_STAR, TOKEN_SLASH,
+        TOKEN_LT, TOKEN_LE, TOKEN_GT, TOKEN_GE, TOKEN_EQ, TOKEN_NE,
+        TOKEN_INVALID
+    };
+
+    enum Type : uint8_t { TYPE_ERROR, TYPE_NUMBER, TYPE_BOOL };
+
+    // Lexer: one token of lookahead
+    void next() {
+        while (source[pos] == ' ') {
+            pos++;
+        }
+        tokenStart = pos;
+        char c = source[pos];
+        if (c == '\0') {
+            token = TOKEN_END;
+        } else if (c >= '0' && c <= '9') {
+            lexNumber();
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+            while (isWordChar(source[pos])) {
+                pos++;
+            }
+            token = TOKEN_WORD;
+        } else {
+            pos++;
+            char n = source[pos];
+            switch (c) {
+                case '(': token = TOKEN_LPAREN; break;
+                case ')': token = TOKEN_RPAREN; break;
+                case ',': token = TOKEN_COMMA; break;
+                case ':': token = TOKEN_COLON; break;
+                case '+': token = TOKEN_PLUS; break;
+                case '-': token = TOKEN_MINUS; break;
+                case '*': token = TOKEN_STAR; break;
+                case '/': token = TOKEN_SLASH; break;
+                case '<': token = n == '=' ? (pos++, TOKEN_LE) : TOKEN_LT; break;
+                case '>': token = n == '=' ? (pos++, TOKEN_GE) : TOKEN_GT; break;
+                case '=': token = n == '=' ? (pos++, TOKEN_EQ) : TOKEN_INVALID; break;
+                case '!': token = n == '=' ? (pos++, TOKEN_NE) : TOKEN_INVALID; break;
+                default: token = TOKEN_INVALID; break;
+            }
+        }
+        tokenLength = pos - tokenStart;
+    }
+
+    // Decimal literal to thousandths (further decimals are truncated)
+    void lexNumber() {
+        int64_t whole = 0;
+        while (source[pos] >= '0' && source[pos] <= '9') {
+            whole = whole * 10 + (source[pos++] - '0');
+            if (whole > INT32_MAX / RULE_VALUE_SCALE) {
+                token = TOKEN_INVALID;
+                return;
+            }
+        }
+        int32_t fraction = 0;
+        int32_t place = RULE_VALUE_SCALE / 10;
+        fractional = false;
+        if (source[pos] == '.') {
+            pos++;
+            fractional = true;
+            while (source[pos] >= '0' && source[pos] <= '9') {
+                fraction += (source[pos++] - '0') * place;
+                place /= 10;
+            }
+        }
+        int64_t value = whole * RULE_VALUE_SCALE + fraction;  // 2147483.999 passes the check above
+        if (value > INT32_MAX) {
+            token = TOKEN_INVALID;
+            return;
+        }
+        number = (int32_t)value;
+        token = TOKEN_NUMBER;
+    }
+
+    static bool isWordChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    bool isWord(const char* word) const {
+        return token == TOKEN_WORD && strlen(word) == tokenLength && strncmp(source + tokenStart, word, tokenLength) == 0;
+    }
+
+    bool accept(const char* word) {
+        if (isWord(word)) {
+            next();
+            return true;
+        }
+        return false;
+    }
+
+    bool accept(Token expected) {
+        if (token == expected) {
+            next();
+            return true;
+        }
+        return false;
+    }
+
+    Type fail(const char* message) {
+        if (!failure) {
+            failure = message;
+            failurePosition = tokenStart;
+        }
+        return TYPE_ERROR;
+    }
+
+    void emit(uint8_t op) {
+        if (program->codeLength >= RULE_MAX_CODE) {
+            fail("rule too long");
+            return;
+        }
+        program->code[program->codeLength++] = op;
+        depth += ruleStackEffect(op);
+        if (depth > RULE_STACK_DEPTH) {
+            fail("expression nested too deeply");
+        }
+    }
+
+    void emitPush(int32_t value) {
+        if (program->codeLength + 5 > RULE_MAX_CODE) {
+            fail("rule too long");
+            return;
+        }
+        emit(RULE_OP_PUSH);
+        for (uint8_t i = 0; i < 4; i++) {
+            program->code[program->codeLength++] = (uint8_t)((uint32_t)value >> (8 * i));
+        }
+    }
+
+    void emitLoad(SensorChannel channel) {
+        if (program->codeLength + 2 > RULE_MAX_CODE) {
+            fail("rule too long");
+            return;
+        }
+        emit(RULE_OP_LOAD);
+        program->code[program->codeLength++] = channel;
+        program->channelMask |= 1UL << channel;
+    }
+
+    // Binary operator whose operands must both be `operand`
+    Type binary(Type left, Type right, Type operand, uint8_t op, Type result) {
+        if (left == TYPE_ERROR || right == TYPE_ERROR) {
+            return TYPE_ERROR;
+        }
+        if (left != operand || right != operand) {
+            return fail(operand == TYPE_NUMBER ? "expected a number" : "expected a comparison");
+        }
+        emit(op);
+        return result;
+    }
+
+    Type condition() {
+        Type left = conjunction();
+        while (!failure && isWord("or")) {
+            next();
+            left = binary(left, conjunction(), TYPE_BOOL, RULE_OP_OR, TYPE_BOOL);
+        }
+        return left;
+    }
+
+    Type conjunction() {
+        Type left = negation();
+        while (!failure && isWord("and")) {
+            next();
+            left = binary(left, negation(), TYPE_BOOL, RULE_OP_AND, TYPE_BOOL);
+        }
+        return left;
+    }
+
+    Type negation() {
+        if (accept("not")) {
+            Type operand = negation();
+            if (operand == TYPE_NUMBER) {
+                return fail("expected a comparison after 'not'");
+            }
+            emit(RULE_OP_NOT);
+            return operand;
+        }
+        return comparison();
+    }
+
+    Type comparison() {
+        Type left = sum();
+        uint8_t op;
+        switch (token) {
+            case TOKEN_LT: op = RULE_OP_LT; break;
+            case TOKEN_LE: op = RULE_OP_LE; break;
+            case TOKEN_GT: op = RULE_OP_GT; break;
+            case TOKEN_GE: op = RULE_OP_GE; break;
+            case TOKEN_EQ: op = RULE_OP_EQ; break;
+            case TOKEN_NE: op = RULE_OP_NE; break;
+            default: return left;
+        }
+        next();
+        return binary(left, sum(), TYPE_NUMBER, op, TYPE_BOOL);
+    }
+
+    Type sum() {
+        Type left = product();
+        while (!failure && (token == TOKEN_PLUS || token == TOKEN_MINUS)) {
+            uint8_t op = token == TOKEN_PLUS ? RULE_OP_ADD : RULE_OP_SUB;
+            next();
+            left = binary(left, product(), TYPE_NUMBER, op, TYPE_NUMBER);
+        }
+        return left;
+    }
+
+    Type product() {
+        Type left = unary();
+        while (!failure && (token == TOKEN_STAR || token == TOKEN_SLASH)) {
+            uint8_t op = token == TOKEN_STAR ? RULE_OP_MUL : RULE_OP_DIV;
+            next();
+            left = binary(left, unary(), TYPE_NUMBER, op, TYPE_NUMBER);
+        }
+        return left;
+    }
+
+    Type unary() {
+        if (accept(TOKEN_MINUS)) {
+            if (token == TOKEN_NUMBER) {
+                emitPush(-number);  // Fold negative literals
+                next();
+                return TYPE_NUMBER;
+            }
+            Type operand = unary();
+            if (operand == TYPE_BOOL) {
+                return fail("expected a number after '-'");
+            }
+            emit(RULE_OP_NEG);
+            return operand;
+        }
+        if (token == TOKEN_NUMBER) {
+            emitPush(number);
+            next();
+            return TYPE_NUMBER;
+        }
+        if (token == TOKEN_WORD) {
+            char name[24];
+            SensorChannel channel;
+            if (tokenLength >= sizeof(name)) {
+                return fail("unknown channel");
+            }
+            memcpy(name, source + tokenStart, tokenLength);
+            name[tokenLength] = '\0';
+            if (!channelFromName(name, channel)) {
+                return fail("unknown channel");
+            }
+            emitLoad(channel);
+            next();
+            return TYPE_NUMBER;
+        }
+        if (accept(TOKEN_LPAREN)) {
+            Type inner = condition();
+            if (!failure && !accept(TOKEN_RPAREN)) {
+                return fail("expected ')'");
+            }
+            return inner;
+        }
+        return fail(token == TOKEN_INVALID ? "invalid character or number" : "expected a channel or number");
+    }
+
+    void duration() {
+        if (token != TOKEN_NUMBER || fractional) {
+            fail("expected a whole number of s, m or h");
+            return;
+        }
+        int64_t amount = number / RULE_VALUE_SCALE;
+        next();
+        if (accept("s")) {
+        } else if (accept("m")) {
+            amount *= 60;
+        } else if (accept("h")) {
+            amount *= 3600;
+        } else {
+            fail("expected a duration unit (s, m or h)");
+            return;
+        }
+        if (amount > RULE_MAX_HOLD) {
+            fail("duration longer than 24 hours");
+            return;
+        }
+        program->holdSeconds = (uint32_t)amount;
+    }
+
+    void action() {
+        if (accept("alert")) {
+            program->actions |= RULE_ACTION_ALERT;
+            return;
+        }
+        if (!accept("led")) {
+            fail("expected an action (alert, led:blink, led:strobe)");
+            return;
+        }
+        if (!accept(TOKEN_COLON)) {
+            fail("expected ':' and an LED pattern");
+            return;
+        }
+        for (uint8_t p = RULE_LED_BLINK; p <= RULE_LED_STROBE; p++) {
+            if (accept(RULE_LED_NAMES[p])) {
+                program->actions |= RULE_ACTION_LED;
+                program->ledPattern = p;
+                return;
+            }
+        }
+        fail("unknown LED pattern (blink, strobe)");
+    }
+
+    const char* source = NULL;
+    RuleProgram* program = NULL;
+    uint16_t pos = 0;
+    uint16_t tokenStart = 0;
+    uint16_t tokenLength = 0;
+    Token token = TOKEN_END;
+    int32_t number = 0;
+    bool fractional = false;
+    int depth = 0;
+    const char* failure = NULL;
+    uint16_t failurePosition = 0;
+};
+
+enum RuleResult : uint8_t {
+    RULE_FALSE,
+    RULE_TRUE,
+    RULE_UNKNOWN  // A channel it reads has no value, or division by zero
+};
+
+// Runs one verified program against a snapshot
+inline RuleResult evaluateRule(const RuleProgram& program, const SensorSnapshot& readings) {
+    int32_t stack[RULE_STACK_DEPTH];
+    uint8_t top = 0;
+    uint8_t pc = 0;
+    while (pc < program.codeLength) {
+        uint8_t op = program.code[pc++];
+        if (op == RULE_OP_PUSH) {
+            stack[top++] = (int32_t)((uint32_t)program.code[pc] | ((uint32_t)program.code[pc + 1] << 8) |
+                                     ((uint32_t)program.code[pc + 2] << 16) | ((uint32_t)program.code[pc + 3] << 24));
+            pc += 4;
+            continue;
+        }
+        if (op == RULE_OP_LOAD) {
+            SensorChannel channel = (SensorChannel)program.code[pc++];
+            if (!readings.has(channel)) {
+                return RULE_UNKNOWN;
+            }
+            stack[top++] = readings.get(channel) * ruleChannelFactor(channel);
+            continue;
+        }
+        if (op == RULE_OP_NEG) {
+            // Saturates like the binary operators: INT32_MIN has no int32 negation
+            stack[top - 1] = stack[top - 1] == INT32_MIN ? INT32_MAX : -stack[top - 1];
+            continue;
+        }
+        if (op == RULE_OP_NOT) {
+            stack[top - 1] = !stack[top - 1];
+            continue;
+        }
+
+        int32_t b = stack[--top];
+        int32_t a = stack[top - 1];
+        int64_t result;
+        switch (op) {
+            case RULE_OP_ADD: result = (int64_t)a + b; break;
+            case RULE_OP_SUB: result = (int64_t)a - b; break;
+            case RULE_OP_MUL: result = (int64_t)a * b / RULE_VALUE_SCALE; break;
+            case RULE_OP_DIV:
+                if (b == 0) {
+                    return RULE_UNKNOWN;
+                }
+                result = (int64_t)a * RULE_VALUE_SCALE / b;
+                break;
+            case RULE_OP_LT: result = a < b; break;
+            case RULE_OP_LE: result = a <= b; break;
+            case RULE_OP_GT: result = a > b; break;
+            case RULE_OP_GE: result = a >= b; break;
+            case RULE_OP_EQ: result = a == b; break;
+            case RULE_OP_NE: result = a != b; break;
+            case RULE_OP_AND: result = a && b; break;
+            default: result = a || b; break;  // RULE_OP_OR
+        }
+        // Saturate rather than wrap
+        stack[top - 1] = (int32_t)(result > INT32_MAX ? INT32_MAX : (result < INT32_MIN ? INT32_MIN : result));
+    }
+    return stack[0] ? RULE_TRUE : RULE_FALSE;
+}
+
+// Runtime state of one rule (not persisted)
+struct RuleState {
+    RuleResult condition = RULE_UNKNOWN;
+    bool evaluated = false;
+    bool holding = false;    // Condition true, waiting out holdSeconds
+    bool firing = false;
+    uint32_t since = 0;      // When the condition became true
+    uint32_t fires = 0;
+    uint32_t lastFired = 0;
+};
+
+// Active rules plus the incremental evaluation state.
+// Written by the sensor task (update) and the web server (add/remove), so
+// callers serialize all access with their own lock.
+template <uint8_t Capacity>
+class RuleEngine {
+public:
+    uint8_t size() const { return count; }
+    uint8_t capacity() const { return Capacity; }
+    const RuleProgram& program(uint8_t i) const { return programs[i]; }
+    const RuleState& state(uint8_t i) const { return states[i]; }
+
+    bool add(const RuleProgram& program) {
+        if (count >= Capacity || !verifyRuleProgram(program)) {
+            return false;
+        }
+        programs[count] = program;
+        states[count] = RuleState();
+        count++;
+        return true;
+    }
+
+    // Later rules move down one index
+    bool remove(uint8_t index) {
+        if (index >= count) {
+            return false;
+        }
+        for (uint8_t i = index; i + 1 < count; i++) {
+            programs[i] = programs[i + 1];
+            states[i] = states[i + 1];
+        }
+        count--;
+        return true;
+    }
+
+    // One sensor cycle. Conditions are re-run only for rules reading a
+    // channel that changed (value or presence) since the previous call.
+    // Calls onChange(index, firing) when a rule starts or stops firing.
+    template <typename Fn>
+    void update(const SensorSnapshot& readings, uint32_t now, Fn&& onChange) {
+        uint32_t changed = readings.validChannels ^ lastValid;
+        for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+            if (readings.has((SensorChannel)c) && readings.get((SensorChannel)c) != lastValues[c]) {
+                changed |= 1UL << c;
+                lastValues[c] = readings.get((SensorChannel)c);
+            }
+        }
+        lastValid = readings.validChannels;
+
+        for (uint8_t i = 0; i < count; i++) {
+            RuleState& state = states[i];
+            if (!state.evaluated || (programs[i].channelMask & changed)) {
+                state.condition = evaluateRule(programs[i], readings);
+                state.evaluated = true;
+                evaluations++;
+            }
+
+            if (state.condition != RULE_TRUE) {
+                state.holding = false;
+                if (state.firing) {
+                    state.firing = false;
+                    onChange(i, false);
+                }
+                continue;
+            }
+            if (!state.holding) {
+                state.holding = true;
+                state.since = now;
+            }
+            if (!state.firing && now - state.since >= programs[i].holdSeconds) {
+                state.firing = true;
+                state.fires++;
+                state.lastFired = now;
+                onChange(i, true);
+            }
+        }
+    }
+
+    // Pattern of the firing rule with the highest pattern, or RULE_LED_NONE
+    RuleLedPattern ledPattern() const {
+        uint8_t pattern = RULE_LED_NONE;
+        for (uint8_t i = 0; i < count; i++) {
+            if (states[i].firing && (programs[i].actions & RULE_ACTION_LED) && programs[i].ledPattern > pattern) {
+                pattern = programs[i].ledPattern;
+            }
+        }
+        return (RuleLedPattern)pattern;
+    }
+
+    uint32_t getEvaluations() const { return evaluations; }
+
+private:
+    RuleProgram programs[Capacity];
+    RuleState states[Capacity];
+    uint8_t count = 0;
+    int32_t lastValues[CHANNEL_COUNT] = {};
+    uint32_t lastValid = 0;
+    uint32_t evaluations = 0;  // Bytecode runs (skipped rules don't count)
+};
+
+#endif // RULES_ENGINE_H
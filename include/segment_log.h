@@ -0,0 +1,214 @@
+#ifndef SEGMENT_LOG_H
+#define SEGMENT_LOG_H
+
+// Append-Only Segment Log
+// =======================
+// Sealed SensorBlocks (sensor_codec.h) are appended to numbered segment files
+// (<dir>/00000001.seg, ...) on a flash filesystem. Each block is one 256-byte
+// record carrying its own magic and CRC, and batches ~80 sensor records, so
+// the log writes one flash page every few minutes.
+//
+// - A segment holds `segmentBlocks` blocks; then the next one is started and,
+//   beyond `maxSegments`, the oldest segment file is deleted
+// - After a power loss only the tail segment is scanned: blocks are checked
+//   up to the first bad one, and if a torn write is found a fresh segment is
+//   started (readers stop at the first invalid block of a segment, so the
+//   torn tail is never returned)
+// - Counters track bytes written vs useful bytes (write amplification from
+//   padding blocks to full pages) and lifetime bytes for flash-wear estimates
+//
+// FileSystem only needs the fs::FS subset used below (open/exists/mkdir/
+// remove, File read/write/size/seek/openNextFile/name), so the log runs
+// against LittleFS on the board or a thin stdio wrapper on a host.
+// Not thread-safe: callers serialize access.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_codec.h"
+
+struct SegmentLogStats {
+    uint32_t blocksWritten = 0;
+    uint32_t bytesWritten = 0;     // Bytes handed to the filesystem
+    uint32_t payloadBytes = 0;     // Useful bytes in those blocks (header + used payload)
+    uint32_t segmentsCreated = 0;
+    uint32_t segmentsRotated = 0;  // Oldest segments deleted to make room
+    uint32_t tornBlocks = 0;       // Invalid blocks found at the tail after a reset
+    uint32_t writeErrors = 0;
+    uint64_t lifetimeBytes = 0;    // bytesWritten across reboots (restored by the caller)
+
+    // Bytes written per useful byte (>= 1; padding each block to a full page)
+    float writeAmplification() const {
+        return payloadBytes > 0 ? (float)bytesWritten / payloadBytes : 0;
+    }
+};
+
+template <typename FileSystem>
+class SegmentLog {
+public:
+    bool begin(FileSystem& fileSystem, const char* directory, uint16_t blocksPerSegment, uint16_t segmentLimit) {
+        fs = &fileSystem;
+        dir = directory;
+        segmentBlocks = blocksPerSegment;
+        maxSegments = segmentLimit;
+
+        if (!fs->exists(dir) && !fs->mkdir(dir)) {
+            fs = NULL;
+            return false;
+        }
+
+        // Segment numbers from the file names only; no segment is read here
+        firstSegment = 0;
+        lastSegment = 0;
+        auto root = fs->open(dir);
+        auto file = root.openNextFile();
+        while (file) {
+            uint32_t number = strtoul(baseName(file.name()), NULL, 10);
+            if (number > 0) {
+                if (firstSegment == 0 || number < firstSegment) firstSegment = number;
+                if (number > lastSegment) lastSegment = number;
+            }
+            file = root.openNextFile();
+        }
+
+        if (lastSegment == 0) {
+            firstSegment = lastSegment = 1;
+            tailBlocks = 0;
+        } else {
+            recoverTail();
+        }
+        rotate();
+        return true;
+    }
+
+    bool isReady() const { return fs != NULL; }
+
+    bool append(const SensorBlock& block) {
+        if (fs == NULL) {
+            return false;
+        }
+        if (tailBlocks >= segmentBlocks) {
+            lastSegment++;
+            tailBlocks = 0;
+            stats.segmentsCreated++;
+            rotate();
+        }
+
+        char path[48];
+        segmentPath(lastSegment, path, sizeof(path));
+        auto file = fs->open(path, "a");
+        size_t written = file ? file.write((const uint8_t*)&block, sizeof(SensorBlock)) : 0;
+        if (file) {
+            file.close();  // Commits the append (LittleFS is copy-on-write)
+        }
+
+        stats.bytesWritten += written;
+        stats.lifetimeBytes += written;
+        if (written != sizeof(SensorBlock)) {
+            stats.writeErrors++;
+            // A partial block is skipped on read; keep later blocks readable
+            // by moving on to a new segment
+            tailBlocks = segmentBlocks;
+            return false;
+        }
+        tailBlocks++;
+        stats.blocksWritten++;
+        stats.payloadBytes += sizeof(SensorBlockHeader) + (block.header.bits + 7) / 8;
+        return true;
+    }
+
+    // Segments currently held: [getFirstSegment(), getLastSegment()]
+    uint32_t getFirstSegment() const { return firstSegment; }
+    uint32_t getLastSegment() const { return lastSegment; }
+    uint16_t getTailBlocks() const { return tailBlocks; }
+    uint16_t getSegmentBlocks() const { return segmentBlocks; }
+    uint16_t getMaxSegments() const { return maxSegments; }
+
+    // Reads up to `count` blocks of a segment starting at block `first`, in
+    // batches so a reader can release its lock between them (a segment may be
+    // rotated away meanwhile; it then reads as empty). Stops at the first
+    // invalid block. Returns the number of valid blocks read into `out`.
+    uint16_t readBlocks(uint32_t segment, uint16_t first, SensorBlock* out, uint16_t count) {
+        if (fs == NULL) {
+            return 0;
+        }
+        char path[48];
+        segmentPath(segment, path, sizeof(path));
+        auto file = fs->open(path, "r");
+        if (!file) {
+            return 0;
+        }
+        uint16_t read = 0;
+        if (file.seek((uint32_t)first * sizeof(SensorBlock))) {
+            while (read < count && file.read((uint8_t*)&out[read], sizeof(SensorBlock)) == sizeof(SensorBlock) &&
+                   SensorBlockDecoder::isValid(out[read])) {
+                read++;
+            }
+        }
+        file.close();
+        return read;
+    }
+
+    const SegmentLogStats& getStats() const { return stats; }
+    void setLifetimeBytes(uint64_t bytes) { stats.lifetimeBytes = bytes; }
+
+private:
+    // Scans the tail segment once after boot: counts its valid blocks and
+    // starts a new segment if the last write was torn
+    void recoverTail() {
+        char path[48];
+        segmentPath(lastSegment, path, sizeof(path));
+        auto file = fs->open(path, "r");
+        size_t size = file ? file.size() : 0;
+
+        uint16_t valid = 0;
+        SensorBlock block;
+        while (file && file.read((uint8_t*)&block, sizeof(block)) == sizeof(block) &&
+               SensorBlockDecoder::isValid(block)) {
+            valid++;
+        }
+        if (file) {
+            file.close();
+        }
+
+        tailBlocks = valid;
+        size_t validBytes = (size_t)valid * sizeof(SensorBlock);
+        if (size > validBytes) {
+            stats.tornBlocks += (size - validBytes + sizeof(SensorBlock) - 1) / sizeof(SensorBlock);
+            tailBlocks = segmentBlocks;  // Next append opens a fresh segment
+        }
+    }
+
+    // Deletes the oldest segments beyond maxSegments
+    void rotate() {
+        while (lastSegment - firstSegment + 1 > maxSegments) {
+            char path[48];
+            segmentPath(firstSegment, path, sizeof(path));
+            fs->remove(path);
+            firstSegment++;
+            stats.segmentsRotated++;
+        }
+    }
+
+    void segmentPath(uint32_t segment, char* path, size_t size) const {
+        snprintf(path, size, "%s/%08lu.seg", dir, (unsigned long)segment);
+    }
+
+    // File::name() is the bare name on LittleFS but may include the directory elsewhere
+    static const char* baseName(const char* name) {
+        const char* slash = strrchr(name, '/');
+        return slash != NULL ? slash + 1 : name;
+    }
+
+    FileSystem* fs = NULL;
+    const char* dir = "";
+    uint16_t segmentBlocks = 64;
+    uint16_t maxSegments = 16;
+    uint32_t firstSegment = 0;
+    uint32_t lastSegment = 0;
+    uint16_t tailBlocks = 0;  // Blocks in the last segment
+    SegmentLogStats stats;
+};
+
+#endif // SEGMENT_LOG_H
@@ -0,0 +1,359 @@
+#ifndef SENSOR_CODEC_H
+#define SENSOR_CODEC_H
+
+// Compressed Sensor Blocks
+// ========================
+// Gorilla-style bit-packed encoding of sensor records into sealed, fixed-size
+// blocks (SENSOR_BLOCK_SIZE bytes) that can be kept in RAM or written to flash
+// as-is.
+//
+// Timestamps are delta-of-delta encoded: a steady 5 s cycle costs 1 bit.
+// Channel values are the quantized int16 values of the history ring
+// (HISTORY_QUANTIZATION), so a block holds exactly what the raw ring would.
+// They are integers rather than floats, so instead of Gorilla's XOR scheme
+// each value is stored as a zigzag delta from the channel's previous value
+// in a prefix-coded bucket:
+//
+//   0                     unchanged (same value, or still missing)
+//   10    + 2 bits        |delta| <= 2
+//   110   + 5 bits        |delta| <= 16
+//   1110  + 9 bits        |delta| <= 256
+//   11110 + 16 bits       absolute value
+//   11111                 channel lost its reading
+//
+// Slow-moving channels (pressure, altitude, a missing CO2 sensor) mostly cost
+// 1 bit per record; temperature/humidity noise a few bits.
+//
+// A block decodes on its own: the first record starts from an all-missing
+// state and the block's first timestamp. Timestamps are relative to the
+// header's firstTime, so the header can be rebased (e.g. from seconds since
+// boot to Unix time before the block is written to flash) without touching
+// the payload.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "sensor_snapshot.h"
+#include "sensor_history.h"
+
+#define SENSOR_BLOCK_SIZE 256
+#define SENSOR_BLOCK_MAGIC 0x53424C4B  // "SBLK"
+#define SENSOR_BLOCK_UNIX_TIME 0x0001  // Header times are Unix seconds (else seconds since boot)
+
+struct SensorBlockHeader {
+    uint32_t magic;
+    uint32_t firstTime;   // Timestamp of the first record (seconds)
+    uint32_t lastTime;    // Timestamp of the last record
+    uint16_t records;
+    uint16_t bits;        // Payload bits used
+    uint16_t flags;       // SENSOR_BLOCK_UNIX_TIME
+    uint16_t bootCount;   // Boot the block was recorded in (identifies since-boot times)
+    uint32_t crc;         // See sensorBlockCrc(), set when the block is sealed
+};
+
+#define SENSOR_BLOCK_PAYLOAD (SENSOR_BLOCK_SIZE - sizeof(SensorBlockHeader))
+
+struct SensorBlock {
+    SensorBlockHeader header;
+    uint8_t payload[SENSOR_BLOCK_PAYLOAD];
+};
+
+static_assert(sizeof(SensorBlock) == SENSOR_BLOCK_SIZE, "SensorBlock must be exactly one block");
+
+// CRC-32 (IEEE 802.3, reflected), bitwise: blocks are sealed once per few
+// minutes, so a 1 KB lookup table isn't worth the RAM
+inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// CRC-32 of the header (up to the crc field) and the used part of the payload
+inline uint32_t sensorBlockCrc(const SensorBlock& block) {
+    uint32_t crc = crc32Update(0, (const uint8_t*)&block.header, offsetof(SensorBlockHeader, crc));
+    return crc32Update(crc, block.payload, (block.header.bits + 7) / 8);
+}
+
+inline uint32_t zigzagEncode(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int32_t zigzagDecode(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Shared predictor state: what the next record is encoded against
+struct SensorCodecState {
+    uint32_t previousTime = 0;
+    int32_t previousDelta = 0;
+    int16_t previous[HISTORY_CHANNEL_COUNT] = {};
+    uint32_t previousValid = 0;  // Bit per channel
+};
+
+class SensorBlockEncoder {
+public:
+    // Worst case: 35 timestamp bits + 21 bits per channel
+    static constexpr uint16_t MAX_RECORD_BITS = 35 + 21 * HISTORY_CHANNEL_COUNT;
+
+    void begin(SensorBlock* target) {
+        block = target;
+        memset(block, 0, sizeof(SensorBlock));
+        block->header.magic = SENSOR_BLOCK_MAGIC;
+        state = SensorCodecState();
+    }
+
+    // Returns false (and leaves the block untouched) if the record might not fit
+    bool append(uint32_t timestamp, const SensorSnapshot& snapshot) {
+        SensorBlockHeader& header = block->header;
+        if ((size_t)header.bits + MAX_RECORD_BITS > SENSOR_BLOCK_PAYLOAD * 8 || header.records == UINT16_MAX) {
+            return false;
+        }
+        if (header.records == 0) {
+            header.firstTime = timestamp;
+            state.previousTime = timestamp;
+        }
+
+        // Timestamp: delta-of-delta
+        int32_t delta = (int32_t)(timestamp - state.previousTime);
+        uint32_t dod = zigzagEncode((int32_t)((uint32_t)delta - (uint32_t)state.previousDelta));
+        if (dod == 0) {
+            writeBits(0, 1);
+        } else if (dod < (1UL << 7)) {
+            writeBits(0b10, 2);
+            writeBits(dod, 7);
+        } else if (dod < (1UL << 12)) {
+            writeBits(0b110, 3);
+            writeBits(dod, 12);
+        } else {
+            writeBits(0b111, 3);
+            writeBits(dod, 32);
+        }
+        state.previousDelta = delta;
+        state.previousTime = timestamp;
+
+        // Values: zigzag delta buckets
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            uint32_t bit = 1UL << c;
+            bool wasValid = state.previousValid & bit;
+            if (!snapshot.has((SensorChannel)c)) {
+                writeBits(wasValid ? 0b11111 : 0, wasValid ? 5 : 1);
+                state.previousValid &= ~bit;
+                continue;
+            }
+            int16_t value = SensorHistory::quantize((SensorChannel)c, snapshot.values[c]);
+            uint32_t zz = zigzagEncode((int32_t)value - state.previous[c]);
+            if (wasValid && zz == 0) {
+                writeBits(0, 1);
+            } else if (zz < (1UL << 2)) {
+                writeBits(0b10, 2);
+                writeBits(zz, 2);
+            } else if (zz < (1UL << 5)) {
+                writeBits(0b110, 3);
+                writeBits(zz, 5);
+            } else if (zz < (1UL << 9)) {
+                writeBits(0b1110, 4);
+                writeBits(zz, 9);
+            } else {
+                writeBits(0b11110, 5);
+                writeBits((uint16_t)value, 16);
+            }
+            state.previous[c] = value;
+            state.previousValid |= bit;
+        }
+
+        header.lastTime = timestamp;
+        header.records++;
+        return true;
+    }
+
+    // Finalizes the header; the block must not be appended to afterwards
+    // (if the header is rebased later, recompute the CRC)
+    void seal() {
+        block->header.crc = sensorBlockCrc(*block);
+    }
+
+    bool isEmpty() const { return block == NULL || block->header.records == 0; }
+
+private:
+    void writeBits(uint32_t value, uint8_t count) {
+        uint16_t& bits = block->header.bits;
+        for (int8_t i = count - 1; i >= 0; i--) {
+            if (value & (1UL << i)) {
+                block->payload[bits >> 3] |= (uint8_t)(0x80 >> (bits & 7));
+            }
+            bits++;
+        }
+    }
+
+    SensorBlock* block = NULL;
+    SensorCodecState state;
+};
+
+class SensorBlockDecoder {
+public:
+    explicit SensorBlockDecoder(const SensorBlock& source) : block(source) {
+        state.previousTime = block.header.firstTime;
+    }
+
+    // Magic and CRC check (use on blocks read back from flash)
+    static bool isValid(const SensorBlock& block) {
+        return block.header.magic == SENSOR_BLOCK_MAGIC && block.header.bits <= SENSOR_BLOCK_PAYLOAD * 8 &&
+               block.header.crc == sensorBlockCrc(block);
+    }
+
+    // Decodes the next record; false once every record has been read
+    bool next(uint32_t& timestamp, SensorSnapshot& snapshot) {
+        if (decoded >= block.header.records) {
+            return false;
+        }
+
+        uint32_t dod;
+        if (readBits(1) == 0) {
+            dod = 0;
+        } else if (readBits(1) == 0) {
+            dod = readBits(7);
+        } else if (readBits(1) == 0) {
+            dod = readBits(12);
+        } else {
+            dod = readBits(32);
+        }
+        // Modulo 2^32 like the encoder, so a corrupted block can't overflow
+        state.previousDelta = (int32_t)((uint32_t)state.previousDelta + (uint32_t)zigzagDecode(dod));
+        state.previousTime += (uint32_t)state.previousDelta;
+        timestamp = state.previousTime;
+
+        snapshot.validChannels = 0;
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            uint32_t bit = 1UL << c;
+            uint8_t prefix = 0;
+            while (prefix < 5 && readBits(1) == 1) {
+                prefix++;
+            }
+            switch (prefix) {
+                case 0: break;  // Unchanged
+                case 1: state.previous[c] += zigzagDecode(readBits(2)); state.previousValid |= bit; break;
+                case 2: state.previous[c] += zigzagDecode(readBits(5)); state.previousValid |= bit; break;
+                case 3: state.previous[c] += zigzagDecode(readBits(9)); state.previousValid |= bit; break;
+                case 4: state.previous[c] = (int16_t)readBits(16); state.previousValid |= bit; break;
+                default: state.previousValid &= ~bit; break;  // Lost its reading
+            }
+            if (state.previousValid & bit) {
+                snapshot.set((SensorChannel)c, SensorHistory::dequantize((SensorChannel)c, state.previous[c]));
+            }
+        }
+
+        decoded++;
+        return true;
+    }
+
+private:
+    uint32_t readBits(uint8_t count) {
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t byte = position < SENSOR_BLOCK_PAYLOAD * 8 ? block.payload[position >> 3] : 0;
+            value = (value << 1) | ((byte >> (7 - (position & 7))) & 1);
+            position++;
+        }
+        return value;
+    }
+
+    const SensorBlock& block;
+    SensorCodecState state;
+    uint32_t position = 0;
+    uint16_t decoded = 0;
+};
+
+// Ring of compressed blocks in RAM: the open block receives every record,
+// and once full it is sealed and the oldest block is overwritten.
+// Not thread-safe: callers serialize access.
+class SensorBlockRing {
+public:
+    ~SensorBlockRing() { free(blocks); }
+
+    bool begin(size_t blockCount) {
+        free(blocks);
+        blocks = NULL;
+        capacityBlocks = 0;
+        sealedTotal = 0;
+        recordsTotal = 0;
+        if (blockCount < 2) {
+            return false;
+        }
+        blocks = (SensorBlock*)malloc(blockCount * sizeof(SensorBlock));
+        if (blocks == NULL) {
+            return false;
+        }
+        capacityBlocks = blockCount;
+        encoder.begin(&blocks[0]);
+        return true;
+    }
+
+    // Appends one record; returns the block it sealed to make room (valid
+    // until the ring wraps around to it again), or NULL
+    const SensorBlock* append(uint32_t timestamp, const SensorSnapshot& snapshot) {
+        if (capacityBlocks == 0) {
+            return NULL;
+        }
+        const SensorBlock* sealed = NULL;
+        if (!encoder.append(timestamp, snapshot)) {
+            sealed = sealOpenBlock();
+            encoder.append(timestamp, snapshot);
+        }
+        recordsTotal++;
+        return sealed;
+    }
+
+    // Seals the open block early (e.g. before a reboot); NULL if it is empty
+    const SensorBlock* flush() {
+        if (capacityBlocks == 0 || encoder.isEmpty()) {
+            return NULL;
+        }
+        return sealOpenBlock();
+    }
+
+    bool isReady() const { return capacityBlocks > 0; }
+    size_t capacity() const { return capacityBlocks; }
+    uint32_t getSealedTotal() const { return sealedTotal; }
+    uint32_t getRecordsTotal() const { return recordsTotal; }
+
+    // Sealed blocks still held, oldest first: block(0) .. block(sealedCount() - 1)
+    size_t sealedCount() const {
+        return sealedTotal < capacityBlocks - 1 ? sealedTotal : capacityBlocks - 1;
+    }
+    const SensorBlock& block(size_t index) const {
+        return blocks[(sealedTotal - sealedCount() + index) % capacityBlocks];
+    }
+    const SensorBlock& openBlock() const { return blocks[sealedTotal % capacityBlocks]; }
+
+    // Records currently held (sealed blocks + open block)
+    uint32_t recordsHeld() const {
+        uint32_t total = openBlock().header.records;
+        for (size_t i = 0; i < sealedCount(); i++) {
+            total += block(i).header.records;
+        }
+        return total;
+    }
+
+private:
+    const SensorBlock* sealOpenBlock() {
+        encoder.seal();
+        const SensorBlock* sealed = &blocks[sealedTotal % capacityBlocks];
+        sealedTotal++;
+        encoder.begin(&blocks[sealedTotal % capacityBlocks]);
+        return sealed;
+    }
+
+    SensorBlock* blocks = NULL;
+    size_t capacityBlocks = 0;
+    uint32_t sealedTotal = 0;   // Blocks sealed since boot
+    uint32_t recordsTotal = 0;  // Records appended since boot
+    SensorBlockEncoder encoder;
+};
+
+#endif // SENSOR_CODEC_H
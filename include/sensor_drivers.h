@@ -0,0 +1,373 @@
+#ifndef SENSOR_DRIVERS_H
+#define SENSOR_DRIVERS_H
+
+// Sensor Drivers
+// Drivers for the sensor registry (see sensor_registry.h for the interface).
+// A board lists the drivers it uses in BOARD_SENSORS (board_config.h); drivers
+// not listed there are never instantiated.
+//
+// Every driver talks to the bus through I2CManager so transactions are
+// serialized, timed and counted per address, and converts to the channels'
+// fixed-point units with integer math only (no FPU on the ESP32-C3).
+
+#include <Arduino.h>
+#include "i2c_manager.h"
+#include "sensor_snapshot.h"
+#include "env_math.h"
+
+// Sensirion CRC-8 (polynomial 0x31, init 0xFF) used by SHT4x, SCD4x and AHT20
+inline uint8_t sensirionCrc(const uint8_t* data, size_t length) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Sensirion responses are 16-bit words, each followed by its CRC
+inline bool sensirionCheckWords(const uint8_t* data, uint8_t words) {
+    for (uint8_t i = 0; i < words; i++) {
+        if (sensirionCrc(&data[i * 3], 2) != data[i * 3 + 2]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================
+// BMP280 - temperature, pressure, altitude
+// ============================================
+// Register-level driver: raw ADC values are compensated with the datasheet
+// integer formulas and altitude comes from a lookup table (env_math.h), so a
+// read does no floating point at all.
+class Bmp280Driver {
+public:
+    static constexpr const char* NAME = "BMP280";
+    static constexpr const char* STATUS_KEY = "bmpAvailable";
+    static constexpr SensorChannel CHANNELS[] = {CHANNEL_TEMPERATURE, CHANNEL_PRESSURE, CHANNEL_ALTITUDE};
+    static constexpr unsigned long INTERVAL_MS = 5000;
+
+    // Registers
+    static constexpr uint8_t REG_CALIBRATION = 0x88;
+    static constexpr uint8_t REG_CHIP_ID = 0xD0;
+    static constexpr uint8_t REG_RESET = 0xE0;
+    static constexpr uint8_t REG_STATUS = 0xF3;
+    static constexpr uint8_t REG_CTRL_MEAS = 0xF4;
+    static constexpr uint8_t REG_CONFIG = 0xF5;
+    static constexpr uint8_t REG_DATA = 0xF7;  // press_msb..temp_xlsb (6 bytes)
+
+    // Normal mode, temperature x2, pressure x16, IIR filter x16, 500 ms standby
+    static constexpr uint8_t CTRL_MEAS_DEFAULT = (0x2 << 5) | (0x5 << 2) | 0x3;
+    static constexpr uint8_t CONFIG_DEFAULT = (0x4 << 5) | (0x4 << 2);
+
+    // Burst capture: normal mode, temperature x1, pressure x1, IIR off, 0.5 ms
+    // standby - a fresh conversion every ~7 ms
+    static constexpr uint8_t CTRL_MEAS_BURST = (0x1 << 5) | (0x1 << 2) | 0x3;
+    static constexpr uint8_t CONFIG_BURST = 0x00;
+
+    // 0x76 is the common breakout address, 0x77 the alternate
+    bool begin(I2CManager& bus) {
+        return beginAt(bus, 0x76) || beginAt(bus, 0x77);
+    }
+
+    // Out-of-range values mean the bus returned garbage (e.g. a floating SDA line)
+    bool read(I2CManager& bus, SensorSnapshot& readings) {
+        int32_t temperature;
+        int32_t pressure;
+        if (!readCompensated(bus, temperature, pressure) || temperature < -4000 || temperature > 8500 ||
+            pressure < 30000 || pressure > 110000) {
+            return false;
+        }
+
+        readings.set(CHANNEL_TEMPERATURE, temperature);
+        readings.set(CHANNEL_PRESSURE, pressure);
+        readings.set(CHANNEL_ALTITUDE, altitudeCm(pressure));
+        return true;
+    }
+
+    // Temperature in 0.01 °C, pressure in Pa
+    bool readCompensated(I2CManager& bus, int32_t& temperature, int32_t& pressure) {
+        uint32_t pressureQ8;
+        if (!readCompensatedQ8(bus, temperature, pressureQ8)) {
+            return false;
+        }
+        pressure = (int32_t)((pressureQ8 + 128) >> 8);
+        return true;
+    }
+
+    // Temperature in 0.01 °C, pressure in Pa * 256 (full compensation resolution)
+    bool readCompensatedQ8(I2CManager& bus, int32_t& temperature, uint32_t& pressureQ8) {
+        uint8_t raw[6];
+        if (!bus.readRegisters(addr, REG_DATA, raw, sizeof(raw))) {
+            return false;
+        }
+        int32_t adcP = ((int32_t)raw[0] << 12) | ((int32_t)raw[1] << 4) | (raw[2] >> 4);
+        int32_t adcT = ((int32_t)raw[3] << 12) | ((int32_t)raw[4] << 4) | (raw[5] >> 4);
+        if (adcT == 0x80000 || adcP == 0x80000) {
+            return false;  // Measurement skipped (sensor was reset / not configured)
+        }
+
+        int32_t tFine = bmp280TFine(calibration, adcT);
+        temperature = bmp280TemperatureCenti(tFine);
+        pressureQ8 = bmp280PressureQ8(calibration, adcP, tFine);
+        return true;
+    }
+
+    // Writes ctrl_meas/config (used to restore defaults after a burst capture)
+    bool configure(I2CManager& bus, uint8_t ctrlMeas, uint8_t config) {
+        // Config writes are only guaranteed in sleep mode
+        const uint8_t sleep[2] = {REG_CTRL_MEAS, 0x00};
+        const uint8_t configBytes[2] = {REG_CONFIG, config};
+        const uint8_t measBytes[2] = {REG_CTRL_MEAS, ctrlMeas};
+        return bus.writeBytes(addr, sleep, 2) && bus.writeBytes(addr, configBytes, 2) &&
+               bus.writeBytes(addr, measBytes, 2);
+    }
+
+    uint8_t address() const { return addr; }
+
+private:
+    bool beginAt(I2CManager& bus, uint8_t candidate) {
+        bus.registerDevice(candidate, NAME);
+
+        // 0x58 = BMP280 (0x56/0x57 engineering samples), 0x60 = BME280 (same T/P block)
+        uint8_t chipId = 0;
+        if (!bus.readRegisters(candidate, REG_CHIP_ID, &chipId, 1) ||
+            (chipId != 0x58 && chipId != 0x56 && chipId != 0x57 && chipId != 0x60)) {
+            return false;
+        }
+
+        // Soft reset, then wait for the NVM calibration copy to finish
+        const uint8_t reset[2] = {REG_RESET, 0xB6};
+        if (!bus.writeBytes(candidate, reset, 2)) {
+            return false;
+        }
+        delay(5);
+        uint8_t status = 0x01;
+        for (int i = 0; i < 10 && (status & 0x01); i++) {
+            if (!bus.readRegisters(candidate, REG_STATUS, &status, 1)) {
+                return false;
+            }
+            delay(2);
+        }
+
+        uint8_t raw[24];
+        if (!bus.readRegisters(candidate, REG_CALIBRATION, raw, sizeof(raw))) {
+            return false;
+        }
+        calibration.parse(raw);
+
+        addr = candidate;
+        if (!configure(bus, CTRL_MEAS_DEFAULT, CONFIG_DEFAULT)) {
+            return false;
+        }
+        bus.setAttached(candidate, true);
+        return true;
+    }
+
+    Bmp280Calibration calibration = {};
+    uint8_t addr = 0x76;
+};
+
+// ============================================
+// AHT20 - temperature, humidity
+// ============================================
+class Aht20Driver {
+public:
+    static constexpr const char* NAME = "AHT20";
+    static constexpr const char* STATUS_KEY = "ahtAvailable";
+    static constexpr SensorChannel CHANNELS[] = {CHANNEL_TEMPERATURE, CHANNEL_HUMIDITY};
+    static constexpr unsigned long INTERVAL_MS = 5000;
+    static constexpr uint8_t ADDRESS = 0x38;
+
+    static constexpr uint8_t STATUS_BUSY = 0x80;
+    static constexpr uint8_t STATUS_CALIBRATED = 0x08;
+
+    bool begin(I2CManager& bus) {
+        bus.registerDevice(ADDRESS, NAME);
+
+        uint8_t status = 0;
+        if (!bus.read(ADDRESS, &status, 1)) {
+            return false;
+        }
+
+        // Load the calibration coefficients if the sensor hasn't already
+        if (!(status & STATUS_CALIBRATED)) {
+            const uint8_t calibrate[3] = {0xBE, 0x08, 0x00};
+            if (!bus.writeBytes(ADDRESS, calibrate, 3)) {
+                return false;
+            }
+            delay(10);
+            if (!bus.read(ADDRESS, &status, 1) || !(status & STATUS_CALIBRATED)) {
+                return false;
+            }
+        }
+
+        bus.setAttached(ADDRESS, true);
+        return true;
+    }
+
+    bool read(I2CManager& bus, SensorSnapshot& readings) {
+        const uint8_t trigger[3] = {0xAC, 0x33, 0x00};
+        if (!bus.writeBytes(ADDRESS, trigger, 3)) {
+            return false;
+        }
+        delay(80);  // Datasheet measurement time
+
+        // Bounded busy wait (a missing sensor reads back as 0xFF = always busy)
+        uint8_t data[7];
+        for (int attempt = 0;; attempt++) {
+            if (!bus.read(ADDRESS, data, sizeof(data))) {
+                return false;
+            }
+            if (!(data[0] & STATUS_BUSY)) {
+                break;
+            }
+            if (attempt >= 3) {
+                return false;
+            }
+            delay(20);
+        }
+        if (sensirionCrc(data, 6) != data[6]) {  // Same CRC-8 as Sensirion parts
+            return false;
+        }
+
+        // 20-bit raw values (top 16 bits used so the products fit in 32 bits)
+        uint32_t rawHumidity = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) | (data[3] >> 4);
+        uint32_t rawTemperature = (((uint32_t)data[3] & 0x0F) << 16) | ((uint32_t)data[4] << 8) | data[5];
+        readings.set(CHANNEL_TEMPERATURE, (int32_t)(((rawTemperature >> 4) * 1250) >> 12) - 5000);
+        readings.set(CHANNEL_HUMIDITY, (int32_t)(((rawHumidity >> 4) * 625) >> 12));
+        return true;
+    }
+
+    uint8_t address() const { return ADDRESS; }
+};
+
+// ============================================
+// SHT4x - temperature, humidity (Sensirion)
+// ============================================
+class Sht4xDriver {
+public:
+    static constexpr const char* NAME = "SHT4x";
+    static constexpr const char* STATUS_KEY = "shtAvailable";
+    static constexpr SensorChannel CHANNELS[] = {CHANNEL_TEMPERATURE, CHANNEL_HUMIDITY};
+    static constexpr unsigned long INTERVAL_MS = 5000;
+    static constexpr uint8_t ADDRESS = 0x44;
+
+    bool begin(I2CManager& bus) {
+        bus.registerDevice(ADDRESS, NAME);
+
+        // Soft reset, then read the serial number as a presence check
+        const uint8_t reset = 0x94;
+        const uint8_t readSerial = 0x89;
+        uint8_t serial[6];
+        if (!bus.writeBytes(ADDRESS, &reset, 1)) {
+            return false;
+        }
+        delay(2);
+        if (!bus.writeBytes(ADDRESS, &readSerial, 1)) {
+            return false;
+        }
+        delay(2);
+        if (!bus.read(ADDRESS, serial, sizeof(serial)) || !sensirionCheckWords(serial, 2)) {
+            return false;
+        }
+
+        bus.setAttached(ADDRESS, true);
+        return true;
+    }
+
+    bool read(I2CManager& bus, SensorSnapshot& readings) {
+        const uint8_t measureHighPrecision = 0xFD;
+        uint8_t data[6];
+        if (!bus.writeBytes(ADDRESS, &measureHighPrecision, 1)) {
+            return false;
+        }
+        delay(10);  // 8.3 ms max measurement time at high precision
+        if (!bus.read(ADDRESS, data, sizeof(data)) || !sensirionCheckWords(data, 2)) {
+            return false;
+        }
+
+        int32_t rawTemperature = (data[0] << 8) | data[1];
+        int32_t rawHumidity = (data[3] << 8) | data[4];
+        int32_t humidity = -600 + 12500 * rawHumidity / 65535;
+        readings.set(CHANNEL_TEMPERATURE, -4500 + 17500 * rawTemperature / 65535);
+        readings.set(CHANNEL_HUMIDITY, constrain(humidity, (int32_t)0, (int32_t)10000));
+        return true;
+    }
+
+    uint8_t address() const { return ADDRESS; }
+};
+
+// ============================================
+// SCD4x - CO2, temperature, humidity (Sensirion)
+// ============================================
+// Runs in periodic measurement mode (one result every 5 s, matching UPDATE_INTERVAL)
+class Scd4xDriver {
+public:
+    static constexpr const char* NAME = "SCD4x";
+    static constexpr const char* STATUS_KEY = "scdAvailable";
+    static constexpr SensorChannel CHANNELS[] = {CHANNEL_CO2, CHANNEL_TEMPERATURE, CHANNEL_HUMIDITY};
+    static constexpr unsigned long INTERVAL_MS = 5000;
+    static constexpr uint8_t ADDRESS = 0x62;
+
+    bool begin(I2CManager& bus) {
+        bus.registerDevice(ADDRESS, NAME);
+
+        // Stop any measurement left running by a previous boot (takes 500 ms),
+        // then restart periodic measurement
+        if (!command(bus, 0x3F86)) {
+            return false;
+        }
+        delay(500);
+        if (!command(bus, 0x21B1)) {
+            return false;
+        }
+
+        bus.setAttached(ADDRESS, true);
+        return true;
+    }
+
+    bool read(I2CManager& bus, SensorSnapshot& readings) {
+        uint8_t status[3];
+        if (!command(bus, 0xE4B8)) {  // get_data_ready_status
+            return false;
+        }
+        delay(1);
+        if (!bus.read(ADDRESS, status, sizeof(status)) || !sensirionCheckWords(status, 1)) {
+            return false;
+        }
+        if ((((status[0] << 8) | status[1]) & 0x07FF) == 0) {
+            return true;  // No new measurement yet: keep the previous values
+        }
+
+        uint8_t data[9];
+        if (!command(bus, 0xEC05)) {  // read_measurement
+            return false;
+        }
+        delay(1);
+        if (!bus.read(ADDRESS, data, sizeof(data)) || !sensirionCheckWords(data, 3)) {
+            return false;
+        }
+
+        int32_t co2 = (data[0] << 8) | data[1];
+        int32_t rawTemperature = (data[3] << 8) | data[4];
+        int32_t rawHumidity = (data[6] << 8) | data[7];
+        readings.set(CHANNEL_CO2, co2);
+        readings.set(CHANNEL_TEMPERATURE, -4500 + 17500 * rawTemperature / 65536);
+        readings.set(CHANNEL_HUMIDITY, 10000 * rawHumidity / 65536);
+        return true;
+    }
+
+    uint8_t address() const { return ADDRESS; }
+
+private:
+    static bool command(I2CManager& bus, uint16_t code) {
+        uint8_t bytes[2] = {(uint8_t)(code >> 8), (uint8_t)(code & 0xFF)};
+        return bus.writeBytes(ADDRESS, bytes, sizeof(bytes));
+    }
+};
+
+#endif // SENSOR_DRIVERS_H
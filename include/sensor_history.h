@@ -0,0 +1,221 @@
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+// Sensor History Ring Buffer
+// ==========================
+// Fixed-capacity ring of one record per sensor cycle, sized once at boot from
+// free heap. Struct-of-arrays layout: one uint32 timestamp array plus one
+// int16 array per channel, so scanning or downsampling a single channel
+// touches only 2 bytes per record (16 bytes per record in total).
+//
+// Channel values are quantized to int16 (see HISTORY_QUANTIZATION); INT16_MIN
+// marks a record where the channel had no reading.
+//
+// Records are addressed by an absolute sequence number (0 = first record ever
+// appended), so a reader can aggregate in small steps - releasing any lock in
+// between - without being confused by records the writer overwrote meanwhile.
+//
+// Not thread-safe: callers serialize access (the firmware uses a mutex).
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_snapshot.h"
+
+#define HISTORY_MISSING INT16_MIN
+
+// Stored value = (channel value - offset) / step, in the channel's fixed-point units
+struct HistoryQuantization {
+    int32_t offset;
+    int32_t step;
+};
+
+static constexpr HistoryQuantization HISTORY_QUANTIZATION[HISTORY_CHANNEL_COUNT] = {
+    {0, 1},        // Temperature: 0.01 °C, ±327 °C
+    {70000, 4},    // Pressure: 0.04 hPa steps around 700 hPa, 300-1100 hPa fits
+    {0, 50},       // Altitude: 0.5 m steps, ±16 km
+    {0, 1},        // Humidity: 0.01 %RH
+    {0, 2},        // CO2: 2 ppm steps, up to 65534 ppm
+    {0, 1},        // Dew point: 0.01 °C
+};
+
+// min/max/avg of one channel over a range of records (values in channel units)
+struct HistoryAggregate {
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint32_t count;     // Records with a reading
+    uint32_t firstTime;
+    uint32_t lastTime;
+
+    int32_t average() const { return count > 0 ? (int32_t)(sum / (int64_t)count) : 0; }
+};
+
+class SensorHistory {
+public:
+    ~SensorHistory() { release(); }
+
+    // Allocates the arrays; returns false (and stays empty) if the heap can't hold them
+    bool begin(size_t records) {
+        release();
+        if (records == 0) {
+            return false;
+        }
+        timestamps = (uint32_t*)malloc(records * sizeof(uint32_t));
+        bool ok = timestamps != NULL;
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT && ok; c++) {
+            channels[c] = (int16_t*)malloc(records * sizeof(int16_t));
+            ok = channels[c] != NULL;
+        }
+        if (!ok) {
+            release();
+            return false;
+        }
+        capacityRecords = records;
+        return true;
+    }
+
+    static constexpr size_t bytesPerRecord() {
+        return sizeof(uint32_t) + HISTORY_CHANNEL_COUNT * sizeof(int16_t);
+    }
+
+    // O(1): overwrites the oldest record once full
+    void append(uint32_t timestamp, const SensorSnapshot& snapshot) {
+        if (capacityRecords == 0) {
+            return;
+        }
+        size_t slot = (size_t)(total % capacityRecords);
+        timestamps[slot] = timestamp;
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            channels[c][slot] = snapshot.has((SensorChannel)c) ? quantize((SensorChannel)c, snapshot.values[c])
+                                                               : HISTORY_MISSING;
+        }
+        total++;
+    }
+
+    size_t capacity() const { return capacityRecords; }
+    size_t size() const { return total < capacityRecords ? (size_t)total : capacityRecords; }
+    bool isReady() const { return capacityRecords > 0; }
+
+    // Valid sequence numbers are [firstSequence(), endSequence())
+    uint64_t firstSequence() const { return total - size(); }
+    uint64_t endSequence() const { return total; }
+
+    uint32_t timestampAt(uint64_t sequence) const {
+        return timestamps[sequence % capacityRecords];
+    }
+
+    // Returns false if the channel had no reading in that record
+    bool valueAt(SensorChannel channel, uint64_t sequence, int32_t& value) const {
+        int16_t stored = channels[channel][sequence % capacityRecords];
+        if (stored == HISTORY_MISSING) {
+            return false;
+        }
+        value = dequantize(channel, stored);
+        return true;
+    }
+
+    // First sequence whose timestamp is >= t (binary search; timestamps are monotonic)
+    uint64_t findSequence(uint32_t t) const {
+        uint64_t low = firstSequence();
+        uint64_t high = endSequence();
+        while (low < high) {
+            uint64_t mid = low + (high - low) / 2;
+            if (timestampAt(mid) < t) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // Aggregates one channel over [from, to) (clamped to the records still held).
+    // Scans only the timestamp array and that channel's int16 array.
+    HistoryAggregate aggregate(SensorChannel channel, uint64_t from, uint64_t to) const {
+        HistoryAggregate result = {INT32_MAX, INT32_MIN, 0, 0, 0, 0};
+        if (from < firstSequence()) {
+            from = firstSequence();
+        }
+        if (to > endSequence()) {
+            to = endSequence();
+        }
+        if (from >= to) {
+            return result;
+        }
+
+        const int16_t* values = channels[channel];
+        int32_t minStored = INT16_MAX;
+        int32_t maxStored = INT16_MIN;
+        int64_t sumStored = 0;
+        uint32_t count = 0;
+
+        // Walk the (at most two) contiguous slices of the ring
+        uint64_t sequence = from;
+        while (sequence < to) {
+            size_t slot = (size_t)(sequence % capacityRecords);
+            size_t run = capacityRecords - slot;
+            if (run > to - sequence) {
+                run = (size_t)(to - sequence);
+            }
+            for (size_t i = slot; i < slot + run; i++) {
+                int16_t v = values[i];
+                if (v == HISTORY_MISSING) {
+                    continue;
+                }
+                if (v < minStored) minStored = v;
+                if (v > maxStored) maxStored = v;
+                sumStored += v;
+                count++;
+            }
+            sequence += run;
+        }
+
+        result.firstTime = timestampAt(from);
+        result.lastTime = timestampAt(to - 1);
+        result.count = count;
+        if (count > 0) {
+            // Dequantization is linear, so it can be applied once to the aggregates
+            const HistoryQuantization& q = HISTORY_QUANTIZATION[channel];
+            result.min = dequantize(channel, (int16_t)minStored);
+            result.max = dequantize(channel, (int16_t)maxStored);
+            result.sum = sumStored * q.step + (int64_t)q.offset * count;
+        }
+        return result;
+    }
+
+    static int16_t quantize(SensorChannel channel, int32_t value) {
+        const HistoryQuantization& q = HISTORY_QUANTIZATION[channel];
+        int32_t stored = (value - q.offset) / q.step;
+        if (stored <= HISTORY_MISSING) {
+            stored = HISTORY_MISSING + 1;
+        } else if (stored > INT16_MAX) {
+            stored = INT16_MAX;
+        }
+        return (int16_t)stored;
+    }
+
+    static int32_t dequantize(SensorChannel channel, int16_t stored) {
+        const HistoryQuantization& q = HISTORY_QUANTIZATION[channel];
+        return (int32_t)stored * q.step + q.offset;
+    }
+
+private:
+    void release() {
+        free(timestamps);
+        timestamps = NULL;
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            free(channels[c]);
+            channels[c] = NULL;
+        }
+        capacityRecords = 0;
+        total = 0;
+    }
+
+    uint32_t* timestamps = NULL;
+    int16_t* channels[HISTORY_CHANNEL_COUNT] = {};
+    size_t capacityRecords = 0;
+    uint64_t total = 0;  // Records ever appended
+};
+
+#endif // SENSOR_HISTORY_H
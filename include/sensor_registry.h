@@ -0,0 +1,221 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+// Compile-Time Sensor Registry
+// ============================
+// The board's sensors are a std::tuple of driver types (BOARD_SENSORS in
+// board_config.h). Setup, polling, health checks and status serialization are
+// expanded per driver at compile time, so there is no virtual dispatch and no
+// per-sensor code in main.cpp.
+//
+// A driver is any class with:
+//
+//   static constexpr const char* NAME;          // e.g. "BMP280"
+//   static constexpr const char* STATUS_KEY;    // /status availability key, e.g. "bmpAvailable"
+//   static constexpr SensorChannel CHANNELS[];  // Channels it provides
+//   static constexpr unsigned long INTERVAL_MS; // Base time between reads
+//   bool begin(I2CManager& bus);                // Probe + configure, true if found
+//   bool read(I2CManager& bus, SensorSnapshot& readings);  // Sets its channels
+//   uint8_t address() const;                    // I2C address currently in use
+//
+// When several drivers provide the same channel, the one listed LAST wins.
+//
+// Each driver's interval adapts between INTERVAL_MS and the maximum passed to
+// beginAll() depending on how much its readings change (adaptive_sampling.h).
+
+#include <Arduino.h>
+#include <tuple>
+#include <utility>
+#include "i2c_manager.h"
+#include "log_ring.h"
+#include "sensor_snapshot.h"
+#include "env_math.h"
+#include "adaptive_sampling.h"
+
+template <typename... Drivers>
+class SensorRegistry {
+public:
+    static constexpr size_t SENSOR_COUNT = sizeof...(Drivers);
+    static_assert(SENSOR_COUNT <= 32, "attachedSensors is a 32-bit mask");
+
+    // Probes every driver once at boot; maxIntervalMs caps adaptive sampling
+    // (pass 0 to read every driver at its fixed INTERVAL_MS)
+    void beginAll(I2CManager& bus, unsigned long maxIntervalMs) {
+        forEach([&](auto& driver, size_t index) {
+            using Driver = std::decay_t<decltype(driver)>;
+            sampling[index].begin(Driver::INTERVAL_MS, maxIntervalMs);
+            attached[index] = driver.begin(bus);
+            if (attached[index]) {
+                LOG_I("sensor", "%s found at 0x%02X", Driver::NAME, driver.address());
+            } else {
+                LOG_E("sensor", "%s not found (check wiring: SDA GPIO%d, SCL GPIO%d)", Driver::NAME, I2C_SDA,
+                      I2C_SCL);
+            }
+        });
+    }
+
+    // Reads every attached driver whose (adaptive) interval has elapsed, then
+    // composes the snapshot from each driver's latest successful reading.
+    // A failed read keeps the previous value until the driver is detached.
+    // Returns false if the snapshot is unchanged (no driver was due and none
+    // was detached or reattached since the last call).
+    bool pollAll(I2CManager& bus, SensorSnapshot& snapshot, unsigned long now) {
+        bool anyRead = false;
+        forEach([&](auto& driver, size_t index) {
+            using Driver = std::decay_t<decltype(driver)>;
+            // Scheduled against the task's 5 s cycle, so allow a little jitter
+            if (!attached[index] || (lastRead[index] != 0 && now - lastRead[index] + 100 < sampling[index].current)) {
+                return;
+            }
+            lastRead[index] = now;
+            anyRead = true;
+            if (driver.read(bus, readings[index])) {
+                sampling[index].update(readings[index], Driver::CHANNELS,
+                                       sizeof(Driver::CHANNELS) / sizeof(Driver::CHANNELS[0]));
+            } else {
+                sampling[index].reset();  // Retry at the base rate
+            }
+        });
+        uint32_t attachedMask = 0;
+        for (size_t i = 0; i < SENSOR_COUNT; i++) {
+            attachedMask |= attached[i] ? (1UL << i) : 0;
+        }
+        if (!anyRead && attachedMask == snapshot.attachedSensors) {
+            return false;
+        }
+
+        snapshot.validChannels = 0;
+        snapshot.attachedSensors = 0;
+        forEach([&](auto& driver, size_t index) {
+            using Driver = std::decay_t<decltype(driver)>;
+            if (!attached[index]) {
+                return;
+            }
+            snapshot.attachedSensors |= (1UL << index);
+            for (SensorChannel channel : Driver::CHANNELS) {
+                if (readings[index].has(channel)) {
+                    snapshot.set(channel, readings[index].get(channel));
+                }
+            }
+        });
+        return true;
+    }
+
+    // Detaches drivers that keep failing and (if reprobe) re-probes missing ones.
+    // Returns true if any attached driver had a failed transaction.
+    bool checkHealth(I2CManager& bus, bool reprobe) {
+        bool failures = false;
+        forEach([&](auto& driver, size_t index) {
+            using Driver = std::decay_t<decltype(driver)>;
+            if (attached[index]) {
+                const I2CDeviceStats* stats = bus.find(driver.address());
+                if (stats != NULL && stats->consecutiveErrors > 0) {
+                    failures = true;
+                    if (stats->consecutiveErrors >= I2C_MAX_CONSECUTIVE_ERRORS) {
+                        attached[index] = false;
+                        lastRead[index] = 0;
+                        readings[index].validChannels = 0;
+                        sampling[index].reset();
+                        bus.setAttached(driver.address(), false);
+                        LOG_W("sensor", "%s stopped responding - detached (will re-probe)", Driver::NAME);
+                    }
+                }
+            } else if (reprobe && driver.begin(bus)) {
+                attached[index] = true;
+                LOG_I("sensor", "%s reattached at 0x%02X", Driver::NAME, driver.address());
+            }
+        });
+        return failures;
+    }
+
+    bool anyDetached() const {
+        for (size_t i = 0; i < SENSOR_COUNT; i++) {
+            if (!attached[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Access to a driver by type, e.g. sensors.get<Bmp280Driver>()
+    template <typename Driver>
+    Driver& get() { return std::get<Driver>(drivers); }
+
+    template <typename Driver>
+    bool isAttached() const { return attached[indexOf<Driver, Drivers...>()]; }
+
+    // Whether the board lists the driver, for `if constexpr` around get<Driver>()
+    template <typename Driver>
+    static constexpr bool contains() { return (std::is_same<Driver, Drivers>::value || ...); }
+
+    // Appends [{"name":..,"intervalMs":..,"reads":..,"snapBacks":..},...] (adaptive sampling state)
+    void writeSampling(String& json) {
+        json += "[";
+        forEach([&](auto& driver, size_t index) {
+            using Driver = std::decay_t<decltype(driver)>;
+            const AdaptiveInterval& state = sampling[index];
+            if (index > 0) json += ",";
+            json += "{\"name\":\"" + String(Driver::NAME) + "\",";
+            json += "\"intervalMs\":" + String(state.current) + ",";
+            json += "\"reads\":" + String(state.reads) + ",";
+            json += "\"snapBacks\":" + String(state.snapBacks) + "}";
+        });
+        json += "]";
+    }
+
+    // Appends "<STATUS_KEY>":true|false for every driver, then every valid channel
+    static void writeStatus(String& json, const SensorSnapshot& snapshot) {
+        writeAvailability<Drivers...>(json, snapshot, 0);
+
+        char value[FIXED_TEXT_SIZE];
+        for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+            if (snapshot.has((SensorChannel)channel)) {
+                const ChannelInfo& info = CHANNEL_INFO[channel];
+                formatFixed(value, sizeof(value), snapshot.values[channel], info.scale, info.decimals);
+                json += "\"";
+                json += info.statusKey;
+                json += "\":";
+                json += value;
+                json += ",";
+            }
+        }
+    }
+
+private:
+    template <typename Fn, size_t... I>
+    void forEachImpl(Fn& fn, std::index_sequence<I...>) {
+        (fn(std::get<I>(drivers), I), ...);
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        forEachImpl(fn, std::index_sequence_for<Drivers...>{});
+    }
+
+    template <typename Target, typename First, typename... Rest>
+    static constexpr size_t indexOf() {
+        if constexpr (std::is_same<Target, First>::value) {
+            return 0;
+        } else {
+            return 1 + indexOf<Target, Rest...>();
+        }
+    }
+
+    template <typename Driver, typename... Rest>
+    static void writeAvailability(String& json, const SensorSnapshot& snapshot, size_t index) {
+        json += "\"";
+        json += Driver::STATUS_KEY;
+        json += (snapshot.attachedSensors & (1UL << index)) ? "\":true," : "\":false,";
+        if constexpr (sizeof...(Rest) > 0) {
+            writeAvailability<Rest...>(json, snapshot, index + 1);
+        }
+    }
+
+    std::tuple<Drivers...> drivers;
+    SensorSnapshot readings[SENSOR_COUNT];  // Latest successful reading per driver
+    bool attached[SENSOR_COUNT] = {};
+    unsigned long lastRead[SENSOR_COUNT] = {};
+    AdaptiveInterval sampling[SENSOR_COUNT];
+};
+
+#endif // SENSOR_REGISTRY_H
@@ -0,0 +1,217 @@
+#ifndef SENSOR_ROLLUP_H
+#define SENSOR_ROLLUP_H
+
+// Multi-Resolution Rollups
+// ========================
+// The raw history ring (sensor_history.h) only covers a few hours. Rollups keep
+// min/max/sum/count per channel in fixed-width time buckets at 1-minute,
+// 1-hour and 1-day resolution, each tier a bounded ring of buckets.
+//
+// Every sensor cycle updates the open bucket of each tier in place: O(1) per
+// sample, no rescans. A bucket is identified by its absolute index
+// (time / period), stored in its slot, so a slot left over from an older lap
+// of the ring (e.g. after a gap in sampling) is recognised and skipped.
+//
+// Values are quantized like the raw history (HISTORY_QUANTIZATION) to keep a
+// bucket at 76 bytes. Not thread-safe: callers serialize access.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "sensor_snapshot.h"
+#include "sensor_history.h"
+
+#define ROLLUP_TIER_COUNT 3
+
+static constexpr uint32_t ROLLUP_PERIODS[ROLLUP_TIER_COUNT] = {60, 3600, 86400};  // Seconds
+
+struct RollupChannel {
+    int16_t min;
+    int16_t max;
+    int32_t sum;     // Quantized; a 1-day bucket holds 17280 samples, well within int32
+    uint16_t count;  // Samples with a reading
+};
+
+// Index of a bucket slot that has never been opened
+static constexpr uint32_t ROLLUP_NO_BUCKET = UINT32_MAX;
+
+struct RollupBucket {
+    uint32_t index;  // Absolute bucket index (start time / period)
+    RollupChannel channels[HISTORY_CHANNEL_COUNT];
+};
+
+class RollupTier {
+public:
+    ~RollupTier() { release(); }
+
+    bool begin(uint32_t periodSeconds, size_t bucketCount) {
+        release();
+        if (bucketCount == 0) {
+            return false;
+        }
+        buckets = (RollupBucket*)malloc(bucketCount * sizeof(RollupBucket));
+        if (buckets == NULL) {
+            return false;
+        }
+        for (size_t i = 0; i < bucketCount; i++) {
+            buckets[i].index = ROLLUP_NO_BUCKET;  // Never matches a live index, even after a restore
+        }
+        period = periodSeconds;
+        capacityBuckets = bucketCount;
+        return true;
+    }
+
+    // O(1): folds one sample into the bucket covering `timestamp`, opening a new one if needed
+    void add(uint32_t timestamp, const SensorSnapshot& snapshot) {
+        if (capacityBuckets == 0) {
+            return;
+        }
+        uint32_t index = timestamp / period;
+        RollupBucket& bucket = buckets[index % capacityBuckets];
+        if (!hasData || index != newest) {
+            if (hasData && index < newest) {
+                return;  // Clock went backwards; never rewrite a closed bucket
+            }
+            bucket.index = index;
+            for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+                bucket.channels[c] = {INT16_MAX, INT16_MIN, 0, 0};
+            }
+            if (!hasData) {
+                oldest = index;
+            }
+            newest = index;
+            hasData = true;
+            if (newest - oldest >= capacityBuckets) {
+                oldest = newest - capacityBuckets + 1;
+            }
+        }
+
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            if (!snapshot.has((SensorChannel)c)) {
+                continue;
+            }
+            int16_t v = SensorHistory::quantize((SensorChannel)c, snapshot.values[c]);
+            RollupChannel& channel = bucket.channels[c];
+            if (v < channel.min) channel.min = v;
+            if (v > channel.max) channel.max = v;
+            channel.sum += v;
+            channel.count++;
+        }
+    }
+
+    // Aggregates one channel over buckets starting in [from, to) (seconds).
+    // Cost is proportional to the buckets in range, never to the raw samples.
+    HistoryAggregate aggregate(SensorChannel channel, uint32_t from, uint32_t to) const {
+        HistoryAggregate result = {INT32_MAX, INT32_MIN, 0, 0, 0, 0};
+        if (!hasData || from >= to) {
+            return result;
+        }
+        uint32_t first = (from + period - 1) / period;
+        uint32_t last = (to - 1) / period;  // Inclusive
+        if (first < oldest) first = oldest;
+        if (last > newest) last = newest;
+
+        int32_t minStored = INT16_MAX;
+        int32_t maxStored = INT16_MIN;
+        int64_t sumStored = 0;
+        uint32_t count = 0;
+        for (uint32_t index = first; index <= last; index++) {
+            const RollupBucket& bucket = buckets[index % capacityBuckets];
+            const RollupChannel& data = bucket.channels[channel];
+            if (bucket.index != index || data.count == 0) {
+                continue;  // No samples in this bucket
+            }
+            if (count == 0) {
+                result.firstTime = index * period;
+            }
+            result.lastTime = index * period;
+            if (data.min < minStored) minStored = data.min;
+            if (data.max > maxStored) maxStored = data.max;
+            sumStored += data.sum;
+            count += data.count;
+        }
+
+        result.count = count;
+        if (count > 0) {
+            const HistoryQuantization& q = HISTORY_QUANTIZATION[channel];
+            result.min = SensorHistory::dequantize(channel, (int16_t)minStored);
+            result.max = SensorHistory::dequantize(channel, (int16_t)maxStored);
+            result.sum = sumStored * q.step + (int64_t)q.offset * count;
+        }
+        return result;
+    }
+
+    uint32_t getPeriod() const { return period; }
+    size_t capacity() const { return capacityBuckets; }
+    bool isReady() const { return capacityBuckets > 0; }
+
+    // Seconds of history this tier can hold when full
+    uint32_t retention() const { return period * capacityBuckets; }
+
+    // Start time of the oldest bucket still held (0 if empty)
+    uint32_t oldestTime() const { return hasData ? oldest * period : 0; }
+
+private:
+    void release() {
+        free(buckets);
+        buckets = NULL;
+        capacityBuckets = 0;
+        hasData = false;
+    }
+
+    RollupBucket* buckets = NULL;
+    size_t capacityBuckets = 0;
+    uint32_t period = 60;
+    uint32_t oldest = 0;  // Absolute bucket indexes held: [oldest, newest]
+    uint32_t newest = 0;
+    bool hasData = false;
+};
+
+class SensorRollups {
+public:
+    // Bucket counts per tier (minute, hour, day); returns false if any allocation failed
+    bool begin(const size_t bucketCounts[ROLLUP_TIER_COUNT]) {
+        bool ok = true;
+        for (uint8_t t = 0; t < ROLLUP_TIER_COUNT; t++) {
+            ok = tiers[t].begin(ROLLUP_PERIODS[t], bucketCounts[t]) && ok;
+        }
+        return ok;
+    }
+
+    static constexpr size_t bytesPerBucket() { return sizeof(RollupBucket); }
+
+    // O(1) per tier
+    void add(uint32_t timestamp, const SensorSnapshot& snapshot) {
+        for (uint8_t t = 0; t < ROLLUP_TIER_COUNT; t++) {
+            tiers[t].add(timestamp, snapshot);
+        }
+    }
+
+    // Coarsest tier whose buckets are no wider than `bucketSeconds` and which
+    // can hold `spanSeconds`; falls back to the finest tier that covers the
+    // span, then to the longest-retention tier. -1 if no tier is allocated.
+    int selectTier(uint32_t spanSeconds, uint32_t bucketSeconds) const {
+        for (int t = ROLLUP_TIER_COUNT - 1; t >= 0; t--) {
+            if (tiers[t].isReady() && tiers[t].getPeriod() <= bucketSeconds && tiers[t].retention() >= spanSeconds) {
+                return t;
+            }
+        }
+        for (int t = 0; t < ROLLUP_TIER_COUNT; t++) {
+            if (tiers[t].isReady() && tiers[t].retention() >= spanSeconds) {
+                return t;
+            }
+        }
+        for (int t = ROLLUP_TIER_COUNT - 1; t >= 0; t--) {
+            if (tiers[t].isReady()) {
+                return t;
+            }
+        }
+        return -1;
+    }
+
+    const RollupTier& tier(uint8_t index) const { return tiers[index]; }
+
+private:
+    RollupTier tiers[ROLLUP_TIER_COUNT];
+};
+
+#endif // SENSOR_ROLLUP_H
@@ -0,0 +1,127 @@
+#ifndef SENSOR_SNAPSHOT_H
+#define SENSOR_SNAPSHOT_H
+
+// Sensor Snapshot
+// The sensor task is the only writer of the latest readings; the web server,
+// push channels and anything else running on other tasks are readers.
+// Readers must never block the sensor task (and vice versa), so the snapshot
+// is published through a sequence lock instead of a mutex.
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// Physical quantities a sensor driver can provide
+// Several drivers may provide the same channel; the last driver in the board's
+// sensor list wins (see BOARD_SENSORS in board_config.h)
+enum SensorChannel : uint8_t {
+    CHANNEL_TEMPERATURE,
+    CHANNEL_PRESSURE,
+    CHANNEL_ALTITUDE,
+    CHANNEL_HUMIDITY,
+    CHANNEL_CO2,
+    CHANNEL_DEW_POINT,  // Derived from temperature + humidity
+    // Derived per cycle (derived_metrics.h), published but not stored in history
+    CHANNEL_HEAT_INDEX,
+    CHANNEL_ABSOLUTE_HUMIDITY,
+    CHANNEL_PRESSURE_TREND,
+    CHANNEL_COUNT
+};
+
+// Channels kept by the history stores (ring, rollups, compressed blocks, flash
+// log). Adding one changes their record layout.
+static constexpr uint8_t HISTORY_CHANNEL_COUNT = CHANNEL_DEW_POINT + 1;
+
+// Values are fixed-point integers (the ESP32-C3 has no FPU, see env_math.h):
+// a stored value v means v / 10^scale in the channel's unit
+struct ChannelInfo {
+    const char* name;       // Short name used in query parameters (e.g. /history?channel=)
+    const char* statusKey;  // Key in the /status JSON (kept stable for the dashboard)
+    const char* unit;
+    uint8_t scale;          // Decimals of the stored fixed-point value
+    uint8_t decimals;       // Decimals used when formatting
+};
+
+static constexpr ChannelInfo CHANNEL_INFO[CHANNEL_COUNT] = {
+    {"temperature", "sensorTemperature", "°C", 2, 1},  // 0.01 °C
+    {"pressure", "bmpPressure", "hPa", 2, 1},          // Pa
+    {"altitude", "bmpAltitude", "m", 2, 1},            // cm
+    {"humidity", "ahtHumidity", "%", 2, 1},            // 0.01 %RH
+    {"co2", "co2", "ppm", 0, 0},
+    {"dewpoint", "dewPoint", "°C", 2, 1},              // 0.01 °C
+    {"heatindex", "heatIndex", "°C", 2, 1},            // 0.01 °C
+    {"abshumidity", "absoluteHumidity", "g/m³", 2, 2}, // 0.01 g/m³
+    {"pressuretrend", "pressureTrend", "hPa/3h", 2, 1}, // Pa per 3 hours
+};
+
+// Looks up a channel by its short name (e.g. "humidity"); false if unknown
+inline bool channelFromName(const char* name, SensorChannel& channel) {
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+        if (strcmp(name, CHANNEL_INFO[c].name) == 0) {
+            channel = (SensorChannel)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Latest readings published by the sensor task once per update cycle
+struct SensorSnapshot {
+    int32_t values[CHANNEL_COUNT] = {};
+    uint32_t validChannels = 0;    // Bit per SensorChannel with a reading
+    uint32_t attachedSensors = 0;  // Bit per driver in the board's sensor list
+    uint32_t sequence = 0;         // Incremented on every publish (0 = never published)
+    unsigned long timestamp = 0;   // millis() when the readings were taken
+
+    bool has(SensorChannel channel) const { return validChannels & (1UL << channel); }
+    int32_t get(SensorChannel channel) const { return values[channel]; }
+
+    void set(SensorChannel channel, int32_t value) {
+        values[channel] = value;
+        validChannels |= (1UL << channel);
+    }
+};
+
+// Single-writer / multi-reader sequence lock
+// =========================================
+// The writer bumps the sequence to an odd value, copies the payload and bumps
+// it back to even. Readers copy the payload and retry if the sequence was odd
+// or changed underneath them. Neither side ever waits on the other: the writer
+// never retries, and a reader only retries while a write is in flight
+// (a few microseconds every UPDATE_INTERVAL).
+//
+// T must be trivially copyable. Only ONE task may call write().
+template <typename T>
+class SeqLock {
+public:
+    void write(const T& value) {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&payload, &value, sizeof(T));
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        T copy;
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(&copy, &payload, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return copy;
+    }
+
+    // Number of completed writes (cheap change detection for pollers)
+    uint32_t version() const {
+        return sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    std::atomic<uint32_t> sequence{0};
+    T payload{};
+};
+
+#endif // SENSOR_SNAPSHOT_H
@@ -0,0 +1,173 @@
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+// FreeRTOS Task Monitor
+// =====================
+// Per-task CPU share and stack headroom for every task on the device: the
+// Arduino loop task, the sensor/capture tasks, and the system tasks (WiFi,
+// lwIP "tiT", mDNS, esp_timer, the idle tasks per core).
+//
+// sample() takes a snapshot with uxTaskGetSystemState() into a fixed array
+// and computes each task's run time since the PREVIOUS snapshot, so the
+// shares describe the last window rather than everything since boot. Tasks
+// are matched between snapshots by xTaskNumber; a task created during the
+// window counts from zero. Shares are of the total CPU time of all cores
+// (on the dual-core WROOM each core is 50%); the IDLE tasks' shares are the
+// spare capacity left for lowering CPU_FREQ_MHZ.
+//
+// Stack high-water marks are the least free stack the task ever had, in
+// bytes (ESP-IDF stacks are byte-addressed).
+//
+// CPU shares need configGENERATE_RUN_TIME_STATS in the FreeRTOS config;
+// without it only stacks and priorities are reported (hasRunTime() false).
+
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define TASK_MONITOR_MAX_TASKS 24
+#define TASK_MONITOR_STACK_WARN 512  // Bytes: high-water marks below this are logged as warnings
+
+struct TaskUsage {
+    char name[16];
+    uint32_t number;         // xTaskNumber
+    uint32_t runTime;        // Run time counter ticks in the last window
+    uint16_t cpuPermille;    // Share of all cores' time in the last window
+    uint32_t stackFreeMin;   // High-water mark, bytes
+    uint8_t priority;
+    int8_t core;             // -1: not pinned / unknown
+    eTaskState state;
+};
+
+class TaskMonitor {
+public:
+    // Snapshot + deltas against the previous one; false if the task list didn't fit
+    bool sample(uint32_t now) {
+#if configUSE_TRACE_FACILITY
+        uint32_t totalRunTime = 0;
+        UBaseType_t count = uxTaskGetSystemState(status, TASK_MONITOR_MAX_TASKS, &totalRunTime);
+        if (count == 0) {
+            return false;  // More tasks than TASK_MONITOR_MAX_TASKS
+        }
+        uint32_t coreRunTime = totalRunTime - lastTotalRunTime;  // Wall time of the window
+        uint64_t windowRunTime = (uint64_t)coreRunTime * portNUM_PROCESSORS;
+
+        for (UBaseType_t i = 0; i < count; i++) {
+            const TaskStatus_t& task = status[i];
+            TaskUsage& usage = tasks[i];
+            strncpy(usage.name, task.pcTaskName, sizeof(usage.name) - 1);
+            usage.name[sizeof(usage.name) - 1] = '\0';
+            usage.number = task.xTaskNumber;
+            usage.priority = (uint8_t)task.uxCurrentPriority;
+            usage.stackFreeMin = task.usStackHighWaterMark;
+            usage.state = task.eCurrentState;
+#if configTASKLIST_INCLUDE_COREID
+            usage.core = task.xCoreID < portNUM_PROCESSORS ? (int8_t)task.xCoreID : -1;
+#else
+            usage.core = -1;
+#endif
+#if configGENERATE_RUN_TIME_STATS
+            usage.runTime = task.ulRunTimeCounter - previousRunTime(task.xTaskNumber);
+            if (usage.runTime > coreRunTime) {
+                usage.runTime = coreRunTime;  // A task runs on one core at a time
+            }
+            usage.cpuPermille = windowRunTime > 0 ? (uint16_t)((uint64_t)usage.runTime * 1000 / windowRunTime) : 0;
+#else
+            usage.runTime = 0;
+            usage.cpuPermille = 0;
+#endif
+        }
+
+        // Keep this snapshot's counters for the next delta
+        previousCount = count;
+        for (UBaseType_t i = 0; i < count; i++) {
+            previousNumbers[i] = status[i].xTaskNumber;
+#if configGENERATE_RUN_TIME_STATS
+            previousRunTimes[i] = status[i].ulRunTimeCounter;
+#endif
+        }
+        taskCount = count;
+        lastTotalRunTime = totalRunTime;
+        windowMs = now - lastSampleTime;
+        lastSampleTime = now;
+        samples++;
+        sortByCpu();
+        return true;
+#else
+        (void)now;
+        return false;
+#endif
+    }
+
+    static constexpr bool hasRunTime() {
+#if configGENERATE_RUN_TIME_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Sorted by CPU share (highest first); valid for i < size()
+    const TaskUsage& task(uint8_t i) const { return tasks[i]; }
+    uint8_t size() const { return taskCount; }
+    uint32_t getWindowMs() const { return windowMs; }  // Length of the window the shares cover
+    uint32_t getSamples() const { return samples; }
+
+    // Idle share of one core (per mille of that core), -1 if unknown
+    int16_t idlePermille(uint8_t core) const {
+        if (!hasRunTime() || samples == 0) {
+            return -1;
+        }
+        for (uint8_t i = 0; i < taskCount; i++) {
+            // "IDLE", or "IDLE0"/"IDLE1" depending on the IDF version; pinned one per core
+            bool onCore = tasks[i].core == (int8_t)core || (tasks[i].core < 0 && portNUM_PROCESSORS == 1);
+            if (strncmp(tasks[i].name, "IDLE", 4) == 0 && tasks[i].priority == 0 && onCore) {
+                uint32_t share = (uint32_t)tasks[i].cpuPermille * portNUM_PROCESSORS;
+                return (int16_t)(share > 1000 ? 1000 : share);
+            }
+        }
+        return -1;
+    }
+
+private:
+    uint32_t previousRunTime(UBaseType_t number) const {
+#if configGENERATE_RUN_TIME_STATS
+        for (uint8_t i = 0; i < previousCount; i++) {
+            if (previousNumbers[i] == number) {
+                return previousRunTimes[i];
+            }
+        }
+#endif
+        return 0;  // New since the last snapshot (or the first one: since boot)
+    }
+
+    // Insertion sort: at most TASK_MONITOR_MAX_TASKS entries
+    void sortByCpu() {
+        for (uint8_t i = 1; i < taskCount; i++) {
+            TaskUsage usage = tasks[i];
+            uint8_t j = i;
+            while (j > 0 && (tasks[j - 1].cpuPermille < usage.cpuPermille ||
+                             (tasks[j - 1].cpuPermille == usage.cpuPermille && tasks[j - 1].runTime < usage.runTime))) {
+                tasks[j] = tasks[j - 1];
+                j--;
+            }
+            tasks[j] = usage;
+        }
+    }
+
+#if configUSE_TRACE_FACILITY
+    TaskStatus_t status[TASK_MONITOR_MAX_TASKS];
+#endif
+    TaskUsage tasks[TASK_MONITOR_MAX_TASKS];
+    uint8_t taskCount = 0;
+    UBaseType_t previousNumbers[TASK_MONITOR_MAX_TASKS] = {};
+    uint32_t previousRunTimes[TASK_MONITOR_MAX_TASKS] = {};
+    uint8_t previousCount = 0;
+    uint32_t lastTotalRunTime = 0;
+    uint32_t lastSampleTime = 0;
+    uint32_t windowMs = 0;
+    uint32_t samples = 0;
+};
+
+#endif // TASK_MONITOR_H
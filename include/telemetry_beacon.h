@@ -0,0 +1,137 @@
+#ifndef TELEMETRY_BEACON_H
+#define TELEMETRY_BEACON_H
+
+// Telemetry Beacon
+// ================
+// Compact binary UDP multicast datagram carrying a device's identity and its
+// latest readings, sent once per update cycle so a single listener on the LAN
+// can aggregate a fleet without polling each device over HTTP. Shared by the
+// firmware and the host tool (tools/beacon_listener.cpp), so it only depends
+// on the standard headers.
+//
+// Layout (little-endian, byte-serialized, no struct padding):
+//
+//   0  'E' 'M' 'B' version    magic + format version
+//   4  uint32 sequence        +1 per beacon; gaps mean lost datagrams
+//   8  uint32 uptime          seconds since boot
+//  12  uint32 unixTime        0 until SNTP has synced
+//  16  char id[4]             MAC suffix of ap_ssid_unique ("A1B2")
+//  20  uint8 nameLength, name (deviceName, up to BEACON_NAME_MAX bytes)
+//   .  uint16 validChannels   bit per SensorChannel
+//   .  int32 value            one per set bit, in channel order (fixed-point)
+//   .  uint32 crc             CRC-32 of everything before it
+//
+// A listener skips values for channel bits it doesn't know, so newer firmware
+// with more channels stays readable. ~75 bytes with every channel and a
+// 12-character name.
+
+#include <stdint.h>
+#include <string.h>
+#include "sensor_snapshot.h"
+#include "sensor_codec.h"  // crc32Update()
+
+// Group and port shared by the firmware and the listener. 239.255.0.0/16 is
+// the organization-local scope, which routers don't forward off the LAN.
+#define BEACON_MULTICAST_GROUP 239, 255, 42, 99
+#define BEACON_PORT 47800
+
+#define BEACON_VERSION 1
+#define BEACON_ID_LENGTH 4
+#define BEACON_NAME_MAX 32
+#define BEACON_HEADER_SIZE 20
+#define BEACON_MAX_SIZE (BEACON_HEADER_SIZE + 1 + BEACON_NAME_MAX + 2 + 16 * 4 + 4)
+
+struct Beacon {
+    uint32_t sequence;
+    uint32_t uptime;
+    uint32_t unixTime;
+    char id[BEACON_ID_LENGTH + 1];
+    char name[BEACON_NAME_MAX + 1];
+    uint32_t validChannels;  // Known channels only
+    int32_t values[CHANNEL_COUNT];
+};
+
+inline void beaconPut32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint32_t beaconGet32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Serializes a beacon into `out` (at least BEACON_MAX_SIZE bytes); returns its length
+inline size_t encodeBeacon(const Beacon& beacon, uint8_t* out) {
+    out[0] = 'E';
+    out[1] = 'M';
+    out[2] = 'B';
+    out[3] = BEACON_VERSION;
+    beaconPut32(out + 4, beacon.sequence);
+    beaconPut32(out + 8, beacon.uptime);
+    beaconPut32(out + 12, beacon.unixTime);
+    memset(out + 16, 0, BEACON_ID_LENGTH);
+    memcpy(out + 16, beacon.id, strnlen(beacon.id, BEACON_ID_LENGTH));
+
+    size_t nameLength = strnlen(beacon.name, BEACON_NAME_MAX);
+    size_t n = BEACON_HEADER_SIZE;
+    out[n++] = (uint8_t)nameLength;
+    memcpy(out + n, beacon.name, nameLength);
+    n += nameLength;
+
+    uint16_t valid = (uint16_t)(beacon.validChannels & ((1UL << CHANNEL_COUNT) - 1));
+    out[n++] = (uint8_t)valid;
+    out[n++] = (uint8_t)(valid >> 8);
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+        if (valid & (1U << c)) {
+            beaconPut32(out + n, (uint32_t)beacon.values[c]);
+            n += 4;
+        }
+    }
+    beaconPut32(out + n, crc32Update(0, out, n));
+    return n + 4;
+}
+
+// Parses and validates a datagram; false if it isn't a (supported, intact) beacon
+inline bool decodeBeacon(const uint8_t* data, size_t length, Beacon& beacon) {
+    if (length < BEACON_HEADER_SIZE + 1 + 2 + 4 || data[0] != 'E' || data[1] != 'M' || data[2] != 'B' ||
+        data[3] != BEACON_VERSION || crc32Update(0, data, length - 4) != beaconGet32(data + length - 4)) {
+        return false;
+    }
+    size_t end = length - 4;
+    beacon.sequence = beaconGet32(data + 4);
+    beacon.uptime = beaconGet32(data + 8);
+    beacon.unixTime = beaconGet32(data + 12);
+    memcpy(beacon.id, data + 16, BEACON_ID_LENGTH);
+    beacon.id[BEACON_ID_LENGTH] = '\0';
+
+    size_t n = BEACON_HEADER_SIZE;
+    size_t nameLength = data[n++];
+    if (nameLength > BEACON_NAME_MAX || n + nameLength + 2 > end) {
+        return false;
+    }
+    memcpy(beacon.name, data + n, nameLength);
+    beacon.name[nameLength] = '\0';
+    n += nameLength;
+
+    uint16_t valid = (uint16_t)(data[n] | (data[n + 1] << 8));
+    n += 2;
+    beacon.validChannels = 0;
+    for (uint8_t bit = 0; bit < 16; bit++) {
+        if (!(valid & (1U << bit))) {
+            continue;
+        }
+        if (n + 4 > end) {
+            return false;
+        }
+        if (bit < CHANNEL_COUNT) {
+            beacon.values[bit] = (int32_t)beaconGet32(data + n);
+            beacon.validChannels |= 1UL << bit;
+        }
+        n += 4;
+    }
+    return n == end;
+}
+
+#endif // TELEMETRY_BEACON_H
@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_QUEUE_H
+#define TELEMETRY_QUEUE_H
+
+// Telemetry Queue
+// ===============
+// Bounded FIFO of snapshots waiting to be published (MQTT). The sensor task
+// pushes, the loop task publishes; while the broker is unreachable the queue
+// fills up and then drops the OLDEST record, so after an outage the most
+// recent readings are what gets sent.
+//
+// Records leave the queue only after the message carrying them was accepted
+// (peek, publish, then pop), so a failed publish loses nothing. Allocated
+// once at boot; callers serialize access with their own lock.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensor_snapshot.h"
+
+struct TelemetryRecord {
+    uint32_t time;           // Uptime seconds
+    uint32_t validChannels;  // Bit per SensorChannel with a reading
+    int32_t values[CHANNEL_COUNT];
+};
+
+class TelemetryQueue {
+public:
+    bool begin(size_t maxRecords) {
+        records = (TelemetryRecord*)malloc(maxRecords * sizeof(TelemetryRecord));
+        capacityRecords = records != NULL ? maxRecords : 0;
+        return records != NULL;
+    }
+
+    void push(const SensorSnapshot& snapshot, uint32_t time) {
+        if (capacityRecords == 0) {
+            return;
+        }
+        if (count == capacityRecords) {
+            head = (head + 1) % capacityRecords;  // Drop the oldest
+            count--;
+            dropped++;
+        }
+        TelemetryRecord& record = records[(head + count) % capacityRecords];
+        record.time = time;
+        record.validChannels = snapshot.validChannels;
+        memcpy(record.values, snapshot.values, sizeof(record.values));
+        count++;
+    }
+
+    // i = 0 is the oldest record; valid for i < size()
+    const TelemetryRecord& peek(size_t i) const { return records[(head + i) % capacityRecords]; }
+
+    // Removes the `n` oldest records once they were published
+    void pop(size_t n) {
+        if (n > count) {
+            n = count;
+        }
+        head = (head + n) % (capacityRecords > 0 ? capacityRecords : 1);
+        count -= n;
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return capacityRecords; }
+    uint32_t getDropped() const { return dropped; }
+
+private:
+    TelemetryRecord* records = NULL;
+    size_t capacityRecords = 0;
+    size_t head = 0;  // Oldest record
+    size_t count = 0;
+    uint32_t dropped = 0;
+};
+
+#endif // TELEMETRY_QUEUE_H
@@ -20,34 +20,211 @@
 #include <WiFi.h>
 #include <WebServer.h>
 #include <Preferences.h>
+#include <LittleFS.h>
 #include <ArduinoOTA.h>
 #include <ESPmDNS.h>
 #include <Wire.h>
-#include <Adafruit_BMP280.h>
-#include <Adafruit_AHTX0.h>
+#include <PubSubClient.h>
+#include <HTTPClient.h>
+#include <WiFiUdp.h>
 #include "esp_task_wdt.h"  // Watchdog timer for freeze protection
 #include "esp_wifi.h"      // For esp_wifi_set_ps() power save control
+#include "esp_timer.h"     // 64-bit microsecond clock (uptime that doesn't wrap)
+#include <time.h>          // SNTP wall clock for history timestamps
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH && CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+#include "esp_core_dump.h"  // Crash summary of the previous boot
+#endif
 #include "board_config.h"  // Board-specific configuration
 #include "index.h"         // HTML page content
+#include "sensor_snapshot.h"  // Lock-free snapshot shared by sensor task and readers
+#include "i2c_manager.h"   // I2C transaction wrapper with stats and bus recovery
+#include "sensor_drivers.h"   // Sensor drivers (BMP280, AHT20, SHT4x, SCD4x)
+#include "env_math.h"         // Fixed-point dew point / altitude / formatting
+#include "sensor_history.h"   // In-RAM struct-of-arrays history ring
+#include "sensor_rollup.h"    // 1 min / 1 h / 1 day rollup tiers
+#include "sensor_codec.h"     // Compressed (delta-of-delta) sensor blocks
+#include "segment_log.h"      // Append-only flash log of sealed blocks
+#include "history_export.h"   // CSV / NDJSON formatting of history blocks
+#include "history_query.h"    // /query aggregation functions
+#include "burst_capture.h"    // High-rate BMP280 capture buffer
+#include "sensor_registry.h"  // Compile-time sensor set (BOARD_SENSORS)
+#include "derived_metrics.h"  // Per-cycle derived values (heat index, pressure trend)
+#include "anomaly_detector.h" // Spike / drift detection per channel
+#include "rules_engine.h"     // Text rules compiled to bytecode
+#include "telemetry_queue.h"  // MQTT / InfluxDB snapshot queues
+#include "line_protocol.h"    // InfluxDB line protocol batches
+#include "batch_spool.h"      // Store-and-forward batches on LittleFS
+#include "telemetry_beacon.h" // UDP multicast beacon format
+#include "metrics_writer.h"   // Prometheus /metrics
+#include "perf_profiler.h"    // PERF_* phase timings (-DPERF_PROFILING)
+#include "heap_stats.h"       // Fragmentation watermarks, per-route allocations
+#include "task_monitor.h"     // Per-task CPU share and stack high-water marks
+#include "log_ring.h"         // LOG_E/W/I/D into the log ring
+#include "boot_history.h"     // Reset reasons, breadcrumbs and crash summaries across reboots
+#include "heartbeat_registry.h"  // Per-subsystem software watchdog
 
 // Web server on port 80
 WebServer server(80);
 
+// Log ring: LOG_x() calls from any task append under logRingMutex and wake
+// the drain task, which writes new entries to Serial at idle priority
+LogRing logRing;
+SemaphoreHandle_t logRingMutex = NULL;
+TaskHandle_t logDrainTaskHandle = NULL;
+volatile uint32_t logDrained = 0;     // Next sequence number to write to Serial
+uint32_t logSerialDropped = 0;        // Overwritten before the drain task got to them
+
+// Boot history: breadcrumbs survive resets in RTC memory (not power cycles);
+// at boot they become a BootRecord in the history kept in NVS
+RTC_NOINIT_ATTR BootBreadcrumbs bootBreadcrumbs;
+BootHistory bootHistory;
+Preferences bootPreferences;
+
+// Heartbeat supervisor: subsystems check in, the supervisor task restarts
+// the ones that stop and feeds the hardware task watchdog
+HeartbeatRegistry heartbeats;
+TaskHandle_t supervisorTaskHandle = NULL;
+
 // NVS storage for WiFi credentials
 Preferences preferences;
 
-// BMP280 and AHT20 Sensor Configuration
-// I2C pins are defined in board_config.h (board-specific)
-Adafruit_BMP280 bmp;
-Adafruit_AHTX0 aht;
-bool bmpAvailable = false;
-bool ahtAvailable = false;
+// Sensor Configuration
+// I2C pins and the sensor list (BOARD_SENSORS) are defined in board_config.h
+// All transactions go through i2cBus (see i2c_manager.h)
+I2CManager i2cBus;
+using BoardSensors = SensorRegistry<BOARD_SENSORS>;
+BoardSensors sensors;  // Only touched by the sensor task after setup()
 
 // Sensor readings
-float currentTemperature = 0.0;
-float currentPressure = 0.0;
-float currentAltitude = 0.0;
-float currentHumidity = 0.0;
+// Written only by the sensor task, read lock-free by the web server and push channels
+SeqLock<SensorSnapshot> sensorSnapshot;
+TaskHandle_t sensorTaskHandle = NULL;
+DerivedMetrics derivedMetrics;  // Sensor task only
+
+// Anomaly detection: updated by the sensor task under anomalyMutex; events are
+// queued to the loop task, which pushes them to /events subscribers
+AnomalyDetector anomalyDetector;
+SemaphoreHandle_t anomalyMutex = NULL;
+QueueHandle_t anomalyQueue = NULL;
+uint32_t anomalyQueueDrops = 0;
+const uint8_t MAX_EVENT_SUBSCRIBERS = 4;
+WiFiClient eventSubscribers[MAX_EVENT_SUBSCRIBERS];
+const unsigned long EVENT_KEEPALIVE_INTERVAL = 15000;  // SSE comment so proxies keep the stream open
+unsigned long lastEventKeepalive = 0;
+
+// Rules engine: compiled rules are kept in NVS ("rules" namespace, one blob
+// per rule) and evaluated by the sensor task; rulesMutex guards the engine
+// against /rules-add and /rules-delete
+RuleEngine<RULES_MAX> ruleEngine;
+SemaphoreHandle_t rulesMutex = NULL;
+Preferences rulePreferences;
+
+// Alert actions, queued by the sensor task for the /events stream
+struct RuleEvent {
+  uint32_t time;  // Uptime seconds
+  uint8_t rule;
+  bool firing;
+  char source[RULE_MAX_SOURCE];
+};
+QueueHandle_t ruleQueue = NULL;
+uint32_t ruleQueueDrops = 0;
+volatile RuleLedPattern ruleLedPattern = RULE_LED_NONE;  // Set by the sensor task, shown by loop()
+
+// MQTT telemetry: the sensor task queues every published snapshot; the loop
+// task connects, batches and publishes. Broker settings are kept in NVS
+// alongside the WiFi settings (/set-mqtt-settings); an empty host disables MQTT.
+WiFiClient mqttNetClient;
+PubSubClient mqttClient(mqttNetClient);
+TelemetryQueue telemetryQueue;
+SemaphoreHandle_t telemetryMutex = NULL;
+volatile bool mqttEnabled = false;  // Read by the sensor task
+String mqttHost = "";
+uint16_t mqttPort = 1883;
+String mqttUser = "";
+String mqttPassword = "";
+String mqttPrefix = "esp32-monitor";  // Topics: <prefix>/<hostname>/telemetry and /status
+uint8_t mqttBatch = 1;  // Snapshots per message
+const unsigned long MQTT_RETRY_MIN = 5000;    // Reconnect backoff: 5s -> 10s -> ... -> 2 min
+const unsigned long MQTT_RETRY_MAX = 120000;
+const uint8_t MQTT_DRAIN_PER_LOOP = 2;  // Messages per loop() pass while catching up
+unsigned long mqttRetryInterval = MQTT_RETRY_MIN;
+unsigned long mqttLastAttempt = 0;
+bool mqttAttempted = false;
+uint32_t mqttPublished = 0;
+uint32_t mqttPublishFailures = 0;
+uint32_t mqttConnects = 0;
+
+// InfluxDB push: the sensor task queues snapshots (influxQueue, under
+// telemetryMutex); the loop task formats them into a line protocol batch and
+// POSTs it over a kept-alive connection. While the station is down or the
+// server fails, batches go to a LittleFS spool and are replayed in order.
+TelemetryQueue influxQueue;
+LineProtocolBatch influxBatch;
+BatchSpool<fs::LittleFSFS> influxSpool;
+char* influxReplayBuffer = NULL;  // One spooled batch read back for replay
+WiFiClient influxNetClient;
+HTTPClient influxHttp;
+volatile bool influxEnabled = false;  // Read by the sensor task
+String influxUrl = "";    // Full write URL, e.g. http://host:8086/api/v2/write?org=o&bucket=b&precision=s
+String influxToken = "";  // Sent as "Authorization: Token ..." when set
+String influxTags = "";   // Measurement and tags, rebuilt when the device name changes
+unsigned long influxBatchStarted = 0;  // millis() of the batch's first line
+unsigned long influxRetryInterval = MQTT_RETRY_MIN;  // Same 5s -> 2 min backoff as MQTT
+unsigned long influxLastFailure = 0;
+bool influxFailing = false;
+LatencyHistogram influxLatency;  // POST round trip (µs)
+
+struct InfluxStats {
+  uint32_t linesFormatted = 0;
+  uint32_t linesDuplicate = 0;   // Timestamp not after the previous line
+  uint32_t linesTooLong = 0;     // Over LINE_PROTOCOL_MAX_LINE or the batch, dropped
+  uint32_t linesSent = 0;
+  uint32_t batchesSent = 0;
+  uint32_t batchesSpooled = 0;
+  uint32_t batchesRejected = 0;  // 4xx: malformed or unauthorized, dropped
+  uint32_t batchesLost = 0;      // Couldn't be spooled (no filesystem / write error)
+  uint32_t sendFailures = 0;
+  uint64_t bytesSent = 0;
+  int lastStatus = 0;            // HTTP status or negative HTTPClient error
+  uint32_t linesLastMinute = 0;  // Throughput over the last full minute
+  uint32_t linesAtMinuteStart = 0;
+  unsigned long minuteStarted = 0;
+};
+InfluxStats influxStats;
+
+// UDP multicast beacon: one datagram with the identity and latest readings
+// per update cycle, so a listener can aggregate devices without polling
+WiFiUDP beaconUdp;
+bool beaconEnabled = false;
+uint32_t beaconSequence = 0;
+uint32_t beaconsSent = 0;
+uint32_t beaconErrors = 0;
+
+// Sensor history (one record per sensor cycle, sized from free heap at boot)
+// Written by the sensor task, read by /history; access is serialized by historyMutex
+SensorHistory sensorHistory;
+SensorRollups sensorRollups;  // Long-horizon min/max/avg, fed on the same cycle
+SensorBlockRing sensorBlocks;  // Same records, compressed into sealed blocks
+
+// Persistent history: sealed blocks appended to LittleFS (survives reboot/OTA)
+// The sensor task queues sealed blocks; the loop task writes them, outside
+// historyMutex, serialized by logMutex
+SegmentLog<fs::LittleFSFS> historyLog;
+SemaphoreHandle_t logMutex = NULL;
+QueueHandle_t sealedBlockQueue = NULL;
+uint32_t sealedBlocksDropped = 0;  // Queue full: the loop didn't get to them
+uint16_t bootCount = 0;  // Stamped into blocks recorded before SNTP sync
+const uint16_t EXPORT_BATCH_BLOCKS = 4;  // Blocks read from flash per lock (1 KB)
+SemaphoreHandle_t historyMutex = NULL;
+const int HISTORY_MAX_POINTS = 500;  // Upper bound for /history?points=
+const time_t MIN_VALID_EPOCH = 1700000000;  // Anything earlier means SNTP hasn't synced
+
+// Burst capture (/capture): a timer-driven task samples the BMP280 into a
+// buffer allocated at boot; the sensor task pauses its polling meanwhile
+BurstCapture burstCapture;
+TaskHandle_t captureTaskHandle = NULL;
+esp_timer_handle_t captureTimer = NULL;
+volatile bool captureActive = false;  // Read by the sensor task
 
 // AP Configuration (from board_config.h)
 // These will be modified with MAC address suffix in setup()
@@ -55,6 +232,141 @@ String ap_ssid_unique = "";
 String mdns_hostname_unique = "";
 const char* ap_password = AP_PASSWORD;
 
+// /metrics: per-route request counts and handler latency (routes registered
+// through addRoute()), loop iteration time and event counters. All updated
+// and read on the loop task.
+struct RouteMetrics {
+  const char* path;
+  uint32_t requests;
+  LatencyHistogram latency;  // µs
+};
+const uint8_t MAX_ROUTES = 40;
+RouteMetrics routeMetrics[MAX_ROUTES];
+uint8_t routeCount = 0;
+LatencyHistogram loopLatency;  // µs, one loop() pass excluding its trailing delay
+
+#ifdef PERF_PROFILING
+PerfProfiler perfProfiler;  // /debug/perf
+#endif
+
+// Heap health: worst largest-block / fragmentation since boot, sampled every
+// update cycle. The instrumented build (HEAP_ACCOUNTING) also counts the
+// allocations each route handler makes, through the malloc wrappers below.
+HeapWatermarks heapWatermarks;
+
+// Task monitor: CPU share per task over the last TASK_MONITOR_INTERVAL and
+// stack high-water marks, for sizing stacks and CPU_FREQ_MHZ per board
+TaskMonitor taskMonitor;
+unsigned long lastTaskSample = 0;
+
+#ifdef HEAP_ACCOUNTING
+#include "esp_heap_caps.h"
+
+RouteAllocations routeAllocations[MAX_ROUTES];
+volatile int8_t heapAccountingRoute = -1;  // Route whose handler is running, -1 outside handlers
+TaskHandle_t heapAccountingTask = NULL;    // Loop task: other tasks' allocations aren't attributed
+uint32_t heapRequestBytes = 0;
+
+// Linked with -Wl,--wrap=malloc etc.: every caller of malloc() lands in
+// __wrap_malloc(), which reaches the allocator through __real_malloc().
+// Sizes are the allocator's block sizes so allocated and freed bytes match.
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+static inline RouteAllocations* heapAccountingSlot() {
+  if (heapAccountingRoute < 0 || xTaskGetCurrentTaskHandle() != heapAccountingTask) {
+    return NULL;
+  }
+  return &routeAllocations[heapAccountingRoute];
+}
+
+static inline void countAllocation(RouteAllocations* slot, void* ptr) {
+  uint32_t bytes = heap_caps_get_allocated_size(ptr);
+  slot->allocations++;
+  slot->bytesAllocated += bytes;
+  heapRequestBytes += bytes;
+}
+
+static inline void countFree(RouteAllocations* slot, void* ptr) {
+  slot->frees++;
+  slot->bytesFreed += heap_caps_get_allocated_size(ptr);
+}
+
+void* __wrap_malloc(size_t size) {
+  void* ptr = __real_malloc(size);
+  RouteAllocations* slot = heapAccountingSlot();
+  if (slot != NULL && ptr != NULL) {
+    countAllocation(slot, ptr);
+  }
+  return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  void* ptr = __real_calloc(count, size);
+  RouteAllocations* slot = heapAccountingSlot();
+  if (slot != NULL && ptr != NULL) {
+    countAllocation(slot, ptr);
+  }
+  return ptr;
+}
+
+// String growth: counted as freeing the old block and allocating the new one
+void* __wrap_realloc(void* ptr, size_t size) {
+  RouteAllocations* slot = heapAccountingSlot();
+  uint32_t oldBytes = slot != NULL && ptr != NULL ? heap_caps_get_allocated_size(ptr) : 0;
+  void* moved = __real_realloc(ptr, size);
+  // A failed realloc leaves the old block in place: nothing to count
+  if (slot != NULL && (moved != NULL || size == 0)) {
+    if (ptr != NULL) {
+      slot->frees++;
+      slot->bytesFreed += oldBytes;
+    }
+    if (moved != NULL) {
+      countAllocation(slot, moved);
+    }
+  }
+  return moved;
+}
+
+void __wrap_free(void* ptr) {
+  RouteAllocations* slot = heapAccountingSlot();
+  if (slot != NULL && ptr != NULL) {
+    countFree(slot, ptr);
+  }
+  __real_free(ptr);
+}
+}
+
+inline void heapAccountingBegin(uint8_t route) {
+  heapRequestBytes = 0;
+  heapAccountingRoute = route;
+}
+
+inline void heapAccountingEnd(uint8_t route) {
+  heapAccountingRoute = -1;
+  routeAllocations[route].requests++;
+  if (heapRequestBytes > routeAllocations[route].peakRequestBytes) {
+    routeAllocations[route].peakRequestBytes = heapRequestBytes;
+  }
+}
+#else
+inline void heapAccountingBegin(uint8_t route) {}
+inline void heapAccountingEnd(uint8_t route) {}
+#endif
+
+struct SystemCounters {
+  uint32_t wifiScans = 0;       // /scan and roaming scans
+  uint32_t wifiRoams = 0;       // Switched to a stronger AP
+  uint32_t wifiDisconnects = 0;
+  uint32_t wifiReconnects = 0;
+  uint32_t otaAttempts = 0;
+  uint32_t otaFailures = 0;
+};
+SystemCounters systemCounters;
+
 // Variables for WiFi
 String sta_ssid = "";
 String sta_password = "";
@@ -66,7 +378,7 @@ bool apCurrentlyEnabled = true;  // Track current AP state
 String deviceName = "Living Room";  // Default device name (e.g., "Living Room", "Bedroom", "Kitchen")
 
 // OTA update flags
-bool otaInProgress = false;
+volatile bool otaInProgress = false;  // Also read by the sensor task
 bool otaInitialized = false;  // Track if OTA has been initialized
 
 // OTA preparation tracking (for disabling WiFi power save temporarily)
@@ -104,14 +416,46 @@ unsigned long lastRoamingCheck = 0;
 const unsigned long UPDATE_INTERVAL = 5000;  // 5 seconds - master update interval
 unsigned long lastUpdateCycle = 0;
 
+// I2C health: detached sensors are re-probed on this interval (multiple of UPDATE_INTERVAL)
+const unsigned long I2C_REPROBE_INTERVAL = 30000;
+// Task monitor window; each sample also prints a one-line summary (multiple of UPDATE_INTERVAL)
+const unsigned long TASK_MONITOR_INTERVAL = 60000;
+const uint16_t I2C_TIMEOUT_MS = 50;  // Per-transaction timeout to prevent freezing on I2C errors
+
 // Function prototypes
 void setupAccessPoint();
 void setupOTA();
 void setupMDNS();
-void setupBMP280();
-void setupAHT20();
-void readBMP280();
-void readAHT20();
+void setupSensors();
+void checkSensorHealth();
+void startSensorTask();
+void sensorTask(void* parameter);
+void setupCapture();
+void setupAnomalyDetection();
+void detectAnomalies(const SensorSnapshot& readings);
+void setupRules();
+void saveRules(uint8_t from);
+void evaluateRules(const SensorSnapshot& readings);
+void setupMqtt();
+void queueTelemetry(const SensorSnapshot& readings);
+bool connectMqtt();
+void serviceMqtt();
+void setupInflux();
+void serviceInflux();
+void setupBeacon();
+void sendBeacon();
+void serviceEventStream();
+void captureTask(void* parameter);
+void onCaptureTimer(void* arg);
+void setupHistory();
+void recordHistory(const SensorSnapshot& snapshot);
+void setupHistoryLog();
+void persistBlock(SensorBlock& block);
+void persistSealedBlocks();
+void rebaseBlock(SensorBlock& block);
+void flushHistoryLog();
+uint32_t uptimeSeconds();
+uint32_t toUnixTime(uint32_t uptime);
 void loadWiFiCredentials();
 void saveWiFiCredentials(String ssid, String password);
 void connectToWiFi();
@@ -120,6 +464,45 @@ void handleRoot();
 void handleScan();
 void handleConnect();
 void handleStatus();
+void handleI2CStats();
+void handleHistory();
+void handleStorageStats();
+void handleExport();
+void handleQuery();
+void handleCapture();
+void handleCaptureStatus();
+void handleCaptureData();
+void handleEvents();
+void handleAnomalies();
+void handleRules();
+void handleRulesAdd();
+void handleRulesDelete();
+void handleGetMqttSettings();
+void handleSetMqttSettings();
+void handleGetInfluxSettings();
+void handleSetInfluxSettings();
+void handleInfluxStats();
+void handleGetBeaconSettings();
+void handleSetBeaconSettings();
+void handleMetrics();
+void handleDebugPerf();
+void handleHeapStats();
+void handleDebugTasks();
+void sampleTasks();
+void setupLogging();
+void logDrainTask(void* parameter);
+void drainLogs();
+void flushLogs(uint32_t timeoutMs);
+void handleLogs();
+void setupBootHistory();
+void readCrashSummary(BootRecord& record);
+void startSupervisor();
+void supervisorTask(void* parameter);
+void superviseHeartbeats();
+void serviceRestarts();
+void abortOta();
+void handleDebugHeartbeats();
+void addRoute(const char* path, void (*handler)());
 void handlePrepareOTA();
 void handleGetAPSettings();
 void handleSetAPSettings();
@@ -133,6 +516,8 @@ String getHTMLPage();
 
 void setup() {
   Serial.begin(115200);
+  setupLogging();  // Before anything logs
+  setupBootHistory();  // Before the sensor task overwrites the previous boot's breadcrumbs
   delay(1000);
 
   // OTA improvements test - firmware version 1.1
@@ -150,18 +535,17 @@ void setup() {
   mdns_hostname_unique.toLowerCase(); // mDNS hostnames should be lowercase
 
   // Initialize watchdog timer to prevent system freezes
-  // If the system freezes for more than 10 seconds, it will auto-reset
+  // If setup() freezes for more than 10 seconds, it will auto-reset; once it
+  // is done the heartbeat supervisor takes over (see startSupervisor())
   esp_task_wdt_init(WDT_TIMEOUT, true);  // 10 sec timeout, panic on timeout
   esp_task_wdt_add(NULL);  // Add current thread to watchdog
-  Serial.println("✓ Watchdog timer enabled (10s timeout)");
+  LOG_I("sys", "Watchdog timer enabled (%ds timeout)", WDT_TIMEOUT);
 
   // POWER SAVING: Set CPU frequency from board config
   // ESP32-C3: 80 MHz for power saving (~30-40% reduction)
   // ESP32 WROOM: 160 MHz for standard performance (or 240 MHz max)
   setCpuFrequencyMhz(CPU_FREQ_MHZ);
-  Serial.print("✓ CPU Frequency set to ");
-  Serial.print(CPU_FREQ_MHZ);
-  Serial.println(" MHz");
+  LOG_I("sys", "CPU frequency set to %d MHz", CPU_FREQ_MHZ);
 
   // Setup LED pin (board-specific, see board_config.h)
   pinMode(LED_PIN, OUTPUT);
@@ -170,31 +554,23 @@ void setup() {
   // Give sensors time to power up and stabilize after CPU frequency change
   delay(500);
 
-  // Initialize BMP280 sensor
-  setupBMP280();
-
-  // Initialize AHT20 sensor
-  setupAHT20();
-
-  Serial.println("\n=================================");
-  Serial.print(BOARD_FULL_NAME);
-  Serial.println(" - Monitor");
-  Serial.println("=================================");
-  Serial.print("Board: ");
-  Serial.println(BOARD_NAME);
-  Serial.print("Chip Model: ");
-  Serial.println(ESP.getChipModel());
-  Serial.print("Chip Revision: ");
-  Serial.println(ESP.getChipRevision());
-  Serial.print("CPU Frequency: ");
-  Serial.print(ESP.getCpuFreqMHz());
-  Serial.println(" MHz");
-  Serial.print("Free Heap: ");
-  Serial.print(ESP.getFreeHeap() / 1024);
-  Serial.println(" KB");
-  Serial.print("Note: ");
-  Serial.println(BOARD_NOTES);
-  Serial.println("=================================\n");
+  // Initialize I2C sensors (BOARD_SENSORS)
+  setupSensors();
+
+  // Before the sensor task, which feeds the detector from its first cycle
+  setupAnomalyDetection();
+  setupRules();
+
+  // Move sensor acquisition off the Arduino loop task
+  startSensorTask();
+
+  // Burst capture buffer and timer (before the history ring takes its share of heap)
+  setupCapture();
+
+  LOG_I("sys", "%s - Monitor, firmware %s", BOARD_FULL_NAME, FIRMWARE_VERSION);
+  LOG_I("sys", "Board %s, chip %s rev %d, %lu MHz, %lu KB free heap", BOARD_NAME, ESP.getChipModel(),
+        ESP.getChipRevision(), (unsigned long)ESP.getCpuFreqMHz(), (unsigned long)(ESP.getFreeHeap() / 1024));
+  LOG_I("sys", "Note: %s", BOARD_NOTES);
 
   // Initialize NVS
   preferences.begin("wifi-creds", false);
@@ -202,6 +578,10 @@ void setup() {
   // Load saved WiFi credentials
   loadWiFiCredentials();
 
+  // MQTT settings share the same NVS namespace
+  setupMqtt();
+  setupBeacon();
+
   // Setup Access Point (always active as fallback)
   setupAccessPoint();
 
@@ -214,10 +594,10 @@ void setup() {
 
   // Try to connect to saved WiFi network
   if (sta_ssid.length() > 0) {
-    Serial.println("Attempting to connect to saved WiFi...");
+    LOG_I("wifi", "Connecting to saved network");
     connectToWiFi();
   } else {
-    Serial.println("No saved WiFi credentials - AP mode only\n");
+    LOG_I("wifi", "No saved credentials - AP mode only");
   }
 
   // Setup OTA updates and reinitialize mDNS for Station mode
@@ -232,104 +612,143 @@ void setup() {
     }
   }
 
-  // Setup web server routes
-  server.on("/", handleRoot);
-  server.on("/scan", handleScan);
-  server.on("/connect", handleConnect);
-  server.on("/status", handleStatus);
-  server.on("/prepare-ota", handlePrepareOTA);
-  server.on("/get-ap-settings", handleGetAPSettings);
-  server.on("/set-ap-settings", handleSetAPSettings);
-  server.on("/get-device-name", handleGetDeviceName);
-  server.on("/set-device-name", handleSetDeviceName);
+  // Setup web server routes (counted and timed for /metrics)
+#ifdef HEAP_ACCOUNTING
+  heapAccountingTask = xTaskGetCurrentTaskHandle();  // setup() and loop() share the loop task
+#endif
+  addRoute("/", handleRoot);
+  addRoute("/scan", handleScan);
+  addRoute("/connect", handleConnect);
+  addRoute("/status", handleStatus);
+  addRoute("/i2c-stats", handleI2CStats);
+  addRoute("/history", handleHistory);
+  addRoute("/storage-stats", handleStorageStats);
+  addRoute("/export", handleExport);
+  addRoute("/query", handleQuery);
+  addRoute("/capture", handleCapture);
+  addRoute("/capture-status", handleCaptureStatus);
+  addRoute("/capture-data", handleCaptureData);
+  addRoute("/events", handleEvents);
+  addRoute("/anomalies", handleAnomalies);
+  addRoute("/rules", handleRules);
+  addRoute("/rules-add", handleRulesAdd);
+  addRoute("/rules-delete", handleRulesDelete);
+  addRoute("/prepare-ota", handlePrepareOTA);
+  addRoute("/get-ap-settings", handleGetAPSettings);
+  addRoute("/set-ap-settings", handleSetAPSettings);
+  addRoute("/get-device-name", handleGetDeviceName);
+  addRoute("/set-device-name", handleSetDeviceName);
+  addRoute("/get-mqtt-settings", handleGetMqttSettings);
+  addRoute("/set-mqtt-settings", handleSetMqttSettings);
+  addRoute("/get-influx-settings", handleGetInfluxSettings);
+  addRoute("/set-influx-settings", handleSetInfluxSettings);
+  addRoute("/influx-stats", handleInfluxStats);
+  addRoute("/get-beacon-settings", handleGetBeaconSettings);
+  addRoute("/set-beacon-settings", handleSetBeaconSettings);
+  addRoute("/metrics", handleMetrics);
+  addRoute("/debug/perf", handleDebugPerf);
+  addRoute("/heap-stats", handleHeapStats);
+  addRoute("/debug/tasks", handleDebugTasks);
+  addRoute("/logs", handleLogs);
+  addRoute("/debug/heartbeats", handleDebugHeartbeats);
 
   // Start web server
   server.begin();
-  Serial.println("✓ Web server started!");
+  LOG_I("http", "Web server started");
 
-  // Print connection info
-  Serial.println("\n========== CONNECTION INFO ==========");
-  Serial.println("To connect:");
-  Serial.println("1. Connect to WiFi: " + ap_ssid_unique);
-  Serial.println("2. Password: " + String(ap_password));
-  Serial.println("3. Open browser to: http://192.168.4.1");
-  Serial.print("   or: http://");
-  Serial.print(mdns_hostname_unique);
-  Serial.println(".local");
-  Serial.println("=====================================\n");
+  // Size the history ring last, once WiFi and the web server hold their buffers
+  setupHistory();
+
+  // After setupHistory(), which mounts LittleFS for the spool
+  setupInflux();
 
+  // Print connection info
+  LOG_I("sys", "To connect: join %s (password %s), open http://192.168.4.1 or http://%s.local",
+        ap_ssid_unique.c_str(), ap_password, mdns_hostname_unique.c_str());
   if (sta_connected) {
-    Serial.println("Also accessible at: http://" + WiFi.localIP().toString());
+    LOG_I("sys", "Also accessible at http://%s", WiFi.localIP().toString().c_str());
   }
+  LOG_I("sys", "Power: modem sleep, %d MHz CPU, %lus update cycle", CPU_FREQ_MHZ, UPDATE_INTERVAL / 1000);
+  LOG_I("sys", "Setup complete");
 
-  Serial.println("\n========== POWER OPTIMIZATION ==========");
-  Serial.println("✓ WiFi Modem Sleep: Enabled");
-  Serial.println("✓ CPU Frequency: 80 MHz");
-  Serial.println("✓ Update Cycle: 5 seconds");
-  Serial.println("✓ Expected Power: 15-25 mA average");
-  Serial.println("  (60-75% reduction vs no optimization)");
-  Serial.println("=========================================\n");
-
-  Serial.println("Setup complete! LED will flash every 5 seconds...\n");
+  // Last, so no heartbeat's clock starts before its subsystem is up
+  startSupervisor();
 }
 
 void loop() {
-  // Feed the watchdog timer to prevent auto-reset
-  esp_task_wdt_reset();
+  int64_t loopStarted = esp_timer_get_time();
+  bootBreadcrumbs.uptimeMs = millis();
+
+  // Restarts the supervisor asked for since the last pass
+  serviceRestarts();
 
   // Always handle time-critical tasks first (web server, OTA)
   // These must respond quickly regardless of sleep schedule
   if (!otaInProgress) {
-    server.handleClient();
+    PERF_TIME(PERF_HANDLE_CLIENT, server.handleClient());
+    PERF_TIME(PERF_EVENT_STREAM, serviceEventStream());
+    heartbeats.beat(HEARTBEAT_WEB, millis());
+    PERF_TIME(PERF_MQTT, serviceMqtt());
+    heartbeats.beat(HEARTBEAT_MQTT, millis());
+    PERF_TIME(PERF_INFLUX, serviceInflux());
+    heartbeats.beat(HEARTBEAT_INFLUX, millis());
   }
 
   // Handle OTA updates (only when connected to WiFi)
   // Note: mDNS runs automatically in background on ESP32
+  PERF_BEGIN(PERF_OTA_HANDLE);
   if (sta_connected) {
     ArduinoOTA.handle();
 
     // Check if OTA prep timeout expired and re-enable power save
     // IMPORTANT: Don't re-enable power save if OTA is currently in progress!
     if (otaPrepared && !otaInProgress && (millis() - otaPreparedTime > OTA_PREP_TIMEOUT)) {
-      Serial.println("\n--- OTA Prep Timeout ---");
-      Serial.println("Re-enabling power saving features...");
-
       // Re-enable WiFi modem sleep
       WiFi.setSleep(true);
       esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
-      Serial.println("✓ WiFi modem sleep re-enabled");
 
       // Explicit light sleep will automatically resume (controlled by otaPrepared flag)
-      Serial.println("✓ Explicit light sleep will resume in main loop");
-
       otaPrepared = false;
-      Serial.println("--- Power Saving Restored ---\n");
+      LOG_I("ota", "Prepare window expired - WiFi modem sleep re-enabled");
     }
   }
+  heartbeats.beat(HEARTBEAT_OTA, millis());
+  PERF_END(PERF_OTA_HANDLE);
 
   // POWER OPTIMIZATION: Synchronize all periodic tasks to 5-second intervals
   // This allows CPU to sleep for ~4+ seconds between update cycles
   unsigned long currentMillis = millis();
 
   // Check if it's time for the 5-second update cycle
+  // Sensor readings run on the same cadence in sensorTask()
   if (!otaInProgress && (currentMillis - lastUpdateCycle >= UPDATE_INTERVAL)) {
+    PERF_BEGIN(PERF_UPDATE_CYCLE);
     lastUpdateCycle = currentMillis;
 
-    // Feed watchdog before potentially slow I2C operations
-    esp_task_wdt_reset();
+    heapWatermarks.sample(ESP.getFreeHeap(), ESP.getMaxAllocHeap());
+    PERF_TIME(PERF_PERSIST, persistSealedBlocks());
+    bootBreadcrumbs.unixTime = toUnixTime(uptimeSeconds());
 
-    // === SENSOR READINGS (synchronized to 5-second cycle) ===
-    readBMP280();
-    readAHT20();
+    if (currentMillis - lastTaskSample >= TASK_MONITOR_INTERVAL) {
+      lastTaskSample = currentMillis;
+      sampleTasks();
+    }
 
     // === WIFI ROAMING CHECK (at appropriate intervals) ===
     // Only check if enough time has passed since last roaming check
     if (sta_connected && !otaPrepared && (currentMillis - lastRoamingCheck >= currentRoamingInterval)) {
-      checkWiFiRoaming();
+      PERF_TIME(PERF_ROAMING, checkWiFiRoaming());
+    }
+
+    // === TELEMETRY BEACON (same wake-up as the rest of the cycle) ===
+    if (beaconEnabled && sta_connected) {
+      sendBeacon();
     }
+    PERF_END(PERF_UPDATE_CYCLE);
   }
 
   // LED control logic (uses LED_ON()/LED_OFF() macros from board_config.h)
+  PERF_BEGIN(PERF_LED);
   if (otaInProgress) {
     // OTA in progress: Extremely fast flashing (50ms interval) - actively uploading!
     if (currentMillis - lastLedBlink >= 50) {
@@ -344,6 +763,14 @@ void loop() {
       ledState = !ledState;
       if (ledState) { LED_ON(); } else { LED_OFF(); }
     }
+  } else if (ruleLedPattern != RULE_LED_NONE) {
+    // A firing rule with an LED action: blink (250ms) or strobe (50ms flash every 500ms)
+    unsigned long interval = ruleLedPattern == RULE_LED_STROBE ? (ledState ? 50 : 450) : 250;
+    if (currentMillis - lastLedBlink >= interval) {
+      lastLedBlink = currentMillis;
+      ledState = !ledState;
+      if (ledState) { LED_ON(); } else { LED_OFF(); }
+    }
   } else if (sta_connected) {
     // Connected to WiFi: Heartbeat pattern (♥ lub-dub ... pause ... ♥ lub-dub)
     if (currentMillis - lastHeartbeat >= HEARTBEAT_PATTERN[heartbeatStep]) {
@@ -368,11 +795,15 @@ void loop() {
     }
   }
 
+  PERF_END(PERF_LED);
+
   // Check WiFi connection status
+  PERF_BEGIN(PERF_WIFI_STATUS);
   if (sta_ssid.length() > 0 && WiFi.status() != WL_CONNECTED && sta_connected) {
     sta_connected = false;
     otaInitialized = false;  // Mark OTA as uninitialized when WiFi disconnects
-    Serial.println("WiFi connection lost!");
+    systemCounters.wifiDisconnects++;
+    LOG_W("wifi", "Connection lost");
 
     // Re-enable AP if it was disabled due to the "disable AP when connected" setting
     if (disableAPWhenConnected && !apCurrentlyEnabled) {
@@ -380,8 +811,8 @@ void loop() {
     }
   } else if (sta_ssid.length() > 0 && WiFi.status() == WL_CONNECTED && !sta_connected) {
     sta_connected = true;
-    Serial.println("WiFi reconnected!");
-    Serial.println("Station IP: " + WiFi.localIP().toString());
+    systemCounters.wifiReconnects++;
+    LOG_I("wifi", "Reconnected, station IP %s", WiFi.localIP().toString().c_str());
     // Setup mDNS and OTA after reconnection
     setupMDNS();
     setupOTA();
@@ -395,16 +826,22 @@ void loop() {
   // Ensure OTA is always initialized when WiFi is connected
   // This handles edge cases where OTA might fail to initialize or gets stopped
   if (sta_connected && !otaInitialized) {
-    Serial.println("OTA not initialized but WiFi connected - initializing now...");
+    LOG_W("ota", "Not initialized but WiFi connected - initializing now");
     setupOTA();
   }
+  heartbeats.beat(HEARTBEAT_WIFI, millis());
+  PERF_END(PERF_WIFI_STATUS);
+
+  uint32_t loopTime = (uint32_t)(esp_timer_get_time() - loopStarted);
+  loopLatency.record(loopTime);
+  PERF_RECORD(PERF_LOOP, loopTime);
 
   // Small delay to prevent watchdog timeout and allow WiFi stack to process
   delay(10);
 }
 
 void setupAccessPoint() {
-  Serial.println("Setting up Access Point...");
+  LOG_I("ap", "Setting up access point");
 
   // Disconnect any previous connections
   WiFi.disconnect(true);
@@ -420,9 +857,9 @@ void setupAccessPoint() {
   bool result = WiFi.softAP(ap_ssid_unique.c_str(), ap_password, 1, 0, 4);
 
   if (result) {
-    Serial.println("✓ Access Point created successfully!");
+    LOG_I("ap", "Access point created");
   } else {
-    Serial.println("✗ Failed to create Access Point!");
+    LOG_E("ap", "Failed to create access point");
   }
 
   // Set WiFi TX power based on board configuration
@@ -430,9 +867,9 @@ void setupAccessPoint() {
   // ESP32 WROOM: Can use full power (19.5dBm) for maximum range
   WiFi.setTxPower(WIFI_TX_POWER);
   #if WIFI_NEEDS_POWER_REDUCTION
-    Serial.println("✓ WiFi TX Power set to 8.5dBm (board hardware limitation)");
+    LOG_I("wifi", "TX power set to 8.5 dBm (board hardware limitation)");
   #else
-    Serial.println("✓ WiFi TX Power set to 19.5dBm (maximum range)");
+    LOG_I("wifi", "TX power set to 19.5 dBm (maximum range)");
   #endif
 
   // POWER SAVING: Enable WiFi Modem Sleep Mode
@@ -440,7 +877,7 @@ void setupAccessPoint() {
   // Reduces power consumption by ~60-75% (80 mA → 15-25 mA)
   // Web server remains accessible with minimal latency increase (~50-100ms)
   WiFi.setSleep(true);  // Enable WIFI_PS_MIN_MODEM
-  Serial.println("✓ WiFi Modem Sleep enabled for power saving");
+  LOG_I("wifi", "Modem sleep enabled for power saving");
 
   // TODO: Implement explicit light sleep for ESP32-C3/S2/S3/C6 (WiFi wakeup supported)
   // esp_sleep_enable_wifi_wakeup() NOT supported on ESP32 WROOM-32
@@ -454,24 +891,15 @@ void setupAccessPoint() {
   IPAddress subnet(255, 255, 255, 0);
 
   if (WiFi.softAPConfig(local_IP, gateway, subnet)) {
-    Serial.println("✓ AP IP configured successfully");
+    LOG_I("ap", "AP IP configured");
   } else {
-    Serial.println("✗ Failed to configure AP IP");
+    LOG_E("ap", "Failed to configure AP IP");
   }
 
   delay(100);
 
-  IPAddress IP = WiFi.softAPIP();
-  Serial.println("\n--- Access Point Details ---");
-  Serial.print("SSID: ");
-  Serial.println(ap_ssid_unique);
-  Serial.print("Password: ");
-  Serial.println(ap_password);
-  Serial.print("IP Address: ");
-  Serial.println(IP);
-  Serial.print("MAC Address: ");
-  Serial.println(WiFi.softAPmacAddress());
-  Serial.println("---------------------------\n");
+  LOG_I("ap", "SSID %s, password %s, IP %s, MAC %s", ap_ssid_unique.c_str(), ap_password,
+        WiFi.softAPIP().toString().c_str(), WiFi.softAPmacAddress().c_str());
 }
 
 void setupOTA() {
@@ -492,54 +920,50 @@ void setupOTA() {
       type = "filesystem";
     }
 
-    Serial.println("\n========================================");
-    Serial.println("       OTA UPDATE STARTING");
-    Serial.println("========================================");
-    Serial.println("Type: " + type);
-    Serial.println("\nFreeing resources for OTA...");
+    LOG_I("ota", "Update starting (%s), freeing resources", type.c_str());
 
     // Set OTA flag to stop sensor readings and other tasks
     otaInProgress = true;
+    systemCounters.otaAttempts++;
+
+    // Keep the history recorded since the last sealed block
+    // (a filesystem update replaces the log partition anyway)
+    if (ArduinoOTA.getCommand() == U_FLASH) {
+      flushHistoryLog();
+    }
 
     // CRITICAL: Stop web server to free TCP buffers and memory
     // This prevents TCP buffer overflow during OTA
     server.stop();
-    Serial.println("✓ Web server stopped");
 
     // WiFi power save should already be disabled via /prepare-ota endpoint
     // If not already disabled, disable it now (backup safety)
     if (!otaPrepared) {
-      Serial.println("⚠ WARNING: OTA started without /prepare-ota call!");
-      Serial.println("Disabling WiFi power save now...");
+      LOG_W("ota", "Started without /prepare-ota - disabling WiFi power save now");
       WiFi.setSleep(false);
       esp_wifi_set_ps(WIFI_PS_NONE);
-      Serial.println("✓ WiFi power save FULLY disabled (WIFI_PS_NONE)");
-    } else {
-      Serial.println("✓ WiFi power save already disabled via /prepare-ota");
     }
 
     // Stop I2C sensors to prevent interrupts
     // Frequent sensor readings can interfere with OTA timing
-    Wire.end();
-    Serial.println("✓ I2C bus closed");
-
-    // CRITICAL: Disable watchdog timer during OTA to prevent timeout resets
-    // Flash writes can take >10 seconds, exceeding the watchdog timeout
-    esp_task_wdt_delete(NULL);  // Remove current task from watchdog
-    Serial.println("✓ Watchdog timer disabled for OTA");
+    // (waits for any in-flight sensor task transaction to finish)
+    i2cBus.end();
+
+    // The upload blocks loop() until it ends: only the OTA heartbeat stays
+    // supervised, beaten by every progress callback (flash erases and writes
+    // can take longer than WDT_TIMEOUT, but never HEARTBEAT_OTA_MS)
+    heartbeats.suspend(HEARTBEAT_WEB);
+    heartbeats.suspend(HEARTBEAT_WIFI);
+    heartbeats.suspend(HEARTBEAT_MQTT);
+    heartbeats.suspend(HEARTBEAT_INFLUX);
+    heartbeats.beat(HEARTBEAT_OTA, millis());
 
     // LED will flash rapidly (50ms) during OTA - handled in loop()
-    Serial.println("✓ LED will flash rapidly during OTA");
-
-    Serial.print("\nFree heap before OTA: ");
-    Serial.print(ESP.getFreeHeap() / 1024);
-    Serial.println(" KB");
-    Serial.println("Ready for upload...\n");
+    LOG_I("ota", "Web server stopped, I2C closed; %lu KB free, ready for upload",
+          (unsigned long)(ESP.getFreeHeap() / 1024));
   });
 
   ArduinoOTA.onEnd([]() {
-    Serial.println("\n--- OTA Update Complete ---");
-
     // Clear OTA prep flag (power save will be re-enabled after reboot)
     otaPrepared = false;
 
@@ -549,56 +973,49 @@ void setupOTA() {
     LED_OFF();
     delay(100);  // Allow pin state to stabilize
 
-    Serial.println("✓ LED pin set to safe state for reboot");
-    Serial.println("Rebooting...");
+    LOG_I("ota", "Update complete, rebooting");
+    flushLogs(500);  // ArduinoOTA restarts as soon as this returns
   });
 
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
     static unsigned int lastPercent = 0;
     unsigned int percent = (progress / (total / 100));
+    heartbeats.beat(HEARTBEAT_OTA, millis());
 
     // Only print every 10%
     if (percent != lastPercent && percent % 10 == 0) {
-      Serial.printf("Progress: %u%%\n", percent);
+      LOG_I("ota", "Progress: %u%%", percent);
       lastPercent = percent;
     }
   });
 
   ArduinoOTA.onError([](ota_error_t error) {
-    Serial.printf("\n--- OTA Error[%u]: ", error);
+    systemCounters.otaFailures++;
+    const char* reason = "Unknown";
     if (error == OTA_AUTH_ERROR) {
-      Serial.println("Auth Failed");
+      reason = "Auth Failed";
     } else if (error == OTA_BEGIN_ERROR) {
-      Serial.println("Begin Failed");
+      reason = "Begin Failed";
     } else if (error == OTA_CONNECT_ERROR) {
-      Serial.println("Connect Failed");
+      reason = "Connect Failed";
     } else if (error == OTA_RECEIVE_ERROR) {
-      Serial.println("Receive Failed");
+      reason = "Receive Failed";
     } else if (error == OTA_END_ERROR) {
-      Serial.println("End Failed");
+      reason = "End Failed";
     }
-    Serial.println("--- OTA Error End ---\n");
+    LOG_E("ota", "Error[%u]: %s", error, reason);
+    abortOta();  // Still running the old firmware: bring back what onStart() stopped, if it ran
   });
 
   ArduinoOTA.begin();
   otaInitialized = true;  // Mark OTA as successfully initialized
 
-  Serial.println("\n--- OTA Update Enabled ---");
-  Serial.print("Hostname: ");
-  Serial.println(mdns_hostname_unique);
-  Serial.println("IP Address: " + WiFi.localIP().toString());
-  Serial.println("Port: 3232");
-  Serial.println("Password: admin");
-  Serial.println("\nTo upload via OTA:");
-  Serial.println("pio run -t upload --upload-port " + WiFi.localIP().toString());
-  Serial.print("  or: pio run -t upload --upload-port ");
-  Serial.println(mdns_hostname_unique + ".local");
-  Serial.println("--- OTA Ready ---\n");
+  LOG_I("ota", "Enabled: %s (%s) port %d", mdns_hostname_unique.c_str(), WiFi.localIP().toString().c_str(),
+        OTA_PORT);
+  LOG_I("ota", "Upload with: pio run -t upload --upload-port %s.local", mdns_hostname_unique.c_str());
 }
 
 void setupMDNS() {
-  Serial.println("\n--- Initializing mDNS ---");
-
   // IMPORTANT: Always stop mDNS service first if it's running
   // This ensures clean state when called from loop() after WiFi connects
   MDNS.end();
@@ -607,16 +1024,11 @@ void setupMDNS() {
   // Start mDNS service with retry logic using unique hostname
   bool success = false;
   for (int attempt = 1; attempt <= 3; attempt++) {
-    Serial.print("mDNS attempt ");
-    Serial.print(attempt);
-    Serial.print("/3... ");
-
     if (MDNS.begin(mdns_hostname_unique.c_str())) {
       success = true;
-      Serial.println("SUCCESS!");
       break;
     } else {
-      Serial.println("failed");
+      LOG_W("mdns", "Attempt %d/3 failed", attempt);
       if (attempt < 3) {
         delay(500);  // Wait before retry
       }
@@ -627,18 +1039,9 @@ void setupMDNS() {
     // Add service to mDNS-SD
     MDNS.addService("http", "tcp", 80);
 
-    Serial.println("\n✓ mDNS Ready!");
-    Serial.print("Hostname: ");
-    Serial.print(mdns_hostname_unique);
-    Serial.println(".local");
-    Serial.print("Access via: http://");
-    Serial.print(mdns_hostname_unique);
-    Serial.println(".local");
-    Serial.println("--- mDNS Initialized ---\n");
+    LOG_I("mdns", "Ready: http://%s.local", mdns_hostname_unique.c_str());
   } else {
-    Serial.println("\n✗ mDNS failed after 3 attempts");
-    Serial.println("Device still accessible via IP address");
-    Serial.println("Try rebooting to enable mDNS\n");
+    LOG_E("mdns", "Failed after 3 attempts - device still accessible via IP address");
   }
 }
 
@@ -649,29 +1052,27 @@ void loadWiFiCredentials() {
   deviceName = preferences.getString("deviceName", "Living Room");
 
   if (sta_ssid.length() > 0) {
-    Serial.println("Loaded WiFi credentials from NVS");
-    Serial.println("SSID: " + sta_ssid);
-    Serial.println("Disable AP when connected: " + String(disableAPWhenConnected ? "Yes" : "No"));
+    LOG_I("wifi", "Loaded credentials for %s (disable AP when connected: %s)", sta_ssid.c_str(),
+          disableAPWhenConnected ? "yes" : "no");
   } else {
-    Serial.println("No saved WiFi credentials found");
+    LOG_I("wifi", "No saved credentials found");
   }
-  Serial.println("Device Name: " + deviceName);
+  LOG_I("sys", "Device name: %s", deviceName.c_str());
 }
 
 void saveWiFiCredentials(String ssid, String password) {
   preferences.putString("ssid", ssid);
   preferences.putString("password", password);
-  Serial.println("WiFi credentials saved to NVS");
+  LOG_I("wifi", "Credentials saved to NVS");
 }
 
 void connectToWiFi() {
   if (sta_ssid.length() == 0) {
-    Serial.println("No SSID provided");
+    LOG_W("wifi", "No SSID provided");
     return;
   }
 
-  Serial.print("Connecting to WiFi: ");
-  Serial.println(sta_ssid);
+  LOG_I("wifi", "Connecting to %s", sta_ssid.c_str());
 
   WiFi.begin(sta_ssid.c_str(), sta_password.c_str());
 
@@ -688,24 +1089,19 @@ void connectToWiFi() {
   int attempts = 0;
   while (WiFi.status() != WL_CONNECTED && attempts < 20) {
     delay(500);
-    Serial.print(".");
     attempts++;
   }
 
   if (WiFi.status() == WL_CONNECTED) {
     sta_connected = true;
-    Serial.println("\nConnected to WiFi!");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
-    Serial.print("BSSID: ");
-    Serial.println(WiFi.BSSIDstr());
-    Serial.print("Signal strength: ");
-    Serial.print(WiFi.RSSI());
-    Serial.println(" dBm");
-    Serial.println("✓ WiFi Modem Sleep active (station mode)");
+    LOG_I("wifi", "Connected: IP %s, BSSID %s, %d dBm", WiFi.localIP().toString().c_str(),
+          WiFi.BSSIDstr().c_str(), WiFi.RSSI());
+
+    // Wall clock for history timestamps (UTC; SNTP keeps resyncing in the background)
+    configTime(0, 0, "pool.ntp.org", "time.nist.gov");
   } else {
     sta_connected = false;
-    Serial.println("\nFailed to connect to WiFi");
+    LOG_E("wifi", "Failed to connect to %s", sta_ssid.c_str());
   }
 }
 
@@ -727,22 +1123,16 @@ void checkWiFiRoaming() {
     // Signal improved - reset backoff timer for next time
     if (currentRoamingInterval != ROAMING_INTERVAL_MIN) {
       currentRoamingInterval = ROAMING_INTERVAL_MIN;
-      Serial.println("✓ WiFi signal good - reset roaming interval to 15s");
+      LOG_D("wifi", "Signal good - roaming interval reset to %lus", ROAMING_INTERVAL_MIN / 1000);
     }
     return;  // No scan needed
   }
 
-  Serial.println("\n--- WiFi Roaming Check ---");
-  Serial.print("Current RSSI: ");
-  Serial.print(currentRSSI);
-  Serial.println(" dBm (weak signal)");
-  Serial.print("Current interval: ");
-  Serial.print(currentRoamingInterval / 1000);
-  Serial.println("s");
-  Serial.println("Scanning for better AP...");
+  LOG_I("wifi", "Weak signal (%d dBm) - scanning for a better AP", currentRSSI);
 
   // Scan for networks
   int n = WiFi.scanNetworks();
+  systemCounters.wifiScans++;
 
   int bestRSSI = currentRSSI;
   String bestBSSID = "";
@@ -753,11 +1143,7 @@ void checkWiFiRoaming() {
       int rssi = WiFi.RSSI(i);
       String bssid = WiFi.BSSIDstr(i);
 
-      Serial.print("Found AP: ");
-      Serial.print(bssid);
-      Serial.print(" with RSSI: ");
-      Serial.print(rssi);
-      Serial.println(" dBm");
+      LOG_D("wifi", "Found AP %s at %d dBm", bssid.c_str(), rssi);
 
       // Check if this AP is significantly better
       if (rssi > bestRSSI + RSSI_IMPROVEMENT) {
@@ -769,22 +1155,17 @@ void checkWiFiRoaming() {
 
   // If we found a better AP, switch to it
   if (bestBSSID.length() > 0 && bestBSSID != currentBSSID) {
-    Serial.print("✓ Switching to better AP: ");
-    Serial.print(bestBSSID);
-    Serial.print(" (");
-    Serial.print(bestRSSI);
-    Serial.println(" dBm)");
+    LOG_I("wifi", "Switching to better AP %s (%d dBm)", bestBSSID.c_str(), bestRSSI);
 
     // Disconnect and reconnect to force AP selection
+    systemCounters.wifiRoams++;
     WiFi.disconnect();
     delay(100);
     connectToWiFi();
 
     // Successfully switched - reset interval to minimum
     currentRoamingInterval = ROAMING_INTERVAL_MIN;
-    Serial.println("✓ Reset roaming interval to 15s after successful switch");
   } else {
-    Serial.println("✗ No better AP found, staying connected");
 
     // No better AP found - increase interval (exponential backoff)
     unsigned long newInterval = currentRoamingInterval * 2;
@@ -794,17 +1175,9 @@ void checkWiFiRoaming() {
 
     if (newInterval != currentRoamingInterval) {
       currentRoamingInterval = newInterval;
-      Serial.print("⏱  Increased roaming interval to ");
-      Serial.print(currentRoamingInterval / 1000);
-      Serial.println("s (exponential backoff)");
-    } else {
-      Serial.print("⏱  Staying at max interval: ");
-      Serial.print(currentRoamingInterval / 1000);
-      Serial.println("s");
     }
+    LOG_I("wifi", "No better AP found, next check in %lus", currentRoamingInterval / 1000);
   }
-
-  Serial.println("--- Roaming Check Complete ---\n");
 }
 
 String getUptime() {
@@ -840,133 +1213,728 @@ float getTemperature() {
   return temp_celsius;
 }
 
-void setupBMP280() {
-  Serial.println("\n--- BMP280 Sensor Setup ---");
-
-  // Initialize I2C with custom pins for ESP32-C3 Super Mini
-  Wire.begin(I2C_SDA, I2C_SCL);
-  Wire.setTimeOut(50);  // 50ms timeout to prevent freezing on I2C errors
+void setupSensors() {
+  // Initialize I2C with custom pins (board-specific, see board_config.h)
+  i2cBus.begin(I2C_SDA, I2C_SCL, I2C_TIMEOUT_MS);
 
-  // Give I2C bus time to initialize
+  // Give I2C bus and sensors time to initialize
   delay(100);
 
-  Serial.println("Attempting to initialize BMP280 at address 0x76...");
-
-  // Try to initialize the sensor at 0x76 (common address)
-  if (!bmp.begin(0x76)) {
-    Serial.println("✗ Could not find BMP280 sensor at 0x76!");
-    Serial.println("  Check wiring:");
-    Serial.println("  - VCC to 3V3");
-    Serial.println("  - GND to GND");
-    Serial.print("  - SDA to GPIO");
-    Serial.println(I2C_SDA);
-    Serial.print("  - SCL to GPIO");
-    Serial.println(I2C_SCL);
-    Serial.println("  Trying alternate address 0x77...");
-
-    // Try alternate I2C address (library default)
-    if (!bmp.begin(0x77)) {
-      Serial.println("✗ BMP280 not found at 0x77 either!");
-      Serial.println("--- BMP280 Setup Failed ---\n");
-      bmpAvailable = false;
+  // A sensor reset mid-transaction (e.g. brown-out) can leave SDA held low
+  if (!i2cBus.checkAndRecover()) {
+    LOG_E("i2c", "Bus stuck (SDA held low) - recovery failed");
+  }
+
+  // Probe every driver in BOARD_SENSORS
+  // Missing sensors are re-probed at runtime (see checkSensorHealth())
+  sensors.beginAll(i2cBus, ADAPTIVE_MAX_INTERVAL_MS);
+
+  // Initial reading is taken by the sensor task on its first cycle
+}
+
+void checkSensorHealth() {
+  static unsigned long lastReprobe = 0;
+
+  // Hot-reattach: re-probe missing sensors without a reboot
+  bool reprobe = sensors.anyDetached() && (millis() - lastReprobe >= I2C_REPROBE_INTERVAL);
+  if (reprobe) {
+    lastReprobe = millis();
+  }
+
+  // Detaches sensors that keep failing so the dashboard reports them as missing.
+  // Failed transactions may have left a slave holding the bus.
+  if (sensors.checkHealth(i2cBus, reprobe) && !i2cBus.checkAndRecover()) {
+    LOG_E("i2c", "Bus stuck - clock-out recovery did not release SDA");
+  }
+}
+
+void startSensorTask() {
+  // Pinned to the core opposite the WiFi stack where there is one (see board_config.h)
+  BaseType_t created = xTaskCreatePinnedToCore(sensorTask, "sensors", SENSOR_TASK_STACK, NULL,
+                                               SENSOR_TASK_PRIORITY, &sensorTaskHandle, SENSOR_TASK_CORE);
+
+  if (created == pdPASS) {
+    LOG_I("sensor", "Sensor task started on core %d", SENSOR_TASK_CORE);
+  } else {
+    LOG_E("sensor", "Failed to start sensor task");
+  }
+}
+
+void sensorTask(void* parameter) {
+  // Readings persist across cycles so a failed sensor keeps its last value
+  SensorSnapshot readings;
+  TickType_t lastWake = xTaskGetTickCount();
+
+  for (;;) {
+    // Supervised separately from the loop: a hung I2C transaction is caught
+    // even though the web server keeps running
+    heartbeats.beat(HEARTBEAT_SENSORS, millis());
+    if (heartbeats.takeRestart(HEARTBEAT_SENSORS) && !otaInProgress && !captureActive) {
+      LOG_W("sensor", "Restarting: bus recovery and re-probe of every sensor");
+      i2cBus.recoverBus();
+      sensors.beginAll(i2cBus, ADAPTIVE_MAX_INTERVAL_MS);
+    }
+
+    // I2C is shut down while OTA is in progress, and the BMP280 belongs to
+    // the capture task during a burst capture
+    // With adaptive sampling most cycles read nothing in steady conditions;
+    // only cycles that changed the readings are published and stored
+    bool paused = otaInProgress || captureActive;
+    PERF_BEGIN(PERF_SENSOR_POLL);
+    bool changed = !paused && sensors.pollAll(i2cBus, readings, millis());
+    PERF_END(PERF_SENSOR_POLL);
+    if (changed) {
+      PERF_BEGIN(PERF_SENSOR_PUBLISH);
+      // Dew point, heat index, absolute humidity and pressure tendency, once
+      // per cycle here instead of once per client
+      derivedMetrics.update(readings, uptimeSeconds());
+
+      readings.sequence++;
+      readings.timestamp = millis();
+      sensorSnapshot.write(readings);
+
+      recordHistory(readings);
+      queueTelemetry(readings);
+      PERF_END(PERF_SENSOR_PUBLISH);
+    }
+    // Every cycle on the held readings, so the detector's windows are in
+    // real time even when adaptive sampling skipped a read
+    if (!paused && readings.sequence > 0) {
+      PERF_BEGIN(PERF_SENSOR_ANALYSIS);
+      detectAnomalies(readings);
+      evaluateRules(readings);
+      PERF_END(PERF_SENSOR_ANALYSIS);
+    }
+    if (!paused) {
+      PERF_TIME(PERF_SENSOR_HEALTH, checkSensorHealth());
+    }
+
+    // Fixed-rate schedule: sleep until the next 5-second boundary
+    // (drivers on a longer adaptive interval are skipped by pollAll; the task
+    // still wakes every cycle to beat its heartbeat and run health checks)
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(UPDATE_INTERVAL));
+  }
+}
+
+void setupCapture() {
+  if (!BoardSensors::contains<Bmp280Driver>()) {
+    return;
+  }
+  if (!burstCapture.begin(CAPTURE_MAX_SAMPLES)) {
+    LOG_E("capture", "Failed to allocate burst capture buffer");
+    return;
+  }
+
+  // The timer only wakes the capture task; esp_timer callbacks run in the
+  // esp_timer task, so they must not block on I2C themselves
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = onCaptureTimer;
+  timerArgs.name = "capture";
+  if (esp_timer_create(&timerArgs, &captureTimer) != ESP_OK) {
+    LOG_E("capture", "Failed to create burst capture timer");
+    return;
+  }
+  LOG_I("capture", "Burst capture ready (%u samples, up to %d Hz)", (unsigned)burstCapture.capacity(),
+        CAPTURE_MAX_RATE_HZ);
+}
+
+void onCaptureTimer(void* arg) {
+  if (captureTaskHandle != NULL) {
+    xTaskNotifyGive(captureTaskHandle);
+  }
+}
+
+// Runs for one capture, then deletes itself. Above the sensor task's priority
+// and on its core, so samples are only delayed by WiFi interrupts and I2C.
+void captureTask(void* parameter) {
+  if constexpr (BoardSensors::contains<Bmp280Driver>()) {
+    Bmp280Driver& bmp = sensors.get<Bmp280Driver>();
+    bool ok = bmp.configure(i2cBus, Bmp280Driver::CTRL_MEAS_BURST, Bmp280Driver::CONFIG_BURST);
+    if (ok) {
+      vTaskDelay(pdMS_TO_TICKS(10));  // First conversion at the new settings
+      esp_timer_start_periodic(captureTimer, 1000000UL / burstCapture.getRateHz());
+    }
+
+    while (ok && !burstCapture.isFull()) {
+      // Timeout only matters if the timer stalls; ticks that piled up while a
+      // read was running are counted as missed samples
+      uint32_t ticks = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+      if (otaInProgress) {
+        ok = false;
+        break;
+      }
+      if (ticks == 0) {
+        continue;
+      }
+      if (ticks > 1) {
+        burstCapture.addMissed(ticks - 1);
+      }
+
+      int64_t now = esp_timer_get_time();
+      int32_t temperature;
+      uint32_t pressureQ8;
+      if (bmp.readCompensatedQ8(i2cBus, temperature, pressureQ8)) {
+        burstCapture.add(now, (int16_t)temperature, pressureQ8);
+      } else {
+        burstCapture.addReadError();
+      }
+    }
+
+    esp_timer_stop(captureTimer);
+    // Back to the normal filtered, oversampled mode (the bus is closed during OTA)
+    if (!otaInProgress) {
+      bmp.configure(i2cBus, Bmp280Driver::CTRL_MEAS_DEFAULT, Bmp280Driver::CONFIG_DEFAULT);
+    }
+    burstCapture.finish(ok);
+    logWrite(ok ? LOG_LEVEL_INFO : LOG_LEVEL_WARN, "capture",
+             "Burst capture %s: %u samples at %.1f Hz, jitter %.0f us RMS, %lu missed", ok ? "done" : "failed",
+             (unsigned)burstCapture.size(), burstCapture.achievedRate(), burstCapture.jitterRmsUs(),
+             (unsigned long)burstCapture.getMissed());
+  }
+
+  captureTaskHandle = NULL;
+  captureActive = false;
+  vTaskDelete(NULL);
+}
+
+void setupAnomalyDetection() {
+  anomalyMutex = xSemaphoreCreateMutex();
+  anomalyQueue = xQueueCreate(8, sizeof(AnomalyEvent));
+}
+
+void detectAnomalies(const SensorSnapshot& readings) {
+  if (xSemaphoreTake(anomalyMutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+    return;
+  }
+  anomalyDetector.update(readings, uptimeSeconds(), [](const AnomalyEvent& event) {
+    char value[FIXED_TEXT_SIZE];
+    char baseline[FIXED_TEXT_SIZE];
+    const ChannelInfo& info = CHANNEL_INFO[event.channel];
+    formatFixed(value, sizeof(value), event.value, info.scale, info.decimals);
+    formatFixed(baseline, sizeof(baseline), event.baseline, info.scale, info.decimals);
+    LOG_W("anomaly", "%s %s %s %s (baseline %s)", info.name, ANOMALY_TYPE_NAMES[event.type], value, info.unit,
+          baseline);
+
+    // Never wait on the loop task; a full queue means nobody is draining it
+    if (xQueueSend(anomalyQueue, &event, 0) != pdTRUE) {
+      anomalyQueueDrops++;
+    }
+  });
+  xSemaphoreGive(anomalyMutex);
+}
+
+// Appends one anomaly event as a JSON object
+void appendAnomalyJson(String& json, const AnomalyEvent& event) {
+  const ChannelInfo& info = CHANNEL_INFO[event.channel];
+  char value[FIXED_TEXT_SIZE];
+  uint32_t unixTime = toUnixTime(event.time);
+  json += "{\"time\":" + String(unixTime != 0 ? unixTime : event.time) + ",";
+  json += "\"clock\":\"" + String(unixTime != 0 ? "unix" : "uptime") + "\",";
+  json += "\"channel\":\"" + String(info.name) + "\",";
+  json += "\"type\":\"" + String(ANOMALY_TYPE_NAMES[event.type]) + "\",";
+  formatFixed(value, sizeof(value), event.value, info.scale, info.decimals);
+  json += "\"value\":" + String(value) + ",";
+  formatFixed(value, sizeof(value), event.baseline, info.scale, info.decimals);
+  json += "\"baseline\":" + String(value) + ",";
+  json += "\"score\":" + String(event.score / 256.0f, 1) + "}";
+}
+
+void broadcastEvent(const String& message) {
+  for (uint8_t i = 0; i < MAX_EVENT_SUBSCRIBERS; i++) {
+    if (eventSubscribers[i] && eventSubscribers[i].connected()) {
+      eventSubscribers[i].print(message);
+    }
+  }
+}
+
+// Loop task: pushes queued anomaly and rule events to /events subscribers (SSE)
+void serviceEventStream() {
+  AnomalyEvent event;
+  while (xQueueReceive(anomalyQueue, &event, 0) == pdTRUE) {
+    String message = "event: anomaly\ndata: ";
+    appendAnomalyJson(message, event);
+    message += "\n\n";
+    broadcastEvent(message);
+  }
+
+  RuleEvent ruleEvent;
+  while (xQueueReceive(ruleQueue, &ruleEvent, 0) == pdTRUE) {
+    uint32_t unixTime = toUnixTime(ruleEvent.time);
+    String message = "event: rule\ndata: {";
+    message += "\"time\":" + String(unixTime != 0 ? unixTime : ruleEvent.time) + ",";
+    message += "\"clock\":\"" + String(unixTime != 0 ? "unix" : "uptime") + "\",";
+    message += "\"id\":" + String(ruleEvent.rule) + ",";
+    message += "\"rule\":\"" + String(ruleEvent.source) + "\",";
+    message += "\"state\":\"" + String(ruleEvent.firing ? "firing" : "cleared") + "\"}\n\n";
+    broadcastEvent(message);
+  }
+
+  // Keepalive doubles as dead-subscriber detection
+  if (millis() - lastEventKeepalive >= EVENT_KEEPALIVE_INTERVAL) {
+    lastEventKeepalive = millis();
+    for (uint8_t i = 0; i < MAX_EVENT_SUBSCRIBERS; i++) {
+      if (!eventSubscribers[i]) {
+        continue;
+      }
+      if (!eventSubscribers[i].connected() || eventSubscribers[i].print(": keepalive\n\n") == 0) {
+        eventSubscribers[i].stop();
+        eventSubscribers[i] = WiFiClient();
+      }
+    }
+  }
+}
+
+void setupRules() {
+  rulesMutex = xSemaphoreCreateMutex();
+  ruleQueue = xQueueCreate(4, sizeof(RuleEvent));
+  rulePreferences.begin("rules", false);
+
+  // Programs are stored compiled; verification rejects anything from an
+  // older format or a damaged blob rather than running it
+  uint8_t stored = rulePreferences.getUChar("count", 0);
+  uint8_t rejected = 0;
+  for (uint8_t i = 0; i < stored && i < RULES_MAX; i++) {
+    RuleProgram program;
+    String key = "r" + String(i);
+    if (rulePreferences.getBytes(key.c_str(), &program, sizeof(program)) != sizeof(program) ||
+        !ruleEngine.add(program)) {
+      rejected++;
+    }
+  }
+  if (rejected > 0) {
+    LOG_E("rules", "%d stored rule(s) invalid, dropped", rejected);
+    saveRules(0);
+  }
+  LOG_I("rules", "%d loaded (max %d)", ruleEngine.size(), RULES_MAX);
+}
+
+// Writes rules from index `from` onwards and the count (caller holds rulesMutex)
+void saveRules(uint8_t from) {
+  uint8_t previous = rulePreferences.getUChar("count", 0);
+  for (uint8_t i = from; i < ruleEngine.size(); i++) {
+    String key = "r" + String(i);
+    rulePreferences.putBytes(key.c_str(), &ruleEngine.program(i), sizeof(RuleProgram));
+  }
+  for (uint8_t i = ruleEngine.size(); i < previous; i++) {
+    String key = "r" + String(i);
+    rulePreferences.remove(key.c_str());
+  }
+  rulePreferences.putUChar("count", ruleEngine.size());
+}
+
+void evaluateRules(const SensorSnapshot& readings) {
+  // /rules-add and /rules-delete hold the lock while writing NVS; skip a cycle rather than wait
+  if (xSemaphoreTake(rulesMutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+    return;
+  }
+  uint32_t now = uptimeSeconds();
+  ruleEngine.update(readings, now, [now](uint8_t index, bool firing) {
+    const RuleProgram& program = ruleEngine.program(index);
+    if (!(program.actions & RULE_ACTION_ALERT)) {
       return;
-    } else {
-      Serial.println("✓ BMP280 found at address 0x77!");
     }
-  } else {
-    Serial.println("✓ BMP280 found at address 0x76!");
+    logWrite(firing ? LOG_LEVEL_WARN : LOG_LEVEL_INFO, "rules", "Rule %d %s: %s", index,
+             firing ? "firing" : "cleared", program.source);
+
+    RuleEvent event;
+    event.time = now;
+    event.rule = index;
+    event.firing = firing;
+    memcpy(event.source, program.source, RULE_MAX_SOURCE);
+    if (xQueueSend(ruleQueue, &event, 0) != pdTRUE) {
+      ruleQueueDrops++;
+    }
+  });
+  ruleLedPattern = ruleEngine.ledPattern();
+  xSemaphoreGive(rulesMutex);
+}
+
+void setupMqtt() {
+  telemetryMutex = xSemaphoreCreateMutex();
+  if (!telemetryQueue.begin(MQTT_QUEUE_RECORDS)) {
+    LOG_E("mqtt", "Not enough heap for the offline queue");
+  }
+
+  mqttHost = preferences.getString("mqttHost", "");
+  mqttPort = preferences.getUShort("mqttPort", 1883);
+  mqttUser = preferences.getString("mqttUser", "");
+  mqttPassword = preferences.getString("mqttPass", "");
+  mqttPrefix = preferences.getString("mqttPrefix", "esp32-monitor");
+  mqttBatch = preferences.getUChar("mqttBatch", 1);
+  if (mqttBatch < 1 || mqttBatch > MQTT_MAX_BATCH) {
+    mqttBatch = 1;
   }
 
-  // Configure sensor settings for best accuracy
-  bmp.setSampling(Adafruit_BMP280::MODE_NORMAL,     /* Operating Mode */
-                  Adafruit_BMP280::SAMPLING_X2,      /* Temperature oversampling */
-                  Adafruit_BMP280::SAMPLING_X16,     /* Pressure oversampling */
-                  Adafruit_BMP280::FILTER_X16,       /* Filtering */
-                  Adafruit_BMP280::STANDBY_MS_500);  /* Standby time */
+  // Modem sleep stays on: the radio wakes for every DTIM beacon, which adds
+  // at most a few hundred ms per round trip - far inside these timeouts
+  mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+  mqttClient.setKeepAlive(MQTT_KEEPALIVE_SECONDS);
+  mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT_SECONDS);
 
-  bmpAvailable = true;
-  Serial.println("✓ BMP280 configured successfully!");
-  Serial.println("--- BMP280 Ready ---\n");
+  mqttEnabled = mqttHost.length() > 0 && telemetryQueue.capacity() > 0;
+  if (mqttEnabled) {
+    LOG_I("mqtt", "%s:%d, %d snapshot(s) per message, queue of %d", mqttHost.c_str(), mqttPort, mqttBatch,
+          (int)telemetryQueue.capacity());
+  } else {
+    LOG_I("mqtt", "Not configured");
+  }
+}
 
-  // Take initial reading
-  readBMP280();
+String mqttTopic(const char* leaf) {
+  return mqttPrefix + "/" + mdns_hostname_unique + "/" + leaf;
 }
 
-void readBMP280() {
-  if (!bmpAvailable) {
+// Sensor task: queued even while disconnected (the oldest snapshot is dropped when full)
+void queueTelemetry(const SensorSnapshot& readings) {
+  if ((!mqttEnabled && !influxEnabled) || xSemaphoreTake(telemetryMutex, pdMS_TO_TICKS(50)) != pdTRUE) {
     return;
   }
+  if (mqttEnabled) {
+    telemetryQueue.push(readings, uptimeSeconds());
+  }
+  if (influxEnabled) {
+    influxQueue.push(readings, uptimeSeconds());
+  }
+  xSemaphoreGive(telemetryMutex);
+}
+
+bool connectMqtt() {
+  mqttClient.setServer(mqttHost.c_str(), mqttPort);
+  String statusTopic = mqttTopic("status");
+
+  // The broker publishes the retained "offline" will if the device drops off
+  heartbeats.beat(HEARTBEAT_MQTT, millis());
+  bool connected = mqttClient.connect(mdns_hostname_unique.c_str(),
+                                      mqttUser.length() > 0 ? mqttUser.c_str() : NULL,
+                                      mqttUser.length() > 0 ? mqttPassword.c_str() : NULL,
+                                      statusTopic.c_str(), 0, true, "offline");
+  if (!connected) {
+    LOG_W("mqtt", "Connect to %s:%d failed (state %d)", mqttHost.c_str(), mqttPort, mqttClient.state());
+    return false;
+  }
+  mqttClient.publish(statusTopic.c_str(), "online", true);
+  mqttConnects++;
+  LOG_I("mqtt", "Connected to %s:%d", mqttHost.c_str(), mqttPort);
+  return true;
+}
+
+// One message: {"device":..,"records":[{"time":..,"clock":..,<channel>:<value>,..},..]}
+String buildTelemetryPayload(const TelemetryRecord* records, size_t count) {
+  String payload;
+  payload.reserve(64 + count * 200);
+  char name[32 * 6 + 1];  // handleSetDeviceName() allows 32 characters, each at most \u00XX
+  logEscapeJson(name, sizeof(name), deviceName.c_str());
+  payload = "{\"device\":\"" + String(name) + "\",\"records\":[";
+  char value[FIXED_TEXT_SIZE];
+  for (size_t i = 0; i < count; i++) {
+    const TelemetryRecord& record = records[i];
+    uint32_t unixTime = toUnixTime(record.time);
+    if (i > 0) payload += ",";
+    payload += "{\"time\":" + String(unixTime != 0 ? unixTime : record.time);
+    payload += ",\"clock\":\"" + String(unixTime != 0 ? "unix" : "uptime") + "\"";
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+      if (!(record.validChannels & (1UL << c))) {
+        continue;
+      }
+      const ChannelInfo& info = CHANNEL_INFO[c];
+      formatFixed(value, sizeof(value), record.values[c], info.scale, info.scale);
+      payload += ",\"" + String(info.name) + "\":" + String(value);
+    }
+    payload += "}";
+  }
+  payload += "]}";
+  return payload;
+}
 
-  // Read sensor values
-  currentTemperature = bmp.readTemperature();
-  currentPressure = bmp.readPressure() / 100.0F;  // Convert Pa to hPa (mbar)
-  currentAltitude = bmp.readAltitude(1013.25);     // 1013.25 = sea-level pressure in hPa
+// Loop task: keeps the connection up and publishes full batches. After an
+// outage the backlog drains at MQTT_DRAIN_PER_LOOP messages per pass, and a
+// publish the socket can't take (full send buffer, dropped link) stops the
+// drain with the records still queued.
+void serviceMqtt() {
+  if (!mqttEnabled || !sta_connected) {
+    return;
+  }
+  if (!mqttClient.connected()) {
+    if (mqttAttempted && millis() - mqttLastAttempt < mqttRetryInterval) {
+      return;
+    }
+    mqttAttempted = true;
+    mqttLastAttempt = millis();
+    if (!connectMqtt()) {
+      mqttRetryInterval = mqttRetryInterval * 2 < MQTT_RETRY_MAX ? mqttRetryInterval * 2 : MQTT_RETRY_MAX;
+      return;
+    }
+    mqttRetryInterval = MQTT_RETRY_MIN;
+  }
+  mqttClient.loop();  // Keepalive
+
+  String topic = mqttTopic("telemetry");
+  for (uint8_t sent = 0; sent < MQTT_DRAIN_PER_LOOP; sent++) {
+    TelemetryRecord batch[MQTT_MAX_BATCH];
+    size_t count = 0;
+    uint32_t droppedBefore = 0;
+    xSemaphoreTake(telemetryMutex, portMAX_DELAY);
+    if (telemetryQueue.size() >= mqttBatch) {
+      count = mqttBatch;
+      for (size_t i = 0; i < count; i++) {
+        batch[i] = telemetryQueue.peek(i);
+      }
+      droppedBefore = telemetryQueue.getDropped();
+    }
+    xSemaphoreGive(telemetryMutex);
+    if (count == 0) {
+      return;
+    }
 
-  // Optional: Print to serial for debugging
-  // Uncomment the lines below if you want to see sensor readings in serial monitor
-  /*
-  Serial.print("Temperature: ");
-  Serial.print(currentTemperature);
-  Serial.print(" °C, Pressure: ");
-  Serial.print(currentPressure);
-  Serial.print(" hPa, Altitude: ");
-  Serial.print(currentAltitude);
-  Serial.println(" m");
-  */
+    String payload = buildTelemetryPayload(batch, count);
+    if (!mqttClient.publish(topic.c_str(), payload.c_str())) {
+      mqttPublishFailures++;
+      return;
+    }
+    mqttPublished++;
+
+    // Records the sensor task dropped from a full queue meanwhile were
+    // already among the ones just sent
+    xSemaphoreTake(telemetryMutex, portMAX_DELAY);
+    uint32_t droppedSince = telemetryQueue.getDropped() - droppedBefore;
+    if (droppedSince < count) {
+      telemetryQueue.pop(count - droppedSince);
+    }
+    xSemaphoreGive(telemetryMutex);
+  }
 }
 
-void setupAHT20() {
-  Serial.println("\n--- AHT20 Sensor Setup ---");
+// "environment,device=<hostname>,name=<device name>"
+void buildInfluxTags() {
+  char name[80];
+  lineProtocolEscapeTag(deviceName.c_str(), name, sizeof(name));
+  influxTags = "environment,device=" + mdns_hostname_unique + ",name=" + String(name);
+}
 
-  // Add delay to ensure AHT20 has time to be ready
-  delay(100);
+void setupInflux() {
+  influxUrl = preferences.getString("influxUrl", "");
+  influxToken = preferences.getString("influxToken", "");
+  buildInfluxTags();
 
-  Serial.println("Attempting to initialize AHT20 sensor...");
-
-  // Try to initialize the sensor (AHT20 is at address 0x38)
-  if (!aht.begin()) {
-    Serial.println("✗ Could not find AHT20 sensor!");
-    Serial.println("  Check wiring (same as BMP280):");
-    Serial.println("  - VCC to 3V3");
-    Serial.println("  - GND to GND");
-    Serial.print("  - SDA to GPIO");
-    Serial.println(I2C_SDA);
-    Serial.print("  - SCL to GPIO");
-    Serial.println(I2C_SCL);
-    Serial.println("--- AHT20 Setup Failed ---\n");
-    ahtAvailable = false;
+  influxReplayBuffer = (char*)malloc(INFLUX_BATCH_BYTES);
+  if (!influxQueue.begin(INFLUX_QUEUE_RECORDS) || !influxBatch.begin(INFLUX_BATCH_BYTES) ||
+      influxReplayBuffer == NULL) {
+    LOG_E("influx", "Not enough heap for the batch buffers");
     return;
   }
+  if (!influxSpool.begin(LittleFS, "/influx", INFLUX_SPOOL_MAX_BATCHES, INFLUX_SPOOL_MAX_BYTES)) {
+    LOG_W("influx", "No spool (LittleFS unavailable) - batches are dropped while offline");
+  }
 
-  ahtAvailable = true;
-  Serial.println("✓ AHT20 sensor found!");
-  Serial.println("✓ AHT20 configured successfully!");
-  Serial.println("--- AHT20 Ready ---\n");
+  influxHttp.setReuse(true);  // Keep-alive between batches
+  influxHttp.setTimeout(INFLUX_HTTP_TIMEOUT_MS);
+
+  influxEnabled = influxUrl.length() > 0;
+  if (influxEnabled) {
+    LOG_I("influx", "%s, %lu batch(es) spooled", influxUrl.c_str(), (unsigned long)influxSpool.size());
+  } else {
+    LOG_I("influx", "Not configured");
+  }
+}
+
+enum InfluxResult { INFLUX_SENT, INFLUX_REJECTED, INFLUX_FAILED };
+
+InfluxResult postInflux(const char* data, size_t length) {
+  if (!influxHttp.begin(influxNetClient, influxUrl)) {
+    influxStats.lastStatus = HTTPC_ERROR_CONNECTION_REFUSED;
+    return INFLUX_FAILED;
+  }
+  influxHttp.addHeader("Content-Type", "text/plain; charset=utf-8");
+  if (influxToken.length() > 0) {
+    influxHttp.addHeader("Authorization", "Token " + influxToken);
+  }
+
+  heartbeats.beat(HEARTBEAT_INFLUX, millis());
+  int64_t started = esp_timer_get_time();
+  int status = influxHttp.POST((uint8_t*)data, length);
+  influxLatency.record((uint32_t)(esp_timer_get_time() - started));
+  influxHttp.end();  // Keeps the connection open (setReuse) if the server allows it
+  influxStats.lastStatus = status;
+
+  if (status >= 200 && status < 300) {
+    influxStats.batchesSent++;
+    influxStats.bytesSent += length;
+    for (size_t i = 0; i < length; i++) {
+      if (data[i] == '\n') influxStats.linesSent++;
+    }
+    return INFLUX_SENT;
+  }
+  // Retrying a malformed or unauthorized batch can't succeed; timeouts and
+  // rate limiting can
+  if (status >= 400 && status < 500 && status != 408 && status != 429) {
+    influxStats.batchesRejected++;
+    LOG_E("influx", "Batch rejected (HTTP %d), dropped", status);
+    return INFLUX_REJECTED;
+  }
+  influxStats.sendFailures++;
+  return INFLUX_FAILED;
+}
+
+void noteInfluxFailure() {
+  influxLastFailure = millis();
+  if (influxFailing) {
+    influxRetryInterval = influxRetryInterval * 2 < MQTT_RETRY_MAX ? influxRetryInterval * 2 : MQTT_RETRY_MAX;
+  }
+  influxFailing = true;
+}
+
+bool influxCanSend() {
+  return sta_connected && (!influxFailing || millis() - influxLastFailure >= influxRetryInterval);
+}
+
+// Sends the current batch directly if nothing older is waiting, otherwise
+// (or if that fails) appends it to the spool
+void flushInfluxBatch() {
+  if (influxBatch.size() == 0) {
+    return;
+  }
+  bool delivered = false;
+  if (influxSpool.size() == 0 && influxCanSend()) {
+    InfluxResult result = postInflux(influxBatch.data(), influxBatch.size());
+    delivered = result != INFLUX_FAILED;
+    if (result == INFLUX_FAILED) {
+      noteInfluxFailure();
+    } else {
+      influxFailing = false;
+      influxRetryInterval = MQTT_RETRY_MIN;
+    }
+  }
+  if (!delivered) {
+    if (influxSpool.push(influxBatch.data(), influxBatch.size())) {
+      influxStats.batchesSpooled++;
+    } else {
+      influxStats.batchesLost++;
+    }
+  }
+  influxBatch.clear();
 }
 
-void readAHT20() {
-  if (!ahtAvailable) {
+// Loop task: formats queued snapshots, flushes the batch by size or age and
+// replays at most one spooled batch per pass
+void serviceInflux() {
+  if (!influxEnabled) {
     return;
   }
 
-  // Read sensor values
-  sensors_event_t humidity, temp;
-  aht.getEvent(&humidity, &temp);
+  unsigned long now = millis();
+  if (now - influxStats.minuteStarted >= 60000) {
+    influxStats.linesLastMinute = influxStats.linesSent - influxStats.linesAtMinuteStart;
+    influxStats.linesAtMinuteStart = influxStats.linesSent;
+    influxStats.minuteStarted = now;
+  }
+
+  // Line protocol needs wall-clock timestamps: snapshots wait in the queue
+  // until SNTP has synced (the oldest are dropped if that takes too long)
+  bool full = false;
+  if (toUnixTime(uptimeSeconds()) != 0) {
+    xSemaphoreTake(telemetryMutex, portMAX_DELAY);
+    while (influxQueue.size() > 0 && !full) {
+      const TelemetryRecord& record = influxQueue.peek(0);
+      LineAppendResult result = influxBatch.append(influxTags.c_str(), record, toUnixTime(record.time));
+      if (result == LINE_FULL && influxBatch.size() > 0) {
+        full = true;
+        break;
+      }
+      if (result == LINE_APPENDED) {
+        if (influxBatch.lines() == 1) {
+          influxBatchStarted = now;
+        }
+        influxStats.linesFormatted++;
+      } else if (result == LINE_DUPLICATE) {
+        influxStats.linesDuplicate++;
+      } else if (result == LINE_FULL) {
+        // Doesn't fit even an empty batch: flushing can't help, and keeping
+        // it would wedge the queue
+        influxStats.linesTooLong++;
+      }
+      influxQueue.pop(1);
+    }
+    xSemaphoreGive(telemetryMutex);
+  }
+
+  if (full || influxBatch.size() >= INFLUX_BATCH_BYTES * 3 / 4 ||
+      (influxBatch.size() > 0 && now - influxBatchStarted >= INFLUX_BATCH_MAX_AGE_MS)) {
+    flushInfluxBatch();
+  }
+
+  // Replay: oldest first, one batch per pass; a failure backs off and leaves it spooled
+  if (influxSpool.size() > 0 && influxCanSend()) {
+    uint32_t length = influxSpool.peek(influxReplayBuffer, INFLUX_BATCH_BYTES);
+    if (length > 0) {
+      InfluxResult result = postInflux(influxReplayBuffer, length);
+      if (result == INFLUX_FAILED) {
+        noteInfluxFailure();
+      } else {
+        influxSpool.pop();
+        influxFailing = false;
+        influxRetryInterval = MQTT_RETRY_MIN;
+      }
+    }
+  }
+}
+
+void setupBeacon() {
+  beaconEnabled = preferences.getBool("beacon", false);
+  if (beaconEnabled) {
+    LOG_I("beacon", "%s:%d every %lus", IPAddress(BEACON_MULTICAST_GROUP).toString().c_str(), BEACON_PORT,
+          UPDATE_INTERVAL / 1000);
+  }
+}
+
+// Latest readings as one multicast datagram (~75 bytes)
+void sendBeacon() {
+  SensorSnapshot readings = sensorSnapshot.read();
+  if (readings.sequence == 0) {
+    return;  // Nothing measured yet
+  }
 
-  // Use AHT20 temperature (more accurate than BMP280)
-  // If you prefer BMP280 temperature, comment out the line below
-  currentTemperature = temp.temperature;
-  currentHumidity = humidity.relative_humidity;
+  Beacon beacon;
+  beacon.sequence = ++beaconSequence;
+  beacon.uptime = uptimeSeconds();
+  beacon.unixTime = toUnixTime(beacon.uptime);
+  // ap_ssid_unique ends in the 4-digit MAC suffix
+  strncpy(beacon.id, ap_ssid_unique.c_str() + ap_ssid_unique.length() - BEACON_ID_LENGTH, sizeof(beacon.id));
+  strncpy(beacon.name, deviceName.c_str(), sizeof(beacon.name) - 1);
+  beacon.name[sizeof(beacon.name) - 1] = '\0';
+  beacon.validChannels = readings.validChannels;
+  memcpy(beacon.values, readings.values, sizeof(beacon.values));
+
+  uint8_t packet[BEACON_MAX_SIZE];
+  size_t length = encodeBeacon(beacon, packet);
+  if (beaconUdp.beginPacket(IPAddress(BEACON_MULTICAST_GROUP), BEACON_PORT) &&
+      beaconUdp.write(packet, length) == length && beaconUdp.endPacket()) {
+    beaconsSent++;
+  } else {
+    beaconErrors++;
+  }
+}
 
-  // Optional: Print to serial for debugging
-  // Uncomment the lines below if you want to see sensor readings in serial monitor
-  /*
-  Serial.print("AHT20 - Temperature: ");
-  Serial.print(currentTemperature);
-  Serial.print(" °C, Humidity: ");
-  Serial.print(currentHumidity);
-  Serial.println(" %");
-  */
+// server.on() with a request counter and a latency histogram for /metrics
+void addRoute(const char* path, void (*handler)()) {
+  if (routeCount >= MAX_ROUTES) {
+    server.on(path, handler);
+    return;
+  }
+  uint8_t index = routeCount++;
+  RouteMetrics* metrics = &routeMetrics[index];
+  metrics->path = path;
+  server.on(path, [metrics, handler, index]() {
+    int64_t started = esp_timer_get_time();
+    strncpy(bootBreadcrumbs.route, metrics->path, BOOT_ROUTE_LENGTH - 1);
+    heapAccountingBegin(index);
+    handler();
+    heapAccountingEnd(index);
+    bootBreadcrumbs.route[0] = '\0';
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - started);
+    metrics->requests++;
+    metrics->latency.record(elapsed);
+    PERF_RECORD_ROUTE(index, elapsed);
+  });
 }
 
 void handleRoot() {
@@ -975,28 +1943,23 @@ void handleRoot() {
 }
 
 void handleScan() {
-  Serial.println("\n--- WiFi Scan Requested ---");
-
   // IMPORTANT: Always delete previous scan results first
   // This prevents "Scan already in progress" errors
   WiFi.scanDelete();
   delay(100);  // Give it time to clean up
 
-  Serial.println("Starting WiFi scan...");
-
   // Use BLOCKING scan for reliability in AP+STA mode
   // Async mode can hang in AP+STA configuration on ESP32-C3
   int n = WiFi.scanNetworks(false, true);  // blocking mode, show hidden networks
+  systemCounters.wifiScans++;
 
   if (n < 0) {
-    Serial.println("✗ Scan failed! Error code: " + String(n));
+    LOG_E("wifi", "Scan failed (error %d)", n);
     WiFi.scanDelete();
     server.send(500, "application/json", "{\"error\":\"Scan failed\"}");
     return;
   }
 
-  Serial.println("✓ Scan complete! Found " + String(n) + " networks");
-
   // Deduplicate networks - keep only the strongest signal for each SSID
   // Using a simple map-like structure with arrays
   String uniqueSSIDs[n > 0 ? n : 1];  // Prevent zero-size array
@@ -1052,8 +2015,7 @@ void handleScan() {
   // Clean up scan results
   WiFi.scanDelete();
 
-  Serial.println("✓ Sent " + String(uniqueCount) + " unique networks to client");
-  Serial.println("--- WiFi Scan Complete ---\n");
+  LOG_I("wifi", "Scan found %d networks (%d unique SSIDs)", n, uniqueCount);
 }
 
 void handleConnect() {
@@ -1061,8 +2023,7 @@ void handleConnect() {
     sta_ssid = server.arg("ssid");
     sta_password = server.arg("password");
 
-    Serial.println("Received connection request:");
-    Serial.println("SSID: " + sta_ssid);
+    LOG_I("wifi", "Connection request for %s", sta_ssid.c_str());
 
     saveWiFiCredentials(sta_ssid, sta_password);
 
@@ -1076,6 +2037,9 @@ void handleConnect() {
 }
 
 void handleStatus() {
+  // Lock-free copy of the latest readings (never waits on the sensor task)
+  SensorSnapshot snapshot = sensorSnapshot.read();
+
   String json = "{";
 
   // Firmware version
@@ -1089,23 +2053,45 @@ void handleStatus() {
   // System statistics
   json += "\"uptime\":\"" + getUptime() + "\",";
   json += "\"temperature\":" + String(getTemperature(), 1) + ",";
-  json += "\"freeHeap\":" + String(ESP.getFreeHeap()) + ",";
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t largestBlock = ESP.getMaxAllocHeap();
+  json += "\"freeHeap\":" + String(freeHeap) + ",";
   json += "\"totalHeap\":" + String(ESP.getHeapSize()) + ",";
+  json += "\"minFreeHeap\":" + String(ESP.getMinFreeHeap()) + ",";
+  json += "\"largestFreeBlock\":" + String(largestBlock) + ",";
+  json += "\"heapFragmentation\":" + String(heapFragmentation(freeHeap, largestBlock) / 10.0f, 1) + ",";
   json += "\"cpuFreq\":" + String(ESP.getCpuFreqMHz()) + ",";
 
-  // Sensor data (BMP280 + AHT20)
-  json += "\"bmpAvailable\":" + String(bmpAvailable ? "true" : "false") + ",";
-  json += "\"ahtAvailable\":" + String(ahtAvailable ? "true" : "false") + ",";
-  if (bmpAvailable || ahtAvailable) {
-    json += "\"sensorTemperature\":" + String(currentTemperature, 1) + ",";
-  }
-  if (bmpAvailable) {
-    json += "\"bmpPressure\":" + String(currentPressure, 1) + ",";
-    json += "\"bmpAltitude\":" + String(currentAltitude, 1) + ",";
-  }
-  if (ahtAvailable) {
-    json += "\"ahtHumidity\":" + String(currentHumidity, 1) + ",";
+  // Boot history, newest first: why each boot started and where the one before it ended
+  json += "\"bootCount\":" + String(bootHistory.boots) + ",";
+  json += "\"crashCount\":" + String(bootHistory.crashes()) + ",";
+  json += "\"resetReason\":\"" + String(bootResetReasonName(bootHistory.records[0].reason)) + "\",";
+  json += "\"bootHistory\":[";
+  for (uint8_t i = 0; i < bootHistory.count; i++) {
+    const BootRecord& record = bootHistory.records[i];
+    if (i > 0) json += ",";
+    json += "{\"boot\":" + String(record.boot) + ",";
+    json += "\"reason\":\"" + String(bootResetReasonName(record.reason)) + "\",";
+    json += "\"uptime\":" + String(record.uptimeS) + ",";
+    json += "\"time\":" + String(record.unixTime) + ",";
+    json += "\"loopPhase\":\"" + String(perfPhaseName(record.loopPhase)) + "\",";
+    json += "\"sensorPhase\":\"" + String(perfPhaseName(record.sensorPhase)) + "\",";
+    json += "\"route\":\"" + String(record.route) + "\"";
+    if (record.stalled != BOOT_SUBSYSTEM_NONE) {
+      json += ",\"stalled\":\"" + String(heartbeatName(record.stalled)) + "\"";
+    }
+    if (record.task[0] != '\0') {
+      char backtrace[12 * (BOOT_BACKTRACE_DEPTH + 1)];
+      bootFormatBacktrace(record, backtrace, sizeof(backtrace));
+      json += ",\"task\":\"" + String(record.task) + "\",";
+      json += "\"backtrace\":\"" + String(backtrace) + "\"";
+    }
+    json += "}";
   }
+  json += "],";
+
+  // Sensor data (availability per driver + every valid channel)
+  BoardSensors::writeStatus(json, snapshot);
 
   // Chip information
   json += "\"chipModel\":\"" + String(ESP.getChipModel()) + "\",";
@@ -1129,17 +2115,976 @@ void handleStatus() {
   server.send(200, "application/json", json);
 }
 
-void handlePrepareOTA() {
-  Serial.println("\n========================================");
-  Serial.println("     PREPARE OTA ENDPOINT CALLED");
-  Serial.println("========================================");
+void setupHistory() {
+  historyMutex = xSemaphoreCreateMutex();
+
+  // Rollup tiers first: they are small and fixed, the raw ring takes what's left
+  const size_t rollupBuckets[ROLLUP_TIER_COUNT] = {ROLLUP_MINUTE_BUCKETS, ROLLUP_HOUR_BUCKETS, ROLLUP_DAY_BUCKETS};
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  bool rollupsAllocated = sensorRollups.begin(rollupBuckets);
+  xSemaphoreGive(historyMutex);
+
+  if (rollupsAllocated) {
+    LOG_I("history", "Rollups: %u min / %u h / %u days (%u KB)", ROLLUP_MINUTE_BUCKETS, ROLLUP_HOUR_BUCKETS,
+          ROLLUP_DAY_BUCKETS,
+          (unsigned)((ROLLUP_MINUTE_BUCKETS + ROLLUP_HOUR_BUCKETS + ROLLUP_DAY_BUCKETS) *
+                     SensorRollups::bytesPerBucket() / 1024));
+  } else {
+    LOG_E("history", "Rollups: not enough heap for every tier");
+  }
+
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  bool blocksAllocated = sensorBlocks.begin(SENSOR_BLOCK_COUNT);
+  xSemaphoreGive(historyMutex);
+
+  if (blocksAllocated) {
+    LOG_I("history", "Compressed history: %u blocks (%u KB)", SENSOR_BLOCK_COUNT,
+          SENSOR_BLOCK_COUNT * SENSOR_BLOCK_SIZE / 1024);
+  } else {
+    LOG_E("history", "Compressed history: not enough heap");
+  }
+
+  setupHistoryLog();
+
+  // Per-board share of the free heap, capped (see board_config.h)
+  size_t budget = (size_t)ESP.getFreeHeap() * HISTORY_HEAP_PERCENT / 100;
+  size_t records = budget / SensorHistory::bytesPerRecord();
+  if (records > HISTORY_MAX_RECORDS) {
+    records = HISTORY_MAX_RECORDS;
+  }
+
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  bool allocated = sensorHistory.begin(records);
+  xSemaphoreGive(historyMutex);
+
+  if (allocated) {
+    LOG_I("history", "Ring: %u records (%u KB, %u min at 5 s/record)", (unsigned)records,
+          (unsigned)(records * SensorHistory::bytesPerRecord() / 1024),
+          (unsigned)(records * (UPDATE_INTERVAL / 1000) / 60));
+  } else {
+    LOG_E("history", "Ring: not enough heap - /history disabled");
+  }
+}
+
+void recordHistory(const SensorSnapshot& snapshot) {
+  if (historyMutex == NULL) {
+    return;  // Not allocated yet (setup still running)
+  }
+  if (xSemaphoreTake(historyMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+    uint32_t now = uptimeSeconds();
+    sensorHistory.append(now, snapshot);
+    sensorRollups.add(now, snapshot);
+    const SensorBlock* block = sensorBlocks.append(now, snapshot);
+    // A block fills every few minutes. The queue copies it, so no 256-byte
+    // block lands on this task's stack, and the loop task writes it to flash.
+    if (block != NULL && (sealedBlockQueue == NULL || xQueueSend(sealedBlockQueue, block, 0) != pdTRUE)) {
+      sealedBlocksDropped++;
+    }
+    xSemaphoreGive(historyMutex);
+  }
+}
+
+void setupHistoryLog() {
+  logMutex = xSemaphoreCreateMutex();
+  sealedBlockQueue = xQueueCreate(SEALED_BLOCK_QUEUE, sizeof(SensorBlock));
+
+  // Format on first boot (or if the partition is corrupt)
+  if (!LittleFS.begin(true)) {
+    LOG_E("history", "LittleFS mount failed - history will not survive reboots");
+    return;
+  }
+
+  // Boot counter and lifetime flash writes (wear estimate) live in NVS
+  Preferences logPreferences;
+  logPreferences.begin("history-log", false);
+  bootCount = logPreferences.getUShort("boots", 0) + 1;
+  logPreferences.putUShort("boots", bootCount);
+  uint64_t lifetimeBytes = logPreferences.getULong64("wearBytes", 0);
+  logPreferences.end();
+
+  xSemaphoreTake(logMutex, portMAX_DELAY);
+  bool ready = historyLog.begin(LittleFS, "/history", LOG_SEGMENT_BLOCKS, LOG_MAX_SEGMENTS);
+  historyLog.setLifetimeBytes(lifetimeBytes);
+  xSemaphoreGive(logMutex);
+
+  if (ready) {
+    const SegmentLogStats& stats = historyLog.getStats();
+    LOG_I("history", "Log: segments %lu-%lu, %u blocks in tail, %lu torn block(s) skipped, %u/%u KB used",
+          (unsigned long)historyLog.getFirstSegment(), (unsigned long)historyLog.getLastSegment(),
+          historyLog.getTailBlocks(), (unsigned long)stats.tornBlocks, (unsigned)(LittleFS.usedBytes() / 1024),
+          (unsigned)(LittleFS.totalBytes() / 1024));
+  } else {
+    LOG_E("history", "Log: could not create /history");
+  }
+}
+
+// Appends a sealed block from the RAM ring to the flash log (loop task)
+void persistBlock(SensorBlock& block) {
+  if (logMutex == NULL || !historyLog.isReady()) {
+    return;
+  }
+  rebaseBlock(block);
+
+  xSemaphoreTake(logMutex, portMAX_DELAY);
+  uint32_t segmentsBefore = historyLog.getStats().segmentsCreated;
+  historyLog.append(block);
+  bool newSegment = historyLog.getStats().segmentsCreated != segmentsBefore;
+  uint64_t lifetimeBytes = historyLog.getStats().lifetimeBytes;
+  xSemaphoreGive(logMutex);
+
+  // Wear counter is saved once per segment, not per block, to spare NVS
+  if (newSegment) {
+    Preferences logPreferences;
+    logPreferences.begin("history-log", false);
+    logPreferences.putULong64("wearBytes", lifetimeBytes);
+    logPreferences.end();
+  }
+}
+
+// Rebases a block copied from the RAM ring to Unix time if the clock is synced
+// (since-boot times are only meaningful together with the boot count)
+void rebaseBlock(SensorBlock& block) {
+  if (!(block.header.flags & SENSOR_BLOCK_UNIX_TIME) && toUnixTime(0) != 0) {
+    block.header.firstTime = toUnixTime(block.header.firstTime);
+    block.header.lastTime = toUnixTime(block.header.lastTime);
+    block.header.flags |= SENSOR_BLOCK_UNIX_TIME;
+  }
+  block.header.bootCount = bootCount;
+  block.header.crc = sensorBlockCrc(block);
+}
+
+// Seals and writes the partially filled block (before OTA) so at most one
+// update interval of history is lost
+void flushHistoryLog() {
+  if (historyMutex == NULL) {
+    return;
+  }
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  const SensorBlock* block = sensorBlocks.flush();
+  // Behind any blocks still queued, so the log stays in time order
+  if (block != NULL && (sealedBlockQueue == NULL || xQueueSend(sealedBlockQueue, block, 0) != pdTRUE)) {
+    sealedBlocksDropped++;
+  }
+  xSemaphoreGive(historyMutex);
+  persistSealedBlocks();
+}
+
+// Loop task, every update cycle: writes the blocks the sensor task sealed
+void persistSealedBlocks() {
+  static SensorBlock block;  // Static: 256 bytes, and only the loop task gets here
+  static uint32_t droppedReported = 0;
+  if (sealedBlockQueue == NULL) {
+    return;
+  }
+  while (xQueueReceive(sealedBlockQueue, &block, 0) == pdTRUE) {
+    persistBlock(block);
+  }
+  if (sealedBlocksDropped != droppedReported) {
+    LOG_W("history", "%lu sealed block(s) not written to flash (queue full)",
+          (unsigned long)(sealedBlocksDropped - droppedReported));
+    droppedReported = sealedBlocksDropped;
+  }
+}
+
+uint32_t uptimeSeconds() {
+  return (uint32_t)(esp_timer_get_time() / 1000000ULL);
+}
+
+// Unix time of an uptime timestamp, or 0 if SNTP hasn't synced yet
+uint32_t toUnixTime(uint32_t uptime) {
+  time_t now = time(nullptr);
+  if (now < MIN_VALID_EPOCH) {
+    return 0;
+  }
+  return (uint32_t)now - (uptimeSeconds() - uptime);
+}
+
+void handleI2CStats() {
+  String json = "{";
+  json += "\"busRecoveries\":" + String(i2cBus.getRecoveries()) + ",";
+  json += "\"failedRecoveries\":" + String(i2cBus.getFailedRecoveries()) + ",";
+  json += "\"stuckDetections\":" + String(i2cBus.getStuckDetections()) + ",";
+  json += "\"sampling\":";
+  sensors.writeSampling(json);
+  json += ",";
+  json += "\"devices\":[";
+
+  for (uint8_t i = 0; i < i2cBus.getDeviceCount(); i++) {
+    const I2CDeviceStats& device = i2cBus.getDevice(i);
+    char address[5];
+    snprintf(address, sizeof(address), "0x%02X", device.address);
+
+    if (i > 0) json += ",";
+    json += "{";
+    json += "\"address\":\"" + String(address) + "\",";
+    json += "\"name\":\"" + String(device.name) + "\",";
+    json += "\"attached\":" + String(device.attached ? "true" : "false") + ",";
+    json += "\"attachCount\":" + String(device.attachCount) + ",";
+    json += "\"transactions\":" + String(device.transactions) + ",";
+    json += "\"errors\":" + String(device.errors) + ",";
+    json += "\"consecutiveErrors\":" + String(device.consecutiveErrors) + ",";
+    json += "\"avgUs\":" + String(device.latency.average()) + ",";
+    json += "\"p95Us\":" + String(device.latency.percentile(95)) + ",";
+    json += "\"maxUs\":" + String(device.latency.max) + ",";
+
+    // Log2 latency buckets: entry i counts transactions taking <= 2^i µs
+    json += "\"latencyBuckets\":[";
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+      if (b > 0) json += ",";
+      json += String(device.latency.buckets[b]);
+    }
+    json += "]}";
+  }
+
+  json += "]}";
+
+  server.send(200, "application/json", json);
+}
+
+void handleHistory() {
+  SensorChannel channel = CHANNEL_TEMPERATURE;
+  if (server.hasArg("channel") && !channelFromName(server.arg("channel").c_str(), channel)) {
+    server.send(400, "text/plain", "Unknown channel");
+    return;
+  }
+  if (channel >= HISTORY_CHANNEL_COUNT) {
+    server.send(400, "text/plain", "Channel is not kept in history (derived per cycle, see /status)");
+    return;
+  }
+  if (!sensorHistory.isReady() && sensorRollups.selectTier(0, 0) < 0) {
+    server.send(503, "text/plain", "History not available");
+    return;
+  }
+
+  int points = server.hasArg("points") ? server.arg("points").toInt() : 60;
+  points = constrain(points, 1, HISTORY_MAX_POINTS);
+  long seconds = server.hasArg("seconds") ? server.arg("seconds").toInt() : 0;
+  uint32_t now = uptimeSeconds();
+
+  // Raw records answer short spans at fine resolution; anything the raw ring
+  // can't hold, or that wants buckets of a minute or more, is read from the
+  // coarsest rollup tier that fits, never from raw samples
+  int tier = -1;
+  if (seconds > 0) {
+    uint32_t bucketSeconds = seconds / points;
+    bool rawCovers = sensorHistory.capacity() * (UPDATE_INTERVAL / 1000) >= (unsigned long)seconds;
+    if (bucketSeconds >= ROLLUP_PERIODS[0] || !rawCovers) {
+      tier = sensorRollups.selectTier(seconds, bucketSeconds);
+    }
+  }
+
+  // Selected range: sequence numbers for raw records, seconds for a rollup tier
+  uint64_t first = 0;
+  uint64_t records = 0;
+  size_t capacity = 0;
+  uint32_t interval = UPDATE_INTERVAL / 1000;
+
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  if (tier >= 0) {
+    const RollupTier& rollup = sensorRollups.tier(tier);
+    interval = rollup.getPeriod();
+    capacity = rollup.capacity();
+    first = now > (uint32_t)seconds ? now - seconds : 0;
+    records = (now - first) / interval + 1;
+  } else {
+    first = sensorHistory.firstSequence();
+    if (seconds > 0) {
+      first = sensorHistory.findSequence(now > (uint32_t)seconds ? now - seconds : 0);
+    }
+    records = sensorHistory.endSequence() - first;
+    capacity = sensorHistory.capacity();
+  }
+  xSemaphoreGive(historyMutex);
+
+  if ((uint64_t)points > records) {
+    points = (int)records;
+  }
+
+  const ChannelInfo& info = CHANNEL_INFO[channel];
+  bool unixClock = toUnixTime(0) != 0;
+  static const char* const TIER_NAMES[ROLLUP_TIER_COUNT] = {"1m", "1h", "1d"};
+
+  // Streamed in chunks: the response can hold hundreds of points and the
+  // history lock is only held while aggregating one bucket
+  char buffer[1024];
+  size_t used = 0;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  used += snprintf(buffer + used, sizeof(buffer) - used,
+                   "{\"channel\":\"%s\",\"unit\":\"%s\",\"source\":\"%s\",\"interval\":%lu,"
+                   "\"capacity\":%u,\"records\":%lu,\"clock\":\"%s\",\"points\":[",
+                   info.name, info.unit, tier >= 0 ? TIER_NAMES[tier] : "raw", (unsigned long)interval,
+                   (unsigned)capacity, (unsigned long)records, unixClock ? "unix" : "uptime");
+
+  // Rollup ranges are in seconds; one past `now` so the open bucket is included
+  uint64_t span = tier >= 0 ? (uint64_t)now + 1 - first : records;
+
+  bool firstPoint = true;
+  for (int b = 0; b < points; b++) {
+    // Bucket b covers an equal share of the selected range
+    uint64_t from = first + span * b / points;
+    uint64_t to = first + span * (b + 1) / points;
+
+    xSemaphoreTake(historyMutex, portMAX_DELAY);
+    HistoryAggregate bucket = tier >= 0 ? sensorRollups.tier(tier).aggregate(channel, (uint32_t)from, (uint32_t)to)
+                                        : sensorHistory.aggregate(channel, from, to);
+    xSemaphoreGive(historyMutex);
+
+    if (bucket.count == 0) {
+      continue;
+    }
+
+    // [time, min, max, avg]
+    char minText[FIXED_TEXT_SIZE], maxText[FIXED_TEXT_SIZE], avgText[FIXED_TEXT_SIZE];
+    formatFixed(minText, sizeof(minText), bucket.min, info.scale, info.decimals);
+    formatFixed(maxText, sizeof(maxText), bucket.max, info.scale, info.decimals);
+    formatFixed(avgText, sizeof(avgText), bucket.average(), info.scale, info.decimals);
+    uint32_t t = unixClock ? toUnixTime(bucket.lastTime) : bucket.lastTime;
+
+    if (used > sizeof(buffer) - 80) {
+      server.sendContent(buffer, used);
+      used = 0;
+    }
+    used += snprintf(buffer + used, sizeof(buffer) - used, "%s[%lu,%s,%s,%s]", firstPoint ? "" : ",",
+                     (unsigned long)t, minText, maxText, avgText);
+    firstPoint = false;
+  }
+
+  used += snprintf(buffer + used, sizeof(buffer) - used, "]}");
+  server.sendContent(buffer, used);
+  server.sendContent("");  // Terminating chunk
+}
+
+void handleStorageStats() {
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  uint32_t records = sensorBlocks.getRecordsTotal();
+  uint32_t sealed = sensorBlocks.getSealedTotal();
+  uint32_t held = sensorBlocks.isReady() ? sensorBlocks.recordsHeld() : 0;
+  size_t heldBlocks = sensorBlocks.isReady() ? sensorBlocks.sealedCount() + 1 : 0;
+  size_t rawRecords = sensorHistory.size();
+  xSemaphoreGive(historyMutex);
+
+  // Bytes per record in the compressed ring vs the raw ring's fixed 16
+  uint32_t heldBytes = heldBlocks * SENSOR_BLOCK_SIZE;
+  float bytesPerRecord = held > 0 ? (float)heldBytes / held : 0;
+
+  String json = "{";
+  json += "\"blockSize\":" + String(SENSOR_BLOCK_SIZE) + ",";
+  json += "\"blockCapacity\":" + String(sensorBlocks.capacity()) + ",";
+  json += "\"blocksSealed\":" + String(sealed) + ",";
+  json += "\"recordsAppended\":" + String(records) + ",";
+  json += "\"recordsHeld\":" + String(held) + ",";
+  json += "\"bytesPerRecord\":" + String(bytesPerRecord, 2) + ",";
+  json += "\"rawBytesPerRecord\":" + String(SensorHistory::bytesPerRecord()) + ",";
+  json += "\"rawRecordsHeld\":" + String(rawRecords) + ",";
+
+  // Flash log
+  xSemaphoreTake(logMutex, portMAX_DELAY);
+  SegmentLogStats log = historyLog.getStats();
+  uint32_t firstSegment = historyLog.getFirstSegment();
+  uint32_t lastSegment = historyLog.getLastSegment();
+  uint16_t tailBlocks = historyLog.getTailBlocks();
+  bool logReady = historyLog.isReady();
+  xSemaphoreGive(logMutex);
+
+  size_t fsTotal = logReady ? LittleFS.totalBytes() : 0;
+  json += "\"log\":{";
+  json += "\"mounted\":" + String(logReady ? "true" : "false") + ",";
+  json += "\"firstSegment\":" + String(firstSegment) + ",";
+  json += "\"lastSegment\":" + String(lastSegment) + ",";
+  json += "\"tailBlocks\":" + String(tailBlocks) + ",";
+  json += "\"segmentBlocks\":" + String(LOG_SEGMENT_BLOCKS) + ",";
+  json += "\"maxSegments\":" + String(LOG_MAX_SEGMENTS) + ",";
+  json += "\"blocksWritten\":" + String(log.blocksWritten) + ",";
+  json += "\"bytesWritten\":" + String(log.bytesWritten) + ",";
+  json += "\"payloadBytes\":" + String(log.payloadBytes) + ",";
+  json += "\"writeAmplification\":" + String(log.writeAmplification(), 2) + ",";
+  json += "\"segmentsRotated\":" + String(log.segmentsRotated) + ",";
+  json += "\"tornBlocks\":" + String(log.tornBlocks) + ",";
+  json += "\"writeErrors\":" + String(log.writeErrors) + ",";
+  json += "\"lifetimeBytesWritten\":" + String((unsigned long long)log.lifetimeBytes) + ",";
+  // Full-partition write cycles so far; LittleFS wear-levels, NOR flash is rated ~100k
+  json += "\"wearCycles\":" + String(fsTotal > 0 ? (float)log.lifetimeBytes / fsTotal : 0.0f, 4) + ",";
+  json += "\"fsUsedBytes\":" + String(logReady ? LittleFS.usedBytes() : 0) + ",";
+  json += "\"fsTotalBytes\":" + String(fsTotal);
+  json += "}}";
+
+  server.send(200, "application/json", json);
+}
+
+void handleExport() {
+  String formatName = server.hasArg("format") ? server.arg("format") : String("csv");
+  ExportFormat format;
+  if (formatName == "csv") {
+    format = EXPORT_CSV;
+  } else if (formatName == "ndjson") {
+    format = EXPORT_NDJSON;
+  } else {
+    server.send(400, "text/plain", "format must be csv or ndjson");
+    return;
+  }
+  uint32_t from = server.hasArg("from") ? strtoul(server.arg("from").c_str(), NULL, 10) : 0;
+  uint32_t to = server.hasArg("to") ? strtoul(server.arg("to").c_str(), NULL, 10) : 0;
+
+  // Chunked transfer: records are formatted into a fixed buffer and sent as
+  // they are decoded, so memory stays bounded for any export size
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.sendHeader("Content-Disposition", format == EXPORT_CSV ? "attachment; filename=\"history.csv\""
+                                                                : "attachment; filename=\"history.ndjson\"");
+  server.send(200, format == EXPORT_CSV ? "text/csv" : "application/x-ndjson", "");
+
+  unsigned long start = millis();
+  auto sink = [](const char* data, size_t length) {
+    server.sendContent(data, length);
+    heartbeats.beat(HEARTBEAT_WEB, millis());  // Large exports take longer than HEARTBEAT_WEB_MS
+  };
+  HistoryExporter<decltype(sink)> exporter(format, from, to, sink);
+  exporter.begin();
+
+  // Only the loop task serves HTTP, so one static batch buffer is enough
+  static SensorBlock batch[EXPORT_BATCH_BLOCKS];
+
+  // 1. Sealed blocks: from the flash log if mounted (it holds every sealed
+  //    block), else from the RAM ring
+  if (historyLog.isReady()) {
+    xSemaphoreTake(logMutex, portMAX_DELAY);
+    uint32_t firstSegment = historyLog.getFirstSegment();
+    uint32_t lastSegment = historyLog.getLastSegment();
+    xSemaphoreGive(logMutex);
+
+    for (uint32_t segment = firstSegment; segment <= lastSegment && server.client().connected(); segment++) {
+      for (uint16_t index = 0;; index += EXPORT_BATCH_BLOCKS) {
+        xSemaphoreTake(logMutex, portMAX_DELAY);
+        uint16_t count = historyLog.readBlocks(segment, index, batch, EXPORT_BATCH_BLOCKS);
+        xSemaphoreGive(logMutex);
+
+        for (uint16_t i = 0; i < count; i++) {
+          exporter.addBlock(batch[i]);
+        }
+        if (count < EXPORT_BATCH_BLOCKS) {
+          break;
+        }
+      }
+    }
+  } else if (sensorBlocks.isReady()) {
+    xSemaphoreTake(historyMutex, portMAX_DELAY);
+    uint32_t end = sensorBlocks.getSealedTotal();
+    uint32_t next = end - sensorBlocks.sealedCount();
+    xSemaphoreGive(historyMutex);
+
+    for (; next < end && server.client().connected(); next++) {
+      // Blocks sealed meanwhile may have overwritten the oldest ones
+      xSemaphoreTake(historyMutex, portMAX_DELAY);
+      uint32_t oldest = sensorBlocks.getSealedTotal() - sensorBlocks.sealedCount();
+      bool held = next >= oldest;
+      if (held) {
+        batch[0] = sensorBlocks.block(next - oldest);
+      }
+      xSemaphoreGive(historyMutex);
+
+      if (held) {
+        rebaseBlock(batch[0]);
+        exporter.addBlock(batch[0]);
+      }
+    }
+  }
+
+  // 2. Records since the last sealed block
+  if (sensorBlocks.isReady()) {
+    xSemaphoreTake(historyMutex, portMAX_DELAY);
+    batch[0] = sensorBlocks.openBlock();
+    xSemaphoreGive(historyMutex);
+    rebaseBlock(batch[0]);
+    exporter.addBlock(batch[0]);
+  }
+
+  exporter.finish();
+  server.sendContent("");  // Terminating chunk
+
+  unsigned long elapsed = millis() - start;
+  LOG_I("http", "Export (%s): %lu records, %lu KB in %lu ms (%.1f KB/s)", formatName.c_str(),
+        (unsigned long)exporter.getRecords(), (unsigned long)(exporter.getBytes() / 1024), elapsed,
+        elapsed > 0 ? exporter.getBytes() / 1.024f / elapsed : 0.0f);
+}
+
+// Calls fn(timestamp, value) for every reading of `channel` in [from, to)
+// (seconds since boot): from the raw ring if it reaches back to `from`, else
+// from the compressed RAM blocks, which hold about twice as long.
+// Returns the source used ("raw" or "blocks").
+template <typename Fn>
+const char* forEachRecord(SensorChannel channel, uint32_t from, uint32_t to, Fn fn) {
+  xSemaphoreTake(historyMutex, portMAX_DELAY);
+  bool rawCovers = sensorHistory.size() > 0 && sensorHistory.timestampAt(sensorHistory.firstSequence()) <= from;
+  if (rawCovers || !sensorBlocks.isReady()) {
+    uint64_t end = sensorHistory.findSequence(to);
+    for (uint64_t seq = sensorHistory.findSequence(from); seq < end; seq++) {
+      int32_t value;
+      if (sensorHistory.valueAt(channel, seq, value)) {
+        fn(sensorHistory.timestampAt(seq), value);
+      }
+    }
+    xSemaphoreGive(historyMutex);
+    return "raw";
+  }
+  uint32_t end = sensorBlocks.getSealedTotal() + 1;  // +1: the open block
+  uint32_t next = end - 1 - sensorBlocks.sealedCount();
+  xSemaphoreGive(historyMutex);
+
+  // Blocks are copied one at a time so the sensor task is never held up by decoding
+  static SensorBlock block;
+  for (; next < end; next++) {
+    xSemaphoreTake(historyMutex, portMAX_DELAY);
+    uint32_t oldest = sensorBlocks.getSealedTotal() - sensorBlocks.sealedCount();
+    bool held = next >= oldest;
+    if (held) {
+      block = next - oldest < sensorBlocks.sealedCount() ? sensorBlocks.block(next - oldest) : sensorBlocks.openBlock();
+    }
+    xSemaphoreGive(historyMutex);
+
+    if (!held || block.header.records == 0 || block.header.lastTime < from || block.header.firstTime >= to) {
+      continue;
+    }
+    SensorBlockDecoder decoder(block);
+    uint32_t timestamp;
+    SensorSnapshot record;
+    while (decoder.next(timestamp, record)) {
+      if (timestamp >= from && timestamp < to && record.has(channel)) {
+        fn(timestamp, record.values[channel]);
+      }
+    }
+  }
+  return "blocks";
+}
+
+void handleQuery() {
+  SensorChannel channel = CHANNEL_TEMPERATURE;
+  if (server.hasArg("channel") && !channelFromName(server.arg("channel").c_str(), channel)) {
+    server.send(400, "text/plain", "Unknown channel");
+    return;
+  }
+  if (channel >= HISTORY_CHANNEL_COUNT) {
+    server.send(400, "text/plain", "Channel is not kept in history (derived per cycle, see /status)");
+    return;
+  }
+  QueryFunction function;
+  if (!server.hasArg("fn") || !queryFunctionFromName(server.arg("fn").c_str(), function)) {
+    server.send(400, "text/plain", "fn must be min, max, avg, count, slope or percentile");
+    return;
+  }
+
+  // Nothing older than the day tier's retention exists anywhere
+  const uint32_t maxSeconds = ROLLUP_PERIODS[ROLLUP_TIER_COUNT - 1] * ROLLUP_DAY_BUCKETS;
+  uint32_t seconds = 3600;
+  if (server.hasArg("seconds") && !queryParseSeconds(server.arg("seconds").c_str(), maxSeconds, seconds)) {
+    server.send(400, "text/plain", "seconds must be a whole number from 1 to " + String(maxSeconds));
+    return;
+  }
+  uint32_t step = seconds;
+  if (server.hasArg("step") && !queryParseSeconds(server.arg("step").c_str(), maxSeconds, step)) {
+    server.send(400, "text/plain", "step must be a whole number from 1 to " + String(maxSeconds));
+    return;
+  }
+  int percentile = server.hasArg("p") ? constrain(server.arg("p").toInt(), 1, 100) : 50;
+
+  unsigned long started = micros();
+  uint32_t now = uptimeSeconds();
+  uint32_t from = now >= seconds ? now + 1 - seconds : 0;
+
+  // Push down to a rollup tier where it answers exactly: the coarsest tier
+  // whose period divides the step (groups then cover whole buckets). Spans
+  // beyond the raw ring fall back to the closest tier. Percentiles need the
+  // individual readings and always scan records.
+  int tier = -1;
+  if (function != QUERY_PERCENTILE) {
+    for (int t = ROLLUP_TIER_COUNT - 1; t >= 0 && tier < 0; t--) {
+      const RollupTier& rollup = sensorRollups.tier(t);
+      if (rollup.isReady() && step % rollup.getPeriod() == 0 && rollup.retention() >= seconds) {
+        tier = t;
+      }
+    }
+    xSemaphoreTake(historyMutex, portMAX_DELAY);
+    bool rawCovers = sensorHistory.size() > 0 && sensorHistory.timestampAt(sensorHistory.firstSequence()) <= from;
+    xSemaphoreGive(historyMutex);
+    if (tier < 0 && !rawCovers) {
+      tier = sensorRollups.selectTier(seconds, step);
+    }
+  }
+  if (tier >= 0) {
+    from -= from % sensorRollups.tier(tier).getPeriod();  // Group edges on bucket edges
+  }
+  // Counted after snapping, which can add a group
+  uint32_t groups = queryGroupCount(from, now, step);
+  if (groups > (uint32_t)HISTORY_MAX_POINTS) {
+    server.send(400, "text/plain", "At most " + String(HISTORY_MAX_POINTS) + " steps (seconds / step)");
+    return;
+  }
+
+  static const char* const TIER_NAMES[ROLLUP_TIER_COUNT] = {"1m", "1h", "1d"};
+  const ChannelInfo& info = CHANNEL_INFO[channel];
+  bool unixClock = toUnixTime(0) != 0;
+  const char* source = tier >= 0 ? TIER_NAMES[tier] : "raw";
+
+  char buffer[1024];
+  size_t used = 0;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  used += snprintf(buffer + used, sizeof(buffer) - used, "{\"channel\":\"%s\",\"fn\":\"%s\",\"unit\":\"%s%s\",",
+                   info.name, QUERY_FUNCTION_NAMES[function], function == QUERY_COUNT ? "" : info.unit,
+                   function == QUERY_SLOPE ? "/h" : "");
+  if (function == QUERY_PERCENTILE) {
+    used += snprintf(buffer + used, sizeof(buffer) - used, "\"p\":%d,", percentile);
+  }
+  used += snprintf(buffer + used, sizeof(buffer) - used, "\"step\":%lu,\"clock\":\"%s\",\"results\":[",
+                   (unsigned long)step, unixClock ? "unix" : "uptime");
+
+  for (uint32_t group = 0; group < groups; group++) {
+    uint32_t groupFrom = from + group * step;
+    uint32_t groupTo = groupFrom + step;
+    if (groupTo <= groupFrom) {
+      break;  // Past the end of the uptime clock
+    }
+    HistoryAggregate aggregate = {INT32_MAX, INT32_MIN, 0, 0, 0, 0};
+    LinearFit fit;
+    int32_t result = 0;
+    bool hasResult = false;
+
+    if (tier >= 0) {
+      const RollupTier& rollup = sensorRollups.tier(tier);
+      xSemaphoreTake(historyMutex, portMAX_DELAY);
+      if (function == QUERY_SLOPE) {
+        // Regression over the bucket averages (one point per bucket)
+        for (uint32_t bucket = groupFrom; bucket < groupTo; bucket += rollup.getPeriod()) {
+          HistoryAggregate part = rollup.aggregate(channel, bucket, bucket + rollup.getPeriod());
+          if (part.count > 0) {
+            fit.add(bucket + rollup.getPeriod() / 2, part.average());
+          }
+        }
+      } else {
+        aggregate = rollup.aggregate(channel, groupFrom, groupTo);
+      }
+      xSemaphoreGive(historyMutex);
+    } else {
+      source = forEachRecord(channel, groupFrom, groupTo, [&](uint32_t timestamp, int32_t value) {
+        if (value < aggregate.min) aggregate.min = value;
+        if (value > aggregate.max) aggregate.max = value;
+        aggregate.sum += value;
+        aggregate.count++;
+        if (function == QUERY_SLOPE) {
+          fit.add(timestamp, value);
+        }
+      });
+    }
+
+    switch (function) {
+      case QUERY_MIN: hasResult = aggregate.count > 0; result = aggregate.min; break;
+      case QUERY_MAX: hasResult = aggregate.count > 0; result = aggregate.max; break;
+      case QUERY_AVG: hasResult = aggregate.count > 0; result = aggregate.average(); break;
+      case QUERY_COUNT: hasResult = true; result = aggregate.count; break;
+      case QUERY_SLOPE: hasResult = fit.slopePerHour(result); break;
+      case QUERY_PERCENTILE:
+        if (aggregate.count > 0) {
+          // Second pass over the same records, binned between the first pass's min and max
+          static QuantileSketch sketch;
+          sketch.reset(aggregate.min, aggregate.max);
+          forEachRecord(channel, groupFrom, groupTo, [&](uint32_t, int32_t value) { sketch.add(value); });
+          result = sketch.percentile(percentile);
+          hasResult = true;
+        }
+        break;
+      default: break;
+    }
+
+    char value[FIXED_TEXT_SIZE] = "null";
+    if (hasResult) {
+      if (function == QUERY_COUNT) {
+        snprintf(value, sizeof(value), "%ld", (long)result);
+      } else {
+        formatFixed(value, sizeof(value), result, info.scale,
+                    function == QUERY_SLOPE ? info.scale : info.decimals);
+      }
+    }
+    uint32_t t = unixClock ? toUnixTime(groupFrom) : groupFrom;
+    if (used > sizeof(buffer) - 48) {
+      server.sendContent(buffer, used);
+      used = 0;
+    }
+    used += snprintf(buffer + used, sizeof(buffer) - used, "%s[%lu,%s]", groupFrom == from ? "" : ",",
+                     (unsigned long)t, value);
+    heartbeats.beat(HEARTBEAT_WEB, millis());
+  }
+
+  used += snprintf(buffer + used, sizeof(buffer) - used, "],\"source\":\"%s\",\"elapsedUs\":%lu}", source,
+                   (unsigned long)(micros() - started));
+  server.sendContent(buffer, used);
+  server.sendContent("");  // Terminating chunk
+}
+
+// /capture?duration=<s>&rate=<Hz>: starts a burst capture (runs in the background)
+void handleCapture() {
+  bool bmpAttached = false;
+  if constexpr (BoardSensors::contains<Bmp280Driver>()) {
+    bmpAttached = sensors.isAttached<Bmp280Driver>();
+  }
+  if (burstCapture.capacity() == 0 || !bmpAttached) {
+    server.send(503, "text/plain", "Burst capture needs a BMP280");
+    return;
+  }
+  if (captureActive || otaInProgress) {
+    server.send(409, "text/plain", "Capture already running");
+    return;
+  }
+
+  float duration = server.hasArg("duration") ? server.arg("duration").toFloat() : 5;
+  long rate = server.hasArg("rate") ? server.arg("rate").toInt() : CAPTURE_MAX_RATE_HZ;
+  size_t samples = (size_t)(duration * rate);
+  if (duration <= 0 || rate < 1 || rate > CAPTURE_MAX_RATE_HZ || samples == 0 ||
+      samples > burstCapture.capacity()) {
+    server.send(400, "text/plain", "rate must be 1-" + String(CAPTURE_MAX_RATE_HZ) + " Hz and duration * rate at most " +
+                String((unsigned)burstCapture.capacity()) + " samples");
+    return;
+  }
+
+  burstCapture.start(rate, samples);
+  captureActive = true;
+  if (xTaskCreatePinnedToCore(captureTask, "capture", SENSOR_TASK_STACK, NULL, SENSOR_TASK_PRIORITY + 1,
+                              &captureTaskHandle, SENSOR_TASK_CORE) != pdPASS) {
+    burstCapture.finish(false);
+    captureActive = false;
+    server.send(500, "text/plain", "Failed to start capture task");
+    return;
+  }
+
+  String json = "{";
+  json += "\"rate\":" + String(rate) + ",";
+  json += "\"samples\":" + String((unsigned)samples) + ",";
+  json += "\"durationMs\":" + String((unsigned long)(samples * 1000UL / rate));
+  json += "}";
+  server.send(202, "application/json", json);
+}
+
+void handleCaptureStatus() {
+  static const char* const STATES[] = {"idle", "running", "done", "failed"};
+  String json = "{";
+  json += "\"state\":\"" + String(STATES[burstCapture.getState()]) + "\",";
+  json += "\"samples\":" + String((unsigned)burstCapture.size()) + ",";
+  json += "\"target\":" + String((unsigned)burstCapture.getTarget()) + ",";
+  json += "\"capacity\":" + String((unsigned)burstCapture.capacity()) + ",";
+  json += "\"rate\":" + String(burstCapture.getRateHz()) + ",";
+  // Timing figures are only consistent once the capture task has finished
+  if (burstCapture.getState() == CAPTURE_DONE || burstCapture.getState() == CAPTURE_FAILED) {
+    json += "\"achievedRate\":" + String(burstCapture.achievedRate(), 2) + ",";
+    json += "\"jitterRmsUs\":" + String(burstCapture.jitterRmsUs(), 1) + ",";
+    json += "\"minIntervalUs\":" + String(burstCapture.getMinIntervalUs()) + ",";
+    json += "\"maxIntervalUs\":" + String(burstCapture.getMaxIntervalUs()) + ",";
+  }
+  json += "\"missed\":" + String(burstCapture.getMissed()) + ",";
+  json += "\"readErrors\":" + String(burstCapture.getReadErrors());
+  json += "}";
+  server.send(200, "application/json", json);
+}
+
+// Binary download: CaptureHeader followed by the samples (see burst_capture.h)
+void handleCaptureData() {
+  if (captureActive || burstCapture.getState() != CAPTURE_DONE) {
+    server.send(409, "text/plain", "No finished capture");
+    return;
+  }
+
+  CaptureHeader header = burstCapture.header();
+  size_t dataBytes = header.count * sizeof(CaptureSample);
+  server.sendHeader("Content-Disposition", "attachment; filename=\"capture.bin\"");
+  server.setContentLength(sizeof(header) + dataBytes);
+  server.send(200, "application/octet-stream", "");
+
+  WiFiClient client = server.client();
+  client.write((const uint8_t*)&header, sizeof(header));
+  // In slices so the watchdog is fed on a slow link
+  const uint8_t* data = (const uint8_t*)burstCapture.data();
+  for (size_t sent = 0; sent < dataBytes && client.connected();) {
+    size_t slice = dataBytes - sent < 1440 ? dataBytes - sent : 1440;
+    size_t written = client.write(data + sent, slice);
+    if (written == 0) {
+      break;
+    }
+    sent += written;
+    heartbeats.beat(HEARTBEAT_WEB, millis());
+  }
+}
+
+// /events: Server-Sent Events stream of anomaly events. The connection is
+// kept open after the handler returns; serviceEventStream() writes to it.
+void handleEvents() {
+  int8_t slot = -1;
+  for (uint8_t i = 0; i < MAX_EVENT_SUBSCRIBERS; i++) {
+    if (!eventSubscribers[i] || !eventSubscribers[i].connected()) {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0) {
+    server.send(503, "text/plain", "Too many event subscribers");
+    return;
+  }
+
+  WiFiClient client = server.client();
+  client.print("HTTP/1.1 200 OK\r\n"
+               "Content-Type: text/event-stream\r\n"
+               "Cache-Control: no-cache\r\n"
+               "Connection: keep-alive\r\n"
+               "Access-Control-Allow-Origin: *\r\n\r\n"
+               "retry: 5000\n\n");
+  eventSubscribers[slot] = client;
+  LOG_I("http", "Event subscriber %d connected", slot);
+}
+
+// /anomalies: detector state per monitored channel and the most recent events
+void handleAnomalies() {
+  String json = "{";
+  json += "\"channels\":[";
+  xSemaphoreTake(anomalyMutex, portMAX_DELAY);
+  bool first = true;
+  char value[FIXED_TEXT_SIZE];
+  for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+    if (ANOMALY_NOISE_FLOOR[c] == 0) {
+      continue;
+    }
+    const ChannelInfo& info = CHANNEL_INFO[c];
+    const ChannelDetector& detector = anomalyDetector.channel((SensorChannel)c);
+    if (!first) json += ",";
+    first = false;
+    json += "{\"channel\":\"" + String(info.name) + "\",";
+    json += "\"warm\":" + String(detector.isWarm() ? "true" : "false") + ",";
+    formatFixed(value, sizeof(value), detector.getMean(), info.scale, info.decimals);
+    json += "\"baseline\":" + String(value) + ",";
+    formatFixed(value, sizeof(value), (int32_t)(detector.getDeviation() >> 8), info.scale, info.decimals);
+    json += "\"deviation\":" + String(value) + ",";
+    json += "\"drift\":" + String(detector.getDrift() / 256.0f, 1) + ",";
+    json += "\"drifting\":" + String(detector.isDrifting() ? "true" : "false") + "}";
+  }
+  json += "],";
+
+  uint32_t total = anomalyDetector.getTotal();
+  json += "\"events\":" + String(total) + ",";
+  json += "\"recent\":[";
+  for (uint8_t i = 0; i < total && i < ANOMALY_RECENT_EVENTS; i++) {
+    if (i > 0) json += ",";
+    appendAnomalyJson(json, anomalyDetector.recentEvent(i));
+  }
+  xSemaphoreGive(anomalyMutex);
+  json += "],";
+
+  uint8_t subscribers = 0;
+  for (uint8_t i = 0; i < MAX_EVENT_SUBSCRIBERS; i++) {
+    if (eventSubscribers[i] && eventSubscribers[i].connected()) {
+      subscribers++;
+    }
+  }
+  json += "\"subscribers\":" + String(subscribers) + ",";
+  json += "\"queueDrops\":" + String(anomalyQueueDrops);
+  json += "}";
+  server.send(200, "application/json", json);
+}
+
+// /rules: active rules with their compiled size and current state
+void handleRules() {
+  static const char* CONDITION_NAMES[] = {"false", "true", "unknown"};
+  String json = "{\"rules\":[";
+  xSemaphoreTake(rulesMutex, portMAX_DELAY);
+  for (uint8_t i = 0; i < ruleEngine.size(); i++) {
+    const RuleProgram& program = ruleEngine.program(i);
+    const RuleState& state = ruleEngine.state(i);
+    if (i > 0) json += ",";
+    json += "{\"id\":" + String(i) + ",";
+    json += "\"rule\":\"" + String(program.source) + "\",";
+    json += "\"bytes\":" + String(program.codeLength) + ",";
+    json += "\"holdSeconds\":" + String(program.holdSeconds) + ",";
+    json += "\"condition\":\"" + String(state.evaluated ? CONDITION_NAMES[state.condition] : "pending") + "\",";
+    json += "\"firing\":" + String(state.firing ? "true" : "false") + ",";
+    json += "\"fires\":" + String(state.fires);
+    if (state.fires > 0) {
+      uint32_t unixTime = toUnixTime(state.lastFired);
+      json += ",\"lastFired\":" + String(unixTime != 0 ? unixTime : state.lastFired);
+    }
+    json += "}";
+  }
+  json += "],";
+  json += "\"capacity\":" + String(ruleEngine.capacity()) + ",";
+  json += "\"evaluations\":" + String(ruleEngine.getEvaluations()) + ",";
+  json += "\"queueDrops\":" + String(ruleQueueDrops);
+  xSemaphoreGive(rulesMutex);
+  json += "}";
+  server.send(200, "application/json", json);
+}
+
+// /rules-add?rule=...: compiles a rule (also accepts the text as a plain POST body)
+void handleRulesAdd() {
+  String text = server.hasArg("rule") ? server.arg("rule") : server.arg("plain");
+  text.trim();
+  if (text.length() == 0) {
+    server.send(400, "application/json", "{\"error\":\"Missing rule\"}");
+    return;
+  }
+
+  RuleCompiler compiler;
+  RuleProgram program;
+  RuleError error;
+  if (!compiler.compile(text.c_str(), program, error)) {
+    server.send(400, "application/json",
+                "{\"error\":\"" + String(error.message) + "\",\"position\":" + String(error.position) + "}");
+    return;
+  }
+
+  xSemaphoreTake(rulesMutex, portMAX_DELAY);
+  if (!ruleEngine.add(program)) {
+    xSemaphoreGive(rulesMutex);
+    server.send(409, "application/json", "{\"error\":\"Rule limit reached (" + String(RULES_MAX) + ")\"}");
+    return;
+  }
+  uint8_t id = ruleEngine.size() - 1;
+  saveRules(id);
+  xSemaphoreGive(rulesMutex);
+
+  LOG_I("rules", "Rule %d added (%d bytes): %s", id, program.codeLength, program.source);
+  server.send(200, "application/json",
+              "{\"id\":" + String(id) + ",\"bytes\":" + String(program.codeLength) + "}");
+}
+
+// /rules-delete?id=N: later rules move down one id
+void handleRulesDelete() {
+  if (!server.hasArg("id")) {
+    server.send(400, "application/json", "{\"error\":\"Missing id\"}");
+    return;
+  }
+  // toInt() would turn "abc" into 0 and the cast 256 into 0: rule 0 deleted
+  String text = server.arg("id");
+  char* end = NULL;
+  long id = strtol(text.c_str(), &end, 10);
+  if (text.length() == 0 || *end != '\0') {
+    server.send(400, "application/json", "{\"error\":\"id must be a number\"}");
+    return;
+  }
+
+  xSemaphoreTake(rulesMutex, portMAX_DELAY);
+  if (id < 0 || id >= ruleEngine.size() || !ruleEngine.remove((uint8_t)id)) {
+    xSemaphoreGive(rulesMutex);
+    server.send(404, "application/json", "{\"error\":\"No such rule\"}");
+    return;
+  }
+  saveRules((uint8_t)id);
+  ruleLedPattern = ruleEngine.ledPattern();
+  xSemaphoreGive(rulesMutex);
 
+  LOG_I("rules", "Rule %ld deleted", id);
+  server.send(200, "application/json", "{\"deleted\":" + String(id) + "}");
+}
+
+void handlePrepareOTA() {
   // Check if OTA needs to be initialized
   bool otaWasInitialized = otaInitialized;
   if (!otaInitialized && sta_connected) {
-    Serial.println("⚠ OTA not initialized - initializing now...");
+    LOG_W("ota", "Not initialized - initializing now");
     setupOTA();
-    Serial.println("✓ OTA initialized successfully");
   }
 
   // Disable WiFi power save for the next 5 minutes
@@ -1150,11 +3095,8 @@ void handlePrepareOTA() {
   otaPrepared = true;
   otaPreparedTime = millis();
 
-  Serial.println("✓ WiFi power save DISABLED (WIFI_PS_NONE)");
-  Serial.println("✓ Explicit light sleep DISABLED (via otaPrepared flag)");
-  Serial.println("✓ OTA window active for 5 minutes");
-  Serial.println("✓ Ready for OTA upload");
-  Serial.println("========================================\n");
+  LOG_I("ota", "Prepared: WiFi power save and light sleep disabled for %lu minutes",
+        OTA_PREP_TIMEOUT / 60000);
 
   // Return success JSON
   String json = "{";
@@ -1186,9 +3128,7 @@ void handleSetAPSettings() {
     // Save the setting to NVS
     preferences.putBool("disableAP", disableAPWhenConnected);
 
-    Serial.println("\n--- AP Settings Updated ---");
-    Serial.print("Disable AP when connected: ");
-    Serial.println(disableAPWhenConnected ? "Yes" : "No");
+    LOG_I("ap", "Settings saved: disable AP when connected: %s", disableAPWhenConnected ? "yes" : "no");
 
     // Apply the setting immediately if connected to WiFi
     if (sta_connected) {
@@ -1206,7 +3146,6 @@ void handleSetAPSettings() {
     json += "}";
 
     server.send(200, "application/json", json);
-    Serial.println("--- Settings Saved ---\n");
   } else {
     server.send(400, "text/plain", "Missing disableAP parameter");
   }
@@ -1230,10 +3169,9 @@ void handleSetDeviceName() {
 
       // Save to NVS
       preferences.putString("deviceName", deviceName);
+      buildInfluxTags();
 
-      Serial.println("\n--- Device Name Updated ---");
-      Serial.println("New name: " + deviceName);
-      Serial.println("--- Name Saved ---\n");
+      LOG_I("sys", "Device name set to %s", deviceName.c_str());
 
       String json = "{";
       json += "\"status\":\"success\",";
@@ -1249,13 +3187,963 @@ void handleSetDeviceName() {
   }
 }
 
+void handleGetMqttSettings() {
+  xSemaphoreTake(telemetryMutex, portMAX_DELAY);
+  size_t queued = telemetryQueue.size();
+  uint32_t dropped = telemetryQueue.getDropped();
+  xSemaphoreGive(telemetryMutex);
+
+  String json = "{";
+  json += "\"host\":\"" + mqttHost + "\",";
+  json += "\"port\":" + String(mqttPort) + ",";
+  json += "\"user\":\"" + mqttUser + "\",";
+  json += "\"hasPassword\":" + String(mqttPassword.length() > 0 ? "true" : "false") + ",";
+  json += "\"prefix\":\"" + mqttPrefix + "\",";
+  json += "\"batch\":" + String(mqttBatch) + ",";
+  json += "\"topic\":\"" + mqttTopic("telemetry") + "\",";
+  json += "\"connected\":" + String(mqttClient.connected() ? "true" : "false") + ",";
+  json += "\"queued\":" + String(queued) + ",";
+  json += "\"queueCapacity\":" + String(telemetryQueue.capacity()) + ",";
+  json += "\"dropped\":" + String(dropped) + ",";
+  json += "\"published\":" + String(mqttPublished) + ",";
+  json += "\"publishFailures\":" + String(mqttPublishFailures) + ",";
+  json += "\"connects\":" + String(mqttConnects);
+  json += "}";
+
+  server.send(200, "application/json", json);
+}
+
+// Every parameter is optional; the password is only replaced when given
+void handleSetMqttSettings() {
+  String host = server.hasArg("host") ? server.arg("host") : mqttHost;
+  long port = server.hasArg("port") ? server.arg("port").toInt() : mqttPort;
+  String prefix = server.hasArg("prefix") ? server.arg("prefix") : mqttPrefix;
+  long batch = server.hasArg("batch") ? server.arg("batch").toInt() : mqttBatch;
+  host.trim();
+  prefix.trim();
+
+  if (host.length() > 64 || port < 1 || port > 65535) {
+    server.send(400, "text/plain", "Invalid host or port");
+    return;
+  }
+  if (prefix.length() == 0 || prefix.length() > 64 || prefix.indexOf('+') >= 0 || prefix.indexOf('#') >= 0) {
+    server.send(400, "text/plain", "Invalid topic prefix (1-64 characters, no + or #)");
+    return;
+  }
+  if (batch < 1 || batch > MQTT_MAX_BATCH) {
+    server.send(400, "text/plain", "Batch must be 1-" + String(MQTT_MAX_BATCH));
+    return;
+  }
+
+  mqttHost = host;
+  mqttPort = port;
+  mqttPrefix = prefix;
+  mqttBatch = batch;
+  if (server.hasArg("user")) {
+    mqttUser = server.arg("user");
+  }
+  if (server.hasArg("password")) {
+    mqttPassword = server.arg("password");
+  }
+
+  // Save to NVS
+  preferences.putString("mqttHost", mqttHost);
+  preferences.putUShort("mqttPort", mqttPort);
+  preferences.putString("mqttUser", mqttUser);
+  preferences.putString("mqttPass", mqttPassword);
+  preferences.putString("mqttPrefix", mqttPrefix);
+  preferences.putUChar("mqttBatch", mqttBatch);
+
+  // Reconnect with the new settings on the next loop() pass
+  if (mqttClient.connected()) {
+    mqttClient.disconnect();
+  }
+  mqttAttempted = false;
+  mqttRetryInterval = MQTT_RETRY_MIN;
+  mqttEnabled = mqttHost.length() > 0 && telemetryQueue.capacity() > 0;
+
+  LOG_I("mqtt", "Settings saved: broker %s, topic %s, batch %d",
+        mqttHost.length() > 0 ? (mqttHost + ":" + String(mqttPort)).c_str() : "(disabled)",
+        mqttTopic("telemetry").c_str(), mqttBatch);
+
+  server.send(200, "application/json", "{\"status\":\"success\",\"enabled\":" +
+              String(mqttEnabled ? "true" : "false") + "}");
+}
+
+void handleGetInfluxSettings() {
+  String json = "{";
+  json += "\"url\":\"" + influxUrl + "\",";
+  json += "\"hasToken\":" + String(influxToken.length() > 0 ? "true" : "false") + ",";
+  json += "\"enabled\":" + String(influxEnabled ? "true" : "false");
+  json += "}";
+
+  server.send(200, "application/json", json);
+}
+
+// url: full write URL (empty disables the push); token: only replaced when given
+void handleSetInfluxSettings() {
+  if (!server.hasArg("url")) {
+    server.send(400, "text/plain", "Missing url parameter");
+    return;
+  }
+  String url = server.arg("url");
+  url.trim();
+  if (url.length() > 0 && (!url.startsWith("http://") || url.length() > 200)) {
+    server.send(400, "text/plain", "url must be an http:// write URL (max 200 characters)");
+    return;
+  }
+  if (influxBatch.data() == NULL) {
+    server.send(503, "text/plain", "InfluxDB push unavailable (not enough heap)");
+    return;
+  }
+
+  influxUrl = url;
+  if (server.hasArg("token")) {
+    influxToken = server.arg("token");
+  }
+
+  // Save to NVS
+  preferences.putString("influxUrl", influxUrl);
+  preferences.putString("influxToken", influxToken);
+
+  // The next POST opens a connection to the new URL
+  influxHttp.end();
+  influxNetClient.stop();
+  influxFailing = false;
+  influxRetryInterval = MQTT_RETRY_MIN;
+  influxEnabled = influxUrl.length() > 0;
+
+  LOG_I("influx", "Settings saved: URL %s", influxEnabled ? influxUrl.c_str() : "(disabled)");
+
+  server.send(200, "application/json", "{\"status\":\"success\",\"enabled\":" +
+              String(influxEnabled ? "true" : "false") + "}");
+}
+
+// /influx-stats: throughput, latency and queue depths of the InfluxDB push
+void handleInfluxStats() {
+  xSemaphoreTake(telemetryMutex, portMAX_DELAY);
+  size_t queued = influxQueue.size();
+  uint32_t queueDropped = influxQueue.getDropped();
+  xSemaphoreGive(telemetryMutex);
+  const BatchSpoolStats& spool = influxSpool.getStats();
+
+  String json = "{";
+  json += "\"enabled\":" + String(influxEnabled ? "true" : "false") + ",";
+  json += "\"linkUp\":" + String(sta_connected ? "true" : "false") + ",";
+  json += "\"backoffMs\":" + String(influxFailing ? influxRetryInterval : 0) + ",";
+  json += "\"lastStatus\":" + String(influxStats.lastStatus) + ",";
+  json += "\"queue\":{\"records\":" + String(queued) + ",\"capacity\":" + String(influxQueue.capacity()) +
+          ",\"dropped\":" + String(queueDropped) + "},";
+  json += "\"batch\":{\"lines\":" + String(influxBatch.lines()) + ",\"bytes\":" + String(influxBatch.size()) +
+          ",\"ageMs\":" + String(influxBatch.size() > 0 ? millis() - influxBatchStarted : 0) + "},";
+  json += "\"spool\":{\"batches\":" + String(influxSpool.size()) + ",\"bytes\":" + String(influxSpool.bytes()) +
+          ",\"written\":" + String(spool.batchesWritten) + ",\"replayed\":" + String(spool.batchesReplayed) +
+          ",\"dropped\":" + String(spool.batchesDropped) + ",\"corrupt\":" + String(spool.batchesCorrupt) + "},";
+  json += "\"lines\":{\"formatted\":" + String(influxStats.linesFormatted) +
+          ",\"duplicate\":" + String(influxStats.linesDuplicate) +
+          ",\"tooLong\":" + String(influxStats.linesTooLong) + ",\"sent\":" + String(influxStats.linesSent) +
+          ",\"lastMinute\":" + String(influxStats.linesLastMinute) + "},";
+  json += "\"batches\":{\"sent\":" + String(influxStats.batchesSent) +
+          ",\"spooled\":" + String(influxStats.batchesSpooled) + ",\"rejected\":" + String(influxStats.batchesRejected) +
+          ",\"lost\":" + String(influxStats.batchesLost) + ",\"failures\":" + String(influxStats.sendFailures) + "},";
+  json += "\"bytesSent\":" + String((unsigned long)influxStats.bytesSent) + ",";
+  json += "\"postLatencyMs\":{\"avg\":" + String(influxLatency.average() / 1000.0f, 1) +
+          ",\"p95\":" + String(influxLatency.percentile(95) / 1000.0f, 1) +
+          ",\"max\":" + String(influxLatency.max / 1000.0f, 1) + "}";
+  json += "}";
+
+  server.send(200, "application/json", json);
+}
+
+void handleGetBeaconSettings() {
+  String json = "{";
+  json += "\"enabled\":" + String(beaconEnabled ? "true" : "false") + ",";
+  json += "\"group\":\"" + IPAddress(BEACON_MULTICAST_GROUP).toString() + "\",";
+  json += "\"port\":" + String(BEACON_PORT) + ",";
+  json += "\"sent\":" + String(beaconsSent) + ",";
+  json += "\"errors\":" + String(beaconErrors);
+  json += "}";
+
+  server.send(200, "application/json", json);
+}
+
+void handleSetBeaconSettings() {
+  if (!server.hasArg("enabled")) {
+    server.send(400, "text/plain", "Missing enabled parameter");
+    return;
+  }
+  beaconEnabled = server.arg("enabled") == "1" || server.arg("enabled") == "true";
+  preferences.putBool("beacon", beaconEnabled);
+  LOG_I("beacon", "%s", beaconEnabled ? "Enabled" : "Disabled");
+
+  server.send(200, "application/json", "{\"status\":\"success\",\"enabled\":" +
+              String(beaconEnabled ? "true" : "false") + "}");
+}
+
+// /metrics: Prometheus text format, streamed straight to the client through
+// MetricsWriter's fixed buffer (no per-scrape heap allocation; the headers
+// are written raw for the same reason, as in handleEvents)
+void handleMetrics() {
+  WiFiClient client = server.client();
+  client.print("HTTP/1.1 200 OK\r\n"
+               "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+               "Cache-Control: no-cache\r\n"
+               "Connection: close\r\n\r\n");
+  MetricsWriter<WiFiClient> metrics(client);
+  char labels[64];
+
+  metrics.header("esp32_uptime_seconds", "gauge", "Seconds since boot");
+  metrics.sample("esp32_uptime_seconds", uptimeSeconds());
+
+  metrics.header("esp32_boots_total", "counter", "Boots recorded in the boot history");
+  metrics.sample("esp32_boots_total", bootHistory.boots);
+  metrics.header("esp32_resets_total", "counter", "Boots per reset reason");
+  for (uint8_t reason = 0; reason <= BOOT_RESET_REASON_COUNT; reason++) {
+    if (bootHistory.resets[reason] > 0) {
+      snprintf(labels, sizeof(labels), "reason=\"%s\"", bootResetReasonName(reason));
+      metrics.sample("esp32_resets_total", bootHistory.resets[reason], labels);
+    }
+  }
+  metrics.header("esp32_crashes_total", "counter", "Panics, watchdog resets, brown-outs and supervisor resets");
+  metrics.sample("esp32_crashes_total", bootHistory.crashes());
+  metrics.header("esp32_supervisor_resets_total", "counter", "Resets after a stalled subsystem did not recover");
+  metrics.sample("esp32_supervisor_resets_total", bootHistory.supervisorResets);
+  const BootRecord& lastBoot = bootHistory.records[0];
+  char bootLabels[160];
+  snprintf(bootLabels, sizeof(bootLabels),
+           "reason=\"%s\",loop_phase=\"%s\",sensor_phase=\"%s\",route=\"%s\",stalled=\"%s\"",
+           bootResetReasonName(lastBoot.reason), perfPhaseName(lastBoot.loopPhase),
+           perfPhaseName(lastBoot.sensorPhase), lastBoot.route, heartbeatName(lastBoot.stalled));
+  metrics.header("esp32_last_reset_info", "gauge", "Reason of the last reset and the phases it interrupted");
+  metrics.sample("esp32_last_reset_info", 1, bootLabels);
+  metrics.header("esp32_previous_uptime_seconds", "gauge", "Uptime of the previous boot when it reset");
+  metrics.sample("esp32_previous_uptime_seconds", lastBoot.uptimeS);
+
+  uint32_t now = millis();
+  metrics.header("esp32_heartbeat_age_seconds", "gauge", "Time since each subsystem last checked in");
+  for (uint8_t id = 0; id < HEARTBEAT_COUNT; id++) {
+    snprintf(labels, sizeof(labels), "subsystem=\"%s\"", heartbeatName(id));
+    metrics.sample("esp32_heartbeat_age_seconds", heartbeats.age(id, now), labels, 3);
+  }
+  metrics.header("esp32_heartbeat_stalls_total", "counter", "Subsystem stalls detected by the supervisor");
+  for (uint8_t id = 0; id < HEARTBEAT_COUNT; id++) {
+    snprintf(labels, sizeof(labels), "subsystem=\"%s\"", heartbeatName(id));
+    metrics.sample("esp32_heartbeat_stalls_total", heartbeats.get(id).stalls, labels);
+  }
+  metrics.header("esp32_heartbeat_restarts_total", "counter", "Targeted subsystem restarts");
+  for (uint8_t id = 0; id < HEARTBEAT_COUNT; id++) {
+    snprintf(labels, sizeof(labels), "subsystem=\"%s\"", heartbeatName(id));
+    metrics.sample("esp32_heartbeat_restarts_total", heartbeats.get(id).restarts, labels);
+  }
+
+  metrics.header("esp32_heap_free_bytes", "gauge", "Free heap");
+  metrics.sample("esp32_heap_free_bytes", ESP.getFreeHeap());
+  metrics.header("esp32_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+  metrics.sample("esp32_heap_min_free_bytes", ESP.getMinFreeHeap());
+  metrics.header("esp32_heap_largest_block_bytes", "gauge", "Largest allocatable heap block");
+  metrics.sample("esp32_heap_largest_block_bytes", ESP.getMaxAllocHeap());
+  metrics.header("esp32_heap_fragmentation_ratio", "gauge", "1 - largest free block / free heap");
+  metrics.sample("esp32_heap_fragmentation_ratio", heapFragmentation(ESP.getFreeHeap(), ESP.getMaxAllocHeap()), NULL, 3);
+  if (heapWatermarks.samples > 0) {
+    metrics.header("esp32_heap_lowest_largest_block_bytes", "gauge", "Smallest largest-free-block seen since boot");
+    metrics.sample("esp32_heap_lowest_largest_block_bytes", heapWatermarks.lowestLargestBlock);
+  }
+  metrics.header("esp32_chip_temperature_celsius", "gauge", "Internal chip temperature");
+  metrics.sample("esp32_chip_temperature_celsius", (int64_t)(getTemperature() * 10), NULL, 1);
+  metrics.header("esp32_wifi_connected", "gauge", "1 while the station is connected");
+  metrics.sample("esp32_wifi_connected", sta_connected ? 1 : 0);
+  if (sta_connected) {
+    metrics.header("esp32_wifi_rssi_dbm", "gauge", "Station signal strength");
+    metrics.sample("esp32_wifi_rssi_dbm", WiFi.RSSI());
+  }
+
+  // Latest readings, one gauge per channel with a reading (fixed-point, full precision)
+  SensorSnapshot readings = sensorSnapshot.read();
+  for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+    if (!readings.has((SensorChannel)c)) {
+      continue;
+    }
+    const ChannelInfo& info = CHANNEL_INFO[c];
+    char name[40];
+    char help[40];
+    snprintf(name, sizeof(name), "esp32_sensor_%s", info.name);
+    snprintf(help, sizeof(help), "Latest %s reading (%s)", info.name, info.unit);
+    metrics.header(name, "gauge", help);
+    metrics.sample(name, readings.get((SensorChannel)c), NULL, info.scale);
+  }
+
+  metrics.header("esp32_i2c_device_attached", "gauge", "1 while the sensor responds");
+  for (uint8_t i = 0; i < i2cBus.getDeviceCount(); i++) {
+    const I2CDeviceStats& device = i2cBus.getDevice(i);
+    snprintf(labels, sizeof(labels), "device=\"%s\"", device.name);
+    metrics.sample("esp32_i2c_device_attached", device.attached ? 1 : 0, labels);
+  }
+  metrics.header("esp32_i2c_transactions_total", "counter", "I2C transactions per device");
+  for (uint8_t i = 0; i < i2cBus.getDeviceCount(); i++) {
+    const I2CDeviceStats& device = i2cBus.getDevice(i);
+    snprintf(labels, sizeof(labels), "device=\"%s\"", device.name);
+    metrics.sample("esp32_i2c_transactions_total", device.transactions, labels);
+  }
+  metrics.header("esp32_i2c_errors_total", "counter", "Failed I2C transactions per device");
+  for (uint8_t i = 0; i < i2cBus.getDeviceCount(); i++) {
+    const I2CDeviceStats& device = i2cBus.getDevice(i);
+    snprintf(labels, sizeof(labels), "device=\"%s\"", device.name);
+    metrics.sample("esp32_i2c_errors_total", device.errors, labels);
+  }
+  metrics.header("esp32_i2c_bus_recoveries_total", "counter", "I2C bus recoveries (stuck SDA/SCL)");
+  metrics.sample("esp32_i2c_bus_recoveries_total", i2cBus.getRecoveries());
+  metrics.header("esp32_i2c_transaction_duration_seconds", "histogram", "I2C transaction time per device");
+  for (uint8_t i = 0; i < i2cBus.getDeviceCount(); i++) {
+    const I2CDeviceStats& device = i2cBus.getDevice(i);
+    snprintf(labels, sizeof(labels), "device=\"%s\"", device.name);
+    metrics.histogram("esp32_i2c_transaction_duration_seconds", device.latency, labels);
+  }
+
+  metrics.header("esp32_wifi_scans_total", "counter", "WiFi scans (dashboard and roaming)");
+  metrics.sample("esp32_wifi_scans_total", systemCounters.wifiScans);
+  metrics.header("esp32_wifi_roams_total", "counter", "Switches to a stronger access point");
+  metrics.sample("esp32_wifi_roams_total", systemCounters.wifiRoams);
+  metrics.header("esp32_wifi_disconnects_total", "counter", "Station connection losses");
+  metrics.sample("esp32_wifi_disconnects_total", systemCounters.wifiDisconnects);
+  metrics.header("esp32_wifi_reconnects_total", "counter", "Station reconnections after a loss");
+  metrics.sample("esp32_wifi_reconnects_total", systemCounters.wifiReconnects);
+  metrics.header("esp32_ota_attempts_total", "counter", "OTA updates started");
+  metrics.sample("esp32_ota_attempts_total", systemCounters.otaAttempts);
+  metrics.header("esp32_ota_failures_total", "counter", "OTA updates that failed");
+  metrics.sample("esp32_ota_failures_total", systemCounters.otaFailures);
+
+  metrics.header("esp32_http_requests_total", "counter", "HTTP requests per route");
+  for (uint8_t i = 0; i < routeCount; i++) {
+    snprintf(labels, sizeof(labels), "route=\"%s\"", routeMetrics[i].path);
+    metrics.sample("esp32_http_requests_total", routeMetrics[i].requests, labels);
+  }
+  // Only routes that were requested, to keep the scrape small
+  metrics.header("esp32_http_handler_duration_seconds", "histogram", "Time spent in the route handler");
+  for (uint8_t i = 0; i < routeCount; i++) {
+    if (routeMetrics[i].latency.count > 0) {
+      snprintf(labels, sizeof(labels), "route=\"%s\"", routeMetrics[i].path);
+      metrics.histogram("esp32_http_handler_duration_seconds", routeMetrics[i].latency, labels);
+    }
+  }
+#ifdef HEAP_ACCOUNTING
+  metrics.header("esp32_http_allocations_total", "counter", "Heap allocations made by the route handler");
+  for (uint8_t i = 0; i < routeCount; i++) {
+    snprintf(labels, sizeof(labels), "route=\"%s\"", routeMetrics[i].path);
+    metrics.sample("esp32_http_allocations_total", routeAllocations[i].allocations, labels);
+  }
+  metrics.header("esp32_http_allocated_bytes_total", "counter", "Heap bytes allocated by the route handler");
+  for (uint8_t i = 0; i < routeCount; i++) {
+    snprintf(labels, sizeof(labels), "route=\"%s\"", routeMetrics[i].path);
+    metrics.sample("esp32_http_allocated_bytes_total", routeAllocations[i].bytesAllocated, labels);
+  }
+#endif
+  metrics.header("esp32_loop_duration_seconds", "histogram", "One loop() pass, excluding its 10 ms delay");
+  metrics.histogram("esp32_loop_duration_seconds", loopLatency);
+
+  metrics.finish();
+  client.stop();
+}
+
+#ifdef PERF_PROFILING
+void appendPerfJson(String& json, const char* name, const LatencyHistogram& histogram) {
+  json += "{\"name\":\"" + String(name) + "\",";
+  json += "\"count\":" + String(histogram.count) + ",";
+  json += "\"avgUs\":" + String(histogram.average()) + ",";
+  json += "\"p50Us\":" + String(histogram.percentile(50)) + ",";
+  json += "\"p99Us\":" + String(histogram.percentile(99)) + ",";
+  json += "\"maxUs\":" + String(histogram.max) + ",";
+  json += "\"totalMs\":" + String((unsigned long)(histogram.sum / 1000)) + ",";
+  // Log2 buckets: entry i counts samples taking <= 2^i µs
+  json += "\"buckets\":[";
+  for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+    if (b > 0) json += ",";
+    json += String(histogram.buckets[b]);
+  }
+  json += "]}";
+}
+#endif
+
+// /debug/perf: phase and route timings since boot or the last ?reset=1
+void handleDebugPerf() {
+#ifdef PERF_PROFILING
+  if (server.hasArg("reset")) {
+    perfProfiler.reset();
+    server.send(200, "application/json", "{\"status\":\"reset\"}");
+    return;
+  }
+
+  String json = "{";
+  json += "\"resets\":" + String(perfProfiler.getResets()) + ",";
+  json += "\"phases\":[";
+  for (uint8_t i = 0; i < PERF_PHASE_COUNT; i++) {
+    if (i > 0) json += ",";
+    appendPerfJson(json, PERF_PHASE_NAMES[i], perfProfiler.get(i));
+  }
+  json += "],\"routes\":[";
+  bool first = true;
+  for (uint8_t i = 0; i < routeCount; i++) {
+    const LatencyHistogram& histogram = perfProfiler.get(PERF_PHASE_COUNT + i);
+    if (histogram.count == 0) {
+      continue;
+    }
+    if (!first) json += ",";
+    first = false;
+    appendPerfJson(json, routeMetrics[i].path, histogram);
+  }
+  json += "]}";
+
+  server.send(200, "application/json", json);
+#else
+  server.send(404, "text/plain", "Profiler not compiled in (build with -DPERF_PROFILING)");
+#endif
+}
+
+// /heap-stats: fragmentation now and at its worst; per-route allocations in
+// the instrumented build
+void handleHeapStats() {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t largestBlock = ESP.getMaxAllocHeap();
+
+  String json = "{";
+  json += "\"freeHeap\":" + String(freeHeap) + ",";
+  json += "\"totalHeap\":" + String(ESP.getHeapSize()) + ",";
+  json += "\"minFreeHeap\":" + String(ESP.getMinFreeHeap()) + ",";
+  json += "\"largestFreeBlock\":" + String(largestBlock) + ",";
+  json += "\"fragmentation\":" + String(heapFragmentation(freeHeap, largestBlock) / 10.0f, 1) + ",";
+  json += "\"lowestLargestFreeBlock\":" +
+          String(heapWatermarks.samples > 0 ? heapWatermarks.lowestLargestBlock : largestBlock) + ",";
+  json += "\"worstFragmentation\":" + String(heapWatermarks.worstFragmentation / 10.0f, 1) + ",";
+#ifdef HEAP_ACCOUNTING
+  json += "\"accounting\":true,";
+  json += "\"routes\":[";
+  bool first = true;
+  for (uint8_t i = 0; i < routeCount; i++) {
+    const RouteAllocations& route = routeAllocations[i];
+    if (route.requests == 0) {
+      continue;
+    }
+    if (!first) json += ",";
+    first = false;
+    json += "{\"route\":\"" + String(routeMetrics[i].path) + "\",";
+    json += "\"requests\":" + String(route.requests) + ",";
+    json += "\"allocations\":" + String(route.allocations) + ",";
+    json += "\"frees\":" + String(route.frees) + ",";
+    json += "\"bytesAllocated\":" + String((unsigned long)route.bytesAllocated) + ",";
+    json += "\"bytesPerRequest\":" + String((unsigned long)(route.bytesAllocated / route.requests)) + ",";
+    json += "\"peakRequestBytes\":" + String(route.peakRequestBytes) + ",";
+    json += "\"retainedBytes\":" + String((long)route.retainedBytes()) + "}";
+  }
+  json += "]";
+#else
+  json += "\"accounting\":false";
+#endif
+  json += "}";
+
+  server.send(200, "application/json", json);
+}
+
+const char* taskStateName(eTaskState state) {
+  switch (state) {
+    case eRunning: return "running";
+    case eReady: return "ready";
+    case eBlocked: return "blocked";
+    case eSuspended: return "suspended";
+    case eDeleted: return "deleted";
+    default: return "unknown";
+  }
+}
+
+// Takes a task monitor snapshot and prints the window's summary on one line:
+// the busiest tasks, idle per core and the task closest to its stack limit
+void sampleTasks() {
+  if (!taskMonitor.sample(millis())) {
+    LOG_W("tasks", "More than %d tasks", TASK_MONITOR_MAX_TASKS);
+    return;
+  }
+
+  String line = String(taskMonitor.getWindowMs() / 1000) + "s:";
+  if (TaskMonitor::hasRunTime()) {
+    uint8_t shown = 0;
+    for (uint8_t i = 0; i < taskMonitor.size() && shown < 4; i++) {
+      const TaskUsage& task = taskMonitor.task(i);
+      if (strncmp(task.name, "IDLE", 4) == 0) {
+        continue;
+      }
+      line += " " + String(task.name) + " " + String(task.cpuPermille / 10.0f, 1) + "%";
+      shown++;
+    }
+    line += " | idle";
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+      int16_t idle = taskMonitor.idlePermille(core);
+      line += " c" + String(core) + " " + (idle < 0 ? String("?") : String(idle / 10.0f, 1) + "%");
+    }
+    line += " |";
+  }
+
+  uint8_t tightest = 0;
+  for (uint8_t i = 1; i < taskMonitor.size(); i++) {
+    if (taskMonitor.task(i).stackFreeMin < taskMonitor.task(tightest).stackFreeMin) {
+      tightest = i;
+    }
+  }
+  line += " min stack " + String(taskMonitor.task(tightest).name) + " " +
+          String(taskMonitor.task(tightest).stackFreeMin) + "B";
+  LOG_I("tasks", "%s", line.c_str());
+  for (uint8_t i = 0; i < taskMonitor.size(); i++) {
+    if (taskMonitor.task(i).stackFreeMin < TASK_MONITOR_STACK_WARN) {
+      LOG_W("tasks", "%s: only %luB of stack left at its deepest", taskMonitor.task(i).name,
+            (unsigned long)taskMonitor.task(i).stackFreeMin);
+    }
+  }
+}
+
+// /debug/tasks: every task's CPU share over the last monitor window (busiest
+// first), priority, core and stack high-water mark
+void handleDebugTasks() {
+  if (taskMonitor.getSamples() == 0) {
+    taskMonitor.sample(millis());  // Before the first periodic sample: shares since boot
+  }
+
+  String json = "{";
+  json += "\"windowMs\":" + String(taskMonitor.getWindowMs()) + ",";
+  json += "\"samples\":" + String(taskMonitor.getSamples()) + ",";
+  json += "\"runTimeStats\":" + String(TaskMonitor::hasRunTime() ? "true" : "false") + ",";
+  json += "\"cpuFreqMHz\":" + String(getCpuFrequencyMhz()) + ",";
+  json += "\"idle\":[";
+  for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+    if (core > 0) json += ",";
+    int16_t idle = taskMonitor.idlePermille(core);
+    json += idle < 0 ? String("null") : String(idle / 10.0f, 1);
+  }
+  json += "],";
+  json += "\"tasks\":[";
+  for (uint8_t i = 0; i < taskMonitor.size(); i++) {
+    const TaskUsage& task = taskMonitor.task(i);
+    if (i > 0) json += ",";
+    json += "{\"name\":\"" + String(task.name) + "\",";
+    json += "\"priority\":" + String(task.priority) + ",";
+    json += "\"state\":\"" + String(taskStateName(task.state)) + "\",";
+    json += "\"core\":" + (task.core < 0 ? String("null") : String(task.core)) + ",";
+    if (TaskMonitor::hasRunTime()) {
+      json += "\"cpu\":" + String(task.cpuPermille / 10.0f, 1) + ",";
+    }
+    json += "\"stackFreeMin\":" + String(task.stackFreeMin) + "}";
+  }
+  json += "]}";
+
+  server.send(200, "application/json", json);
+}
+
+void setupLogging() {
+  logRingMutex = xSemaphoreCreateMutex();
+  BaseType_t created = xTaskCreate(logDrainTask, "logDrain", LOG_DRAIN_TASK_STACK, NULL, LOG_DRAIN_TASK_PRIORITY,
+                                   &logDrainTaskHandle);
+  if (created != pdPASS) {
+    logDrainTaskHandle = NULL;
+    Serial.println("✗ Failed to start log drain task - logs only at /logs");
+  }
+}
+
+void logWrite(uint8_t level, const char* tag, const char* format, ...) {
+  char text[LOG_TEXT_LENGTH];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+
+  if (logRingMutex == NULL) {
+    return;  // Before setupLogging()
+  }
+  xSemaphoreTake(logRingMutex, portMAX_DELAY);
+  logRing.append(level, millis(), tag, text);
+  xSemaphoreGive(logRingMutex);
+
+  if (logDrainTaskHandle != NULL) {
+    xTaskNotifyGive(logDrainTaskHandle);
+  }
+}
+
+// Lowest priority: it only runs when every other task is blocked, and only
+// this task ever waits on a full UART buffer
+void logDrainTask(void* parameter) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    drainLogs();
+  }
+}
+
+// Writes every entry not yet on Serial; notes lines the ring overwrote first
+void drainLogs() {
+  LogEntry entry;
+  for (;;) {
+    uint32_t skipped = 0;
+    xSemaphoreTake(logRingMutex, portMAX_DELAY);
+    if (logDrained < logRing.oldest()) {
+      skipped = logRing.oldest() - logDrained;
+      logDrained = logRing.oldest();
+    }
+    bool pending = logRing.get(logDrained, entry);
+    xSemaphoreGive(logRingMutex);
+
+    if (skipped > 0) {
+      logSerialDropped += skipped;
+      Serial.printf("[log] %lu line(s) dropped\n", (unsigned long)skipped);
+    }
+    if (!pending) {
+      return;
+    }
+    char line[LOG_TEXT_LENGTH + LOG_TAG_LENGTH + 24];
+    snprintf(line, sizeof(line), "[%6lu.%03lu] %c %s: %s\n", (unsigned long)(entry.ms / 1000),
+             (unsigned long)(entry.ms % 1000), LOG_LEVEL_LETTERS[entry.level], entry.tag, entry.text);
+    Serial.print(line);
+    logDrained = entry.seq + 1;
+  }
+}
+
+// Waits (up to timeoutMs) for the drain task to write everything logged so far;
+// for the last messages before a restart
+void flushLogs(uint32_t timeoutMs) {
+  if (logDrainTaskHandle == NULL) {
+    return;
+  }
+  xTaskNotifyGive(logDrainTaskHandle);
+  unsigned long started = millis();
+  while (logDrained < logRing.next() && millis() - started < timeoutMs) {
+    delay(1);
+  }
+  Serial.flush();
+}
+
+// /logs: entries still in the ring, oldest first. ?since=<seq> returns only
+// newer ones (poll with the returned "next"); ?level=W keeps warnings and
+// errors; ?tag=wifi one subsystem
+void handleLogs() {
+  uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), NULL, 10) : 0;
+  uint8_t maxLevel = LOG_LEVEL_DEBUG;
+  if (server.hasArg("level")) {
+    const char* letter = strchr(LOG_LEVEL_LETTERS + 1, toupper(server.arg("level")[0]));
+    if (letter == NULL || *letter == '\0') {
+      server.send(400, "text/plain", "level must be E, W, I or D");
+      return;
+    }
+    maxLevel = letter - LOG_LEVEL_LETTERS;
+  }
+  String tag = server.arg("tag");
+
+  xSemaphoreTake(logRingMutex, portMAX_DELAY);
+  uint32_t oldest = logRing.oldest();
+  uint32_t next = logRing.next();
+  xSemaphoreGive(logRingMutex);
+
+  String json = "{";
+  json += "\"next\":" + String(next) + ",";
+  json += "\"oldest\":" + String(oldest) + ",";
+  json += "\"compiledLevel\":\"" + String(LOG_LEVEL_LETTERS[LOG_COMPILED_LEVEL]) + "\",";
+  json += "\"serialDropped\":" + String(logSerialDropped) + ",";
+  json += "\"counts\":{\"error\":" + String(logRing.count(LOG_LEVEL_ERROR)) +
+          ",\"warn\":" + String(logRing.count(LOG_LEVEL_WARN)) +
+          ",\"info\":" + String(logRing.count(LOG_LEVEL_INFO)) +
+          ",\"debug\":" + String(logRing.count(LOG_LEVEL_DEBUG)) + "},";
+  json += "\"entries\":[";
+  bool first = true;
+  LogEntry entry;
+  char escaped[LOG_TEXT_LENGTH * 2];
+  for (uint32_t seq = since > oldest ? since : oldest; seq < next; seq++) {
+    xSemaphoreTake(logRingMutex, portMAX_DELAY);
+    bool found = logRing.get(seq, entry);  // Overwritten meanwhile if false
+    xSemaphoreGive(logRingMutex);
+    if (!found || entry.level > maxLevel || (tag.length() > 0 && tag != entry.tag)) {
+      continue;
+    }
+    logEscapeJson(escaped, sizeof(escaped), entry.text);
+    if (!first) json += ",";
+    first = false;
+    json += "{\"seq\":" + String(entry.seq) + ",";
+    json += "\"ms\":" + String(entry.ms) + ",";
+    json += "\"level\":\"" + String(LOG_LEVEL_LETTERS[entry.level]) + "\",";
+    json += "\"tag\":\"" + String(entry.tag) + "\",";
+    json += "\"text\":\"" + String(escaped) + "\"}";
+  }
+  json += "]}";
+
+  server.send(200, "application/json", json);
+}
+
+// Records why this boot happened and where the previous one ended (one NVS
+// write), then starts this boot's breadcrumbs
+void setupBootHistory() {
+  bootPreferences.begin("boot", false);
+  if (bootPreferences.getBytes("history", &bootHistory, sizeof(bootHistory)) != sizeof(bootHistory) ||
+      bootHistory.version != BOOT_HISTORY_VERSION) {
+    bootHistory = BootHistory();  // First boot, or stored by a firmware with another layout
+  }
+
+  BootRecord record = {};
+  record.reason = (uint8_t)esp_reset_reason();
+  record.loopPhase = BOOT_PHASE_NONE;
+  record.sensorPhase = BOOT_PHASE_NONE;
+  record.stalled = BOOT_SUBSYSTEM_NONE;
+  // RTC memory holds garbage after a power cycle, whatever it looks like
+  if (record.reason != BOOT_RESET_POWERON && bootBreadcrumbs.valid()) {
+    record.uptimeS = bootBreadcrumbs.uptimeMs / 1000;
+    record.unixTime = bootBreadcrumbs.unixTime;
+    record.loopPhase = bootBreadcrumbs.loopPhase;
+    record.sensorPhase = bootBreadcrumbs.sensorPhase;
+    record.stalled = bootBreadcrumbs.stalled;
+    memcpy(record.route, bootBreadcrumbs.route, BOOT_ROUTE_LENGTH);
+    record.route[BOOT_ROUTE_LENGTH - 1] = '\0';
+  }
+  if (bootResetIsCrash(record.reason)) {
+    readCrashSummary(record);
+  }
+  bootHistory.add(record);
+  bootPreferences.putBytes("history", &bootHistory, sizeof(bootHistory));
+  bootBreadcrumbs.reset();
+
+  if (bootRecordIsSupervisorReset(record)) {
+    LOG_W("boot", "Boot %lu after a supervisor reset at %lus uptime: %s stalled, loop in %s, sensors in %s",
+          (unsigned long)record.boot, (unsigned long)record.uptimeS, heartbeatName(record.stalled),
+          perfPhaseName(record.loopPhase), perfPhaseName(record.sensorPhase));
+    return;
+  }
+  if (!bootResetIsCrash(record.reason)) {
+    LOG_I("boot", "Boot %lu (%s)", (unsigned long)record.boot, bootResetReasonName(record.reason));
+    return;
+  }
+  LOG_W("boot", "Boot %lu after %s at %lus uptime: loop in %s, sensors in %s%s%s", (unsigned long)record.boot,
+        bootResetReasonName(record.reason), (unsigned long)record.uptimeS, perfPhaseName(record.loopPhase),
+        perfPhaseName(record.sensorPhase), record.route[0] != '\0' ? ", handling " : "", record.route);
+  if (record.task[0] != '\0') {
+    char backtrace[12 * (BOOT_BACKTRACE_DEPTH + 1)];
+    bootFormatBacktrace(record, backtrace, sizeof(backtrace));
+    LOG_W("boot", "Crashed in task %s: %s", record.task, backtrace);
+  }
+}
+
+// Crashed task, PC and the first backtrace frames from the core dump the
+// panic handler wrote to flash (when the core enables ELF core dumps). The
+// dump is erased afterwards so a later reset never reports it again.
+void readCrashSummary(BootRecord& record) {
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH && CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+  size_t address = 0;
+  size_t size = 0;
+  if (esp_core_dump_image_get(&address, &size) != ESP_OK) {
+    return;  // No dump: brown-out, or the panic handler couldn't write one
+  }
+  // Over 1 KB on RISC-V (raw stack dump), too big for the stack this early
+  esp_core_dump_summary_t* summary = (esp_core_dump_summary_t*)malloc(sizeof(esp_core_dump_summary_t));
+  if (summary != NULL && esp_core_dump_get_summary(summary) == ESP_OK) {
+    strncpy(record.task, summary->exc_task, sizeof(record.task) - 1);
+    record.task[sizeof(record.task) - 1] = '\0';
+    record.pc = summary->exc_pc;
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+    // Frame 0 is the PC itself
+    uint8_t depth = 0;
+    for (uint32_t i = 1; i < summary->exc_bt_info.depth && depth < BOOT_BACKTRACE_DEPTH; i++) {
+      record.backtrace[depth++] = summary->exc_bt_info.bt[i];
+    }
+    record.backtraceDepth = depth;
+#else
+    // RISC-V summaries carry a raw stack dump, not a walked backtrace; the
+    // return address is the caller
+    record.backtrace[0] = summary->ex_info.ra;
+    record.backtraceDepth = 1;
+#endif
+  }
+  free(summary);
+  esp_core_dump_image_erase();
+#else
+  (void)record;
+#endif
+}
+
+void startSupervisor() {
+  uint32_t now = millis();
+  heartbeats.add(HEARTBEAT_SENSORS, HEARTBEAT_SENSORS_MS, now);
+  heartbeats.add(HEARTBEAT_WEB, HEARTBEAT_WEB_MS, now);
+  heartbeats.add(HEARTBEAT_WIFI, HEARTBEAT_WIFI_MS, now);
+  heartbeats.add(HEARTBEAT_OTA, HEARTBEAT_OTA_MS, now);
+  heartbeats.add(HEARTBEAT_MQTT, HEARTBEAT_PUSH_MS, now);
+  heartbeats.add(HEARTBEAT_INFLUX, HEARTBEAT_PUSH_MS, now);
+
+  BaseType_t created = xTaskCreate(supervisorTask, "supervisor", SUPERVISOR_TASK_STACK, NULL,
+                                   SUPERVISOR_TASK_PRIORITY, &supervisorTaskHandle);
+  if (created != pdPASS) {
+    supervisorTaskHandle = NULL;
+    LOG_E("sys", "Failed to start supervisor - loop() stays on the hardware watchdog");
+    return;
+  }
+  // The supervisor feeds the hardware watchdog from now on; the loop task is
+  // watched through its subsystems' heartbeats
+  esp_task_wdt_delete(NULL);
+  LOG_I("sys", "Supervisor watching %d subsystems", HEARTBEAT_COUNT);
+}
+
+void supervisorTask(void* parameter) {
+  // The last line of defence: if the supervisor itself stops running (a task
+  // spinning above its priority, interrupts off), the hardware watchdog resets
+  esp_task_wdt_add(NULL);
+
+  TickType_t lastWake = xTaskGetTickCount();
+  for (;;) {
+    esp_task_wdt_reset();
+    superviseHeartbeats();
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SUPERVISOR_INTERVAL_MS));
+  }
+}
+
+// The subsystem whose code a loop() phase runs; BOOT_SUBSYSTEM_NONE for the
+// LED, flash writes and the rest of the update cycle, which no restart fixes
+uint8_t heartbeatForLoopPhase(uint8_t phase) {
+  switch (phase) {
+    case PERF_HANDLE_CLIENT:
+    case PERF_EVENT_STREAM:
+      return HEARTBEAT_WEB;
+    case PERF_MQTT:
+      return HEARTBEAT_MQTT;
+    case PERF_INFLUX:
+      return HEARTBEAT_INFLUX;
+    case PERF_OTA_HANDLE:
+      return HEARTBEAT_OTA;
+    case PERF_ROAMING:
+    case PERF_WIFI_STATUS:
+      return HEARTBEAT_WIFI;
+    default:
+      return BOOT_SUBSYSTEM_NONE;
+  }
+}
+
+// Supervisor task, once a second. Stalls are logged and left in the boot
+// breadcrumbs, so a reset that follows is recorded against the subsystem.
+void superviseHeartbeats() {
+  uint32_t now = millis();
+
+  // A loop pass takes milliseconds. When none has started for a second the
+  // loop is blocked in its current phase: that phase's subsystem is the one
+  // stalled, the other loop subsystems are only waiting for their turn.
+  bool loopBlocked = (int32_t)(now - bootBreadcrumbs.uptimeMs) > 1000;
+  uint8_t blocking = heartbeatForLoopPhase(bootBreadcrumbs.loopPhase);
+
+  for (uint8_t id = 0; id < HEARTBEAT_COUNT; id++) {
+    bool waiting = id != HEARTBEAT_SENSORS && loopBlocked && blocking != BOOT_SUBSYSTEM_NONE && blocking != id;
+    uint32_t age = heartbeats.age(id, now);
+    switch (heartbeats.check(id, now, waiting)) {
+      case HEARTBEAT_STALLED:
+        if (bootBreadcrumbs.stalled == BOOT_SUBSYSTEM_NONE) {
+          bootBreadcrumbs.stalled = id;
+        }
+        LOG_E("wdt", "%s stalled: no heartbeat for %lus (loop in %s, sensors in %s) - restarting it",
+              heartbeatName(id), (unsigned long)(age / 1000), perfPhaseName(bootBreadcrumbs.loopPhase),
+              perfPhaseName(bootBreadcrumbs.sensorPhase));
+        break;
+      case HEARTBEAT_RECOVERED:
+        if (bootBreadcrumbs.stalled == id) {
+          bootBreadcrumbs.stalled = BOOT_SUBSYSTEM_NONE;
+        }
+        LOG_W("wdt", "%s recovered", heartbeatName(id));
+        break;
+      case HEARTBEAT_FAILED:
+        bootBreadcrumbs.stalled = id;
+        LOG_E("wdt", "%s did not recover (no heartbeat for %lus) - resetting", heartbeatName(id),
+              (unsigned long)(age / 1000));
+        flushLogs(500);
+        ESP.restart();
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// Targeted restarts the supervisor asked for, run by the loop task that owns
+// these subsystems once it gets back here (the sensor task restarts itself)
+void serviceRestarts() {
+  if (supervisorTaskHandle == NULL) {
+    esp_task_wdt_reset();  // No supervisor: the loop task is still on the hardware watchdog
+    return;
+  }
+  if (heartbeats.takeRestart(HEARTBEAT_WEB)) {
+    LOG_W("http", "Restarting web server");
+    server.stop();  // Drops a client that stopped reading
+    server.begin();
+  }
+  if (heartbeats.takeRestart(HEARTBEAT_WIFI) && sta_ssid.length() > 0) {
+    LOG_W("wifi", "Restarting connection to %s", sta_ssid.c_str());
+    WiFi.reconnect();
+  }
+  if (heartbeats.takeRestart(HEARTBEAT_OTA)) {
+    if (otaInProgress) {
+      abortOta();
+    } else {
+      LOG_W("ota", "Restarting OTA listener");
+      ArduinoOTA.end();
+      otaInitialized = false;  // Set up again by the WiFi status check
+    }
+  }
+  if (heartbeats.takeRestart(HEARTBEAT_MQTT)) {
+    LOG_W("mqtt", "Restarting connection");
+    mqttClient.disconnect();
+    mqttAttempted = false;  // Reconnect on the next pass, not after the backoff
+    mqttRetryInterval = MQTT_RETRY_MIN;
+  }
+  if (heartbeats.takeRestart(HEARTBEAT_INFLUX)) {
+    LOG_W("influx", "Restarting connection");
+    influxHttp.end();
+    influxNetClient.stop();
+  }
+}
+
+// Undoes ArduinoOTA.onStart() after a failed or stalled upload: the old
+// firmware keeps running, with the web server, sensors and supervision back.
+// Auth and begin errors arrive before onStart() has stopped anything: the
+// /prepare-ota window stays open for the retry
+void abortOta() {
+  if (!otaInProgress) {
+    return;
+  }
+  otaInProgress = false;
+  otaPrepared = false;
+  WiFi.setSleep(true);
+  esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+  i2cBus.begin(I2C_SDA, I2C_SCL, I2C_TIMEOUT_MS);
+  server.begin();
+
+  uint32_t now = millis();
+  heartbeats.resume(HEARTBEAT_WEB, now);
+  heartbeats.resume(HEARTBEAT_WIFI, now);
+  heartbeats.resume(HEARTBEAT_MQTT, now);
+  heartbeats.resume(HEARTBEAT_INFLUX, now);
+  LOG_W("ota", "Update aborted - web server, I2C and power save restored");
+}
+
+// /debug/heartbeats: every subsystem's period, time since its last
+// heartbeat, state and how often it stalled and was restarted
+void handleDebugHeartbeats() {
+  uint32_t now = millis();
+  String json = "{\"supervisor\":" + String(supervisorTaskHandle != NULL ? "true" : "false") + ",";
+  json += "\"loopAgeMs\":" + String(now - bootBreadcrumbs.uptimeMs) + ",";
+  json += "\"supervisorResets\":" + String(bootHistory.supervisorResets) + ",";
+  json += "\"heartbeats\":[";
+  for (uint8_t id = 0; id < HEARTBEAT_COUNT; id++) {
+    const Heartbeat& heartbeat = heartbeats.get(id);
+    if (id > 0) json += ",";
+    json += "{\"name\":\"" + String(heartbeatName(id)) + "\",";
+    json += "\"periodMs\":" + String(heartbeat.periodMs) + ",";
+    json += "\"ageMs\":" + String(heartbeats.age(id, now)) + ",";
+    json += "\"state\":\"" + String(heartbeat.suspended ? "suspended" : heartbeat.stalled ? "stalled" : "ok") + "\",";
+    json += "\"stalls\":" + String(heartbeat.stalls) + ",";
+    json += "\"restarts\":" + String(heartbeat.restarts) + "}";
+  }
+  json += "]}";
+
+  server.send(200, "application/json", json);
+}
+
 void enableAP() {
   if (apCurrentlyEnabled) {
     return;  // Already enabled
   }
 
-  Serial.println("\n--- Enabling Access Point ---");
-
   // Re-enable AP mode
   WiFi.mode(WIFI_AP_STA);
   delay(100);
@@ -1264,20 +4152,14 @@ void enableAP() {
   bool result = WiFi.softAP(ap_ssid_unique.c_str(), ap_password, 1, 0, 4);
 
   if (result) {
-    Serial.println("✓ Access Point re-enabled successfully!");
+    LOG_I("ap", "Access point re-enabled: %s at %s", ap_ssid_unique.c_str(), WiFi.softAPIP().toString().c_str());
     apCurrentlyEnabled = true;
   } else {
-    Serial.println("✗ Failed to re-enable Access Point!");
+    LOG_E("ap", "Failed to re-enable access point");
   }
 
   // Restore WiFi TX power
   WiFi.setTxPower(WIFI_TX_POWER);
-
-  Serial.print("AP SSID: ");
-  Serial.println(ap_ssid_unique);
-  Serial.print("AP IP: ");
-  Serial.println(WiFi.softAPIP());
-  Serial.println("--- AP Enabled ---\n");
 }
 
 void disableAP() {
@@ -1285,19 +4167,13 @@ void disableAP() {
     return;  // Already disabled
   }
 
-  Serial.println("\n--- Disabling Access Point ---");
-  Serial.println("Switching to Station-only mode...");
-
   // Switch to STA-only mode (this stops the AP)
   WiFi.mode(WIFI_STA);
   delay(100);
 
   apCurrentlyEnabled = false;
 
-  Serial.println("✓ Access Point disabled");
-  Serial.println("✓ ESP32 WiFi network is no longer broadcasting");
-  Serial.println("Device is now only connected to: " + sta_ssid);
-  Serial.println("--- AP Disabled ---\n");
+  LOG_I("ap", "Access point disabled - station only, connected to %s", sta_ssid.c_str());
 }
 
 String getHTMLPage() {
@@ -0,0 +1,193 @@
+// Adaptive sampling replay (adaptive_sampling.h)
+// Replays synthetic 5 s traces through the same scheduling rule as
+// SensorRegistry::pollAll() and compares the sample-and-hold values the
+// firmware would publish against the ground truth: reads saved vs. a fixed
+// 5 s rate, error of the held values, and how long a real change can go
+// unseen. The traces are generated from a fixed seed, so the numbers
+// reproduce exactly.
+//   pio test -e native -f test_adaptive_replay -v
+
+#include <unity.h>
+
+#include <math.h>
+#include <vector>
+
+#include "adaptive_sampling.h"
+
+static const unsigned long CYCLE_MS = 5000;        // UPDATE_INTERVAL
+static const unsigned long MAX_INTERVAL_MS = 60000;  // ADAPTIVE_MAX_INTERVAL_MS, ESP32-C3
+
+// SHT4x channels
+static const SensorChannel CHANNELS[] = {CHANNEL_TEMPERATURE, CHANNEL_HUMIDITY};
+static const size_t CHANNEL_COUNT_READ = sizeof(CHANNELS) / sizeof(CHANNELS[0]);
+
+struct TracePoint {
+    int32_t temperature;  // 0.01 °C, including sensor noise
+    int32_t humidity;     // 0.01 %RH
+};
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static int32_t noise(int32_t amplitude) {
+    return (int32_t)(nextRandom() % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+// `hours` of 5 s cycles; shape(t) gives the true values at t seconds
+template <typename Shape>
+static std::vector<TracePoint> makeTrace(double hours, Shape shape) {
+    std::vector<TracePoint> trace;
+    for (uint32_t t = 0; t < hours * 3600; t += CYCLE_MS / 1000) {
+        double temperature, humidity;
+        shape(t, temperature, humidity);
+        trace.push_back({(int32_t)lround(temperature * 100) + noise(2), (int32_t)lround(humidity * 100) + noise(3)});
+    }
+    return trace;
+}
+
+struct ReplayResult {
+    uint32_t reads = 0;
+    uint32_t cycles = 0;
+    double maxError[CHANNEL_COUNT_READ] = {};
+    double rmsError[CHANNEL_COUNT_READ] = {};
+    uint32_t longestStaleMs = 0;  // Longest run where a held value was off by more than twice its deadband
+};
+
+static ReplayResult replay(const std::vector<TracePoint>& trace, unsigned long maximumMs) {
+    AdaptiveInterval sampling;
+    sampling.begin(CYCLE_MS, maximumMs);
+    SensorSnapshot held;
+    unsigned long lastRead = 0;
+    ReplayResult result;
+    double squares[CHANNEL_COUNT_READ] = {};
+    uint32_t staleSince = 0;
+    bool stale = false;
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        unsigned long now = 1 + i * CYCLE_MS;
+        // pollAll(): due once the interval has elapsed, allowing 100 ms of jitter
+        if (lastRead == 0 || now - lastRead + 100 >= sampling.current) {
+            lastRead = now;
+            SensorSnapshot reading;
+            reading.set(CHANNEL_TEMPERATURE, trace[i].temperature);
+            reading.set(CHANNEL_HUMIDITY, trace[i].humidity);
+            sampling.update(reading, CHANNELS, CHANNEL_COUNT_READ);
+            held = reading;
+            result.reads++;
+        }
+        result.cycles++;
+
+        bool off = false;
+        const int32_t truth[CHANNEL_COUNT_READ] = {trace[i].temperature, trace[i].humidity};
+        for (size_t c = 0; c < CHANNEL_COUNT_READ; c++) {
+            double error = fabs((double)held.get(CHANNELS[c]) - truth[c]);
+            if (error > result.maxError[c]) result.maxError[c] = error;
+            squares[c] += error * error;
+            off = off || error > 2 * ADAPTIVE_DEADBAND[CHANNELS[c]];
+        }
+        if (off && !stale) {
+            staleSince = now;
+        }
+        stale = off;
+        if (stale && now - staleSince > result.longestStaleMs) {
+            result.longestStaleMs = now - staleSince;
+        }
+    }
+    for (size_t c = 0; c < CHANNEL_COUNT_READ; c++) {
+        result.rmsError[c] = sqrt(squares[c] / result.cycles);
+    }
+    return result;
+}
+
+static void report(const char* name, const ReplayResult& result) {
+    char message[200];
+    snprintf(message, sizeof(message),
+             "%-22s %5.1fx fewer reads (%lu of %lu), temperature max %.2f / rms %.3f °C, humidity max %.2f / rms "
+             "%.3f %%RH, longest stale %lu s",
+             name, (double)result.cycles / result.reads, (unsigned long)result.reads, (unsigned long)result.cycles,
+             result.maxError[0] / 100, result.rmsError[0] / 100, result.maxError[1] / 100, result.rmsError[1] / 100,
+             (unsigned long)(result.longestStaleMs / 1000));
+    TEST_MESSAGE(message);
+}
+
+void setUp(void) { rngState = 2024; }
+void tearDown(void) {}
+
+void test_fixed_rate_reads_every_cycle(void) {
+    std::vector<TracePoint> trace = makeTrace(1, [](uint32_t, double& t, double& h) { t = 21; h = 45; });
+    ReplayResult result = replay(trace, CYCLE_MS);
+    TEST_ASSERT_EQUAL_UINT32(result.cycles, result.reads);
+}
+
+// Night: still air, only sensor noise
+void test_steady_air(void) {
+    std::vector<TracePoint> trace = makeTrace(8, [](uint32_t, double& t, double& h) { t = 19.5; h = 48; });
+    ReplayResult result = replay(trace, MAX_INTERVAL_MS);
+    report("steady", result);
+    TEST_ASSERT_TRUE(result.cycles >= 10 * result.reads);  // Settles at 60 s: 12x
+    TEST_ASSERT_TRUE(result.maxError[0] <= ADAPTIVE_DEADBAND[CHANNEL_TEMPERATURE]);
+    TEST_ASSERT_EQUAL_UINT32(0, result.longestStaleMs);
+}
+
+// Heating from 17 to 21 °C over two hours, with the humidity following
+void test_slow_ramp(void) {
+    std::vector<TracePoint> trace = makeTrace(4, [](uint32_t s, double& t, double& h) {
+        double hours = s / 3600.0;
+        t = 17 + 4 * fmin(fmax(hours - 1, 0), 2) / 2;
+        h = 55 - (t - 17) * 2.5;
+    });
+    ReplayResult result = replay(trace, MAX_INTERVAL_MS);
+    report("slow ramp", result);
+    TEST_ASSERT_TRUE(result.cycles >= 3 * result.reads);
+    TEST_ASSERT_TRUE(result.longestStaleMs <= MAX_INTERVAL_MS);
+}
+
+// Shower next door: +30 %RH within two minutes, then a half-hour decay
+void test_humidity_spike(void) {
+    std::vector<TracePoint> trace = makeTrace(3, [](uint32_t s, double& t, double& h) {
+        double minutes = s / 60.0 - 60;
+        t = 22;
+        h = 50;
+        if (minutes >= 0) {
+            h += 30 * fmin(minutes / 2, 1) * exp(-fmax(minutes - 2, 0) / 30);
+        }
+    });
+    ReplayResult result = replay(trace, MAX_INTERVAL_MS);
+    report("humidity spike", result);
+    TEST_ASSERT_TRUE(result.cycles >= 3 * result.reads);
+    TEST_ASSERT_TRUE(result.longestStaleMs <= MAX_INTERVAL_MS);
+}
+
+// Window opened: -3 °C in five minutes, closed again half an hour later
+void test_temperature_step(void) {
+    std::vector<TracePoint> trace = makeTrace(3, [](uint32_t s, double& t, double& h) {
+        double minutes = s / 60.0;
+        t = 21;
+        if (minutes >= 60 && minutes < 90) {
+            t -= 3 * fmin((minutes - 60) / 5, 1);
+        } else if (minutes >= 90) {
+            t -= 3 * exp(-(minutes - 90) / 10);
+        }
+        h = 45 + (21 - t) * 3;
+    });
+    ReplayResult result = replay(trace, MAX_INTERVAL_MS);
+    report("temperature step", result);
+    TEST_ASSERT_TRUE(result.cycles >= 3 * result.reads);
+    TEST_ASSERT_TRUE(result.longestStaleMs <= MAX_INTERVAL_MS);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_rate_reads_every_cycle);
+    RUN_TEST(test_steady_air);
+    RUN_TEST(test_slow_ramp);
+    RUN_TEST(test_humidity_spike);
+    RUN_TEST(test_temperature_step);
+    return UNITY_END();
+}
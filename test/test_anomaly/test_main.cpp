@@ -0,0 +1,177 @@
+// Anomaly detector replay (anomaly_detector.h)
+// Synthetic indoor devices (daily cycle, HVAC sawtooth, humidity random walk,
+// weather in the pressure, occupancy in the CO2) are replayed at the 5 s
+// sensor cycle: clean traces give the false event rate per device-day, and
+// the same traces with an injected humidity jump or temperature climb give
+// the detection latency. Every device is generated from a fixed seed, so
+// the numbers reproduce exactly.
+//   pio test -e native -f test_anomaly -v
+
+#include <unity.h>
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#include "anomaly_detector.h"
+
+static const uint32_t CYCLE_S = 5;
+static const uint32_t SAMPLES_PER_DAY = 86400 / CYCLE_S;
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// Uniform in [-1, 1)
+static double uniform() { return (nextRandom() >> 8) / (double)(1 << 23) - 1; }
+
+static int32_t noise(int32_t amplitude) {
+    return (int32_t)(nextRandom() % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+// One indoor device; its parameters are drawn from the seed
+struct Room {
+    double phase;         // Daily cycle, fraction of a day
+    double swing;         // Daily temperature swing, °C
+    double hvacPeriod;    // s
+    double hvacAmplitude;  // °C
+    double humidity = 45;  // %RH, random walk
+    double weather = 0;   // hPa offset, random walk
+    double weatherRate = 0;  // hPa per sample
+
+    explicit Room() {
+        phase = (uniform() + 1) / 2;
+        swing = 1 + uniform() * 0.5;
+        hvacPeriod = 1800 + uniform() * 600;
+        hvacAmplitude = 0.3 + uniform() * 0.1;
+    }
+
+    void sample(uint32_t t, SensorSnapshot& readings) {
+        double day = 2 * M_PI * (t / 86400.0 + phase);
+        // Heating runs for the first third of each cycle, then the room cools off
+        double cycle = fmod(t, hvacPeriod) / hvacPeriod;
+        double hvac = cycle < 1.0 / 3 ? cycle * 3 : (1 - cycle) * 1.5;
+        double temperature = 21 + swing * sin(day) + hvacAmplitude * (hvac - 0.5);
+
+        humidity += uniform() * 0.02 + (45 - humidity) / SAMPLES_PER_DAY;
+        weatherRate += uniform() * 0.00002 - weatherRate / 2000;
+        weather += weatherRate;
+
+        // Occupied evenings: CO2 climbs from 450 to 900 ppm and back
+        double occupied = fmax(0, sin(day - 1));
+        readings.set(CHANNEL_TEMPERATURE, (int32_t)lround(temperature * 100) + noise(2));
+        readings.set(CHANNEL_PRESSURE, (int32_t)lround((1013 + weather + 0.4 * sin(2 * day)) * 100) + noise(3));
+        readings.set(CHANNEL_HUMIDITY, (int32_t)lround((humidity - (temperature - 21) * 2.5) * 100) + noise(5));
+        readings.set(CHANNEL_CO2, (int32_t)lround(450 + 450 * occupied * occupied) + noise(5));
+    }
+};
+
+void setUp(void) { rngState = 2024; }
+void tearDown(void) {}
+
+// Events per device-day on clean data
+void test_false_event_rate(void) {
+    const uint32_t devices = 20;
+    const uint32_t days = 14;
+    uint32_t events = 0;
+    uint32_t byChannel[CHANNEL_COUNT] = {};
+    for (uint32_t d = 0; d < devices; d++) {
+        Room room;
+        AnomalyDetector detector;
+        for (uint32_t i = 0; i < days * SAMPLES_PER_DAY; i++) {
+            SensorSnapshot readings;
+            room.sample(i * CYCLE_S, readings);
+            detector.update(readings, i * CYCLE_S, [&](const AnomalyEvent& event) {
+                events++;
+                byChannel[event.channel]++;
+            });
+        }
+    }
+    double rate = (double)events / (devices * days);
+    static char message[160];
+    snprintf(message, sizeof(message),
+             "%lu false events in %lu device-days: %.3f per device-day (temperature %lu, pressure %lu, humidity %lu, "
+             "CO2 %lu)",
+             (unsigned long)events, (unsigned long)(devices * days), rate, (unsigned long)byChannel[CHANNEL_TEMPERATURE],
+             (unsigned long)byChannel[CHANNEL_PRESSURE], (unsigned long)byChannel[CHANNEL_HUMIDITY],
+             (unsigned long)byChannel[CHANNEL_CO2]);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(rate <= 0.07);  // ~0.05 in anomaly_detector.h
+}
+
+// Seconds from `start` to the first event of `type` on `channel`, or
+// UINT32_MAX if none within `limit` seconds. `inject` adds the anomaly.
+template <typename Inject>
+static uint32_t detectionDelay(uint32_t start, uint32_t limit, SensorChannel channel, AnomalyType type,
+                               Inject inject) {
+    Room room;
+    AnomalyDetector detector;
+    uint32_t found = UINT32_MAX;
+    for (uint32_t t = 0; t < start + limit && found == UINT32_MAX; t += CYCLE_S) {
+        SensorSnapshot readings;
+        room.sample(t, readings);
+        if (t >= start) {
+            inject(t - start, readings);
+        }
+        detector.update(readings, t, [&](const AnomalyEvent& event) {
+            if (t >= start && event.channel == channel && event.type == type) {
+                found = t - start;
+            }
+        });
+    }
+    return found;
+}
+
+// Sorts `delays` and reports the median and worst case
+static void reportDelays(const char* name, std::vector<uint32_t>& delays) {
+    std::sort(delays.begin(), delays.end());
+    static char message[160];
+    snprintf(message, sizeof(message), "%s: median %lu s, worst %lu s over %u trials", name,
+             (unsigned long)delays[delays.size() / 2], (unsigned long)delays.back(), (unsigned)delays.size());
+    TEST_MESSAGE(message);
+}
+
+// A leak: humidity jumps by 10 %RH and stays there
+void test_humidity_jump_latency(void) {
+    std::vector<uint32_t> delays;
+    for (uint32_t trial = 0; trial < 20; trial++) {
+        uint32_t start = 86400 + trial * 3931;  // Spread over the day
+        uint32_t delay = detectionDelay(start, 3600, CHANNEL_HUMIDITY, ANOMALY_SPIKE_HIGH,
+                                        [](uint32_t, SensorSnapshot& readings) {
+                                            readings.set(CHANNEL_HUMIDITY, readings.get(CHANNEL_HUMIDITY) + 1000);
+                                        });
+        TEST_ASSERT_TRUE(delay <= 2 * CYCLE_S);
+        delays.push_back(delay);
+    }
+    reportDelays("+10 %RH jump", delays);
+}
+
+// HVAC failure: the temperature climbs 2 °C per hour
+void test_temperature_drift_latency(void) {
+    std::vector<uint32_t> delays;
+    for (uint32_t trial = 0; trial < 20; trial++) {
+        uint32_t start = 86400 + trial * 3931;
+        uint32_t delay = detectionDelay(start, 3 * 3600, CHANNEL_TEMPERATURE, ANOMALY_DRIFT_UP,
+                                        [](uint32_t elapsed, SensorSnapshot& readings) {
+                                            readings.set(CHANNEL_TEMPERATURE,
+                                                         readings.get(CHANNEL_TEMPERATURE) + elapsed * 200 / 3600);
+                                        });
+        TEST_ASSERT_TRUE(delay <= 90 * 60);
+        delays.push_back(delay);
+    }
+    reportDelays("2 C/h climb", delays);
+    TEST_ASSERT_TRUE(delays[delays.size() / 2] <= 40 * 60);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_false_event_rate);
+    RUN_TEST(test_humidity_jump_latency);
+    RUN_TEST(test_temperature_drift_latency);
+    return UNITY_END();
+}
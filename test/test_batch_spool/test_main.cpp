@@ -0,0 +1,289 @@
+// Influx store-and-forward (batch_spool.h, line_protocol.h)
+// The spool on a host directory through the segment log's stdio shim: order,
+// the file and byte limits, resuming after a reboot, and discarding batches
+// a power loss tore or flash corrupted. The line protocol batch: formatting,
+// tag escaping, the monotonic timestamp floor that makes re-sends
+// idempotent, and the longest line the firmware can produce.
+//   pio test -e native -f test_batch_spool
+
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string>
+
+#include "batch_spool.h"
+#include "line_protocol.h"
+#include "../test_segment_log/stdio_fs.h"
+
+static const char* DIRECTORY = "/influx";
+
+static char root[] = "/tmp/batch_spool_XXXXXX";
+static StdioFS fileSystem;
+
+// Distinct payload per batch number
+static std::string batch(int n) {
+    char text[64];
+    snprintf(text, sizeof(text), "environment,device=d temperature=%d.00 %d\n", n, 1760000000 + n);
+    return text;
+}
+
+static bool push(BatchSpool<StdioFS>& spool, int n) {
+    std::string data = batch(n);
+    return spool.push(data.c_str(), data.size());
+}
+
+static std::string peek(BatchSpool<StdioFS>& spool) {
+    char out[256];
+    uint32_t length = spool.peek(out, sizeof(out));
+    return std::string(out, length);
+}
+
+// Path of batch `number` as the spool sees it
+static std::string batchPath(uint32_t number) {
+    char path[48];
+    snprintf(path, sizeof(path), "%s/%08lu.lp", DIRECTORY, (unsigned long)number);
+    return path;
+}
+
+static std::string batchFile(uint32_t number) { return fileSystem.host(batchPath(number).c_str()); }
+
+void setUp(void) {
+    strcpy(root, "/tmp/batch_spool_XXXXXX");
+    TEST_ASSERT_NOT_NULL(mkdtemp(root));
+    fileSystem = StdioFS();
+    fileSystem.begin(root);
+}
+
+void tearDown(void) {
+    std::string command = std::string("rm -rf ") + root;
+    TEST_ASSERT_EQUAL_INT(0, system(command.c_str()));
+}
+
+void test_oldest_first(void) {
+    BatchSpool<StdioFS> spool;
+    TEST_ASSERT_TRUE(spool.begin(fileSystem, DIRECTORY, 8, 4096));
+    TEST_ASSERT_EQUAL_STRING("", peek(spool).c_str());
+    for (int n = 1; n <= 3; n++) {
+        TEST_ASSERT_TRUE(push(spool, n));
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, spool.size());
+    for (int n = 1; n <= 3; n++) {
+        TEST_ASSERT_EQUAL_STRING(batch(n).c_str(), peek(spool).c_str());
+        TEST_ASSERT_EQUAL_STRING(batch(n).c_str(), peek(spool).c_str());  // Until popped
+        spool.pop();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, spool.size());
+    TEST_ASSERT_EQUAL_UINT32(0, spool.bytes());
+    TEST_ASSERT_EQUAL_UINT32(3, spool.getStats().batchesReplayed);
+}
+
+// Over the file limit the oldest batches go
+void test_file_limit(void) {
+    BatchSpool<StdioFS> spool;
+    TEST_ASSERT_TRUE(spool.begin(fileSystem, DIRECTORY, 4, 1 << 20));
+    for (int n = 1; n <= 10; n++) {
+        TEST_ASSERT_TRUE(push(spool, n));
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, spool.size());
+    TEST_ASSERT_EQUAL_UINT32(6, spool.getStats().batchesDropped);
+    TEST_ASSERT_EQUAL_STRING(batch(7).c_str(), peek(spool).c_str());
+    TEST_ASSERT_FALSE(fileSystem.exists(batchPath(6).c_str()));
+}
+
+// Over the byte limit too, but the newest batch always stays
+void test_byte_limit(void) {
+    uint32_t fileBytes = sizeof(BatchSpoolHeader) + batch(1).size();
+    BatchSpool<StdioFS> spool;
+    TEST_ASSERT_TRUE(spool.begin(fileSystem, DIRECTORY, 64, 3 * fileBytes));
+    for (int n = 1; n <= 5; n++) {
+        TEST_ASSERT_TRUE(push(spool, n));
+        TEST_ASSERT_TRUE(spool.bytes() <= 3 * fileBytes);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, spool.size());
+    TEST_ASSERT_EQUAL_UINT32(3 * fileBytes, spool.bytes());
+    TEST_ASSERT_EQUAL_STRING(batch(3).c_str(), peek(spool).c_str());
+
+    BatchSpool<StdioFS> tiny;
+    TEST_ASSERT_TRUE(tiny.begin(fileSystem, "/tiny", 64, 10));
+    TEST_ASSERT_TRUE(push(tiny, 1));
+    TEST_ASSERT_TRUE(push(tiny, 2));
+    TEST_ASSERT_EQUAL_UINT32(1, tiny.size());
+    TEST_ASSERT_EQUAL_STRING(batch(2).c_str(), peek(tiny).c_str());
+}
+
+// A reboot picks up where the spool was, numbering included
+void test_resume_after_reopen(void) {
+    uint32_t bytes;
+    {
+        BatchSpool<StdioFS> spool;
+        TEST_ASSERT_TRUE(spool.begin(fileSystem, DIRECTORY, 8, 4096));
+        for (int n = 1; n <= 4; n++) {
+            TEST_ASSERT_TRUE(push(spool, n));
+        }
+        spool.pop();
+        bytes = spool.bytes();
+    }
+    BatchSpool<StdioFS> spool;
+    TEST_ASSERT_TRUE(spool.begin(fileSystem, DIRECTORY, 8, 4096));
+    TEST_ASSERT_EQUAL_UINT32(3, spool.size());
+    TEST_ASSERT_EQUAL_UINT32(bytes, spool.bytes());
+    TEST_ASSERT_EQUAL_STRING(batch(2).c_str(), peek(spool).c_str());
+
+    TEST_ASSERT_TRUE(push(spool, 5));
+    TEST_ASSERT_TRUE(fileSystem.exists(batchPath(5).c_str()));
+    for (int n = 2; n <= 5; n++) {
+        TEST_ASSERT_EQUAL_STRING(batch(n).c_str(), peek(spool).c_str());
+        spool.pop();
+    }
+
+    // Emptied before the reboot: numbering starts over, nothing is replayed
+    BatchSpool<StdioFS> empty;
+    TEST_ASSERT_TRUE(empty.begin(fileSystem, DIRECTORY, 8, 4096));
+    TEST_ASSERT_EQUAL_UINT32(0, empty.size());
+    TEST_ASSERT_EQUAL_STRING("", peek(empty).c_str());
+}
+
+// Torn by a power loss, or a flipped bit: discarded, never sent
+void test_torn_and_corrupt_batches(void) {
+    BatchSpool<StdioFS> spool;
+    TEST_ASSERT_TRUE(spool.begin(fileSystem, DIRECTORY, 8, 4096));
+    for (int n = 1; n <= 5; n++) {
+        TEST_ASSERT_TRUE(push(spool, n));
+    }
+    // 1: header only; 2: payload cut short; 3: payload bit flip; 4: bad magic
+    TEST_ASSERT_EQUAL_INT(0, truncate(batchFile(1).c_str(), sizeof(BatchSpoolHeader)));
+    TEST_ASSERT_EQUAL_INT(0, truncate(batchFile(2).c_str(), sizeof(BatchSpoolHeader) + 10));
+    FILE* file = fopen(batchFile(3).c_str(), "r+b");
+    fseek(file, sizeof(BatchSpoolHeader) + 5, SEEK_SET);
+    fputc('#', file);
+    fclose(file);
+    file = fopen(batchFile(4).c_str(), "r+b");
+    fputc('X', file);
+    fclose(file);
+
+    BatchSpool<StdioFS> reopened;
+    TEST_ASSERT_TRUE(reopened.begin(fileSystem, DIRECTORY, 8, 4096));
+    TEST_ASSERT_EQUAL_STRING(batch(5).c_str(), peek(reopened).c_str());
+    TEST_ASSERT_EQUAL_UINT32(4, reopened.getStats().batchesCorrupt);
+    TEST_ASSERT_EQUAL_UINT32(1, reopened.size());
+    reopened.pop();
+    TEST_ASSERT_EQUAL_UINT32(0, reopened.bytes());
+}
+
+// A short write (full partition) leaves no file behind
+void test_short_write(void) {
+    BatchSpool<StdioFS> spool;
+    TEST_ASSERT_TRUE(spool.begin(fileSystem, DIRECTORY, 8, 4096));
+    TEST_ASSERT_TRUE(push(spool, 1));
+    fileSystem.writeBudget = sizeof(BatchSpoolHeader) + 4;
+    TEST_ASSERT_FALSE(push(spool, 2));
+    fileSystem.writeBudget = -1;
+    TEST_ASSERT_EQUAL_UINT32(1, spool.getStats().writeErrors);
+    TEST_ASSERT_EQUAL_UINT32(1, spool.size());
+    TEST_ASSERT_FALSE(fileSystem.exists(batchPath(2).c_str()));
+
+    TEST_ASSERT_TRUE(push(spool, 3));
+    TEST_ASSERT_EQUAL_STRING(batch(1).c_str(), peek(spool).c_str());
+    spool.pop();
+    TEST_ASSERT_EQUAL_STRING(batch(3).c_str(), peek(spool).c_str());
+}
+
+static TelemetryRecord record(int32_t temperature, int32_t humidity) {
+    TelemetryRecord result = {};
+    result.values[CHANNEL_TEMPERATURE] = temperature;
+    result.values[CHANNEL_HUMIDITY] = humidity;
+    result.validChannels = (1UL << CHANNEL_TEMPERATURE) | (1UL << CHANNEL_HUMIDITY);
+    return result;
+}
+
+void test_line_format_and_escaping(void) {
+    char name[80];
+    lineProtocolEscapeTag("Living Room, =1", name, sizeof(name));
+    TEST_ASSERT_EQUAL_STRING("Living\\ Room\\,\\ \\=1", name);
+
+    LineProtocolBatch lines;
+    TEST_ASSERT_TRUE(lines.begin(1024));
+    std::string tags = std::string("environment,device=esp32-monitor-a1b2,name=") + name;
+    TEST_ASSERT_EQUAL(LINE_APPENDED, lines.append(tags.c_str(), record(2153, -5), 1760000000));
+    TEST_ASSERT_EQUAL_STRING(
+        "environment,device=esp32-monitor-a1b2,name=Living\\ Room\\,\\ \\=1 temperature=21.53,humidity=-0.05 "
+        "1760000000\n",
+        std::string(lines.data(), lines.size()).c_str());
+
+    TelemetryRecord none = {};
+    TEST_ASSERT_EQUAL(LINE_EMPTY, lines.append(tags.c_str(), none, 1760000001));
+    TEST_ASSERT_EQUAL_UINT16(1, lines.lines());
+}
+
+// Timestamps only move forward, across clear() too: a clock step back never
+// writes a second point for the same series and second
+void test_monotonic_timestamps(void) {
+    LineProtocolBatch lines;
+    TEST_ASSERT_TRUE(lines.begin(1024));
+    TEST_ASSERT_EQUAL(LINE_APPENDED, lines.append("m", record(1, 1), 100));
+    TEST_ASSERT_EQUAL(LINE_DUPLICATE, lines.append("m", record(2, 2), 100));
+    TEST_ASSERT_EQUAL(LINE_DUPLICATE, lines.append("m", record(3, 3), 99));
+    lines.clear();
+    TEST_ASSERT_EQUAL(LINE_DUPLICATE, lines.append("m", record(4, 4), 100));
+    TEST_ASSERT_EQUAL(LINE_APPENDED, lines.append("m", record(5, 5), 101));
+    TEST_ASSERT_EQUAL_UINT16(1, lines.lines());
+    TEST_ASSERT_EQUAL_UINT32(101, lines.getLastTime());
+}
+
+// A full batch refuses the line without advancing the timestamp floor
+void test_full_batch(void) {
+    LineProtocolBatch lines;
+    TEST_ASSERT_TRUE(lines.begin(40));
+    TEST_ASSERT_EQUAL(LINE_APPENDED, lines.append("m", record(1, 1), 100));
+    size_t used = lines.size();
+    TEST_ASSERT_EQUAL(LINE_FULL, lines.append("m", record(2, 2), 101));
+    TEST_ASSERT_EQUAL_size_t(used, lines.size());
+    lines.clear();
+    TEST_ASSERT_EQUAL(LINE_APPENDED, lines.append("m", record(2, 2), 101));
+}
+
+// The longest line the firmware formats: a 32-character name that escapes
+// to 64, every channel at the widest value its sensor can report
+void test_longest_line_fits(void) {
+    char name[80];
+    lineProtocolEscapeTag("================================", name, sizeof(name));
+    std::string tags = std::string("environment,device=esp32-monitor-a1b2,name=") + name;
+
+    TelemetryRecord widest = {};
+    const int32_t values[CHANNEL_COUNT] = {-4000, 110000, -50000, 10000, 40000, -4000, -4000, 10000, -99999};
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+        widest.values[c] = values[c];
+        widest.validChannels |= 1UL << c;
+    }
+    LineProtocolBatch lines;
+    TEST_ASSERT_TRUE(lines.begin(1024));
+    TEST_ASSERT_EQUAL(LINE_APPENDED, lines.append(tags.c_str(), widest, UINT32_MAX));
+    static char message[80];
+    snprintf(message, sizeof(message), "longest line %u of %d bytes", (unsigned)lines.size(),
+             LINE_PROTOCOL_MAX_LINE);
+    TEST_MESSAGE(message);
+
+    // Past the limit: LINE_FULL even on an empty batch, which serviceInflux() drops
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+        widest.values[c] = INT32_MIN;
+    }
+    LineProtocolBatch empty;
+    TEST_ASSERT_TRUE(empty.begin(1024));
+    TEST_ASSERT_EQUAL(LINE_FULL, empty.append(tags.c_str(), widest, UINT32_MAX));
+    TEST_ASSERT_EQUAL_size_t(0, empty.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_oldest_first);
+    RUN_TEST(test_file_limit);
+    RUN_TEST(test_byte_limit);
+    RUN_TEST(test_resume_after_reopen);
+    RUN_TEST(test_torn_and_corrupt_batches);
+    RUN_TEST(test_short_write);
+    RUN_TEST(test_line_format_and_escaping);
+    RUN_TEST(test_monotonic_timestamps);
+    RUN_TEST(test_full_batch);
+    RUN_TEST(test_longest_line_fits);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// Boot history (boot_history.h)
+// Records are numbered and kept newest first up to BOOT_HISTORY_RECORDS,
+// resets are counted per reason (unknown reasons in the "other" slot),
+// crashes() adds supervisor resets to the resets nobody asked for, and the
+// backtrace formats for addr2line without overrunning short buffers.
+//   pio test -e native -f test_boot_history
+
+#include <unity.h>
+
+#include "boot_history.h"
+#include "heartbeat_registry.h"
+
+static BootRecord record(uint8_t reason, uint8_t stalled = BOOT_SUBSYSTEM_NONE) {
+    BootRecord result = {};
+    result.reason = reason;
+    result.loopPhase = BOOT_PHASE_NONE;
+    result.sensorPhase = BOOT_PHASE_NONE;
+    result.stalled = stalled;
+    return result;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_breadcrumbs_reset(void) {
+    BootBreadcrumbs breadcrumbs;
+    memset(&breadcrumbs, 0xA5, sizeof(breadcrumbs));  // RTC memory after a power cycle
+    TEST_ASSERT_FALSE(breadcrumbs.valid());
+    breadcrumbs.reset();
+    TEST_ASSERT_TRUE(breadcrumbs.valid());
+    TEST_ASSERT_EQUAL_UINT8(BOOT_PHASE_NONE, breadcrumbs.loopPhase);
+    TEST_ASSERT_EQUAL_UINT8(BOOT_SUBSYSTEM_NONE, breadcrumbs.stalled);
+    TEST_ASSERT_EQUAL_STRING("", breadcrumbs.route);
+}
+
+// Newest first, numbered, the oldest dropped once full
+void test_add_keeps_newest_first(void) {
+    BootHistory history;
+    for (uint32_t i = 0; i < BOOT_HISTORY_RECORDS + 3; i++) {
+        BootRecord boot = record(BOOT_RESET_SOFTWARE);
+        boot.uptimeS = i;
+        history.add(boot);
+        TEST_ASSERT_EQUAL_UINT8(i + 1 < BOOT_HISTORY_RECORDS ? i + 1 : BOOT_HISTORY_RECORDS, history.count);
+    }
+    TEST_ASSERT_EQUAL_UINT32(BOOT_HISTORY_RECORDS + 3, history.boots);
+    for (uint8_t i = 0; i < BOOT_HISTORY_RECORDS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(BOOT_HISTORY_RECORDS + 3 - i, history.records[i].boot);
+        TEST_ASSERT_EQUAL_UINT32(BOOT_HISTORY_RECORDS + 2 - i, history.records[i].uptimeS);
+    }
+}
+
+void test_reset_counts_and_crashes(void) {
+    BootHistory history;
+    history.add(record(BOOT_RESET_POWERON));
+    history.add(record(BOOT_RESET_PANIC));
+    history.add(record(BOOT_RESET_TASK_WDT));
+    history.add(record(BOOT_RESET_BROWNOUT));
+    history.add(record(BOOT_RESET_SOFTWARE));                  // OTA or /restart
+    history.add(record(BOOT_RESET_SOFTWARE, HEARTBEAT_WIFI));  // The supervisor gave up
+    history.add(record(BOOT_RESET_EXTERNAL));
+    history.add(record(42));                                   // A newer IDF reason
+
+    TEST_ASSERT_EQUAL_UINT32(2, history.resets[BOOT_RESET_SOFTWARE]);
+    TEST_ASSERT_EQUAL_UINT32(1, history.resets[BOOT_RESET_REASON_COUNT]);
+    TEST_ASSERT_EQUAL_UINT32(1, history.supervisorResets);
+    TEST_ASSERT_EQUAL_UINT32(4, history.crashes());  // Panic, task WDT, brown-out, supervisor
+    TEST_ASSERT_EQUAL_STRING("other", bootResetReasonName(42));
+    TEST_ASSERT_TRUE(bootRecordIsSupervisorReset(history.records[2]));
+    TEST_ASSERT_FALSE(bootRecordIsSupervisorReset(history.records[3]));
+}
+
+void test_format_backtrace(void) {
+    BootRecord crash = record(BOOT_RESET_PANIC);
+    char out[80];
+    TEST_ASSERT_EQUAL_size_t(0, bootFormatBacktrace(crash, out, sizeof(out)));  // No core dump
+    TEST_ASSERT_EQUAL_STRING("", out);
+
+    strcpy(crash.task, "loopTask");
+    crash.pc = 0x400d1234;
+    crash.backtrace[0] = 0x400d5678;
+    crash.backtrace[1] = 0x40081abc;
+    crash.backtraceDepth = 2;
+    size_t length = bootFormatBacktrace(crash, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("0x400d1234 0x400d5678 0x40081abc", out);
+    TEST_ASSERT_EQUAL_size_t(strlen(out), length);
+
+    // A depth past the array is clamped
+    crash.backtraceDepth = 200;
+    for (uint8_t i = 0; i < BOOT_BACKTRACE_DEPTH; i++) {
+        crash.backtrace[i] = 0x40080000 + i;
+    }
+    length = bootFormatBacktrace(crash, out, sizeof(out));
+    TEST_ASSERT_EQUAL_size_t(11 * (BOOT_BACKTRACE_DEPTH + 1) - 1, length);
+}
+
+// Short buffers keep whole addresses only, always terminated
+void test_format_backtrace_truncates(void) {
+    BootRecord crash = record(BOOT_RESET_PANIC);
+    strcpy(crash.task, "sensorTask");
+    crash.pc = 0x400d1234;
+    crash.backtrace[0] = 0x400d5678;
+    crash.backtraceDepth = 1;
+    for (size_t size = 1; size <= 24; size++) {
+        char out[32];
+        memset(out, '#', sizeof(out));
+        size_t length = bootFormatBacktrace(crash, out, size);
+        TEST_ASSERT_EQUAL_size_t(strlen(out), length);
+        TEST_ASSERT_TRUE(length < size);
+        TEST_ASSERT_EQUAL_INT('#', out[size]);  // Nothing written past the buffer
+        TEST_ASSERT_EQUAL_size_t(size > 21 ? 21 : size > 10 ? 10 : 0, length);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_breadcrumbs_reset);
+    RUN_TEST(test_add_keeps_newest_first);
+    RUN_TEST(test_reset_counts_and_crashes);
+    RUN_TEST(test_format_backtrace);
+    RUN_TEST(test_format_backtrace_truncates);
+    return UNITY_END();
+}
@@ -0,0 +1,268 @@
+// Compressed block codec: round-trip fuzz and benchmark (sensor_codec.h)
+// Random streams with gaps, clock jumps, dropouts and value jumps of every
+// size must decode to exactly the quantized records that went in. A synthetic
+// indoor trace measures bytes per record and encode/decode throughput.
+//   pio test -e native -f test_codec -v
+
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+#include <vector>
+
+#include "env_math.h"
+#include "sensor_codec.h"
+
+struct Record {
+    uint32_t time;
+    SensorSnapshot snapshot;
+};
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static int32_t randomBetween(int32_t low, int32_t high) {
+    return low + (int32_t)(nextRandom() % (uint32_t)(high - low + 1));
+}
+
+// Value that round-trips through quantize() unchanged
+static int32_t quantized(SensorChannel channel, int32_t value) {
+    return SensorHistory::dequantize(channel, SensorHistory::quantize(channel, value));
+}
+
+static std::vector<Record> fuzzStream(size_t count) {
+    std::vector<Record> records;
+    uint32_t time = nextRandom() % 100000;
+    int32_t values[HISTORY_CHANNEL_COUNT] = {2100, 100000, 5000, 5000, 800, 1200};
+    for (size_t i = 0; i < count; i++) {
+        uint32_t roll = nextRandom() % 100;
+        if (roll < 80) {
+            time += 5;
+        } else if (roll < 90) {
+            time += nextRandom() % 60;  // Jitter, repeats
+        } else if (roll < 97) {
+            time += nextRandom() % 5000;  // Missed cycles
+        } else {
+            time += nextRandom() % 10000000;  // Powered off for days
+        }
+
+        Record record;
+        record.time = time;
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            const HistoryQuantization& q = HISTORY_QUANTIZATION[c];
+            uint32_t jump = nextRandom() % 100;
+            int32_t steps;
+            if (jump < 40) steps = 0;
+            else if (jump < 70) steps = randomBetween(-2, 2);
+            else if (jump < 85) steps = randomBetween(-16, 16);
+            else if (jump < 95) steps = randomBetween(-256, 256);
+            else steps = randomBetween(-70000, 70000);  // Anything, clamped by quantize()
+            values[c] += steps * q.step;
+            int32_t low = q.offset + (HISTORY_MISSING + 1) * q.step;
+            int32_t high = q.offset + INT16_MAX * q.step;
+            values[c] = values[c] < low ? low : (values[c] > high ? high : values[c]);
+            if (nextRandom() % 20 != 0) {  // Dropouts
+                record.snapshot.set((SensorChannel)c, quantized((SensorChannel)c, values[c]));
+            }
+        }
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Slow indoor days: diurnal temperature, humidity that follows it, weather
+// pressure, CO2 with occupancy, plus +-`noise` LSBs of sensor noise (1 is
+// typical of the BMP280 / SHT4x at their oversampling settings)
+static std::vector<Record> indoorTrace(size_t count, int32_t noise) {
+    std::vector<Record> records;
+    double temperature = 21.0;
+    double pressure = 1012.0;
+    double co2 = 600;
+    for (size_t i = 0; i < count; i++) {
+        double hours = i * 5.0 / 3600.0;
+        temperature += 0.002 * ((int32_t)(nextRandom() % 3) - 1);
+        pressure += 0.001 * ((int32_t)(nextRandom() % 3) - 1);
+        bool occupied = fmod(hours, 24.0) > 8 && fmod(hours, 24.0) < 22;
+        co2 += occupied ? 0.05 : -0.03;
+        co2 = co2 < 420 ? 420 : (co2 > 2000 ? 2000 : co2);
+
+        Record record;
+        record.time = 1000 + (uint32_t)i * 5;
+        int32_t t = (int32_t)((temperature + 1.5 * sin(hours * M_PI / 12.0)) * 100) + randomBetween(-noise, noise);
+        int32_t rh = 4500 - (t - 2100) * 2 + randomBetween(-noise, noise);
+        int32_t p = (int32_t)(pressure * 100) + randomBetween(-noise, noise);
+        record.snapshot.set(CHANNEL_TEMPERATURE, t);
+        record.snapshot.set(CHANNEL_PRESSURE, quantized(CHANNEL_PRESSURE, p));
+        record.snapshot.set(CHANNEL_ALTITUDE, quantized(CHANNEL_ALTITUDE, altitudeCm(p)));
+        record.snapshot.set(CHANNEL_HUMIDITY, rh);
+        record.snapshot.set(CHANNEL_CO2, quantized(CHANNEL_CO2, (int32_t)co2 + randomBetween(-2 * noise, 2 * noise)));
+        record.snapshot.set(CHANNEL_DEW_POINT, dewPointCenti(t, rh));
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Encodes into as many blocks as needed, sealing each
+static std::vector<SensorBlock> encode(const std::vector<Record>& records) {
+    std::vector<SensorBlock> blocks(1);
+    SensorBlockEncoder encoder;
+    encoder.begin(&blocks.back());
+    for (const Record& record : records) {
+        if (!encoder.append(record.time, record.snapshot)) {
+            encoder.seal();
+            blocks.emplace_back();
+            encoder.begin(&blocks.back());
+            TEST_ASSERT_TRUE(encoder.append(record.time, record.snapshot));
+        }
+    }
+    encoder.seal();
+    return blocks;
+}
+
+static void assertSameRecord(const Record& expected, uint32_t time, const SensorSnapshot& snapshot) {
+    TEST_ASSERT_EQUAL_UINT32(expected.time, time);
+    TEST_ASSERT_EQUAL_UINT32(expected.snapshot.validChannels, snapshot.validChannels);
+    for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+        if (expected.snapshot.has((SensorChannel)c)) {
+            TEST_ASSERT_EQUAL_INT32(expected.snapshot.get((SensorChannel)c), snapshot.get((SensorChannel)c));
+        }
+    }
+}
+
+static void assertRoundTrip(const std::vector<Record>& records, const std::vector<SensorBlock>& blocks) {
+    size_t next = 0;
+    for (const SensorBlock& block : blocks) {
+        TEST_ASSERT_TRUE(SensorBlockDecoder::isValid(block));
+        SensorBlockDecoder decoder(block);
+        uint32_t time;
+        SensorSnapshot snapshot;
+        while (decoder.next(time, snapshot)) {
+            TEST_ASSERT_TRUE(next < records.size());
+            assertSameRecord(records[next++], time, snapshot);
+        }
+    }
+    TEST_ASSERT_EQUAL_size_t(records.size(), next);
+}
+
+void setUp(void) { rngState = 0x1234567; }
+void tearDown(void) {}
+
+void test_round_trip_fuzz(void) {
+    for (int stream = 0; stream < 50; stream++) {
+        std::vector<Record> records = fuzzStream(2000);
+        assertRoundTrip(records, encode(records));
+    }
+}
+
+void test_round_trip_through_ring(void) {
+    std::vector<Record> records = fuzzStream(5000);
+    SensorBlockRing ring;
+    TEST_ASSERT_TRUE(ring.begin(4));
+    std::vector<SensorBlock> sealed;
+    for (const Record& record : records) {
+        const SensorBlock* block = ring.append(record.time, record.snapshot);
+        if (block != NULL) {
+            sealed.push_back(*block);  // Copied before the ring wraps around to it
+        }
+    }
+    const SensorBlock* last = ring.flush();
+    TEST_ASSERT_NOT_NULL(last);
+    sealed.push_back(*last);
+    TEST_ASSERT_EQUAL_UINT32(records.size(), ring.getRecordsTotal());
+    assertRoundTrip(records, sealed);
+}
+
+void test_corruption_is_detected(void) {
+    std::vector<Record> records = fuzzStream(500);
+    std::vector<SensorBlock> blocks = encode(records);
+    SensorBlock& block = blocks[0];
+    for (uint16_t bit = 0; bit < block.header.bits; bit += 7) {
+        SensorBlock copy = block;
+        copy.payload[bit >> 3] ^= (uint8_t)(0x80 >> (bit & 7));
+        TEST_ASSERT_FALSE(SensorBlockDecoder::isValid(copy));
+
+        // Decoding it anyway stays inside the block
+        SensorBlockDecoder decoder(copy);
+        uint32_t time;
+        SensorSnapshot snapshot;
+        while (decoder.next(time, snapshot)) {
+        }
+    }
+    SensorBlock copy = block;
+    copy.header.lastTime++;
+    TEST_ASSERT_FALSE(SensorBlockDecoder::isValid(copy));
+}
+
+// Bytes per record of a week-long trace with +-`noise` LSBs of sensor noise
+static double measureTrace(int32_t noise, bool timed) {
+    const size_t RECORDS = 17280 * 7;  // A week of 5 s cycles
+    std::vector<Record> records = indoorTrace(RECORDS, noise);
+
+    std::vector<SensorBlock> blocks;
+    double encodeNs = 0;
+    const int ROUNDS = timed ? 5 : 1;
+    for (int round = 0; round < ROUNDS; round++) {
+        auto start = std::chrono::steady_clock::now();
+        blocks = encode(records);
+        encodeNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    encodeNs /= ROUNDS * (double)RECORDS;
+
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (const SensorBlock& block : blocks) {
+            SensorBlockDecoder decoder(block);
+            uint32_t time;
+            SensorSnapshot snapshot;
+            while (decoder.next(time, snapshot)) {
+                checksum += time + (uint32_t)snapshot.values[CHANNEL_TEMPERATURE];
+            }
+        }
+    }
+    double decodeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                      (ROUNDS * (double)RECORDS);
+    assertRoundTrip(records, blocks);
+
+    double bytesPerRecord = blocks.size() * (double)SENSOR_BLOCK_SIZE / RECORDS;
+    double floatRecord = sizeof(uint32_t) + HISTORY_CHANNEL_COUNT * sizeof(float);
+    char message[160];
+    snprintf(message, sizeof(message),
+             "noise +-%d: %u records in %u blocks, %.2f bytes/record: %.1fx the raw ring (%u B), %.1fx float records (%.0f B)",
+             (int)noise, (unsigned)RECORDS, (unsigned)blocks.size(), bytesPerRecord,
+             SensorHistory::bytesPerRecord() / bytesPerRecord, (unsigned)SensorHistory::bytesPerRecord(),
+             floatRecord / bytesPerRecord, floatRecord);
+    TEST_MESSAGE(message);
+    if (timed) {
+        snprintf(message, sizeof(message), "encode %.0f ns/record (%.1f M/s), decode %.0f ns/record (%.1f M/s) [%llu]",
+                 encodeNs, 1000.0 / encodeNs, decodeNs, 1000.0 / decodeNs, (unsigned long long)(checksum & 0xFF));
+        TEST_MESSAGE(message);
+    }
+    return bytesPerRecord;
+}
+
+void test_benchmark_indoor_trace(void) {
+    // README: about 3 bytes per record, ~5x the raw ring, and more than 8x
+    // over records of raw floats
+    double bytesPerRecord = measureTrace(1, true);
+    TEST_ASSERT_TRUE(bytesPerRecord <= 3.2);
+    TEST_ASSERT_TRUE((sizeof(uint32_t) + HISTORY_CHANNEL_COUNT * sizeof(float)) / bytesPerRecord >= 8.0);
+
+    measureTrace(0, false);  // Perfectly quiet sensors
+    measureTrace(2, false);  // Noisier ones: every channel changes every record
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_fuzz);
+    RUN_TEST(test_round_trip_through_ring);
+    RUN_TEST(test_corruption_is_detected);
+    RUN_TEST(test_benchmark_indoor_trace);
+    return UNITY_END();
+}
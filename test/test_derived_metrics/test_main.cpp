@@ -0,0 +1,221 @@
+// Pressure tendency regression (derived_metrics.h)
+// SlidingTrend keeps its least-squares sums in O(1) per sample; every
+// change() is compared with a fit recomputed from scratch over the same
+// window, while the ring fills, wraps many times and after a reset. Through
+// DerivedMetrics the same holds for an irregular sample stream whose
+// skipped minute slots updateTrend() fills with the held value.
+//   pio test -e native -f test_derived_metrics
+
+#include <unity.h>
+
+#include <math.h>
+#include <vector>
+
+#include "derived_metrics.h"
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static int32_t randomBetween(int32_t low, int32_t high) {
+    return low + (int32_t)(nextRandom() % (uint32_t)(high - low + 1));
+}
+
+// Least-squares change across PRESSURE_TREND_WINDOW samples, from the last
+// min(size, window) values, with change()'s rounding
+static int32_t bruteForceChange(const std::vector<int32_t>& values) {
+    size_t n = values.size() < PRESSURE_TREND_WINDOW ? values.size() : PRESSURE_TREND_WINDOW;
+    size_t start = values.size() - n;
+    int64_t sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (size_t x = 0; x < n; x++) {
+        int64_t y = values[start + x];
+        sumX += x;
+        sumY += y;
+        sumXX += (int64_t)(x * x);
+        sumXY += (int64_t)x * y;
+    }
+    int64_t numerator = ((int64_t)n * sumXY - sumX * sumY) * PRESSURE_TREND_WINDOW;
+    int64_t denominator = (int64_t)n * sumXX - sumX * sumX;
+    return (int32_t)((numerator + (numerator >= 0 ? denominator / 2 : -denominator / 2)) / denominator);
+}
+
+// The same fit in floating point, as a check on the integer formula itself
+static double floatChange(const std::vector<int32_t>& values) {
+    size_t n = values.size() < PRESSURE_TREND_WINDOW ? values.size() : PRESSURE_TREND_WINDOW;
+    size_t start = values.size() - n;
+    double meanX = (n - 1) / 2.0, meanY = 0;
+    for (size_t x = 0; x < n; x++) {
+        meanY += values[start + x];
+    }
+    meanY /= n;
+    double sxy = 0, sxx = 0;
+    for (size_t x = 0; x < n; x++) {
+        sxy += (x - meanX) * (values[start + x] - meanY);
+        sxx += (x - meanX) * (x - meanX);
+    }
+    return sxy / sxx * PRESSURE_TREND_WINDOW;
+}
+
+void setUp(void) { rngState = 2024; }
+void tearDown(void) {}
+
+void test_needs_two_samples(void) {
+    SlidingTrend trend;
+    trend.reset();
+    int32_t change = 12345;
+    TEST_ASSERT_FALSE(trend.change(change));
+    trend.add(101325);
+    TEST_ASSERT_FALSE(trend.change(change));
+    trend.add(101335);
+    TEST_ASSERT_TRUE(trend.change(change));
+    TEST_ASSERT_EQUAL_INT32(10 * PRESSURE_TREND_WINDOW, change);
+}
+
+// Weather-like random walk with fronts, through several window wraps
+void test_sliding_matches_brute_force(void) {
+    SlidingTrend trend;
+    trend.reset();
+    std::vector<int32_t> values;
+    int32_t pressure = 101325;
+    int32_t drift = 0;
+    for (int i = 0; i < 10 * PRESSURE_TREND_WINDOW + 37; i++) {
+        if (i % 400 == 0) {
+            drift = randomBetween(-8, 8);  // Pa per minute
+        }
+        pressure += drift + randomBetween(-5, 5);
+        trend.add(pressure);
+        values.push_back(pressure);
+        TEST_ASSERT_EQUAL_UINT16(values.size() < PRESSURE_TREND_WINDOW ? values.size() : PRESSURE_TREND_WINDOW,
+                                 trend.size());
+        if (values.size() < 2) {
+            continue;
+        }
+        int32_t change;
+        TEST_ASSERT_TRUE(trend.change(change));
+        TEST_ASSERT_EQUAL_INT32(bruteForceChange(values), change);
+        TEST_ASSERT_TRUE(fabs(change - floatChange(values)) <= 0.5 + 1e-6);
+    }
+}
+
+// Extreme inputs keep the sums inside int64 and the fit exact
+void test_extreme_values(void) {
+    SlidingTrend trend;
+    trend.reset();
+    std::vector<int32_t> values;
+    for (int i = 0; i < 3 * PRESSURE_TREND_WINDOW; i++) {
+        int32_t value = i % 2 == 0 ? 1100000 : 0;  // 11000 hPa swings
+        trend.add(value);
+        values.push_back(value);
+        int32_t change;
+        if (trend.change(change)) {
+            TEST_ASSERT_EQUAL_INT32(bruteForceChange(values), change);
+        }
+    }
+}
+
+// A reset starts a fresh window: nothing from before it leaks into the sums
+void test_reset(void) {
+    SlidingTrend trend;
+    trend.reset();
+    for (int i = 0; i < PRESSURE_TREND_WINDOW + 50; i++) {
+        trend.add(100000 + i * 7);
+    }
+    trend.reset();
+    std::vector<int32_t> values;
+    for (int i = 0; i < PRESSURE_TREND_WINDOW + 10; i++) {
+        int32_t value = 101000 - i * 3 + randomBetween(-2, 2);
+        trend.add(value);
+        values.push_back(value);
+    }
+    int32_t change;
+    TEST_ASSERT_TRUE(trend.change(change));
+    TEST_ASSERT_EQUAL_INT32(bruteForceChange(values), change);
+}
+
+// Sensor cycles at irregular times (adaptive sampling skips up to minutes,
+// one outage longer than the window): every minute slot gets the value
+// held at its start, and the published tendency is the fit over them
+void test_slot_gaps_match_brute_force(void) {
+    DerivedMetrics metrics;
+    std::vector<int32_t> slots;  // Expected value per minute slot
+    uint32_t now = 1000;
+    int32_t pressure = 101325;
+    int32_t held = 0;
+    bool started = false;
+    uint32_t lastSlot = 0;
+    int published = 0;
+    for (int cycle = 0; cycle < 20000; cycle++) {
+        uint32_t r = nextRandom() % 100;
+        now += r < 80 ? 5 : r < 98 ? 5 * randomBetween(2, 60) : (cycle % 2 == 0 ? 30 : 15000);
+        pressure += randomBetween(-20, 20);
+
+        SensorSnapshot readings;
+        readings.set(CHANNEL_PRESSURE, pressure);
+        metrics.update(readings, now);
+
+        uint32_t slot = now / PRESSURE_TREND_SLOT_SECONDS;
+        if (!started || slot != lastSlot) {
+            if (started) {
+                uint32_t skipped = slot - lastSlot - 1;
+                for (uint32_t i = 0; i < skipped && i < PRESSURE_TREND_WINDOW; i++) {
+                    slots.push_back(held);
+                }
+            }
+            held = pressure;
+            slots.push_back(held);
+            lastSlot = slot;
+            started = true;
+        }
+
+        size_t covered = slots.size() < PRESSURE_TREND_WINDOW ? slots.size() : PRESSURE_TREND_WINDOW;
+        TEST_ASSERT_EQUAL(covered >= PRESSURE_TREND_MIN_SAMPLES, readings.has(CHANNEL_PRESSURE_TREND));
+        if (readings.has(CHANNEL_PRESSURE_TREND)) {
+            TEST_ASSERT_EQUAL_INT32(bruteForceChange(slots), readings.get(CHANNEL_PRESSURE_TREND));
+            published++;
+        }
+    }
+    TEST_ASSERT_TRUE(published > 10000);
+}
+
+// A detached sensor drops the window; the tendency returns after 30 minutes
+void test_detach_restarts_window(void) {
+    DerivedMetrics metrics;
+    uint32_t now = 0;
+    for (int i = 0; i < 2 * PRESSURE_TREND_WINDOW; i++, now += 60) {
+        SensorSnapshot readings;
+        readings.set(CHANNEL_PRESSURE, 101325 + i);
+        metrics.update(readings, now);
+        TEST_ASSERT_EQUAL(i + 1 >= PRESSURE_TREND_MIN_SAMPLES, readings.has(CHANNEL_PRESSURE_TREND));
+    }
+    SensorSnapshot missing;
+    metrics.update(missing, now);
+    TEST_ASSERT_FALSE(missing.has(CHANNEL_PRESSURE_TREND));
+
+    // Only the new, falling samples count
+    for (int i = 0; i < PRESSURE_TREND_MIN_SAMPLES; i++) {
+        now += 60;
+        SensorSnapshot readings;
+        readings.set(CHANNEL_PRESSURE, 100000 - 2 * i);
+        metrics.update(readings, now);
+        TEST_ASSERT_EQUAL(i + 1 == PRESSURE_TREND_MIN_SAMPLES, readings.has(CHANNEL_PRESSURE_TREND));
+        if (readings.has(CHANNEL_PRESSURE_TREND)) {
+            TEST_ASSERT_EQUAL_INT32(-2 * PRESSURE_TREND_WINDOW, readings.get(CHANNEL_PRESSURE_TREND));
+        }
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_needs_two_samples);
+    RUN_TEST(test_sliding_matches_brute_force);
+    RUN_TEST(test_extreme_values);
+    RUN_TEST(test_reset);
+    RUN_TEST(test_slot_gaps_match_brute_force);
+    RUN_TEST(test_detach_restarts_window);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+// Fixed-point environmental math: accuracy and benchmark (env_math.h)
+// Sweeps each integer function over its operating range against the float
+// reference formulas the tables were generated from, checks the maximum
+// errors stated in env_math.h, and times both versions.
+//   pio test -e native -f test_env_math -v
+
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+
+#include "env_math.h"
+
+// ============================================
+// Float references
+// ============================================
+static double magnusPressure(double celsius) { return 611.2 * exp(17.62 * celsius / (243.12 + celsius)); }
+
+static double magnusDewPoint(double celsius, double humidity) {
+    double gamma = log(humidity / 100.0) + 17.62 * celsius / (243.12 + celsius);
+    return 243.12 * gamma / (17.62 - gamma);
+}
+
+static double absoluteHumidity(double celsius, double humidity) {
+    return magnusPressure(celsius) * humidity / 100.0 * 2.1668 / (celsius + 273.15);
+}
+
+static double altitudeMeters(double pascals) { return 44330.0 * (1.0 - pow(pascals / 101325.0, 0.1903)); }
+
+// NWS heat index; `regression` tells which formula was used
+static double nwsHeatIndex(double celsius, double humidity, bool& regression, double& switchOver) {
+    double t = celsius * 1.8 + 32.0;
+    double heat = 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + humidity * 0.094);
+    switchOver = (heat + t) / 2.0;
+    regression = switchOver >= 80.0;
+    if (regression) {
+        heat = -42.379 + 2.04901523 * t + 10.14333127 * humidity - 0.22475541 * t * humidity -
+               0.00683783 * t * t - 0.05481717 * humidity * humidity + 0.00122874 * t * t * humidity +
+               0.00085282 * t * humidity * humidity - 0.00000199 * t * t * humidity * humidity;
+        if (humidity < 13 && t >= 80 && t <= 112) {
+            heat -= (13 - humidity) / 4 * sqrt((17 - fabs(t - 95)) / 17);
+        } else if (humidity > 85 && t >= 80 && t <= 87) {
+            heat += (humidity - 85) / 10 * (87 - t) / 5;
+        }
+    }
+    return (heat - 32.0) / 1.8;
+}
+
+static char message[160];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_dew_point_accuracy(void) {
+    double worst = 0;
+    int32_t worstT = 0, worstRh = 0;
+    for (int32_t t = -4000; t <= 8500; t += 5) {
+        for (int32_t rh = 100; rh <= 10000; rh += 5) {
+            double reference = magnusDewPoint(t / 100.0, rh / 100.0);
+            int32_t dewPoint = dewPointCenti(t, rh);
+            if (reference < VAPOR_LUT_MIN_C) {
+                TEST_ASSERT_EQUAL_INT32(VAPOR_LUT_MIN_C * 100, dewPoint);  // Clamped, as documented
+                continue;
+            }
+            double error = fabs(dewPoint / 100.0 - reference);
+            if (error > worst) {
+                worst = error;
+                worstT = t;
+                worstRh = rh;
+            }
+        }
+    }
+    snprintf(message, sizeof(message), "dew point: max error %.4f °C at %.2f °C, %.2f %%RH", worst, worstT / 100.0,
+             worstRh / 100.0);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst <= 0.032);
+}
+
+void test_absolute_humidity_accuracy(void) {
+    double worst = 0;
+    for (int32_t t = -4000; t <= 4500; t += 5) {
+        for (int32_t rh = 0; rh <= 10000; rh += 10) {
+            double error = fabs(absoluteHumidityCenti(t, rh) / 100.0 - absoluteHumidity(t / 100.0, rh / 100.0));
+            if (error > worst) worst = error;
+        }
+    }
+    snprintf(message, sizeof(message), "absolute humidity: max error %.4f g/m3", worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst <= 0.02);
+}
+
+void test_heat_index_accuracy(void) {
+    double worst = 0;
+    uint32_t skipped = 0;
+    for (int32_t t = -4000; t <= 4500; t += 5) {
+        for (int32_t rh = 0; rh <= 10000; rh += 10) {
+            bool regression;
+            double switchOver;
+            double reference = nwsHeatIndex(t / 100.0, rh / 100.0, regression, switchOver);
+            if (fabs(switchOver - 80.0) < 0.02) {
+                skipped++;  // The two versions may pick different formulas here
+                continue;
+            }
+            double error = fabs(heatIndexCenti(t, rh) / 100.0 - reference);
+            if (error > worst) worst = error;
+        }
+    }
+    snprintf(message, sizeof(message), "heat index: max error %.4f °C (%lu points at the 80 °F switch-over skipped)",
+             worst, (unsigned long)skipped);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst <= 0.03);
+}
+
+void test_altitude_accuracy(void) {
+    double worst = 0;
+    for (int32_t p = 30000; p <= 110000; p++) {
+        double error = fabs(altitudeCm(p) / 100.0 - altitudeMeters(p));
+        if (error > worst) worst = error;
+    }
+    snprintf(message, sizeof(message), "altitude: max error %.3f m", worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst <= 0.21);
+}
+
+void test_format_fixed(void) {
+    char text[FIXED_TEXT_SIZE];
+    formatFixed(text, sizeof(text), 2155, 2, 1);
+    TEST_ASSERT_EQUAL_STRING("21.6", text);
+    formatFixed(text, sizeof(text), -2155, 2, 1);
+    TEST_ASSERT_EQUAL_STRING("-21.6", text);
+    formatFixed(text, sizeof(text), -4, 2, 1);
+    TEST_ASSERT_EQUAL_STRING("0.0", text);  // No "-0.0"
+    formatFixed(text, sizeof(text), 7, 2, 2);
+    TEST_ASSERT_EQUAL_STRING("0.07", text);
+    formatFixed(text, sizeof(text), 1350, 0, 0);
+    TEST_ASSERT_EQUAL_STRING("1350", text);
+    TEST_ASSERT_EQUAL_INT(12, formatFixed(text, sizeof(text), INT32_MIN, 4, 4));
+    TEST_ASSERT_EQUAL_STRING("-214748.3648", text);
+    formatFixed(text, sizeof(text), INT32_MIN, 4, 0);
+    TEST_ASSERT_EQUAL_STRING("-214748", text);
+    formatFixed(text, sizeof(text), INT32_MAX, 2, 1);
+    TEST_ASSERT_EQUAL_STRING("21474836.5", text);
+
+    char small[4];
+    TEST_ASSERT_EQUAL_INT(6, formatFixed(small, sizeof(small), -2155, 2, 2));  // Length it needed
+    TEST_ASSERT_EQUAL_STRING("-21", small);
+}
+
+// ============================================
+// Benchmark
+// ============================================
+static volatile int64_t sink;
+
+template <typename Fn>
+static double nsPerCall(Fn&& fn) {
+    const int ROUNDS = 20;
+    auto start = std::chrono::steady_clock::now();
+    uint32_t calls = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int32_t t = -4000; t <= 8500; t += 50) {
+            for (int32_t rh = 500; rh <= 10000; rh += 500) {
+                fn(t, rh);
+                calls++;
+            }
+        }
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+void test_benchmark(void) {
+    double integerDew = nsPerCall([](int32_t t, int32_t rh) { sink = sink + dewPointCenti(t, rh); });
+    double floatDew = nsPerCall([](int32_t t, int32_t rh) { sink = sink + (int64_t)magnusDewPoint(t / 100.0, rh / 100.0); });
+    double integerHeat = nsPerCall([](int32_t t, int32_t rh) { sink = sink + heatIndexCenti(t, rh); });
+    double floatHeat = nsPerCall([](int32_t t, int32_t rh) {
+        bool regression;
+        double switchOver;
+        sink = sink + (int64_t)nwsHeatIndex(t / 100.0, rh / 100.0, regression, switchOver);
+    });
+    double integerAltitude = nsPerCall([](int32_t t, int32_t rh) { sink = sink + altitudeCm(30000 + t * 4 + rh); });
+    double floatAltitude =
+        nsPerCall([](int32_t t, int32_t rh) { sink = sink + (int64_t)altitudeMeters(30000 + t * 4 + rh); });
+
+    // Host timings: an FPU makes the float versions look far better than on
+    // the ESP32-C3, where every float operation is a libgcc call
+    snprintf(message, sizeof(message), "dew point: %.1f ns integer, %.1f ns float", integerDew, floatDew);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "heat index: %.1f ns integer, %.1f ns float", integerHeat, floatHeat);
+    TEST_MESSAGE(message);
+    snprintf(message, sizeof(message), "altitude: %.1f ns integer, %.1f ns float", integerAltitude, floatAltitude);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_dew_point_accuracy);
+    RUN_TEST(test_absolute_humidity_accuracy);
+    RUN_TEST(test_heat_index_accuracy);
+    RUN_TEST(test_altitude_accuracy);
+    RUN_TEST(test_format_fixed);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+// Heartbeat registry state machine (heartbeat_registry.h)
+// Drives check() through stall -> restart -> recover and stall -> fail on
+// a simulated clock, including across the millis() wrap and with the owner
+// beating after the supervisor read the clock.
+//   pio test -e native -f test_heartbeat
+
+#include <unity.h>
+
+#include "heartbeat_registry.h"
+
+static const uint32_t PERIOD = 10000;
+
+static HeartbeatRegistry heartbeats;
+
+void setUp(void) { heartbeats = HeartbeatRegistry(); }
+void tearDown(void) {}
+
+void test_unregistered_is_ok(void) {
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_MQTT, 1000000));
+    TEST_ASSERT_FALSE(heartbeats.takeRestart(HEARTBEAT_MQTT));
+}
+
+void test_beating_stays_ok(void) {
+    heartbeats.add(HEARTBEAT_WEB, PERIOD, 0);
+    for (uint32_t now = 1000; now < 100000; now += 1000) {
+        heartbeats.beat(HEARTBEAT_WEB, now - 500);
+        TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_WEB, now));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, heartbeats.get(HEARTBEAT_WEB).stalls);
+}
+
+// Overdue: restart requested once, then restarting until it beats again
+void test_stall_restart_recover(void) {
+    heartbeats.add(HEARTBEAT_WEB, PERIOD, 0);
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_WEB, PERIOD));
+    TEST_ASSERT_EQUAL(HEARTBEAT_STALLED, heartbeats.check(HEARTBEAT_WEB, PERIOD + 1));
+    TEST_ASSERT_EQUAL(HEARTBEAT_RESTARTING, heartbeats.check(HEARTBEAT_WEB, PERIOD + 1000));
+
+    TEST_ASSERT_TRUE(heartbeats.takeRestart(HEARTBEAT_WEB));
+    TEST_ASSERT_FALSE(heartbeats.takeRestart(HEARTBEAT_WEB));
+
+    heartbeats.beat(HEARTBEAT_WEB, PERIOD + 2000);
+    TEST_ASSERT_EQUAL(HEARTBEAT_RECOVERED, heartbeats.check(HEARTBEAT_WEB, PERIOD + 3000));
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_WEB, PERIOD + 4000));
+
+    const Heartbeat& heartbeat = heartbeats.get(HEARTBEAT_WEB);
+    TEST_ASSERT_EQUAL_UINT32(1, heartbeat.stalls);
+    TEST_ASSERT_EQUAL_UINT32(1, heartbeat.restarts);
+    TEST_ASSERT_FALSE(heartbeat.stalled);
+}
+
+// Still overdue one period after the stall: reset the device
+void test_stall_then_fail(void) {
+    heartbeats.add(HEARTBEAT_WIFI, PERIOD, 0);
+    uint32_t stalledAt = PERIOD + 1;
+    TEST_ASSERT_EQUAL(HEARTBEAT_STALLED, heartbeats.check(HEARTBEAT_WIFI, stalledAt));
+    TEST_ASSERT_EQUAL(HEARTBEAT_RESTARTING, heartbeats.check(HEARTBEAT_WIFI, stalledAt + PERIOD));
+    TEST_ASSERT_EQUAL(HEARTBEAT_FAILED, heartbeats.check(HEARTBEAT_WIFI, stalledAt + PERIOD + 1));
+}
+
+// A suspended heartbeat never stalls; resume() restarts its clock
+void test_suspend_and_resume(void) {
+    heartbeats.add(HEARTBEAT_MQTT, PERIOD, 0);
+    heartbeats.suspend(HEARTBEAT_MQTT);
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_MQTT, 10 * PERIOD));
+    heartbeats.resume(HEARTBEAT_MQTT, 10 * PERIOD);
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_MQTT, 11 * PERIOD));
+    TEST_ASSERT_EQUAL(HEARTBEAT_STALLED, heartbeats.check(HEARTBEAT_MQTT, 11 * PERIOD + 1));
+}
+
+// Blocked behind another subsystem: not this one's stall
+void test_waiting_is_not_a_stall(void) {
+    heartbeats.add(HEARTBEAT_INFLUX, PERIOD, 0);
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_INFLUX, 3 * PERIOD, true));
+    TEST_ASSERT_EQUAL(0, heartbeats.get(HEARTBEAT_INFLUX).stalls);
+    TEST_ASSERT_EQUAL(HEARTBEAT_STALLED, heartbeats.check(HEARTBEAT_INFLUX, 3 * PERIOD, false));
+}
+
+// millis() wraps after 49.7 days; ages are modulo 2^32
+void test_millis_wrap(void) {
+    uint32_t start = UINT32_MAX - 4000;
+    heartbeats.add(HEARTBEAT_OTA, PERIOD, start);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD, heartbeats.age(HEARTBEAT_OTA, start + PERIOD));
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_OTA, start + PERIOD));
+    TEST_ASSERT_EQUAL(HEARTBEAT_STALLED, heartbeats.check(HEARTBEAT_OTA, start + PERIOD + 1));
+
+    // The grace period also runs across the wrap
+    uint32_t stalledAt = start + PERIOD + 1;
+    TEST_ASSERT_EQUAL(HEARTBEAT_RESTARTING, heartbeats.check(HEARTBEAT_OTA, stalledAt + PERIOD));
+    TEST_ASSERT_EQUAL(HEARTBEAT_FAILED, heartbeats.check(HEARTBEAT_OTA, stalledAt + PERIOD + 1));
+}
+
+// The owner beat after the supervisor read millis(): age 0, not ~49 days
+void test_beat_after_supervisor_clock(void) {
+    heartbeats.add(HEARTBEAT_SENSORS, PERIOD, 0);
+    uint32_t now = 50000;
+    heartbeats.beat(HEARTBEAT_SENSORS, now + 3);
+    TEST_ASSERT_EQUAL_UINT32(0, heartbeats.age(HEARTBEAT_SENSORS, now));
+    TEST_ASSERT_EQUAL(HEARTBEAT_OK, heartbeats.check(HEARTBEAT_SENSORS, now));
+
+    // Same race while stalled: it still counts as recovered
+    TEST_ASSERT_EQUAL(HEARTBEAT_STALLED, heartbeats.check(HEARTBEAT_SENSORS, now + 3 + PERIOD + 1));
+    heartbeats.beat(HEARTBEAT_SENSORS, now + 3 + PERIOD + 10);
+    TEST_ASSERT_EQUAL(HEARTBEAT_RECOVERED, heartbeats.check(HEARTBEAT_SENSORS, now + 3 + PERIOD + 5));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_unregistered_is_ok);
+    RUN_TEST(test_beating_stays_ok);
+    RUN_TEST(test_stall_restart_recover);
+    RUN_TEST(test_stall_then_fail);
+    RUN_TEST(test_suspend_and_resume);
+    RUN_TEST(test_waiting_is_not_a_stall);
+    RUN_TEST(test_millis_wrap);
+    RUN_TEST(test_beat_after_supervisor_clock);
+    return UNITY_END();
+}
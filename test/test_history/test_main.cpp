@@ -0,0 +1,141 @@
+// Raw history ring: correctness and /history query benchmark (sensor_history.h)
+// Fills the ring past capacity (so it has wrapped) at the largest board size,
+// checks aggregate() and findSequence() against a naive scan, and times the
+// bucket loop handleHistory() runs for 60 and HISTORY_MAX_POINTS points.
+//   pio test -e native -f test_history -v
+
+#include <unity.h>
+
+#include <chrono>
+#include <vector>
+
+#include "sensor_history.h"
+
+static const size_t CAPACITY = 8640;  // HISTORY_MAX_RECORDS on the WROOM (12 h)
+static const uint32_t INTERVAL = 5;   // UPDATE_INTERVAL, seconds
+static const int MAX_POINTS = 500;    // HISTORY_MAX_POINTS in main.cpp
+
+static SensorHistory history;
+static std::vector<SensorSnapshot> appended;  // Everything ever appended, by sequence
+
+static uint32_t rngState = 0xC0FFEE11;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t timeOf(uint64_t sequence) { return 100 + (uint32_t)sequence * INTERVAL; }
+
+// Naive scan over what the ring still holds
+static HistoryAggregate naive(SensorChannel channel, uint64_t from, uint64_t to) {
+    HistoryAggregate result = {INT32_MAX, INT32_MIN, 0, 0, 0, 0};
+    for (uint64_t s = from; s < to; s++) {
+        const SensorSnapshot& snapshot = appended[s];
+        if (!snapshot.has(channel)) {
+            continue;
+        }
+        int32_t value = SensorHistory::dequantize(channel, SensorHistory::quantize(channel, snapshot.get(channel)));
+        if (value < result.min) result.min = value;
+        if (value > result.max) result.max = value;
+        result.sum += value;
+        result.count++;
+    }
+    return result;
+}
+
+// handleHistory()'s raw path: `points` equal shares of [first, end)
+static uint32_t downsample(SensorChannel channel, int points) {
+    uint64_t first = history.firstSequence();
+    uint64_t span = history.endSequence() - first;
+    uint32_t filled = 0;
+    for (int b = 0; b < points; b++) {
+        HistoryAggregate bucket = history.aggregate(channel, first + span * b / points, first + span * (b + 1) / points);
+        filled += bucket.count > 0;
+    }
+    return filled;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fill_past_capacity(void) {
+    TEST_ASSERT_TRUE(history.begin(CAPACITY));
+    int32_t temperature = 2100;
+    for (size_t i = 0; i < CAPACITY + CAPACITY / 3; i++) {
+        SensorSnapshot snapshot;
+        temperature += (int32_t)(nextRandom() % 21) - 10;
+        snapshot.set(CHANNEL_TEMPERATURE, temperature);
+        snapshot.set(CHANNEL_PRESSURE, 100000 + (int32_t)(nextRandom() % 400));
+        if (nextRandom() % 50 != 0) {
+            snapshot.set(CHANNEL_HUMIDITY, 4000 + (int32_t)(nextRandom() % 2000));  // Occasional dropout
+        }
+        history.append(timeOf(appended.size()), snapshot);
+        appended.push_back(snapshot);
+    }
+    TEST_ASSERT_EQUAL_size_t(CAPACITY, history.size());
+    TEST_ASSERT_TRUE(history.firstSequence() == appended.size() - CAPACITY);
+}
+
+void test_aggregate_matches_naive_scan(void) {
+    static const SensorChannel CHANNELS[] = {CHANNEL_TEMPERATURE, CHANNEL_PRESSURE, CHANNEL_HUMIDITY, CHANNEL_CO2};
+    uint64_t first = history.firstSequence();
+    uint64_t end = history.endSequence();
+    for (int q = 0; q < 2000; q++) {
+        // Ranges partly outside the ring are clamped to it
+        uint64_t from = first - 100 + nextRandom() % (CAPACITY + 200);
+        uint64_t to = from + nextRandom() % CAPACITY;
+        uint64_t clampedFrom = from < first ? first : from;
+        uint64_t clampedTo = to > end ? end : to;
+        SensorChannel channel = CHANNELS[q % 4];
+        HistoryAggregate actual = history.aggregate(channel, from, to);
+        HistoryAggregate expected = clampedFrom < clampedTo ? naive(channel, clampedFrom, clampedTo)
+                                                            : HistoryAggregate{INT32_MAX, INT32_MIN, 0, 0, 0, 0};
+        TEST_ASSERT_EQUAL_UINT32(expected.count, actual.count);
+        if (expected.count > 0) {
+            TEST_ASSERT_EQUAL_INT32(expected.min, actual.min);
+            TEST_ASSERT_EQUAL_INT32(expected.max, actual.max);
+            TEST_ASSERT_TRUE(expected.sum == actual.sum);
+            TEST_ASSERT_EQUAL_UINT32(timeOf(clampedFrom), actual.firstTime);
+            TEST_ASSERT_EQUAL_UINT32(timeOf(clampedTo - 1), actual.lastTime);
+        }
+    }
+}
+
+void test_find_sequence(void) {
+    uint64_t first = history.firstSequence();
+    TEST_ASSERT_TRUE(history.findSequence(0) == first);
+    TEST_ASSERT_TRUE(history.findSequence(timeOf(first + 10)) == first + 10);
+    TEST_ASSERT_TRUE(history.findSequence(timeOf(first + 10) - 1) == first + 10);
+    TEST_ASSERT_TRUE(history.findSequence(UINT32_MAX) == history.endSequence());
+}
+
+void test_benchmark_full_ring_query(void) {
+    static const int POINTS[] = {60, MAX_POINTS};
+    for (int points : POINTS) {
+        const int ROUNDS = 200;
+        uint32_t filled = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; round++) {
+            filled = downsample(CHANNEL_TEMPERATURE, points);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+        TEST_ASSERT_EQUAL_UINT32(points, filled);
+
+        char message[120];
+        snprintf(message, sizeof(message), "%u records, %3d points: %.1f us per query (%.2f ns per record)",
+                 (unsigned)CAPACITY, points, us, us * 1000.0 / CAPACITY);
+        TEST_MESSAGE(message);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fill_past_capacity);
+    RUN_TEST(test_aggregate_matches_naive_scan);
+    RUN_TEST(test_find_sequence);
+    RUN_TEST(test_benchmark_full_ring_query);
+    return UNITY_END();
+}
@@ -0,0 +1,218 @@
+// /query building blocks and latency (history_query.h, sensor_rollup.h)
+// Parameter parsing and group counting (the negative / huge step regression),
+// LinearFit and QuantileSketch against exact answers, and query latency over
+// a full retention window at the WROOM sizes: 180 days of 5 s samples in the
+// rollups, 12 hours in the raw ring.
+//   pio test -e native -f test_query -v
+
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "history_query.h"
+#include "sensor_history.h"
+#include "sensor_rollup.h"
+
+// board_config.h, ESP32-WROOM
+static const size_t ROLLUP_BUCKETS[ROLLUP_TIER_COUNT] = {720, 336, 180};
+static const size_t RAW_RECORDS = 8640;
+static const uint32_t INTERVAL = 5;
+static const uint32_t MAX_SECONDS = ROLLUP_PERIODS[ROLLUP_TIER_COUNT - 1] * 180;
+static const uint32_t MAX_GROUPS = 500;  // HISTORY_MAX_POINTS
+
+static SensorRollups rollups;
+static SensorHistory history;
+static uint32_t now;
+
+static char message[160];
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_parse_seconds_rejects_bad_values(void) {
+    uint32_t seconds = 42;
+    TEST_ASSERT_TRUE(queryParseSeconds("3600", MAX_SECONDS, seconds));
+    TEST_ASSERT_EQUAL_UINT32(3600, seconds);
+    TEST_ASSERT_TRUE(queryParseSeconds("15552000", MAX_SECONDS, seconds));
+
+    seconds = 42;
+    static const char* BAD[] = {"", "0", "-1", "-3600", "-2147483648", "15552001", "4294967296",
+                                "99999999999999999999", "60s", "1e3", "0x10", "5 "};
+    for (const char* text : BAD) {
+        TEST_ASSERT_FALSE_MESSAGE(queryParseSeconds(text, MAX_SECONDS, seconds), text);
+        TEST_ASSERT_EQUAL_UINT32(42, seconds);  // Untouched
+    }
+}
+
+// A negative step used to wrap to ~4e9 and a huge one overflowed the group
+// arithmetic; neither may produce a group count that slips under the limit
+void test_group_count_never_wraps(void) {
+    TEST_ASSERT_EQUAL_UINT32(24, queryGroupCount(3600, 3600 + 86399, 3600));
+    TEST_ASSERT_EQUAL_UINT32(1, queryGroupCount(100, 100, 60));
+    TEST_ASSERT_EQUAL_UINT32(0, queryGroupCount(101, 100, 60));
+    TEST_ASSERT_EQUAL_UINT32(0, queryGroupCount(0, 100, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, queryGroupCount(0, UINT32_MAX, UINT32_MAX));  // The second one's end wraps: handleQuery() stops there
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, queryGroupCount(0, UINT32_MAX, 1));  // Saturates, then rejected
+    TEST_ASSERT_EQUAL_UINT32(2, queryGroupCount(UINT32_MAX - 10, UINT32_MAX, 10));
+    TEST_ASSERT_TRUE(queryGroupCount(0, MAX_SECONDS, 1) > MAX_GROUPS);
+
+    // Snapping `from` down to a bucket edge can add a group: 3600 s in
+    // 3600 s steps, starting mid-hour, spans two hour buckets
+    uint32_t from = 7200 + 1800;
+    uint32_t end = from + 3600 - 1;
+    TEST_ASSERT_EQUAL_UINT32(1, queryGroupCount(from, end, 3600));
+    TEST_ASSERT_EQUAL_UINT32(2, queryGroupCount(from - from % 3600, end, 3600));
+}
+
+void test_linear_fit(void) {
+    LinearFit fit;
+    int32_t slope = 0;
+    TEST_ASSERT_FALSE(fit.slopePerHour(slope));
+    fit.add(1000, 100);
+    fit.add(1000, 200);
+    TEST_ASSERT_FALSE(fit.slopePerHour(slope));  // No distinct times
+
+    // -1.5 hPa over 3 hours (Pa), 5 s cycles with +-2 Pa noise
+    fit = LinearFit();
+    for (uint32_t t = 0; t < 3 * 3600; t += INTERVAL) {
+        fit.add(500000 + t, 101300 - (int32_t)(t * 150 / 10800) + (int32_t)(t / 5 % 5) - 2);
+    }
+    TEST_ASSERT_TRUE(fit.slopePerHour(slope));
+    TEST_ASSERT_INT32_WITHIN(1, -50, slope);
+}
+
+void test_quantile_sketch_within_resolution(void) {
+    std::vector<int32_t> values;
+    uint32_t state = 7;
+    for (int i = 0; i < 8640; i++) {
+        state = state * 1103515245 + 12345;
+        values.push_back(1800 + (int32_t)((state >> 8) % 700) + (i % 100 == 0 ? 500 : 0));
+    }
+    QuantileSketch sketch;
+    sketch.reset(*std::min_element(values.begin(), values.end()), *std::max_element(values.begin(), values.end()));
+    for (int32_t v : values) {
+        sketch.add(v);
+    }
+    std::sort(values.begin(), values.end());
+    static const uint8_t PERCENTILES[] = {1, 5, 25, 50, 75, 95, 99, 100};
+    for (uint8_t p : PERCENTILES) {
+        int32_t exact = values[(values.size() * p + 99) / 100 - 1];
+        TEST_ASSERT_INT32_WITHIN(sketch.resolution(), exact, sketch.percentile(p));
+    }
+}
+
+void test_fill_full_retention(void) {
+    TEST_ASSERT_TRUE(rollups.begin(ROLLUP_BUCKETS));
+    TEST_ASSERT_TRUE(history.begin(RAW_RECORDS));
+    int32_t pressure = 101300;
+    uint32_t state = 99;
+    for (now = 0; now < MAX_SECONDS; now += INTERVAL) {
+        state = state * 1103515245 + 12345;
+        pressure += (int32_t)((state >> 16) % 9) - 4;
+        pressure = pressure < 97000 ? 97000 : (pressure > 104000 ? 104000 : pressure);
+        SensorSnapshot snapshot;
+        snapshot.set(CHANNEL_PRESSURE, pressure);
+        snapshot.set(CHANNEL_TEMPERATURE, 2100 + (int32_t)((state >> 20) % 300));
+        rollups.add(now, snapshot);
+        history.append(now, snapshot);
+    }
+    now -= INTERVAL;
+    TEST_ASSERT_EQUAL_UINT32(MAX_SECONDS - ROLLUP_PERIODS[2] * 180, rollups.tier(2).oldestTime());
+}
+
+// handleQuery()'s rollup path for min/max/avg: one aggregate() per group
+static uint32_t rollupQuery(uint32_t seconds, uint32_t step, int tier) {
+    const RollupTier& rollup = rollups.tier(tier);
+    uint32_t from = now >= seconds ? now + 1 - seconds : 0;
+    from -= from % rollup.getPeriod();
+    uint32_t groups = queryGroupCount(from, now, step);
+    uint32_t filled = 0;
+    for (uint32_t g = 0; g < groups; g++) {
+        HistoryAggregate aggregate = rollup.aggregate(CHANNEL_PRESSURE, from + g * step, from + g * step + step);
+        filled += aggregate.count > 0;
+    }
+    return filled;
+}
+
+// handleQuery()'s slope over rollups: one point per bucket
+static uint32_t rollupSlope(uint32_t seconds, uint32_t step, int tier) {
+    const RollupTier& rollup = rollups.tier(tier);
+    uint32_t period = rollup.getPeriod();
+    uint32_t from = now >= seconds ? now + 1 - seconds : 0;
+    from -= from % period;
+    uint32_t groups = queryGroupCount(from, now, step);
+    uint32_t filled = 0;
+    for (uint32_t g = 0; g < groups; g++) {
+        LinearFit fit;
+        for (uint32_t bucket = from + g * step; bucket < from + (g + 1) * step; bucket += period) {
+            HistoryAggregate part = rollup.aggregate(CHANNEL_PRESSURE, bucket, bucket + period);
+            if (part.count > 0) {
+                fit.add(bucket + period / 2, part.average());
+            }
+        }
+        int32_t slope;
+        filled += fit.slopePerHour(slope);
+    }
+    return filled;
+}
+
+// handleQuery()'s raw path for a percentile: min/max pass, then the sketch pass
+static uint32_t rawPercentile(uint32_t seconds, uint32_t step) {
+    uint32_t from = now >= seconds ? now + 1 - seconds : 0;
+    uint32_t groups = queryGroupCount(from, now, step);
+    uint32_t filled = 0;
+    static QuantileSketch sketch;
+    for (uint32_t g = 0; g < groups; g++) {
+        uint64_t first = history.findSequence(from + g * step);
+        uint64_t end = history.findSequence(from + (g + 1) * step);
+        HistoryAggregate aggregate = history.aggregate(CHANNEL_PRESSURE, first, end);
+        if (aggregate.count == 0) {
+            continue;
+        }
+        sketch.reset(aggregate.min, aggregate.max);
+        for (uint64_t seq = first; seq < end; seq++) {
+            int32_t value;
+            if (history.valueAt(CHANNEL_PRESSURE, seq, value)) {
+                sketch.add(value);
+            }
+        }
+        filled += sketch.percentile(95) >= aggregate.min;
+    }
+    return filled;
+}
+
+template <typename Fn>
+static void benchmark(const char* name, uint32_t expectedGroups, Fn&& query) {
+    const int ROUNDS = 50;
+    uint32_t filled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        filled = query();
+        asm volatile("" ::: "memory");  // Keep the optimizer from hoisting the query out of the loop
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+    snprintf(message, sizeof(message), "%-44s %3lu groups: %8.1f us", name, (unsigned long)filled, us);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(expectedGroups, filled);
+}
+
+void test_benchmark_full_retention_window(void) {
+    benchmark("max, 180 days by day (1d tier)", 180, [] { return rollupQuery(MAX_SECONDS, 86400, 2); });
+    benchmark("avg, 14 days by hour (1h tier)", 336, [] { return rollupQuery(14 * 86400, 3600, 1); });
+    benchmark("avg, 12 hours by 5 min (1m tier)", 145, [] { return rollupQuery(12 * 3600, 300, 0); });
+    benchmark("slope, 14 days by day over hourly buckets", 14, [] { return rollupSlope(14 * 86400, 86400, 1); });
+    benchmark("p95, 12 hours by hour (raw ring)", 12, [] { return rawPercentile(12 * 3600, 3600); });
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_seconds_rejects_bad_values);
+    RUN_TEST(test_group_count_never_wraps);
+    RUN_TEST(test_linear_fit);
+    RUN_TEST(test_quantile_sketch_within_resolution);
+    RUN_TEST(test_fill_full_retention);
+    RUN_TEST(test_benchmark_full_retention_window);
+    return UNITY_END();
+}
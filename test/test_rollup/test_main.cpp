@@ -0,0 +1,189 @@
+// Rollup property test (sensor_rollup.h)
+// Feeds a tier a random sample stream - gaps longer than the ring, dropped
+// channels, several samples per bucket - and checks every aggregate() against
+// a brute-force scan of the samples the tier still covers.
+//   pio test -e native -f test_rollup
+
+#include <unity.h>
+
+#include <vector>
+
+#include "sensor_rollup.h"
+
+struct Sample {
+    uint32_t time;
+    SensorSnapshot snapshot;
+};
+
+// Value ranges that fit HISTORY_QUANTIZATION
+static const int32_t VALUE_MIN[HISTORY_CHANNEL_COUNT] = {-4000, 30000, -50000, 0, 400, -4500};
+static const int32_t VALUE_MAX[HISTORY_CHANNEL_COUNT] = {8500, 110000, 500000, 10000, 5000, 3000};
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint32_t randomBelow(uint32_t limit) { return nextRandom() % limit; }
+
+static std::vector<Sample> makeStream(uint32_t period, size_t capacity, size_t count) {
+    std::vector<Sample> samples;
+    uint32_t time = 1000000 + randomBelow(period);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t roll = randomBelow(100);
+        if (roll < 2) {
+            time += period * (uint32_t)(capacity + randomBelow((uint32_t)capacity));  // Longer than the ring
+        } else if (roll < 10) {
+            time += period * (2 + randomBelow(5));  // A few empty buckets
+        } else {
+            time += randomBelow(period / 2 + 1);  // Usually the same bucket
+        }
+        Sample sample;
+        sample.time = time;
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            if (randomBelow(10) != 0) {
+                int32_t span = VALUE_MAX[c] - VALUE_MIN[c];
+                sample.snapshot.set((SensorChannel)c, VALUE_MIN[c] + (int32_t)randomBelow((uint32_t)span + 1));
+            }
+        }
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+// What aggregate() must return: every sample in a bucket that starts in
+// [from, to) and is still among the last `capacity` buckets
+static HistoryAggregate bruteForce(const std::vector<Sample>& samples, uint32_t period, size_t capacity,
+                                   SensorChannel channel, uint32_t from, uint32_t to) {
+    HistoryAggregate result = {INT32_MAX, INT32_MIN, 0, 0, 0, 0};
+    if (samples.empty() || from >= to) {
+        return result;
+    }
+    uint32_t newest = samples.back().time / period;
+    uint32_t oldest = newest >= capacity ? newest - (uint32_t)capacity + 1 : 0;
+    for (const Sample& sample : samples) {
+        uint32_t index = sample.time / period;
+        uint32_t start = index * period;
+        if (index < oldest || start < from || start >= to || !sample.snapshot.has(channel)) {
+            continue;
+        }
+        int32_t value = SensorHistory::dequantize(channel, SensorHistory::quantize(channel, sample.snapshot.get(channel)));
+        if (result.count == 0) {
+            result.firstTime = start;
+        }
+        result.lastTime = start;
+        if (value < result.min) result.min = value;
+        if (value > result.max) result.max = value;
+        result.sum += value;
+        result.count++;
+    }
+    return result;
+}
+
+static void checkAggregate(const RollupTier& tier, const std::vector<Sample>& samples, SensorChannel channel,
+                           uint32_t from, uint32_t to) {
+    HistoryAggregate expected = bruteForce(samples, tier.getPeriod(), tier.capacity(), channel, from, to);
+    HistoryAggregate actual = tier.aggregate(channel, from, to);
+    char message[96];
+    snprintf(message, sizeof(message), "channel %u, [%lu, %lu)", (unsigned)channel, (unsigned long)from,
+             (unsigned long)to);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.count, actual.count, message);
+    if (expected.count == 0) {
+        return;
+    }
+    TEST_ASSERT_EQUAL_INT32_MESSAGE(expected.min, actual.min, message);
+    TEST_ASSERT_EQUAL_INT32_MESSAGE(expected.max, actual.max, message);
+    TEST_ASSERT_TRUE_MESSAGE(expected.sum == actual.sum, message);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.firstTime, actual.firstTime, message);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.lastTime, actual.lastTime, message);
+}
+
+void setUp(void) { rngState = 0x2545F491; }
+void tearDown(void) {}
+
+void test_empty_tier_aggregates_nothing(void) {
+    RollupTier tier;
+    TEST_ASSERT_TRUE(tier.begin(60, 16));
+    TEST_ASSERT_EQUAL_UINT32(0, tier.aggregate(CHANNEL_TEMPERATURE, 0, UINT32_MAX).count);
+    TEST_ASSERT_EQUAL_UINT32(0, tier.oldestTime());
+}
+
+// Slots skipped by a gap were never opened and must not count, whatever the
+// heap left in them
+void test_gap_leaves_unopened_slots_empty(void) {
+    // A freed block of the same size, filled with plausible buckets, is what
+    // malloc usually hands back next (not under ASan's quarantine)
+    RollupBucket* stale = (RollupBucket*)malloc(8 * sizeof(RollupBucket));
+    for (uint32_t i = 0; i < 8; i++) {
+        stale[i].index = i;
+        for (uint8_t c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+            stale[i].channels[c] = {-100, 100, 0, 1};
+        }
+    }
+    free(stale);
+
+    RollupTier tier;
+    TEST_ASSERT_TRUE(tier.begin(60, 8));
+    SensorSnapshot snapshot;
+    snapshot.set(CHANNEL_TEMPERATURE, 2150);
+    tier.add(0, snapshot);
+    tier.add(7 * 60, snapshot);
+    HistoryAggregate aggregate = tier.aggregate(CHANNEL_TEMPERATURE, 0, 8 * 60);
+    TEST_ASSERT_EQUAL_UINT32(2, aggregate.count);
+    TEST_ASSERT_EQUAL_UINT32(0, aggregate.firstTime);
+    TEST_ASSERT_EQUAL_UINT32(7 * 60, aggregate.lastTime);
+}
+
+void test_aggregate_matches_brute_force(void) {
+    static const uint32_t PERIODS[] = {60, 3600};
+    static const size_t CAPACITIES[] = {1, 7, 64};
+    for (uint32_t period : PERIODS) {
+        for (size_t capacity : CAPACITIES) {
+            RollupTier tier;
+            TEST_ASSERT_TRUE(tier.begin(period, capacity));
+            std::vector<Sample> samples = makeStream(period, capacity, 3000);
+            std::vector<Sample> fed;
+            for (const Sample& sample : samples) {
+                tier.add(sample.time, sample.snapshot);
+                fed.push_back(sample);
+                if (randomBelow(20) != 0) {
+                    continue;
+                }
+                // Random windows around what the tier holds, including unaligned edges
+                uint32_t newestTime = sample.time;
+                for (int q = 0; q < 20; q++) {
+                    uint32_t reach = period * (uint32_t)(capacity + 2);
+                    uint32_t from = newestTime - randomBelow(reach);
+                    uint32_t to = from + randomBelow(reach) + 1;
+                    SensorChannel channel = (SensorChannel)randomBelow(HISTORY_CHANNEL_COUNT);
+                    checkAggregate(tier, fed, channel, from, to);
+                }
+                checkAggregate(tier, fed, CHANNEL_TEMPERATURE, 0, UINT32_MAX);
+            }
+        }
+    }
+}
+
+void test_select_tier_prefers_coarsest_fitting_tier(void) {
+    SensorRollups rollups;
+    const size_t counts[ROLLUP_TIER_COUNT] = {1440, 720, 365};
+    TEST_ASSERT_TRUE(rollups.begin(counts));
+    TEST_ASSERT_EQUAL_INT(0, rollups.selectTier(3600, 60));
+    TEST_ASSERT_EQUAL_INT(1, rollups.selectTier(7 * 86400, 3600));
+    TEST_ASSERT_EQUAL_INT(2, rollups.selectTier(90 * 86400, 86400));
+    TEST_ASSERT_EQUAL_INT(1, rollups.selectTier(7 * 86400, 60));  // Minutes only hold a day
+    TEST_ASSERT_EQUAL_INT(2, rollups.selectTier(1000 * 86400U, 60));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_tier_aggregates_nothing);
+    RUN_TEST(test_gap_leaves_unopened_slots_empty);
+    RUN_TEST(test_aggregate_matches_brute_force);
+    RUN_TEST(test_select_tier_prefers_coarsest_fitting_tier);
+    return UNITY_END();
+}
@@ -0,0 +1,253 @@
+// Rules engine tests and benchmark (rules_engine.h)
+// Compiler errors and limits, the evaluator's arithmetic, verifyRuleProgram()
+// against corrupted NVS blobs, and RuleEngine::update() cost with 1, 16 and
+// 64 rules.
+//   pio test -e native -f test_rules -v
+
+#include <unity.h>
+
+#include <chrono>
+
+#include "rules_engine.h"
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static RuleProgram compileOk(const char* text) {
+    RuleCompiler compiler;
+    RuleProgram program;
+    RuleError error;
+    bool ok = compiler.compile(text, program, error);
+    TEST_ASSERT_TRUE_MESSAGE(ok, error.message ? error.message : text);
+    TEST_ASSERT_TRUE_MESSAGE(verifyRuleProgram(program), text);
+    return program;
+}
+
+static const char* compileError(const char* text) {
+    RuleCompiler compiler;
+    RuleProgram program;
+    RuleError error;
+    TEST_ASSERT_FALSE_MESSAGE(compiler.compile(text, program, error), text);
+    TEST_ASSERT_NOT_NULL(error.message);
+    return error.message;
+}
+
+static SensorSnapshot indoorReadings() {
+    SensorSnapshot readings;
+    readings.set(CHANNEL_TEMPERATURE, 2150);  // 21.50 °C
+    readings.set(CHANNEL_HUMIDITY, 7240);     // 72.40 %RH
+    readings.set(CHANNEL_PRESSURE, 101325);   // 1013.25 hPa
+    readings.set(CHANNEL_CO2, 1350);
+    readings.set(CHANNEL_DEW_POINT, 1640);
+    return readings;
+}
+
+static RuleResult evaluate(const char* text, const SensorSnapshot& readings) {
+    return evaluateRule(compileOk(text), readings);
+}
+
+void setUp(void) { rngState = 0x9E3779B9; }
+void tearDown(void) {}
+
+void test_compiles_examples(void) {
+    RuleProgram program = compileOk("humidity > 70 for 10m then alert, led:blink");
+    TEST_ASSERT_EQUAL_UINT32(600, program.holdSeconds);
+    TEST_ASSERT_EQUAL_UINT8(RULE_ACTION_ALERT | RULE_ACTION_LED, program.actions);
+    TEST_ASSERT_EQUAL_UINT8(RULE_LED_BLINK, program.ledPattern);
+    TEST_ASSERT_EQUAL_UINT32(1UL << CHANNEL_HUMIDITY, program.channelMask);
+
+    program = compileOk("temperature - dewpoint < 2 and not co2 < 800 then alert");
+    TEST_ASSERT_EQUAL_UINT32((1UL << CHANNEL_TEMPERATURE) | (1UL << CHANNEL_DEW_POINT) | (1UL << CHANNEL_CO2),
+                             program.channelMask);
+}
+
+void test_type_errors(void) {
+    TEST_ASSERT_EQUAL_STRING("expected a comparison", compileError("humidity and 70 then alert"));
+    TEST_ASSERT_EQUAL_STRING("expected a number", compileError("humidity + (co2 > 5) > 1 then alert"));
+    TEST_ASSERT_EQUAL_STRING("expected a comparison", compileError("humidity then alert"));
+    TEST_ASSERT_EQUAL_STRING("expected a comparison after 'not'", compileError("not humidity then alert"));
+    TEST_ASSERT_EQUAL_STRING("unknown channel", compileError("wind > 3 then alert"));
+    TEST_ASSERT_EQUAL_STRING("expected 'then'", compileError("humidity > 70 alert"));
+    TEST_ASSERT_EQUAL_STRING("duration longer than 24 hours", compileError("co2 > 1 for 25h then alert"));
+    TEST_ASSERT_EQUAL_STRING("unknown LED pattern (blink, strobe)", compileError("co2 > 1 then led:pulse"));
+}
+
+void test_depth_limit(void) {
+    // Right-nested sums keep every left operand on the stack
+    compileOk("1 + (1 + (1 + (1 + (1 + (1 + (1 + co2)))))) > 0 then alert");  // 8 deep
+    TEST_ASSERT_EQUAL_STRING("expression nested too deeply",
+                             compileError("1 + (1 + (1 + (1 + (1 + (1 + (1 + (1 + co2))))))) > 0 then alert"));
+    TEST_ASSERT_EQUAL_STRING("rule too long",
+                             compileError("1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1 > 0 then alert"));
+    TEST_ASSERT_EQUAL_STRING("rule text too long",
+                             compileError("co2 > 1                                                                                                then alert"));
+}
+
+void test_literal_overflow(void) {
+    compileOk("co2 < 2147483.647 then alert");
+    TEST_ASSERT_EQUAL_STRING("invalid character or number", compileError("co2 < 2147483.648 then alert"));
+    TEST_ASSERT_EQUAL_STRING("invalid character or number", compileError("co2 < 2147483.999 then alert"));
+    TEST_ASSERT_EQUAL_STRING("invalid character or number", compileError("co2 < 99999999999 then alert"));
+    compileOk("co2 < 0.0001 then alert");  // Truncated to 0
+}
+
+void test_evaluates_fixed_point(void) {
+    SensorSnapshot readings = indoorReadings();
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("humidity > 72.39 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_FALSE, evaluate("humidity > 72.4 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("temperature - dewpoint < 5.2 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("pressure / 10 == 101.325 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("co2 * 0.5 == 675 and not co2 < 800 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("-temperature < -21 or co2 > 5000 then alert", readings));
+}
+
+void test_unknown_results(void) {
+    SensorSnapshot readings = indoorReadings();
+    TEST_ASSERT_EQUAL(RULE_UNKNOWN, evaluate("altitude > 100 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_UNKNOWN, evaluate("co2 / (humidity - humidity) > 1 then alert", readings));
+}
+
+void test_arithmetic_saturates(void) {
+    SensorSnapshot readings = indoorReadings();
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("co2 * 2000000 == 2147483.647 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("-2147483.647 - co2 < -2147483.647 then alert", readings));
+    TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("-(-2147483.647 - co2) == 2147483.647 then alert", readings));
+}
+
+void test_verify_rejects_bad_headers(void) {
+    RuleProgram good = compileOk("humidity > 70 for 10m then alert");
+    RuleProgram program = good;
+    program.version = RULE_FORMAT_VERSION + 1;
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+    program = good;
+    program.codeLength = RULE_MAX_CODE + 1;
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+    program = good;
+    memset(program.source, 'x', sizeof(program.source));
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+    program = good;
+    program.holdSeconds = RULE_MAX_HOLD + 1;
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+    program = good;
+    program.ledPattern = RULE_LED_STROBE + 1;
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+    program = good;
+    program.code[1] = CHANNEL_COUNT;  // LOAD operand
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+    program = good;
+    program.codeLength--;  // Truncated operand
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+    program = good;
+    program.codeLength = 0;  // Empty stack at the end
+    TEST_ASSERT_FALSE(verifyRuleProgram(program));
+}
+
+// Whatever a corrupted blob holds, verifyRuleProgram() either rejects it or
+// the evaluator runs it within its stack (checked by the sanitizers)
+void test_verify_guards_evaluator_on_corrupted_blobs(void) {
+    static const char* RULES[] = {
+        "humidity > 70 for 10m then alert, led:blink",
+        "temperature - dewpoint < 2 and not co2 < 800 then alert",
+        "1 + (1 + (1 + (1 + (1 + (1 + (1 + co2)))))) > 0 then alert",
+        "co2 / (humidity - 40) * 3 > pressure / 1000 or -temperature >= 5 then led:strobe",
+    };
+    SensorSnapshot readings = indoorReadings();
+    uint32_t accepted = 0;
+    uint32_t trials = 0;
+    for (const char* text : RULES) {
+        RuleProgram good = compileOk(text);
+        for (int trial = 0; trial < 50000; trial++) {
+            RuleProgram program = good;
+            int flips = 1 + (int)(nextRandom() % 4);
+            for (int f = 0; f < flips; f++) {
+                uint32_t r = nextRandom();
+                if (r & 0x10000) {
+                    program.code[(r >> 8) % RULE_MAX_CODE] = (uint8_t)r;  // Random byte
+                } else {
+                    ((uint8_t*)&program)[(r >> 8) % sizeof(RuleProgram)] ^= (uint8_t)(1 << (r % 8));  // Bit flip
+                }
+            }
+            trials++;
+            if (verifyRuleProgram(program)) {
+                accepted++;
+                evaluateRule(program, readings);
+            }
+        }
+    }
+    char message[80];
+    snprintf(message, sizeof(message), "%lu of %lu corrupted programs still verified", (unsigned long)accepted,
+             (unsigned long)trials);
+    TEST_MESSAGE(message);
+}
+
+template <uint8_t Count>
+static void benchmarkUpdate() {
+    static const char* RULES[] = {
+        "humidity > 70 for 10m then alert, led:blink",
+        "temperature - dewpoint < 2 and not co2 < 800 then alert",
+        "co2 > 1200 or co2 / 10 > humidity then led:strobe",
+        "pressure < 990 and temperature > 25 for 1h then alert",
+    };
+    static RuleEngine<Count> engine;
+    for (uint8_t i = 0; i < Count; i++) {
+        TEST_ASSERT_TRUE(engine.add(compileOk(RULES[i % 4])));
+    }
+    const int CYCLES = 200000;
+    SensorSnapshot readings = indoorReadings();
+    uint32_t fired = 0;
+    auto onChange = [&](uint8_t, bool firing) { fired += firing; };
+
+    // Every channel changes every cycle: each rule is re-run
+    auto start = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < CYCLES; cycle++) {
+        readings.values[CHANNEL_TEMPERATURE] = 2000 + cycle % 700;
+        readings.values[CHANNEL_HUMIDITY] = 6500 + cycle % 1000;
+        readings.values[CHANNEL_CO2] = 700 + cycle % 900;
+        readings.values[CHANNEL_DEW_POINT] = 1500 + cycle % 500;
+        readings.values[CHANNEL_PRESSURE] = 98000 + cycle % 3000;
+        engine.update(readings, (uint32_t)cycle * 5, onChange);
+    }
+    double changingNs =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CYCLES;
+
+    // Nothing changes: only the hold timers advance
+    start = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < CYCLES; cycle++) {
+        engine.update(readings, (uint32_t)(CYCLES + cycle) * 5, onChange);
+    }
+    double steadyNs =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CYCLES;
+
+    char message[120];
+    snprintf(message, sizeof(message), "%2u rules: %8.1f ns/update all changed, %8.1f ns/update unchanged (%lu fires)",
+             (unsigned)Count, changingNs, steadyNs, (unsigned long)fired);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)CYCLES * Count, engine.getEvaluations());  // None while unchanged
+}
+
+void test_benchmark_update(void) {
+    benchmarkUpdate<1>();
+    benchmarkUpdate<16>();
+    benchmarkUpdate<64>();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_compiles_examples);
+    RUN_TEST(test_type_errors);
+    RUN_TEST(test_depth_limit);
+    RUN_TEST(test_literal_overflow);
+    RUN_TEST(test_evaluates_fixed_point);
+    RUN_TEST(test_unknown_results);
+    RUN_TEST(test_arithmetic_saturates);
+    RUN_TEST(test_verify_rejects_bad_headers);
+    RUN_TEST(test_verify_guards_evaluator_on_corrupted_blobs);
+    RUN_TEST(test_benchmark_update);
+    return UNITY_END();
+}
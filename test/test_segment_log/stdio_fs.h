@@ -0,0 +1,146 @@
+#ifndef STDIO_FS_H
+#define STDIO_FS_H
+
+// Stdio Filesystem Shim
+// =====================
+// The fs::FS / fs::File subset SegmentLog and BatchSpool use, backed by a
+// directory on the host, so their on-flash formats and recovery run
+// unchanged under test (test_batch_spool includes it from here).
+// Paths are relative to the root given to begin() ("/history/..." lands in
+// <root>/history/...). Counts bytes read per file and can fail writes
+// part-way to simulate a power loss or a full partition.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+class StdioFS;
+
+class StdioFile {
+public:
+    StdioFile() {}
+
+    explicit operator bool() const { return file != NULL || dir != NULL; }
+
+    size_t write(const uint8_t* data, size_t length);
+
+    size_t read(uint8_t* data, size_t length) {
+        if (!file) {
+            return 0;
+        }
+        size_t n = fread(data, 1, length, file.get());
+        bytesRead(n);
+        return n;
+    }
+
+    size_t size() const {
+        struct stat info;
+        return stat(hostPath.c_str(), &info) == 0 ? (size_t)info.st_size : 0;
+    }
+
+    bool seek(uint32_t position) {
+        return file && position <= size() && fseek(file.get(), position, SEEK_SET) == 0;
+    }
+
+    void close() {
+        file.reset();
+        dir.reset();
+    }
+
+    const char* name() const { return fsPath.c_str(); }
+
+    StdioFile openNextFile();
+
+private:
+    friend class StdioFS;
+
+    void bytesRead(size_t n);
+
+    StdioFS* owner = NULL;
+    std::string fsPath;    // As the log sees it, e.g. "/history/00000001.seg"
+    std::string hostPath;  // Under the shim's root
+    std::shared_ptr<FILE> file;
+    std::shared_ptr<DIR> dir;
+};
+
+class StdioFS {
+public:
+    // Bytes each file may still take before writes fail short (-1: no limit)
+    long writeBudget = -1;
+    std::map<std::string, size_t> bytesReadByPath;
+
+    void begin(const std::string& rootDirectory) { root = rootDirectory; }
+
+    bool exists(const char* path) const {
+        struct stat info;
+        return stat(host(path).c_str(), &info) == 0;
+    }
+
+    bool mkdir(const char* path) { return ::mkdir(host(path).c_str(), 0755) == 0; }
+
+    bool remove(const char* path) { return ::remove(host(path).c_str()) == 0; }
+
+    StdioFile open(const char* path, const char* mode = "r") {
+        StdioFile result;
+        result.owner = this;
+        result.fsPath = path;
+        result.hostPath = host(path);
+        struct stat info;
+        if (strcmp(mode, "r") == 0 && stat(result.hostPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            DIR* handle = opendir(result.hostPath.c_str());
+            if (handle != NULL) {
+                result.dir = std::shared_ptr<DIR>(handle, closedir);
+            }
+            return result;
+        }
+        const char* hostMode = strcmp(mode, "a") == 0 ? "ab" : strcmp(mode, "w") == 0 ? "wb" : "rb";
+        FILE* handle = fopen(result.hostPath.c_str(), hostMode);
+        if (handle != NULL) {
+            result.file = std::shared_ptr<FILE>(handle, fclose);
+        }
+        return result;
+    }
+
+    std::string host(const char* path) const { return root + path; }
+
+private:
+    std::string root;
+};
+
+inline size_t StdioFile::write(const uint8_t* data, size_t length) {
+    if (!file) {
+        return 0;
+    }
+    if (owner->writeBudget >= 0 && (long)length > owner->writeBudget) {
+        length = (size_t)owner->writeBudget;
+    }
+    size_t n = fwrite(data, 1, length, file.get());
+    if (owner->writeBudget >= 0) {
+        owner->writeBudget -= (long)n;
+    }
+    return n;
+}
+
+inline void StdioFile::bytesRead(size_t n) { owner->bytesReadByPath[fsPath] += n; }
+
+inline StdioFile StdioFile::openNextFile() {
+    StdioFile next;
+    if (!dir) {
+        return next;
+    }
+    while (struct dirent* entry = readdir(dir.get())) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        return owner->open((fsPath + "/" + entry->d_name).c_str(), "r");  // name() includes the directory
+    }
+    return next;
+}
+
+#endif // STDIO_FS_H
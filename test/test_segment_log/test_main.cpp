@@ -0,0 +1,216 @@
+// Segment log on a host directory (segment_log.h, via stdio_fs.h)
+// Appends, rotation, read-back, and recovery after a power loss tore the
+// last write: the torn block is skipped, only the tail segment is scanned,
+// and appending resumes in a fresh segment.
+//   pio test -e native -f test_segment_log
+
+#include <unity.h>
+
+#include <stdlib.h>
+#include <vector>
+
+#include "segment_log.h"
+#include "stdio_fs.h"
+
+static const char* DIRECTORY = "/history";
+static const uint16_t SEGMENT_BLOCKS = 4;
+static const uint16_t MAX_SEGMENTS = 3;
+
+static char root[] = "/tmp/segment_log_XXXXXX";
+static StdioFS fileSystem;
+static uint32_t blockTime;
+
+// A sealed block of a few records; `blockTime` makes every block distinct
+static SensorBlock makeBlock() {
+    SensorBlock block;
+    SensorBlockEncoder encoder;
+    encoder.begin(&block);
+    for (int i = 0; i < 10; i++) {
+        SensorSnapshot snapshot;
+        snapshot.set(CHANNEL_TEMPERATURE, 2100 + i);
+        snapshot.set(CHANNEL_HUMIDITY, 4500 - i);
+        encoder.append(blockTime, snapshot);
+        blockTime += 5;
+    }
+    encoder.seal();
+    return block;
+}
+
+static std::string segmentFile(uint32_t segment) {
+    char path[48];
+    snprintf(path, sizeof(path), "%s/%08lu.seg", DIRECTORY, (unsigned long)segment);
+    return path;
+}
+
+static std::vector<SensorBlock> readSegment(SegmentLog<StdioFS>& log, uint32_t segment) {
+    std::vector<SensorBlock> blocks(SEGMENT_BLOCKS + 1);
+    blocks.resize(log.readBlocks(segment, 0, blocks.data(), SEGMENT_BLOCKS + 1));
+    return blocks;
+}
+
+// Raw bytes appended behind the log's back: the start of a write the power cut
+static void appendRaw(uint32_t segment, const void* data, size_t length) {
+    FILE* file = fopen(fileSystem.host(segmentFile(segment).c_str()).c_str(), "ab");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(data, 1, length, file);
+    fclose(file);
+}
+
+void setUp(void) {
+    strcpy(root, "/tmp/segment_log_XXXXXX");
+    TEST_ASSERT_NOT_NULL(mkdtemp(root));
+    fileSystem = StdioFS();
+    fileSystem.begin(root);
+    blockTime = 1000;
+}
+
+void tearDown(void) {
+    std::string command = std::string("rm -rf ") + root;
+    TEST_ASSERT_EQUAL_INT(0, system(command.c_str()));
+}
+
+void test_append_and_read_back(void) {
+    SegmentLog<StdioFS> log;
+    TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+    std::vector<SensorBlock> written;
+    for (int i = 0; i < 6; i++) {
+        written.push_back(makeBlock());
+        TEST_ASSERT_TRUE(log.append(written.back()));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, log.getFirstSegment());
+    TEST_ASSERT_EQUAL_UINT32(2, log.getLastSegment());
+    TEST_ASSERT_EQUAL_UINT16(2, log.getTailBlocks());
+
+    std::vector<SensorBlock> first = readSegment(log, 1);
+    std::vector<SensorBlock> second = readSegment(log, 2);
+    TEST_ASSERT_EQUAL_size_t(SEGMENT_BLOCKS, first.size());
+    TEST_ASSERT_EQUAL_size_t(2, second.size());
+    for (int i = 0; i < 6; i++) {
+        const SensorBlock& block = i < SEGMENT_BLOCKS ? first[i] : second[i - SEGMENT_BLOCKS];
+        TEST_ASSERT_EQUAL_MEMORY(&written[i], &block, sizeof(SensorBlock));
+    }
+
+    // Partial read from an offset
+    SensorBlock out[2];
+    TEST_ASSERT_EQUAL_UINT16(2, log.readBlocks(1, 2, out, 2));
+    TEST_ASSERT_EQUAL_MEMORY(&written[2], &out[0], sizeof(SensorBlock));
+
+    const SegmentLogStats& stats = log.getStats();
+    TEST_ASSERT_EQUAL_UINT32(6, stats.blocksWritten);
+    TEST_ASSERT_EQUAL_UINT32(6 * sizeof(SensorBlock), stats.bytesWritten);
+    TEST_ASSERT_TRUE(stats.writeAmplification() > 1.0f);
+}
+
+void test_rotation_deletes_oldest_segments(void) {
+    SegmentLog<StdioFS> log;
+    TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+    for (int i = 0; i < SEGMENT_BLOCKS * 5; i++) {
+        TEST_ASSERT_TRUE(log.append(makeBlock()));
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, log.getFirstSegment());
+    TEST_ASSERT_EQUAL_UINT32(5, log.getLastSegment());
+    TEST_ASSERT_EQUAL_UINT32(2, log.getStats().segmentsRotated);
+    TEST_ASSERT_FALSE(fileSystem.exists(segmentFile(2).c_str()));
+    TEST_ASSERT_TRUE(fileSystem.exists(segmentFile(3).c_str()));
+    TEST_ASSERT_EQUAL_size_t(0, readSegment(log, 2).size());  // Rotated away: reads as empty
+}
+
+void test_reopen_resumes_tail_segment(void) {
+    {
+        SegmentLog<StdioFS> log;
+        TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+        for (int i = 0; i < SEGMENT_BLOCKS + 1; i++) {
+            log.append(makeBlock());
+        }
+    }
+    fileSystem.bytesReadByPath.clear();
+    SegmentLog<StdioFS> log;
+    TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+    TEST_ASSERT_EQUAL_UINT32(1, log.getFirstSegment());
+    TEST_ASSERT_EQUAL_UINT32(2, log.getLastSegment());
+    TEST_ASSERT_EQUAL_UINT16(1, log.getTailBlocks());
+    TEST_ASSERT_EQUAL_UINT32(0, log.getStats().tornBlocks);
+
+    // Only the tail segment was read during recovery
+    TEST_ASSERT_EQUAL_size_t(1, fileSystem.bytesReadByPath.size());
+    TEST_ASSERT_EQUAL_size_t(sizeof(SensorBlock), fileSystem.bytesReadByPath[segmentFile(2)]);
+
+    log.append(makeBlock());
+    TEST_ASSERT_EQUAL_size_t(2, readSegment(log, 2).size());
+}
+
+// Power cut in the middle of a block write
+void test_recovers_from_partial_block(void) {
+    std::vector<SensorBlock> written;
+    {
+        SegmentLog<StdioFS> log;
+        TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+        for (int i = 0; i < 2; i++) {
+            written.push_back(makeBlock());
+            log.append(written.back());
+        }
+    }
+    SensorBlock torn = makeBlock();
+    appendRaw(1, &torn, sizeof(SensorBlock) / 3);
+
+    SegmentLog<StdioFS> log;
+    TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+    TEST_ASSERT_EQUAL_UINT32(1, log.getStats().tornBlocks);
+    TEST_ASSERT_EQUAL_size_t(2, readSegment(log, 1).size());  // The torn tail is never returned
+
+    // Appends resume in a fresh segment, so the torn bytes stay behind the valid blocks
+    SensorBlock next = makeBlock();
+    TEST_ASSERT_TRUE(log.append(next));
+    TEST_ASSERT_EQUAL_UINT32(2, log.getLastSegment());
+    std::vector<SensorBlock> tail = readSegment(log, 2);
+    TEST_ASSERT_EQUAL_size_t(1, tail.size());
+    TEST_ASSERT_EQUAL_MEMORY(&next, &tail[0], sizeof(SensorBlock));
+}
+
+// Power cut after the length was committed but before the data was: a whole
+// block of garbage at the tail
+void test_recovers_from_corrupted_tail_block(void) {
+    {
+        SegmentLog<StdioFS> log;
+        TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+        log.append(makeBlock());
+    }
+    SensorBlock corrupted = makeBlock();
+    corrupted.payload[3] ^= 0x10;
+    appendRaw(1, &corrupted, sizeof(SensorBlock));
+
+    SegmentLog<StdioFS> log;
+    TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+    TEST_ASSERT_EQUAL_UINT32(1, log.getStats().tornBlocks);
+    TEST_ASSERT_EQUAL_size_t(1, readSegment(log, 1).size());
+    TEST_ASSERT_TRUE(log.append(makeBlock()));
+    TEST_ASSERT_EQUAL_UINT32(2, log.getLastSegment());
+}
+
+// A short write (partition full) is counted and the log moves on
+void test_short_write_moves_to_next_segment(void) {
+    SegmentLog<StdioFS> log;
+    TEST_ASSERT_TRUE(log.begin(fileSystem, DIRECTORY, SEGMENT_BLOCKS, MAX_SEGMENTS));
+    TEST_ASSERT_TRUE(log.append(makeBlock()));
+    fileSystem.writeBudget = 100;
+    TEST_ASSERT_FALSE(log.append(makeBlock()));
+    TEST_ASSERT_EQUAL_UINT32(1, log.getStats().writeErrors);
+    fileSystem.writeBudget = -1;
+
+    SensorBlock next = makeBlock();
+    TEST_ASSERT_TRUE(log.append(next));
+    TEST_ASSERT_EQUAL_UINT32(2, log.getLastSegment());
+    TEST_ASSERT_EQUAL_size_t(1, readSegment(log, 1).size());
+    TEST_ASSERT_EQUAL_MEMORY(&next, &readSegment(log, 2)[0], sizeof(SensorBlock));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_append_and_read_back);
+    RUN_TEST(test_rotation_deletes_oldest_segments);
+    RUN_TEST(test_reopen_resumes_tail_segment);
+    RUN_TEST(test_recovers_from_partial_block);
+    RUN_TEST(test_recovers_from_corrupted_tail_block);
+    RUN_TEST(test_short_write_moves_to_next_segment);
+    return UNITY_END();
+}
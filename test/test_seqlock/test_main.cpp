@@ -0,0 +1,116 @@
+// SeqLock stress test (sensor_snapshot.h)
+// One writer publishes snapshots whose fields are all derived from a counter
+// while several readers spin on read(); any torn copy shows up as fields that
+// disagree with each other.
+//   pio test -e native -f test_seqlock
+
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "sensor_snapshot.h"
+
+static const uint32_t WRITES = 200000;
+static const int READERS = 3;
+
+static SensorSnapshot snapshotFor(uint32_t n) {
+    SensorSnapshot snapshot;
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+        snapshot.values[c] = (int32_t)(n * 31 + c);
+    }
+    snapshot.validChannels = n;
+    snapshot.attachedSensors = ~n;
+    snapshot.sequence = n;
+    snapshot.timestamp = n * 7UL;
+    return snapshot;
+}
+
+static bool consistent(const SensorSnapshot& snapshot) {
+    uint32_t n = snapshot.sequence;
+    if (n == 0) {
+        return true;  // Not published yet: all zero
+    }
+    if (snapshot.validChannels != n || snapshot.attachedSensors != ~n || snapshot.timestamp != n * 7UL) {
+        return false;
+    }
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+        if (snapshot.values[c] != (int32_t)(n * 31 + c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_read_before_first_write_is_empty(void) {
+    SeqLock<SensorSnapshot> lock;
+    SensorSnapshot snapshot = lock.read();
+    TEST_ASSERT_EQUAL_UINT32(0, snapshot.sequence);
+    TEST_ASSERT_EQUAL_UINT32(0, lock.version());
+}
+
+void test_version_counts_writes(void) {
+    SeqLock<SensorSnapshot> lock;
+    for (uint32_t n = 1; n <= 5; n++) {
+        lock.write(snapshotFor(n));
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, lock.version());
+    TEST_ASSERT_EQUAL_UINT32(5, lock.read().sequence);
+}
+
+void test_concurrent_readers_never_see_torn_snapshots(void) {
+    static SeqLock<SensorSnapshot> lock;
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> torn{0};
+    std::atomic<uint32_t> backwards{0};
+    std::atomic<uint64_t> reads{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&] {
+            uint32_t last = 0;
+            uint64_t count = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                SensorSnapshot snapshot = lock.read();
+                if (!consistent(snapshot)) {
+                    torn++;
+                }
+                if (snapshot.sequence < last) {
+                    backwards++;
+                }
+                last = snapshot.sequence;
+                count++;
+            }
+            reads += count;
+        });
+    }
+
+    for (uint32_t n = 1; n <= WRITES; n++) {
+        lock.write(snapshotFor(n));
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "%u writes, %llu reads by %d readers", (unsigned)WRITES,
+             (unsigned long long)reads.load(), READERS);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    TEST_ASSERT_EQUAL_UINT32(0, backwards.load());
+    TEST_ASSERT_EQUAL_UINT32(WRITES, lock.version());
+    TEST_ASSERT_TRUE(consistent(lock.read()));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_read_before_first_write_is_empty);
+    RUN_TEST(test_version_counts_writes);
+    RUN_TEST(test_concurrent_readers_never_see_torn_snapshots);
+    return UNITY_END();
+}
@@ -0,0 +1,345 @@
+// Beacon Listener
+// ===============
+// Host-side aggregator for the devices' UDP multicast telemetry beacons
+// (include/telemetry_beacon.h). Joins the group, keeps the latest readings
+// per device and prints a table; lost datagrams are counted from sequence
+// gaps and reboots from sequence/uptime resets.
+//
+// Build (Linux / macOS):
+//   g++ -std=c++17 -O2 -pthread -Iinclude tools/beacon_listener.cpp -o beacon_listener
+//
+// Usage:
+//   ./beacon_listener                                  # listen on 239.255.42.99:47800
+//   ./beacon_listener --group 239.255.42.99 --port 47800 --iface 192.168.1.20
+//   ./beacon_listener --simulate 500 --seconds 10      # throughput test, see below
+//
+// --simulate N starts N senders in-process (one socket each, so each has its
+// own source port like a real device) that send beacons to the group over
+// loopback while the listener aggregates them, then reports datagrams per
+// second, loss and the decode + aggregate cost per datagram. The senders use
+// the devices' 5 s cycle unless --interval-ms is given; --interval-ms 0 sends
+// as fast as possible. --unicast sends to 127.0.0.1 instead, for hosts
+// without a multicast route.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "telemetry_beacon.h"
+#include "env_math.h"  // formatFixed()
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    const char* group = "239.255.42.99";  // BEACON_MULTICAST_GROUP
+    uint16_t port = BEACON_PORT;
+    const char* iface = "0.0.0.0";
+    int simulate = 0;
+    int seconds = 10;
+    int intervalMs = 5000;
+    bool unicast = false;
+};
+
+struct DeviceState {
+    Beacon latest;
+    std::string address;
+    Clock::time_point lastSeen;
+    uint64_t received = 0;
+    uint64_t lost = 0;        // Sequence gaps
+    uint64_t duplicates = 0;  // Same or older sequence (reordered or repeated)
+    uint32_t reboots = 0;
+};
+
+// Devices keyed by source address and MAC suffix: two devices can share the
+// 4-digit suffix, but not the address
+class Aggregator {
+public:
+    void add(const uint8_t* data, size_t length, const sockaddr_in& from) {
+        Beacon beacon;
+        if (!decodeBeacon(data, length, beacon)) {
+            invalid++;
+            return;
+        }
+        uint32_t id;
+        memcpy(&id, beacon.id, sizeof(id));
+        uint64_t key = (uint64_t)from.sin_addr.s_addr << 32 | id;  // Not the port: it changes on reboot
+        auto inserted = devices.try_emplace(key);
+        DeviceState& device = inserted.first->second;
+        if (inserted.second) {
+            char address[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &from.sin_addr, address, sizeof(address));
+            device.address = address;
+        } else if (beacon.sequence < device.latest.sequence && beacon.uptime < device.latest.uptime) {
+            device.reboots++;  // Counter restarted
+        } else if (beacon.sequence <= device.latest.sequence) {
+            device.duplicates++;
+            device.received++;
+            return;
+        } else {
+            device.lost += beacon.sequence - device.latest.sequence - 1;
+        }
+        device.latest = beacon;
+        device.lastSeen = Clock::now();
+        device.received++;
+    }
+
+    void print(FILE* out) const {
+        std::vector<const DeviceState*> sorted;
+        for (const auto& entry : devices) {
+            sorted.push_back(&entry.second);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const DeviceState* a, const DeviceState* b) {
+            return strcmp(a->latest.name, b->latest.name) < 0;
+        });
+
+        Clock::time_point now = Clock::now();
+        fprintf(out, "%-20s %-4s %-15s %5s %8s %6s  readings\n", "name", "id", "address", "age", "received", "lost");
+        for (const DeviceState* device : sorted) {
+            long age = (long)std::chrono::duration_cast<std::chrono::seconds>(now - device->lastSeen).count();
+            fprintf(out, "%-20.20s %-4s %-15s %4lds %8llu %6llu ", device->latest.name, device->latest.id,
+                    device->address.c_str(), age, (unsigned long long)device->received,
+                    (unsigned long long)device->lost);
+            for (uint8_t c = 0; c < CHANNEL_COUNT; c++) {
+                if (device->latest.validChannels & (1UL << c)) {
+                    char value[FIXED_TEXT_SIZE];
+                    formatFixed(value, sizeof(value), device->latest.values[c], CHANNEL_INFO[c].scale,
+                                CHANNEL_INFO[c].decimals);
+                    fprintf(out, " %s=%s", CHANNEL_INFO[c].name, value);
+                }
+            }
+            fprintf(out, "\n");
+        }
+        fprintf(out, "%zu device(s), %llu invalid datagram(s)\n\n", devices.size(), (unsigned long long)invalid);
+    }
+
+    size_t size() const { return devices.size(); }
+    uint64_t getInvalid() const { return invalid; }
+
+    uint64_t totalReceived() const {
+        uint64_t total = 0;
+        for (const auto& entry : devices) total += entry.second.received;
+        return total;
+    }
+
+    uint64_t totalLost() const {
+        uint64_t total = 0;
+        for (const auto& entry : devices) total += entry.second.lost;
+        return total;
+    }
+
+private:
+    std::unordered_map<uint64_t, DeviceState> devices;
+    uint64_t invalid = 0;
+};
+
+static int openListener(const Options& options) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    int buffer = 8 << 20;  // Absorb bursts of beacons arriving together
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+    timeval timeout = {0, 200000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        perror("bind");
+        close(fd);
+        return -1;
+    }
+    if (!options.unicast) {
+        ip_mreq membership = {};
+        inet_pton(AF_INET, options.group, &membership.imr_multiaddr);
+        inet_pton(AF_INET, options.iface, &membership.imr_interface);
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+            perror("IP_ADD_MEMBERSHIP (try --iface <address> or --unicast)");
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+// Receives until `stop`; returns the time spent decoding and aggregating
+static std::chrono::nanoseconds receiveLoop(int fd, Aggregator& aggregator, const std::atomic<bool>& stop,
+                                            bool printTable) {
+    std::chrono::nanoseconds busy(0);
+    Clock::time_point lastPrint = Clock::now();
+    uint8_t packet[1500];
+    while (!stop) {
+        sockaddr_in from = {};
+        socklen_t fromLength = sizeof(from);
+        ssize_t length = recvfrom(fd, packet, sizeof(packet), 0, (sockaddr*)&from, &fromLength);
+        if (length > 0) {
+            Clock::time_point started = Clock::now();
+            aggregator.add(packet, (size_t)length, from);
+            busy += Clock::now() - started;
+        }
+        if (printTable && Clock::now() - lastPrint >= std::chrono::seconds(5)) {
+            lastPrint = Clock::now();
+            aggregator.print(stdout);
+        }
+    }
+    return busy;
+}
+
+static int simulate(const Options& options, int listener) {
+    std::vector<int> senders;
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(options.port);
+    inet_pton(AF_INET, options.unicast ? "127.0.0.1" : options.group, &destination.sin_addr);
+    for (int i = 0; i < options.simulate; i++) {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            perror("socket (raise ulimit -n for more senders)");
+            return 1;
+        }
+        if (!options.unicast) {
+            in_addr loopback;
+            inet_pton(AF_INET, "127.0.0.1", &loopback);
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback));
+            unsigned char loop = 1;
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        }
+        senders.push_back(fd);
+    }
+
+    Aggregator aggregator;
+    std::atomic<bool> stop(false);
+    std::chrono::nanoseconds busy(0);
+    std::thread receiver([&] { busy = receiveLoop(listener, aggregator, stop, false); });
+
+    // Each sender's beacon: distinct suffix and name, readings that drift a little
+    std::vector<Beacon> beacons(senders.size());
+    for (size_t i = 0; i < beacons.size(); i++) {
+        Beacon& beacon = beacons[i];
+        memset(&beacon, 0, sizeof(beacon));
+        snprintf(beacon.id, sizeof(beacon.id), "%04X", (unsigned)i);
+        snprintf(beacon.name, sizeof(beacon.name), "Sensor %03zu", i);
+        beacon.validChannels = (1UL << CHANNEL_TEMPERATURE) | (1UL << CHANNEL_PRESSURE) |
+                               (1UL << CHANNEL_HUMIDITY) | (1UL << CHANNEL_DEW_POINT);
+    }
+
+    uint64_t sent = 0, sendErrors = 0, bytes = 0;
+    Clock::time_point started = Clock::now();
+    Clock::time_point end = started + std::chrono::seconds(options.seconds);
+    Clock::time_point nextRound = started;
+    while (Clock::now() < end) {
+        // One round = every sender beacons once, spread over the interval
+        for (size_t i = 0; i < senders.size(); i++) {
+            if (options.intervalMs > 0) {
+                std::this_thread::sleep_until(nextRound + std::chrono::microseconds(
+                                                              (int64_t)options.intervalMs * 1000 * i / senders.size()));
+            }
+            Beacon& beacon = beacons[i];
+            beacon.sequence++;
+            beacon.uptime = (uint32_t)(beacon.sequence * 5);
+            beacon.values[CHANNEL_TEMPERATURE] = 2100 + (int32_t)((i * 7 + beacon.sequence) % 300);
+            beacon.values[CHANNEL_PRESSURE] = 101325 - (int32_t)(i % 500);
+            beacon.values[CHANNEL_HUMIDITY] = 4500 + (int32_t)(beacon.sequence % 100);
+            beacon.values[CHANNEL_DEW_POINT] = 900 + (int32_t)(i % 50);
+
+            uint8_t packet[BEACON_MAX_SIZE];
+            size_t length = encodeBeacon(beacon, packet);
+            if (sendto(senders[i], packet, length, 0, (sockaddr*)&destination, sizeof(destination)) ==
+                (ssize_t)length) {
+                sent++;
+                bytes += length;
+            } else {
+                sendErrors++;
+            }
+        }
+        nextRound += std::chrono::milliseconds(options.intervalMs);
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));  // Let the receiver drain
+    stop = true;
+    receiver.join();
+    for (int fd : senders) {
+        close(fd);
+    }
+
+    uint64_t received = aggregator.totalReceived();
+    printf("senders:     %d (%s, interval %d ms)\n", options.simulate, options.unicast ? "unicast" : "multicast",
+           options.intervalMs);
+    printf("sent:        %llu datagrams, %.1f bytes each, %llu send errors\n", (unsigned long long)sent,
+           sent ? (double)bytes / sent : 0.0, (unsigned long long)sendErrors);
+    printf("received:    %llu (%.0f/s), %zu devices, %llu invalid\n", (unsigned long long)received,
+           received / elapsed, aggregator.size(), (unsigned long long)aggregator.getInvalid());
+    printf("lost:        %llu by sequence gaps (%.3f%%), %llu not received\n",
+           (unsigned long long)aggregator.totalLost(), sent ? 100.0 * aggregator.totalLost() / sent : 0.0,
+           (unsigned long long)(sent - std::min(sent, received)));
+    printf("aggregation: %.0f ns per datagram (decode + update)\n",
+           received ? (double)busy.count() / received : 0.0);
+    return aggregator.size() == (size_t)options.simulate ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--unicast") {
+            options.unicast = true;
+        } else if (value != nullptr && arg == "--group") {
+            options.group = argv[++i];
+        } else if (value != nullptr && arg == "--port") {
+            options.port = (uint16_t)atoi(argv[++i]);
+        } else if (value != nullptr && arg == "--iface") {
+            options.iface = argv[++i];
+        } else if (value != nullptr && arg == "--simulate") {
+            options.simulate = atoi(argv[++i]);
+        } else if (value != nullptr && arg == "--seconds") {
+            options.seconds = atoi(argv[++i]);
+        } else if (value != nullptr && arg == "--interval-ms") {
+            options.intervalMs = atoi(argv[++i]);
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--group ADDR] [--port N] [--iface ADDR] [--unicast]\n"
+                    "          [--simulate SENDERS [--seconds N] [--interval-ms MS]]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (options.simulate > 0 && !options.unicast && strcmp(options.iface, "0.0.0.0") == 0) {
+        options.iface = "127.0.0.1";  // Simulated senders multicast over loopback
+    }
+    int fd = openListener(options);
+    if (fd < 0) {
+        return 1;
+    }
+    if (options.simulate > 0) {
+        int result = simulate(options, fd);
+        close(fd);
+        return result;
+    }
+
+    printf("Listening for beacons on %s:%u\n\n", options.unicast ? "*" : options.group, options.port);
+    Aggregator aggregator;
+    std::atomic<bool> stop(false);
+    receiveLoop(fd, aggregator, stop, true);
+    close(fd);
+    return 0;
+}